@@ -8,13 +8,70 @@ Supports:
 
 import ctypes
 import os
+from array import array
+from itertools import accumulate
 from pathlib import Path
-from typing import Optional
+from typing import Iterable, List, Mapping, Optional, Tuple, Union
 
 # Determine which backend to use
 _backend = None
 _lib = None
 
+def _pack(items: List[bytes]):
+    """Lay items out back to back; return (buffer, pointer array, length array).
+
+    Building the argument arrays from a joined buffer and array('Q') runs at
+    C speed, where a ctypes array constructed element by element costs more
+    than the storage operations it feeds. The buffer must outlive the call.
+    """
+    lens = array('Q', map(len, items))
+    buffer = ctypes.create_string_buffer(b"".join(items), sum(lens) or 1)
+    ptrs = array('Q', accumulate(lens[:-1], initial=ctypes.addressof(buffer)))
+    count = len(items)
+    return (buffer,
+            ctypes.cast((ctypes.c_uint64 * count).from_buffer(ptrs), ctypes.POINTER(ctypes.c_char_p)),
+            (ctypes.c_size_t * count).from_buffer(lens),
+            ptrs, lens)
+
+# fast_storage_durability_t
+DURABILITY_MODES = {"none": 0, "async": 1, "group": 2, "sync": 3}
+
+
+# fast_storage_advice_t
+ADVICE_MODES = {"normal": 0, "random": 1, "sequential": 2, "willneed": 3}
+
+
+class _Options(ctypes.Structure):
+    """Mirror of fast_storage_options_t."""
+    _fields_ = [
+        ("initial_size", ctypes.c_size_t),
+        ("populate_ahead", ctypes.c_size_t),
+        ("advice", ctypes.c_int),
+        ("populate", ctypes.c_bool),
+        ("lock", ctypes.c_bool),
+        ("huge_pages", ctypes.c_bool),
+        ("read_only", ctypes.c_bool),
+    ]
+
+
+class _Stats(ctypes.Structure):
+    """Mirror of fast_storage_stats_t."""
+    _fields_ = [
+        ("keys", ctypes.c_size_t),
+        ("live_bytes", ctypes.c_uint64),
+        ("dead_bytes", ctypes.c_uint64),
+        ("dead_ratio", ctypes.c_double),
+        ("file_size", ctypes.c_uint64),
+        ("compactions", ctypes.c_uint64),
+        ("grows", ctypes.c_uint64),
+        ("replayed", ctypes.c_uint64),
+        ("recovered", ctypes.c_uint64),
+        ("syncs", ctypes.c_uint64),
+        ("committed_bytes", ctypes.c_uint64),
+        ("reads", ctypes.c_uint64),
+        ("writes", ctypes.c_uint64),
+    ]
+
 def _load_c_backend():
     """Load the optimized Pure C FastStorage backend."""
     global _lib
@@ -29,6 +86,12 @@ def _load_c_backend():
             _lib.fast_storage_create.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
             _lib.fast_storage_create.restype = ctypes.c_void_p
             
+            _lib.fast_storage_default_options.argtypes = [ctypes.POINTER(_Options)]
+            _lib.fast_storage_default_options.restype = None
+            
+            _lib.fast_storage_open_ex.argtypes = [ctypes.c_char_p, ctypes.POINTER(_Options)]
+            _lib.fast_storage_open_ex.restype = ctypes.c_void_p
+            
             _lib.fast_storage_destroy.argtypes = [ctypes.c_void_p]
             _lib.fast_storage_destroy.restype = None
             
@@ -40,6 +103,23 @@ def _load_c_backend():
                                               ctypes.POINTER(ctypes.c_char_p), ctypes.POINTER(ctypes.c_size_t)]
             _lib.fast_storage_read.restype = ctypes.c_int
             
+            _lib.fast_storage_write_batch.argtypes = [ctypes.c_void_p, ctypes.c_size_t,
+                                                     ctypes.POINTER(ctypes.c_char_p), ctypes.POINTER(ctypes.c_size_t),
+                                                     ctypes.POINTER(ctypes.c_char_p), ctypes.POINTER(ctypes.c_size_t)]
+            _lib.fast_storage_write_batch.restype = ctypes.c_int
+            
+            # Outputs as void* so ctypes does not stop at NUL bytes
+            _lib.fast_storage_read_many.argtypes = [ctypes.c_void_p, ctypes.c_size_t,
+                                                   ctypes.POINTER(ctypes.c_char_p), ctypes.POINTER(ctypes.c_size_t),
+                                                   ctypes.POINTER(ctypes.c_void_p), ctypes.POINTER(ctypes.c_size_t)]
+            _lib.fast_storage_read_many.restype = ctypes.c_size_t
+            
+            _lib.fast_storage_pin.argtypes = [ctypes.c_void_p]
+            _lib.fast_storage_pin.restype = ctypes.c_int
+            
+            _lib.fast_storage_unpin.argtypes = [ctypes.c_void_p]
+            _lib.fast_storage_unpin.restype = None
+            
             _lib.fast_storage_remove.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
             _lib.fast_storage_remove.restype = ctypes.c_int
             
@@ -58,6 +138,21 @@ def _load_c_backend():
             _lib.fast_storage_capacity.argtypes = [ctypes.c_void_p]
             _lib.fast_storage_capacity.restype = ctypes.c_size_t
             
+            _lib.fast_storage_checkpoint.argtypes = [ctypes.c_void_p]
+            _lib.fast_storage_checkpoint.restype = ctypes.c_int
+            
+            _lib.fast_storage_compact.argtypes = [ctypes.c_void_p]
+            _lib.fast_storage_compact.restype = ctypes.c_int
+            
+            _lib.fast_storage_set_durability.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_uint]
+            _lib.fast_storage_set_durability.restype = ctypes.c_int
+            
+            _lib.fast_storage_sync.argtypes = [ctypes.c_void_p]
+            _lib.fast_storage_sync.restype = ctypes.c_int
+            
+            _lib.fast_storage_get_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(_Stats)]
+            _lib.fast_storage_get_stats.restype = None
+            
             return "c"
     except Exception as e:
         pass
@@ -94,11 +189,19 @@ class FastStorage:
       2. C++ pybind11 version as fallback
     """
     
-    def __init__(self, filename: str, size: int = 100 * 1024 * 1024):
+    def __init__(self, filename: str, size: int = 100 * 1024 * 1024, *,
+                 populate: bool = False, lock: bool = False, huge_pages: bool = False,
+                 advice: str = "normal", read_only: bool = False,
+                 populate_ahead: Optional[int] = None):
+        """Open or create a store; keyword options map to fast_storage_options_t
+        (Pure C backend only): populate/lock fault in and pin the whole file,
+        populate_ahead is how far ahead of the writes pages are faulted in."""
         if not filename:
             raise ValueError("Filename cannot be empty")
         if size < 1024:
             raise ValueError("Size must be at least 1024 bytes")
+        if advice not in ADVICE_MODES:
+            raise ValueError(f"Unknown advice: {advice!r}")
         
         self._filename = filename
         self._size = size
@@ -106,10 +209,22 @@ class FastStorage:
         
         if _backend == "c":
             # Pure C backend
-            self._storage = _lib.fast_storage_create(filename.encode(), size)
+            options = _Options()
+            _lib.fast_storage_default_options(ctypes.byref(options))
+            options.initial_size = size
+            options.populate = populate
+            options.lock = lock
+            options.huge_pages = huge_pages
+            options.advice = ADVICE_MODES[advice]
+            options.read_only = read_only
+            if populate_ahead is not None:
+                options.populate_ahead = populate_ahead
+            self._storage = _lib.fast_storage_open_ex(filename.encode(), ctypes.byref(options))
             if not self._storage:
                 raise RuntimeError(f"Failed to create FastStorage: {filename}")
         else:
+            if populate or lock or huge_pages or read_only or advice != "normal" or populate_ahead is not None:
+                raise NotImplementedError("Open options require the Pure C backend")
             # C++ pybind11 backend
             self._native = _faststorage.NativeFastStorage(filename, size)
     
@@ -147,14 +262,19 @@ class FastStorage:
                 key_bytes = key.encode()
                 value_ptr = ctypes.c_char_p()
                 value_len = ctypes.c_size_t()
-                result = _lib.fast_storage_read(self._storage, key_bytes, len(key_bytes),
-                                               ctypes.byref(value_ptr), ctypes.byref(value_len))
-                if result < 0:
-                    raise KeyError(f"Key not found: {key}")
-                if value_ptr and value_len.value > 0:
-                    # Copy the data because the pointer is into mmap'd memory
-                    return ctypes.string_at(value_ptr, value_len.value).decode()
-                return ""
+                # Pinned so a writer on another thread cannot unmap the value before it is copied
+                _lib.fast_storage_pin(self._storage)
+                try:
+                    result = _lib.fast_storage_read(self._storage, key_bytes, len(key_bytes),
+                                                   ctypes.byref(value_ptr), ctypes.byref(value_len))
+                    if result < 0:
+                        raise KeyError(f"Key not found: {key}")
+                    if value_ptr and value_len.value > 0:
+                        # Copy the data because the pointer is into mmap'd memory
+                        return ctypes.string_at(value_ptr, value_len.value).decode()
+                    return ""
+                finally:
+                    _lib.fast_storage_unpin(self._storage)
             else:
                 return self._native.read(key)
         except KeyError:
@@ -164,6 +284,61 @@ class FastStorage:
                 raise KeyError(f"Key not found: {key}") from e
             raise RuntimeError(f"Read failed: {e}") from e
     
+    def write_many(self, items: Union[Mapping[str, str], Iterable[Tuple[str, str]]]) -> None:
+        """Write many key-value pairs in one native call; later duplicates win."""
+        pairs = list(items.items() if isinstance(items, Mapping) else items)
+        for key, value in pairs:
+            if not isinstance(key, str):
+                raise TypeError("Key must be a string")
+            if not isinstance(value, str):
+                raise TypeError("Value must be a string")
+            if not key:
+                raise ValueError("Key cannot be empty")
+        if not pairs:
+            return
+        
+        if self._backend == "c":
+            count = len(pairs)
+            key_pack = _pack([key.encode() for key, _ in pairs])
+            value_pack = _pack([value.encode() for _, value in pairs])
+            if _lib.fast_storage_write_batch(self._storage, count, key_pack[1], key_pack[2],
+                                             value_pack[1], value_pack[2]) < 0:
+                raise RuntimeError(f"Batch write failed ({count} records)")
+        else:
+            for key, value in pairs:
+                self.write(key, value)
+    
+    def read_many(self, keys: Iterable[str]) -> List[Optional[str]]:
+        """Read many keys in one native call; absent keys map to None."""
+        keys = list(keys)
+        for key in keys:
+            if not isinstance(key, str):
+                raise TypeError("Key must be a string")
+        if not keys:
+            return []
+        
+        if self._backend == "c":
+            count = len(keys)
+            key_pack = _pack([key.encode() for key in keys])
+            values = (ctypes.c_void_p * count)()
+            value_lens = (ctypes.c_size_t * count)()
+            _lib.fast_storage_pin(self._storage)
+            try:
+                _lib.fast_storage_read_many(self._storage, count, key_pack[1], key_pack[2], values, value_lens)
+                # Copy out: the pointers are into mmap'd memory
+                return [ctypes.string_at(ptr, size).decode() if ptr is not None else None
+                        for ptr, size in zip(values, value_lens)]
+            finally:
+                _lib.fast_storage_unpin(self._storage)
+        
+        result = []
+        for key in keys:
+            try:
+                result.append(self.read(key))
+            except KeyError:
+                result.append(None)
+        return result
+    
     def delete(self, key: str) -> None:
         """Delete a key from storage."""
         if not isinstance(key, str):
@@ -196,6 +371,37 @@ class FastStorage:
         except RuntimeError as e:
             raise RuntimeError(f"Flush failed: {e}") from e
     
+    def set_durability(self, mode: str, interval_ms: int = 0) -> None:
+        """Choose when writes reach disk: "none", "async", "group" (a background
+        sync every interval_ms) or "sync" (before each write returns)."""
+        if mode not in DURABILITY_MODES:
+            raise ValueError(f"Unknown durability mode: {mode!r}")
+        if self._backend != "c":
+            raise NotImplementedError("set_durability() requires the Pure C backend")
+        if _lib.fast_storage_set_durability(self._storage, DURABILITY_MODES[mode], interval_ms) != 0:
+            raise RuntimeError(f"Setting durability failed: {self._filename}")
+    
+    def sync(self) -> None:
+        """Make every write so far durable, whatever the durability mode."""
+        if self._backend != "c":
+            raise NotImplementedError("sync() requires the Pure C backend")
+        if _lib.fast_storage_sync(self._storage) != 0:
+            raise RuntimeError(f"Sync failed: {self._filename}")
+    
+    def checkpoint(self) -> None:
+        """Persist the index to <filename>.idx so the next open skips the log scan."""
+        if self._backend != "c":
+            raise NotImplementedError("checkpoint() requires the Pure C backend")
+        if _lib.fast_storage_checkpoint(self._storage) != 0:
+            raise RuntimeError(f"Checkpoint failed: {self._filename}")
+    
+    def compact(self) -> None:
+        """Rewrite live records into a fresh file, reclaiming dead space."""
+        if self._backend != "c":
+            raise NotImplementedError("compact() requires the Pure C backend")
+        if _lib.fast_storage_compact(self._storage) != 0:
+            raise RuntimeError(f"Compaction failed: {self._filename}")
+    
     def __len__(self) -> int:
         """Return number of items in storage."""
         if self._backend == "c":
@@ -251,6 +457,15 @@ class FastStorage:
             return 0.0
         return (self.bytes_used / cap) * 100.0
     
+    @property
+    def stats(self) -> dict:
+        """Return live/dead byte accounting and grow/compaction counts."""
+        if self._backend != "c":
+            raise NotImplementedError("stats requires the Pure C backend")
+        stats = _Stats()
+        _lib.fast_storage_get_stats(self._storage, ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in _Stats._fields_}
+    
     @property
     def backend(self) -> str:
         """Return which backend is being used."""
@@ -1,8 +1,12 @@
 #include <watcher_core.hpp>
 #include <node_api.h>
-#include <node.h>
 #include <iostream>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 // ============================================================================
 // N-API Bindings for JavaScript
@@ -72,8 +76,8 @@ napi_value RegisterPage(napi_env env, napi_callback_info info) {
         return nullptr;
     }
     
-    size_t argc = 4;
-    napi_value argv[4];
+    size_t argc = 5;
+    napi_value argv[5];
     napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
     
     // Get page base address
@@ -93,7 +97,13 @@ napi_value RegisterPage(napi_env env, napi_callback_info info) {
     uint32_t flags;
     napi_get_value_uint32(env, argv[3], &flags);
     
-    watcher::MutationDepth depth{true, 0};
+    // Optional byte range: track only the first bytes (0 or absent: all)
+    uint32_t byte_range = 0;
+    if (argc > 4) {
+        napi_get_value_uint32(env, argv[4], &byte_range);
+    }
+    
+    watcher::MutationDepth depth{byte_range == 0, byte_range};
     std::string var_id = g_core->registerPage(
         page_base, page_size, std::string(name, name_len),
         static_cast<watcher::EventFlags>(flags), depth
@@ -125,6 +135,38 @@ napi_value UnregisterPage(napi_env env, napi_callback_info info) {
     return result;
 }
 
+// setSamplingPolicy(varID, mode, everyN, maxPerSecond, windowUs)
+// mode is watcher::SamplingPolicy::Mode; parameters of other modes are ignored
+napi_value SetSamplingPolicy(napi_env env, napi_callback_info info) {
+    if (!g_core) {
+        napi_throw_error(env, nullptr, "Watcher core not initialized");
+        return nullptr;
+    }
+    
+    size_t argc = 5;
+    napi_value argv[5];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    
+    size_t var_id_len = 0;
+    char var_id[256];
+    napi_get_value_string_utf8(env, argv[0], var_id, sizeof(var_id), &var_id_len);
+    
+    uint32_t params[4] = {0, 0, 0, 0};
+    for (size_t i = 1; i < argc && i < 5; ++i) {
+        napi_get_value_uint32(env, argv[i], &params[i - 1]);
+    }
+    watcher::SamplingPolicy policy;
+    policy.mode = static_cast<watcher::SamplingPolicy::Mode>(params[0]);
+    policy.every_n = params[1];
+    policy.max_per_second = params[2];
+    policy.window_us = params[3];
+    bool success = g_core->setSamplingPolicy(std::string(var_id, var_id_len), policy);
+    
+    napi_value result;
+    napi_get_boolean(env, success, &result);
+    return result;
+}
+
 napi_value GetState(napi_env env, napi_callback_info info) {
     if (!g_core) {
         napi_throw_error(env, nullptr, "Watcher core not initialized");
@@ -136,6 +178,323 @@ napi_value GetState(napi_env env, napi_callback_info info) {
     return result;
 }
 
+// Counters are exposed as doubles (exact up to 2^53)
+static void SetNumber(napi_env env, napi_value object, const char* name, double value) {
+    napi_value number;
+    napi_create_double(env, value, &number);
+    napi_set_named_property(env, object, name, number);
+}
+
+static napi_value StageToObject(napi_env env, const watcher::WatcherCore::LatencyStats& stats) {
+    napi_value object;
+    napi_create_object(env, &object);
+    SetNumber(env, object, "count", static_cast<double>(stats.count));
+    SetNumber(env, object, "minNs", static_cast<double>(stats.min_ns));
+    SetNumber(env, object, "maxNs", static_cast<double>(stats.max_ns));
+    SetNumber(env, object, "meanNs", stats.mean_ns);
+    SetNumber(env, object, "p50Ns", static_cast<double>(stats.p50_ns));
+    SetNumber(env, object, "p90Ns", static_cast<double>(stats.p90_ns));
+    SetNumber(env, object, "p99Ns", static_cast<double>(stats.p99_ns));
+    SetNumber(env, object, "p999Ns", static_cast<double>(stats.p999_ns));
+    return object;
+}
+
+napi_value GetMetrics(napi_env env, napi_callback_info info) {
+    if (!g_core) {
+        napi_throw_error(env, nullptr, "Watcher core not initialized");
+        return nullptr;
+    }
+    
+    auto basic = g_core->getMetrics();
+    auto pipeline = g_core->getPipelineMetrics();
+    
+    napi_value result;
+    napi_create_object(env, &result);
+    SetNumber(env, result, "eventsReceived", static_cast<double>(basic.events_received));
+    SetNumber(env, result, "eventsProcessed", static_cast<double>(basic.events_processed));
+    SetNumber(env, result, "eventsDropped", static_cast<double>(basic.events_dropped));
+    SetNumber(env, result, "policyDrops", static_cast<double>(basic.policy_drops));
+    SetNumber(env, result, "callbacksFailed", static_cast<double>(basic.callbacks_failed));
+    SetNumber(env, result, "meanLatencyMs", basic.mean_latency_ms);
+    SetNumber(env, result, "queueDepth", basic.queue_depth);
+    SetNumber(env, result, "ioctls", static_cast<double>(pipeline.ioctls));
+    SetNumber(env, result, "unprotectFailures", static_cast<double>(pipeline.unprotect_failures));
+    SetNumber(env, result, "reprotectFailures", static_cast<double>(pipeline.reprotect_failures));
+    SetNumber(env, result, "wpReleaseFailures", static_cast<double>(pipeline.wp_release_failures));
+    SetNumber(env, result, "queueFullDrops", static_cast<double>(pipeline.queue_full_drops));
+    SetNumber(env, result, "coalescedWindows", static_cast<double>(pipeline.coalesced_windows));
+    SetNumber(env, result, "deferredReprotects", static_cast<double>(pipeline.deferred_reprotects));
+    SetNumber(env, result, "recordingFailures", static_cast<double>(pipeline.recording_failures));
+    
+    napi_value stages;
+    napi_create_object(env, &stages);
+    napi_set_named_property(env, stages, "faultToUnprotect", StageToObject(env, pipeline.fault_to_unprotect));
+    napi_set_named_property(env, stages, "queueResidency", StageToObject(env, pipeline.queue_residency));
+    napi_set_named_property(env, stages, "enrich", StageToObject(env, pipeline.enrich));
+    napi_set_named_property(env, stages, "persist", StageToObject(env, pipeline.persist));
+    napi_set_named_property(env, stages, "endToEnd", StageToObject(env, pipeline.end_to_end));
+    napi_set_named_property(env, result, "stages", stages);
+    return result;
+}
+
+napi_value VariableIndex(napi_env env, napi_callback_info info) {
+    if (!g_core) {
+        napi_throw_error(env, nullptr, "Watcher core not initialized");
+        return nullptr;
+    }
+    
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    
+    size_t var_id_len = 0;
+    char var_id[256];
+    napi_get_value_string_utf8(env, argv[0], var_id, sizeof(var_id), &var_id_len);
+    
+    napi_value result;
+    napi_create_uint32(env, g_core->variableIndex(std::string(var_id, var_id_len)), &result);
+    return result;
+}
+
+// ============================================================================
+// Event Stream (batches of BinaryEventRecord through a threadsafe function)
+// ============================================================================
+
+// A drain thread copies records out of the core's event channel and hands
+// each batch to the JS callback as one ArrayBuffer; no JS object is built per
+// event. At most max_queued batches wait for the event loop; while they do,
+// records stay in the channel, and once it fills the core drops new ones
+// (counted as channel drops).
+struct EventStream {
+    napi_threadsafe_function tsfn = nullptr;
+    watcher::EventChannel* channel = nullptr;
+    std::thread drainer;
+    std::atomic<bool> running{false};
+    std::atomic<uint32_t> queued{0};      // Batches posted, not yet delivered
+    size_t batch_size = 1024;             // Records per callback (upper bound)
+    uint64_t max_latency_ns = 10000000;   // Oldest pending record waits at most this long
+    uint32_t max_queued = 4;
+    std::atomic<uint64_t> batches{0};     // Batches posted to JS
+    std::atomic<uint64_t> deferred{0};    // Drain rounds skipped for backpressure
+};
+
+static EventStream* g_stream = nullptr;
+
+using RecordBatch = std::vector<watcher::BinaryEventRecord>;
+
+static void FreeBatch(napi_env, void*, void* hint) {
+    delete static_cast<RecordBatch*>(hint);
+}
+
+// Runs on the JS thread; env is null while the threadsafe function is torn down
+static void CallEventCallback(napi_env env, napi_value callback, void* context, void* data) {
+    auto* stream = static_cast<EventStream*>(context);
+    auto* batch = static_cast<RecordBatch*>(data);
+    stream->queued.fetch_sub(1, std::memory_order_relaxed);
+    if (env == nullptr) {
+        delete batch;
+        return;
+    }
+    
+    size_t count = batch->size();
+    size_t bytes = count * sizeof(watcher::BinaryEventRecord);
+    napi_value buffer;
+    if (napi_create_external_arraybuffer(env, batch->data(), bytes, FreeBatch, batch, &buffer) != napi_ok) {
+        // Runtimes with a memory sandbox reject external backing stores
+        void* copy = nullptr;
+        napi_create_arraybuffer(env, bytes, &copy, &buffer);
+        memcpy(copy, batch->data(), bytes);
+        delete batch;
+    }
+    
+    napi_value argv[2];
+    argv[0] = buffer;
+    napi_create_uint32(env, static_cast<uint32_t>(count), &argv[1]);
+    napi_value global;
+    napi_get_global(env, &global);
+    napi_call_function(env, global, callback, 2, argv, nullptr);
+}
+
+static void DrainEvents(EventStream* stream) {
+    auto poll = std::chrono::nanoseconds(std::max<uint64_t>(stream->max_latency_ns / 4, 100000));
+    auto pending_since = std::chrono::steady_clock::time_point();
+    while (stream->running.load(std::memory_order_relaxed)) {
+        uint64_t start = 0;
+        size_t ready = stream->channel->size();
+        if (ready == 0) {
+            pending_since = {};
+            std::this_thread::sleep_for(poll);
+            continue;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (pending_since == std::chrono::steady_clock::time_point()) {
+            pending_since = now;
+        }
+        bool due = ready >= stream->batch_size ||
+                   static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       now - pending_since).count()) >= stream->max_latency_ns;
+        if (!due) {
+            std::this_thread::sleep_for(poll);
+            continue;
+        }
+        if (stream->queued.load(std::memory_order_relaxed) >= stream->max_queued) {
+            stream->deferred.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::sleep_for(poll);
+            continue;
+        }
+        
+        auto* header = static_cast<const watcher::EventChannelHeader*>(stream->channel->base());
+        const auto* slots = reinterpret_cast<const watcher::BinaryEventRecord*>(
+            static_cast<const uint8_t*>(stream->channel->base()) + header->records_offset);
+        auto* batch = new RecordBatch();
+        batch->reserve(std::min(ready, stream->batch_size));
+        // At most two contiguous runs when the batch wraps the ring
+        while (batch->size() < stream->batch_size) {
+            size_t n = std::min(stream->channel->acquire(&start), stream->batch_size - batch->size());
+            if (n == 0) {
+                break;
+            }
+            const auto* first = slots + (start & (stream->channel->capacity() - 1));
+            batch->insert(batch->end(), first, first + n);
+            stream->channel->release(n);
+        }
+        
+        stream->queued.fetch_add(1, std::memory_order_relaxed);
+        if (napi_call_threadsafe_function(stream->tsfn, batch, napi_tsfn_nonblocking) != napi_ok) {
+            stream->queued.fetch_sub(1, std::memory_order_relaxed);
+            delete batch;  // Closing
+            break;
+        }
+        stream->batches.fetch_add(1, std::memory_order_relaxed);
+        pending_since = {};
+    }
+}
+
+static void StopStream() {
+    if (!g_stream) {
+        return;
+    }
+    g_stream->running.store(false);
+    if (g_stream->drainer.joinable()) {
+        g_stream->drainer.join();
+    }
+    napi_release_threadsafe_function(g_stream->tsfn, napi_tsfn_release);
+    g_stream = nullptr;  // Freed by the threadsafe function's finalizer
+}
+
+static void FinalizeStream(napi_env, void* data, void*) {
+    delete static_cast<EventStream*>(data);
+}
+
+static void StopStreamOnExit(void*) {
+    StopStream();
+}
+
+static bool GetUint32Option(napi_env env, napi_value options, const char* name, uint32_t* out) {
+    bool has = false;
+    napi_valuetype type = napi_undefined;
+    if (napi_typeof(env, options, &type) != napi_ok || type != napi_object ||
+        napi_has_named_property(env, options, name, &has) != napi_ok || !has) {
+        return false;
+    }
+    napi_value value;
+    napi_get_named_property(env, options, name, &value);
+    return napi_get_value_uint32(env, value, out) == napi_ok;
+}
+
+// startEventStream(callback(buffer, count), {batchSize, maxLatencyMs, maxQueuedBatches, capacity})
+napi_value StartEventStream(napi_env env, napi_callback_info info) {
+    if (!g_core) {
+        napi_throw_error(env, nullptr, "Watcher core not initialized");
+        return nullptr;
+    }
+    if (g_stream) {
+        napi_throw_error(env, nullptr, "Event stream already running");
+        return nullptr;
+    }
+    
+    size_t argc = 2;
+    napi_value argv[2];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    napi_valuetype type = napi_undefined;
+    if (argc < 1 || napi_typeof(env, argv[0], &type) != napi_ok || type != napi_function) {
+        napi_throw_type_error(env, nullptr, "startEventStream() expects a callback");
+        return nullptr;
+    }
+    napi_value options = argc > 1 ? argv[1] : nullptr;
+    
+    auto stream = std::make_unique<EventStream>();
+    uint32_t value = 0;
+    uint32_t capacity = 0;
+    if (options && GetUint32Option(env, options, "batchSize", &value) && value > 0) {
+        stream->batch_size = value;
+    }
+    if (options && GetUint32Option(env, options, "maxLatencyMs", &value)) {
+        stream->max_latency_ns = static_cast<uint64_t>(value) * 1000000;
+    }
+    if (options && GetUint32Option(env, options, "maxQueuedBatches", &value) && value > 0) {
+        stream->max_queued = value;
+    }
+    if (options) {
+        GetUint32Option(env, options, "capacity", &capacity);
+    }
+    
+    stream->channel = g_core->openEventChannel(capacity);
+    if (!stream->channel) {
+        napi_throw_error(env, nullptr, "Failed to open event channel");
+        return nullptr;
+    }
+    
+    napi_value name;
+    napi_create_string_utf8(env, "watcherEventStream", NAPI_AUTO_LENGTH, &name);
+    napi_status status = napi_create_threadsafe_function(
+        env, argv[0], nullptr, name, 0, 1, stream.get(), FinalizeStream, stream.get(),
+        CallEventCallback, &stream->tsfn);
+    if (status != napi_ok) {
+        napi_throw_error(env, nullptr, "Failed to create event stream");
+        return nullptr;
+    }
+    // Instrumentation must not keep the process alive
+    napi_unref_threadsafe_function(env, stream->tsfn);
+    
+    g_stream = stream.release();
+    g_stream->running.store(true);
+    g_stream->drainer = std::thread(DrainEvents, g_stream);
+    
+    static bool cleanup_registered = false;
+    if (!cleanup_registered) {
+        napi_add_env_cleanup_hook(env, StopStreamOnExit, nullptr);
+        cleanup_registered = true;
+    }
+    
+    napi_value result;
+    napi_get_boolean(env, true, &result);
+    return result;
+}
+
+napi_value StopEventStream(napi_env env, napi_callback_info info) {
+    bool was_running = g_stream != nullptr;
+    StopStream();
+    napi_value result;
+    napi_get_boolean(env, was_running, &result);
+    return result;
+}
+
+// Stream counters; dropped counts records the core lost to a full channel
+napi_value GetEventStreamStats(napi_env env, napi_callback_info info) {
+    napi_value result;
+    napi_create_object(env, &result);
+    if (!g_stream) {
+        return result;
+    }
+    SetNumber(env, result, "batches", static_cast<double>(g_stream->batches.load()));
+    SetNumber(env, result, "queuedBatches", g_stream->queued.load());
+    SetNumber(env, result, "deferred", static_cast<double>(g_stream->deferred.load()));
+    SetNumber(env, result, "pending", static_cast<double>(g_stream->channel->size()));
+    SetNumber(env, result, "dropped", static_cast<double>(g_stream->channel->dropped()));
+    return result;
+}
+
 #define DECLARE_NAPI_METHOD(name, func) \
   { name, 0, func, 0, 0, 0, napi_default, 0 }
 
@@ -147,7 +506,13 @@ static napi_value Init(napi_env env, napi_value exports) {
         DECLARE_NAPI_METHOD("stop", Stop),
         DECLARE_NAPI_METHOD("registerPage", RegisterPage),
         DECLARE_NAPI_METHOD("unregisterPage", UnregisterPage),
+        DECLARE_NAPI_METHOD("setSamplingPolicy", SetSamplingPolicy),
         DECLARE_NAPI_METHOD("getState", GetState),
+        DECLARE_NAPI_METHOD("getMetrics", GetMetrics),
+        DECLARE_NAPI_METHOD("variableIndex", VariableIndex),
+        DECLARE_NAPI_METHOD("startEventStream", StartEventStream),
+        DECLARE_NAPI_METHOD("stopEventStream", StopEventStream),
+        DECLARE_NAPI_METHOD("getEventStreamStats", GetEventStreamStats),
     };
     
     status = napi_define_properties(
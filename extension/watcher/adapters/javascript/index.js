@@ -23,6 +23,40 @@ function getBinding() {
     return binding;
 }
 
+// ============================================================================
+// Event Batches (BinaryEventRecord, 64 bytes each)
+// ============================================================================
+
+// Record layout, in 64-bit words: eventSeq, timestampNs, pageBase, faultAddr,
+// ip; then 32-bit words from byte 40: tid, varIndex, varCount, deltaRuns,
+// deltaBytes, flags
+const RECORD_SIZE = 64;
+
+/**
+ * One batch from the native event stream. Fields are read straight out of
+ * the ArrayBuffer; nothing is allocated per event. byteOffset (a multiple
+ * of 8) locates the records inside a larger buffer such as a processor batch.
+ */
+class EventBatch {
+    constructor(buffer, count, byteOffset = 0) {
+        this.buffer = buffer;
+        this.count = count;
+        this.u64 = new BigUint64Array(buffer, byteOffset, count * 8);
+        this.u32 = new Uint32Array(buffer, byteOffset, count * 16);
+    }
+    
+    eventSeq(i) { return this.u64[i * 8]; }
+    timestampNs(i) { return this.u64[i * 8 + 1]; }
+    pageBase(i) { return this.u64[i * 8 + 2]; }
+    faultAddr(i) { return this.u64[i * 8 + 3]; }
+    ip(i) { return this.u64[i * 8 + 4]; }
+    tid(i) { return this.u32[i * 16 + 10]; }
+    varIndex(i) { return this.u32[i * 16 + 11]; }
+    varCount(i) { return this.u32[i * 16 + 12]; }
+    deltaRuns(i) { return this.u32[i * 16 + 13]; }
+    deltaBytes(i) { return this.u32[i * 16 + 14]; }
+}
+
 // ============================================================================
 // SQL Context Manager (AsyncLocalStorage)
 // ============================================================================
@@ -263,12 +297,23 @@ class WatcherCore {
             flags |= FLAG_TRACK_SQL;
         }
         
+        // 'FULL' tracks the whole page; a number tracks only that many
+        // leading bytes (snapshotted and diffed by the core)
+        let byteRange = 0;
+        if (mutationDepth !== 'FULL') {
+            byteRange = Number(mutationDepth);
+            if (!Number.isInteger(byteRange) || byteRange <= 0 || byteRange > PAGE_SIZE) {
+                throw new RangeError(`mutationDepth must be 'FULL' or 1..${PAGE_SIZE}, got ${mutationDepth}`);
+            }
+        }
+        
         // Register with C++ core
         const varID = this.core.registerPage(
             pageBase,
             pageSize,
             name,
-            flags
+            flags,
+            byteRange
         );
         
         if (!varID || varID.startsWith('Error')) {
@@ -279,6 +324,7 @@ class WatcherCore {
         this.variables.set(varID, {
             buffer: actualBuffer,
             name: name,
+            index: this.core.variableIndex(varID),
             registered: Date.now()
         });
         
@@ -289,7 +335,74 @@ class WatcherCore {
         return this.core.unregisterPage(varID);
     }
     
+    /**
+     * Limit the events recorded for a hot variable: one of
+     * { every: n }, { maxPerSecond: k } or { coalesceUs: window }, or {}
+     * to record every write again. Skipped writes are folded into the next
+     * event's deltas and counted in getMetrics().policyDrops.
+     */
+    setSampling(varID, policy = {}) {
+        const modes = [['every', 1], ['maxPerSecond', 2], ['coalesceUs', 3]]
+            .filter(([key]) => policy[key] !== undefined);
+        if (modes.length > 1) {
+            throw new RangeError('Pass only one of every, maxPerSecond, coalesceUs');
+        }
+        const [key, mode] = modes.length ? modes[0] : [null, 0];
+        const value = key ? Number(policy[key]) : 0;
+        if (key && (!Number.isInteger(value) || value < 1 || value > 0xffffffff)) {
+            throw new RangeError(`${key} must be a positive integer, got ${policy[key]}`);
+        }
+        if (!this.core.setSamplingPolicy(varID, mode,
+                                         mode === 1 ? value : 0,
+                                         mode === 2 ? value : 0,
+                                         mode === 3 ? value : 0)) {
+            throw new Error(`Unknown variable: ${varID}`);
+        }
+    }
+    
+    /**
+     * Deliver events to callback(batch) as EventBatch objects.
+     *
+     * A native thread drains the core and calls back on the event loop once
+     * batchSize events are pending or the oldest has waited maxLatencyMs.
+     * While maxQueuedBatches batches await the event loop, events stay in
+     * the core's channel (capacity records); beyond that the core drops them
+     * (see getEventStreamStats().dropped). Does not keep the process alive.
+     */
+    onEvents(callback, options = {}) {
+        const {
+            batchSize = 1024,
+            maxLatencyMs = 10,
+            maxQueuedBatches = 4,
+            capacity = 0
+        } = options;
+        
+        return this.core.startEventStream(
+            (buffer, count) => callback(new EventBatch(buffer, count)),
+            { batchSize, maxLatencyMs, maxQueuedBatches, capacity }
+        );
+    }
+    
+    offEvents() {
+        return this.core.stopEventStream();
+    }
+    
+    // batches, queuedBatches, deferred (backpressure rounds), pending, dropped
+    getEventStreamStats() {
+        return this.core.getEventStreamStats();
+    }
+    
+    /** var_index from EventBatch.varIndex() -> variable ID */
+    variableForIndex(index) {
+        for (const [varID, info] of this.variables) {
+            if (info.index === index) return varID;
+        }
+        return null;
+    }
+    
     stop() {
+        this.core.stopEventStream();
+        
         // Unregister all variables
         for (const varID of this.variables.keys()) {
             this.core.unregisterPage(varID);
@@ -300,6 +413,11 @@ class WatcherCore {
         return this.core.stop();
     }
     
+    // Counters plus per-stage latency percentiles (ns) under .stages
+    getMetrics() {
+        return this.core.getMetrics();
+    }
+    
     getState() {
         const stateCodes = [
             'UNINITIALIZED',
@@ -324,5 +442,7 @@ function watch(buffer, options) {
 module.exports = {
     watch,
     WatcherCore,
+    EventBatch,
+    RECORD_SIZE,
     SQLContextManager: sqlContext,
 };
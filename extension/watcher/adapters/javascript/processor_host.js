@@ -0,0 +1,280 @@
+/**
+ * Watcher Processor Host
+ * Runs a JavaScript processor script on packed event batches
+ *
+ * Started by the core (processor/javascript_host.cpp) as
+ *     node processor_host.js <script>
+ * with a socket on fd 3. Every frame is a u32 length followed by the payload:
+ *
+ *     host -> core   hello: u8 ok, then the error text if !ok
+ *     core -> host   one packed batch (processor/include/processor_batch.hpp)
+ *     host -> core   u32 count, u8 actions[count], then annotations until the
+ *                    end of the frame: u32 event, u8 type, u32 key length,
+ *                    key, value (i64 | f64 | u32 length + UTF-8 bytes)
+ *
+ * A script exports either:
+ *
+ *     main_batch(batch)   Whole batch: batch.records (EventBatch),
+ *                         batch.event(i), batch.drop(i), batch.annotate(i, {...})
+ *     main(event)         Per event object (keys as in the JSONL output),
+ *                         returning {action: 'pass' | 'drop' | 'annotate' |
+ *                         'enrich', annotations: {...}, extra: {...}}
+ *
+ * Either may be async; batches are handled one at a time.
+ */
+
+'use strict';
+
+const net = require('net');
+const path = require('path');
+const { EventBatch } = require('./index.js');
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+const BATCH_MAGIC = 0x42505357;
+const TEXT_SIZE = 32;
+
+// Values of the action bytes (watcher_processor_abi.h)
+const ACTION_PASS = 0;
+const ACTION_ANNOTATE = 1;
+const ACTION_ENRICH = 2;
+const ACTION_DROP = 3;
+const ACTIONS = { pass: ACTION_PASS, annotate: ACTION_ANNOTATE, enrich: ACTION_ENRICH, drop: ACTION_DROP };
+
+// AnnotationType in processor.hpp
+const ANNOTATION_INT = 0;
+const ANNOTATION_DOUBLE = 1;
+const ANNOTATION_STRING = 2;
+
+const SHARD_SHIFT = 56n;
+
+function formatEventId(eventSeq) {
+    const shard = eventSeq >> SHARD_SHIFT;
+    const count = eventSeq & ((1n << SHARD_SHIFT) - 1n);
+    return shard ? `evt-${shard}-${count}` : `evt-${count}`;
+}
+
+// ============================================================================
+// Processor Batch
+// ============================================================================
+
+class ProcessorBatch {
+    constructor(buffer) {
+        // buffer is an ArrayBuffer holding exactly one packed batch
+        const header = new Uint32Array(buffer, 0, 8);
+        if (header[0] !== BATCH_MAGIC || header[6] !== buffer.byteLength) {
+            throw new Error('Malformed processor batch');
+        }
+        this.count = header[1];
+        this.records = new EventBatch(buffer, this.count, header[2]);
+        this.text = new DataView(buffer, header[3], this.count * TEXT_SIZE);
+        this.strings = new Uint8Array(buffer, header[4], header[5] - header[4]);
+        this.deltas = new DataView(buffer, header[5], header[6] - header[5]);
+        this.actions = new Uint8Array(this.count);
+        this.annotations = [];
+    }
+
+    string(offset) {
+        const end = this.strings.indexOf(0, offset);
+        return Buffer.from(this.strings.buffer, this.strings.byteOffset + offset, end - offset).toString('utf8');
+    }
+
+    /** Event i keyed like the JSONL output */
+    event(i) {
+        const r = this.records;
+        const t = i * TEXT_SIZE;
+        const variableIds = [];
+        let ids = this.text.getUint32(t + 16, true);
+        for (let k = 0; k < r.varCount(i); k++) {
+            const id = this.string(ids);
+            variableIds.push(id);
+            ids = this.strings.indexOf(0, ids) + 1;
+        }
+        const deltas = [];
+        let pos = this.text.getUint32(t + 20, true);
+        for (let k = 0; k < r.deltaRuns(i); k++) {
+            const offset = this.deltas.getUint32(pos, true);
+            const len = this.deltas.getUint32(pos + 4, true);
+            const bytes = Buffer.from(this.deltas.buffer, this.deltas.byteOffset + pos + 8, 2 * len);
+            deltas.push({
+                offset,
+                len,
+                before: bytes.subarray(0, len).toString('hex'),
+                after: bytes.subarray(len).toString('hex'),
+            });
+            pos += 8 + 2 * len;
+        }
+        const event = {
+            event_id: formatEventId(r.eventSeq(i)),
+            timestamp_ns: Number(r.timestampNs(i)),
+            variable_id: variableIds.length ? variableIds[0] : '',
+            variable_ids: variableIds,
+            variable_name: this.string(this.text.getUint32(t + 8, true)),
+            function: this.string(this.text.getUint32(t, true)),
+            file: this.string(this.text.getUint32(t + 4, true)),
+            line: this.text.getInt32(t + 24, true),
+            ip: Number(r.ip(i)),
+            tid: r.tid(i),
+            page_base: '0x' + r.pageBase(i).toString(16),
+            fault_addr: '0x' + r.faultAddr(i).toString(16),
+            deltas,
+        };
+        const sql = this.text.getUint32(t + 12, true);
+        if (sql) {
+            event.sql_context_id = this.string(sql);
+        }
+        return event;
+    }
+
+    drop(i) { this.actions[i] = ACTION_DROP; }
+
+    annotate(i, annotations) {
+        this.actions[i] = ACTION_ANNOTATE;
+        this.annotations.push([i, annotations || {}]);
+    }
+
+    enrich(i, extra) {
+        this.actions[i] = ACTION_ENRICH;
+        this.annotations.push([i, extra || {}]);
+    }
+
+    /** Reply frame payload: count, actions, annotations */
+    encodeReply() {
+        const parts = [];
+        const head = Buffer.alloc(4);
+        head.writeUInt32LE(this.count, 0);
+        parts.push(head, Buffer.from(this.actions.buffer, 0, this.count));
+        for (const [event, values] of this.annotations) {
+            for (const [key, value] of Object.entries(values)) {
+                parts.push(encodeAnnotation(event, key, value));
+            }
+        }
+        return Buffer.concat(parts);
+    }
+}
+
+/** int (integers, bools, bigints), double, or string; others as JSON text */
+function encodeAnnotation(event, key, value) {
+    const keyBytes = Buffer.from(key, 'utf8');
+    let type;
+    let valueBytes;
+    if (typeof value === 'boolean' || typeof value === 'bigint' ||
+        (typeof value === 'number' && Number.isSafeInteger(value))) {
+        type = ANNOTATION_INT;
+        valueBytes = Buffer.alloc(8);
+        valueBytes.writeBigInt64LE(BigInt.asIntN(64, BigInt(value)), 0);
+    } else if (typeof value === 'number') {
+        type = ANNOTATION_DOUBLE;
+        valueBytes = Buffer.alloc(8);
+        valueBytes.writeDoubleLE(value, 0);
+    } else {
+        const text = Buffer.from(typeof value === 'string' ? value : String(JSON.stringify(value)), 'utf8');
+        type = ANNOTATION_STRING;
+        valueBytes = Buffer.alloc(4 + text.length);
+        valueBytes.writeUInt32LE(text.length, 0);
+        text.copy(valueBytes, 4);
+    }
+    const head = Buffer.alloc(9);
+    head.writeUInt32LE(event, 0);
+    head.writeUInt8(type, 4);
+    head.writeUInt32LE(keyBytes.length, 5);
+    return Buffer.concat([head, keyBytes, valueBytes]);
+}
+
+// ============================================================================
+// Script Loading
+// ============================================================================
+
+function loadHandler(scriptPath) {
+    const module = require(path.resolve(scriptPath));
+    if (typeof module.main_batch === 'function') {
+        return module.main_batch;
+    }
+    if (typeof module.main !== 'function') {
+        throw new Error(`${scriptPath} exports neither main(event) nor main_batch(batch)`);
+    }
+    const main = module.main;
+    return async (batch) => {
+        for (let i = 0; i < batch.count; i++) {
+            let response;
+            try {
+                response = (await main(batch.event(i))) || {};
+            } catch (e) {
+                continue;  // A failing event passes
+            }
+            const action = ACTIONS[response.action] ?? ACTION_PASS;
+            if (action === ACTION_ANNOTATE) {
+                batch.annotate(i, response.annotations);
+            } else if (action === ACTION_ENRICH) {
+                batch.enrich(i, response.extra);
+            } else {
+                batch.actions[i] = action;
+            }
+        }
+    };
+}
+
+// ============================================================================
+// Framing
+// ============================================================================
+
+function frame(payload) {
+    const head = Buffer.alloc(4);
+    head.writeUInt32LE(payload.length, 0);
+    return Buffer.concat([head, payload]);
+}
+
+function run() {
+    const socket = new net.Socket({ fd: 3, readable: true, writable: true });
+    let handler;
+    try {
+        handler = loadHandler(process.argv[2]);
+    } catch (e) {
+        socket.end(frame(Buffer.concat([Buffer.from([0]), Buffer.from(String(e && e.stack || e), 'utf8')])));
+        return;
+    }
+    socket.write(frame(Buffer.from([1])));
+
+    let pending = Buffer.alloc(0);
+    const queue = [];
+    let busy = false;
+
+    async function drain() {
+        if (busy) return;
+        busy = true;
+        while (queue.length) {
+            const payload = queue.shift();
+            // Copy into an ArrayBuffer of its own so the typed views are aligned
+            const buffer = new ArrayBuffer(payload.length);
+            payload.copy(Buffer.from(buffer));
+            let reply;
+            try {
+                const batch = new ProcessorBatch(buffer);
+                await handler(batch);
+                reply = batch.encodeReply();
+            } catch (e) {
+                console.error(`[watcher] processor failed: ${e && e.stack || e}`);
+                reply = Buffer.alloc(4, 0xff);  // count 0xffffffff: batch failed
+            }
+            socket.write(frame(reply));
+        }
+        busy = false;
+    }
+
+    socket.on('data', (chunk) => {
+        pending = pending.length ? Buffer.concat([pending, chunk]) : chunk;
+        while (pending.length >= 4) {
+            const length = pending.readUInt32LE(0);
+            if (pending.length < 4 + length) break;
+            queue.push(pending.subarray(4, 4 + length));
+            pending = pending.subarray(4 + length);
+        }
+        drain();
+    });
+    socket.on('end', () => process.exit(0));
+    socket.on('error', () => process.exit(1));
+}
+
+run();
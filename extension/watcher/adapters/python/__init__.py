@@ -10,7 +10,7 @@ import struct
 import threading
 import weakref
 from pathlib import Path
-from typing import Any, Optional, Dict, Callable, List, Tuple
+from typing import Any, Optional, Dict, Callable, List, Tuple, Union
 from dataclasses import dataclass
 import pickle
 import json
@@ -19,6 +19,21 @@ import json
 # FFI Bindings to C++ Core
 # ============================================================================
 
+# Bytes per id in watcher_register_pages output (VARIABLE_ID_MAX in ffi.hpp)
+VARIABLE_ID_MAX = 64
+
+
+class _Range(ctypes.Structure):
+    """WatcherRange in ffi.hpp"""
+    _fields_ = [
+        ("base", ctypes.c_void_p),
+        ("len", ctypes.c_size_t),
+        ("name", ctypes.c_char_p),
+        ("flags", ctypes.c_uint32),
+        ("byte_range", ctypes.c_size_t),
+    ]
+
+
 class WatcherFFI:
     """FFI interface to the C++ watcher core"""
     
@@ -55,8 +70,28 @@ class WatcherFFI:
             ]
             cls._lib.watcher_register_page.restype = ctypes.c_char_p
             
+            cls._lib.watcher_register_page_ex.argtypes = [
+                ctypes.c_void_p, ctypes.c_size_t, ctypes.c_char_p, ctypes.c_uint32, ctypes.c_size_t
+            ]
+            cls._lib.watcher_register_page_ex.restype = ctypes.c_char_p
+            
+            cls._lib.watcher_register_range.argtypes = [
+                ctypes.c_void_p, ctypes.c_size_t, ctypes.c_char_p, ctypes.c_uint32
+            ]
+            cls._lib.watcher_register_range.restype = ctypes.c_char_p
+            
+            cls._lib.watcher_register_pages.argtypes = [
+                ctypes.POINTER(_Range), ctypes.c_size_t, ctypes.c_char_p, ctypes.c_size_t
+            ]
+            cls._lib.watcher_register_pages.restype = ctypes.c_size_t
+            
             cls._lib.watcher_unregister_page.argtypes = [ctypes.c_char_p]
             cls._lib.watcher_unregister_page.restype = ctypes.c_bool
+
+            cls._lib.watcher_set_sampling_policy.argtypes = [
+                ctypes.c_char_p, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32
+            ]
+            cls._lib.watcher_set_sampling_policy.restype = ctypes.c_bool
             
             cls._lib.watcher_read_snapshot.argtypes = [ctypes.c_char_p, ctypes.POINTER(ctypes.c_size_t)]
             cls._lib.watcher_read_snapshot.restype = ctypes.c_void_p
@@ -64,6 +99,45 @@ class WatcherFFI:
             cls._lib.watcher_write_snapshot.argtypes = [ctypes.c_char_p, ctypes.c_void_p, ctypes.c_size_t]
             cls._lib.watcher_write_snapshot.restype = ctypes.c_bool
             
+            cls._lib.watcher_read_snapshot_into.argtypes = [ctypes.c_char_p, ctypes.c_void_p, ctypes.c_size_t]
+            cls._lib.watcher_read_snapshot_into.restype = ctypes.c_size_t
+            
+            cls._lib.watcher_read_snapshots.argtypes = [
+                ctypes.POINTER(ctypes.c_char_p), ctypes.c_size_t, ctypes.POINTER(ctypes.c_void_p),
+                ctypes.POINTER(ctypes.c_size_t), ctypes.POINTER(ctypes.c_size_t)
+            ]
+            cls._lib.watcher_read_snapshots.restype = ctypes.c_size_t
+            
+            cls._lib.watcher_dequeue_fast_path_event.argtypes = []
+            cls._lib.watcher_dequeue_fast_path_event.restype = ctypes.c_char_p
+            
+            cls._lib.watcher_dequeue_events.argtypes = [ctypes.c_size_t, ctypes.POINTER(ctypes.c_size_t)]
+            cls._lib.watcher_dequeue_events.restype = ctypes.c_char_p
+            
+            cls._lib.watcher_open_event_channel.argtypes = [
+                ctypes.c_size_t, ctypes.POINTER(ctypes.c_size_t), ctypes.POINTER(ctypes.c_void_p)
+            ]
+            cls._lib.watcher_open_event_channel.restype = ctypes.c_void_p
+            cls._lib.watcher_event_channel_fd.argtypes = []
+            cls._lib.watcher_event_channel_fd.restype = ctypes.c_int
+            cls._lib.watcher_event_channel_acquire.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint64)]
+            cls._lib.watcher_event_channel_acquire.restype = ctypes.c_size_t
+            cls._lib.watcher_event_channel_release.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+            cls._lib.watcher_event_channel_release.restype = None
+            cls._lib.watcher_variable_index.argtypes = [ctypes.c_char_p]
+            cls._lib.watcher_variable_index.restype = ctypes.c_uint32
+            cls._lib.watcher_resolve_symbol.argtypes = [
+                ctypes.c_uint64, ctypes.c_char_p, ctypes.c_size_t,
+                ctypes.c_char_p, ctypes.c_size_t, ctypes.POINTER(ctypes.c_int)
+            ]
+            cls._lib.watcher_resolve_symbol.restype = ctypes.c_bool
+            
+            cls._lib.watcher_load_processor.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
+            cls._lib.watcher_load_processor.restype = ctypes.c_char_p
+            
+            cls._lib.watcher_get_metrics_json.argtypes = []
+            cls._lib.watcher_get_metrics_json.restype = ctypes.c_char_p
+            
             cls._lib.watcher_get_state.restype = ctypes.c_int
             cls._lib.watcher_get_error.restype = ctypes.c_char_p
             
@@ -80,6 +154,16 @@ FLAG_TRACK_LOCALS = 1 << 3
 
 PAGE_SIZE = 4096
 
+
+def _byte_range(mutation_depth: Union[str, int]) -> int:
+    """MutationDepth byte_range for a watch(): 0 tracks the whole page"""
+    if mutation_depth == "FULL":
+        return 0
+    byte_range = int(mutation_depth)
+    if not 0 < byte_range <= PAGE_SIZE:
+        raise ValueError(f"mutation_depth must be 'FULL' or 1..{PAGE_SIZE}, got {mutation_depth}")
+    return byte_range
+
 # ============================================================================
 # Shadow Memory Manager
 # ============================================================================
@@ -425,6 +509,7 @@ class WatcherCore:
         self.track_sql = False
         self.track_locals = False
         self.track_threads = False
+        self.mutation_depth = "FULL"
         self.scope_config: Optional[Dict[str, List[Dict[str, str]]]] = None
 
         WatcherCore._initialized = True
@@ -442,11 +527,14 @@ class WatcherCore:
                   track_threads: bool = False,
                   track_locals: bool = False,
                   track_sql: bool = False,
-                  scope_config: Optional[Dict[str, List[Dict[str, str]]]] = None):
+                  scope_config: Optional[Dict[str, List[Dict[str, str]]]] = None,
+                  mutation_depth: Union[str, int] = "FULL"):
         """Initialize the watcher core"""
         self.track_threads = track_threads
         self.track_locals = track_locals
         self.track_sql = track_sql
+        self.mutation_depth = mutation_depth
+        _byte_range(mutation_depth)  # Validate now rather than on first watch()
         self.scope_config = scope_config
 
         # Create output directory
@@ -468,7 +556,7 @@ class WatcherCore:
              track_threads: Optional[bool] = None,
              track_locals: Optional[bool] = None,
              track_sql: Optional[bool] = None,
-             mutation_depth: str = "FULL",
+             mutation_depth: Optional[Union[str, int]] = None,
              scope: Optional[str] = None,
              file_path: Optional[str] = None) -> WatchProxy:
         """
@@ -484,7 +572,8 @@ class WatcherCore:
             track_threads: Whether to track thread context (default: from core config)
             track_locals: Whether to track local scope (default: from core config)
             track_sql: Whether to track SQL context (default: from core config)
-            mutation_depth: "FULL" for full page or byte count
+            mutation_depth: "FULL" for the full page, or the number of leading
+                            bytes to snapshot and diff (default: from core config)
             scope: Variable scope (local/global/both/unknown)
             file_path: File path where variable is defined (used for scope config matching)
 
@@ -494,28 +583,15 @@ class WatcherCore:
         # Create shadow memory
         shadow = ShadowMemory(value)
 
-        # Prepare flags
-        flags = 0
-        if track_threads is None:
-            track_threads = self.track_threads
-        if track_locals is None:
-            track_locals = self.track_locals
-        if track_sql is None:
-            track_sql = self.track_sql
-
-        if track_threads:
-            flags |= FLAG_TRACK_THREADS
-        if track_locals:
-            flags |= FLAG_TRACK_LOCALS
-        if track_sql:
-            flags |= FLAG_TRACK_SQL
+        flags = self._flags(track_threads, track_locals, track_sql)
 
         # Register with C++ core
-        var_id = self.lib.watcher_register_page(
+        var_id = self.lib.watcher_register_page_ex(
             shadow.page_base,
             PAGE_SIZE,
             name.encode(),
-            flags
+            flags,
+            _byte_range(self.mutation_depth if mutation_depth is None else mutation_depth)
         ).decode()
 
         if not var_id or var_id.startswith("Error"):
@@ -527,6 +603,137 @@ class WatcherCore:
 
         return proxy
     
+    def watch_many(self, values: Dict[str, Any], *,
+                   track_threads: Optional[bool] = None,
+                   track_locals: Optional[bool] = None,
+                   track_sql: Optional[bool] = None,
+                   mutation_depth: Optional[Union[str, int]] = None) -> Dict[str, WatchProxy]:
+        """
+        Watch many variables with one registration call
+
+        Instrumenting a module at startup registers its variables in one
+        batch (one core lock and one index rebuild) instead of one by one.
+
+        Args:
+            values: Variable name -> value
+            track_threads / track_locals / track_sql / mutation_depth: As for watch()
+
+        Returns:
+            Variable name -> WatchProxy
+        """
+        flags = self._flags(track_threads, track_locals, track_sql)
+        byte_range = _byte_range(self.mutation_depth if mutation_depth is None else mutation_depth)
+        names = list(values)
+        shadows = [ShadowMemory(values[name]) for name in names]
+        encoded = [name.encode() for name in names]
+
+        ranges = (_Range * len(names))()
+        for i, shadow in enumerate(shadows):
+            ranges[i].base = shadow.page_base
+            ranges[i].len = PAGE_SIZE
+            ranges[i].name = encoded[i]
+            ranges[i].flags = flags
+            ranges[i].byte_range = byte_range
+
+        ids = ctypes.create_string_buffer(VARIABLE_ID_MAX * len(names))
+        self.lib.watcher_register_pages(ranges, len(names), ids, VARIABLE_ID_MAX)
+
+        proxies = {}
+        failed = []
+        for i, name in enumerate(names):
+            var_id = ids.raw[i * VARIABLE_ID_MAX:(i + 1) * VARIABLE_ID_MAX].split(b'\0', 1)[0].decode()
+            if not var_id:
+                failed.append(name)
+                continue
+            proxy = WatchProxy(shadows[i], var_id, name)
+            self.variables[var_id] = (shadows[i], proxy)
+            proxies[name] = proxy
+        if failed:
+            raise RuntimeError(f"Failed to register variables: {', '.join(failed)}")
+        return proxies
+
+    def read_snapshots(self, var_ids: List[str]) -> Dict[str, bytes]:
+        """
+        Read the core's snapshots of many variables with one call
+
+        Snapshots are written straight into buffers allocated here.
+
+        Returns:
+            Variable ID -> snapshot bytes (unknown IDs are omitted)
+        """
+        count = len(var_ids)
+        buffers = [ctypes.create_string_buffer(PAGE_SIZE) for _ in var_ids]
+        ids = (ctypes.c_char_p * count)(*[var_id.encode() for var_id in var_ids])
+        pointers = (ctypes.c_void_p * count)(*[ctypes.addressof(b) for b in buffers])
+        capacities = (ctypes.c_size_t * count)(*([PAGE_SIZE] * count))
+        lens = (ctypes.c_size_t * count)()
+        self.lib.watcher_read_snapshots(ids, count, pointers, capacities, lens)
+
+        snapshots = {}
+        for i, var_id in enumerate(var_ids):
+            if lens[i] > PAGE_SIZE:
+                # Larger than a page (a range); read it at its full size
+                buffers[i] = ctypes.create_string_buffer(lens[i])
+                lens[i] = self.lib.watcher_read_snapshot_into(var_id.encode(), buffers[i], lens[i])
+            if lens[i]:
+                snapshots[var_id] = buffers[i].raw[:lens[i]]
+        return snapshots
+
+    def set_sampling(self, var_id: str, *, every: Optional[int] = None,
+                     max_per_second: Optional[int] = None,
+                     coalesce_us: Optional[int] = None):
+        """
+        Limit the events recorded for a hot variable
+
+        Skipped writes are not lost: the next recorded event's deltas cover
+        everything written since the last one. Skips are counted as
+        'policy_drops' in get_metrics(), apart from 'events_dropped'.
+
+        Args:
+            var_id: Variable ID (as keyed in self.variables)
+            every: Record every n-th write
+            max_per_second: Record at most this many events per second
+            coalesce_us: Leave the page writable for this long after a write,
+                         then record one event with the combined delta
+
+        Pass none of them to record every write again.
+
+        Raises:
+            ValueError: More than one policy, or a value below 1
+            RuntimeError: Unknown variable
+        """
+        given = [(mode, value) for mode, value in ((1, every), (2, max_per_second), (3, coalesce_us))
+                 if value is not None]
+        if len(given) > 1:
+            raise ValueError("Pass only one of every, max_per_second, coalesce_us")
+        mode, value = (given[0][0], int(given[0][1])) if given else (0, 0)
+        if given and value < 1:
+            raise ValueError(f"Sampling parameter must be at least 1, got {value}")
+        if not self.lib.watcher_set_sampling_policy(var_id.encode(), mode,
+                                                    value if mode == 1 else 0,
+                                                    value if mode == 2 else 0,
+                                                    value if mode == 3 else 0):
+            raise RuntimeError(f"Unknown variable: {var_id}")
+
+    def _flags(self, track_threads: Optional[bool], track_locals: Optional[bool],
+               track_sql: Optional[bool]) -> int:
+        """Event flags, falling back to the core-wide defaults"""
+        if track_threads is None:
+            track_threads = self.track_threads
+        if track_locals is None:
+            track_locals = self.track_locals
+        if track_sql is None:
+            track_sql = self.track_sql
+
+        flags = 0
+        if track_threads:
+            flags |= FLAG_TRACK_THREADS
+        if track_locals:
+            flags |= FLAG_TRACK_LOCALS
+        if track_sql:
+            flags |= FLAG_TRACK_SQL
+        return flags
+
     def stop(self):
         """Stop the watcher"""
         # Unregister all variables
@@ -537,6 +744,38 @@ class WatcherCore:
         # Stop core
         return self.lib.watcher_stop()
     
+    def load_processor(self, library_path: Optional[str], config: str = ""):
+        """Run a processor on the slow path
+        
+        Its DROP verdicts filter events before they are persisted or handed
+        out, so dropped events never cross into Python. A .py or .js script
+        runs on the core's script host (one interpreter crossing per batch,
+        see watcher/core/processor_host.py); anything else is loaded as a
+        compiled processor (watcher_processor_abi.h).
+        
+        Args:
+            library_path: Processor script, shared library exporting
+                          watcher_processor_entry, or None to remove the
+                          current processor
+            config: String passed to a library's create()
+        
+        Raises:
+            RuntimeError: The processor could not be loaded
+        """
+        path = os.fspath(library_path).encode() if library_path is not None else None
+        result = self.lib.watcher_load_processor(path, config.encode()).decode()
+        if result != "OK":
+            raise RuntimeError(f"Failed to load processor: {result}")
+    
+    def get_metrics(self) -> Dict[str, Any]:
+        """Get core counters and per-stage latency percentiles
+        
+        Returns:
+            Dict of counters plus 'stages', mapping each pipeline stage to
+            count/min_ns/max_ns/mean_ns/p50_ns/p90_ns/p99_ns/p999_ns
+        """
+        return json.loads(self.lib.watcher_get_metrics_json().decode())
+    
     def get_state(self) -> str:
         """Get core state"""
         state_codes = {
@@ -1,9 +1,13 @@
 #include "watcher_core.hpp"
+#include "processor.hpp"
+#include "ffi.hpp"
 #include <string>
 #include <vector>
 #include <cstdint>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <cstring>
 
 extern "C" {
 
@@ -26,11 +30,11 @@ bool watcher_stop() {
     return watcher::WatcherCore::getInstance().stop();
 }
 
-const char* watcher_register_page(void* page_base, size_t page_size,
-                                  const char* name, uint32_t flags) {
+const char* watcher_register_page_ex(void* page_base, size_t page_size,
+                                     const char* name, uint32_t flags, size_t byte_range) {
     static thread_local std::string last_id;
 
-    watcher::MutationDepth depth{true, 0};
+    watcher::MutationDepth depth{byte_range == 0, byte_range};
     last_id = watcher::WatcherCore::getInstance().registerPage(
         page_base, page_size, name, static_cast<watcher::EventFlags>(flags), depth
     );
@@ -41,21 +45,90 @@ const char* watcher_register_page(void* page_base, size_t page_size,
     return last_id.c_str();
 }
 
+const char* watcher_register_page(void* page_base, size_t page_size,
+                                  const char* name, uint32_t flags) {
+    return watcher_register_page_ex(page_base, page_size, name, flags, 0);
+}
+
+const char* watcher_register_range(void* base, size_t len,
+                                   const char* name, uint32_t flags) {
+    static thread_local std::string last_id;
+
+    watcher::MutationDepth depth{true, 0};
+    last_id = watcher::WatcherCore::getInstance().registerRange(
+        base, len, name, static_cast<watcher::EventFlags>(flags), depth
+    );
+
+    if (last_id.empty()) {
+        last_id = "Error: range registration failed";
+    }
+    return last_id.c_str();
+}
+
+size_t watcher_register_pages(const watcher::python::WatcherRange* ranges, size_t count,
+                              char* out_ids, size_t id_stride) {
+    std::vector<watcher::RangeRegistration> batch(count);
+    for (size_t i = 0; i < count; ++i) {
+        batch[i] = watcher::RangeRegistration{
+            ranges[i].base, ranges[i].len, ranges[i].name,
+            static_cast<watcher::EventFlags>(ranges[i].flags),
+            watcher::MutationDepth{ranges[i].byte_range == 0, ranges[i].byte_range}
+        };
+    }
+    
+    std::vector<std::string> ids;
+    size_t registered = watcher::WatcherCore::getInstance().registerRanges(batch.data(), count, ids);
+    for (size_t i = 0; i < count && id_stride > 0; ++i) {
+        size_t n = std::min(ids[i].size(), id_stride - 1);
+        memcpy(out_ids + i * id_stride, ids[i].data(), n);
+        out_ids[i * id_stride + n] = '\0';
+    }
+    return registered;
+}
+
 bool watcher_unregister_page(const char* variable_id) {
     return watcher::WatcherCore::getInstance().unregisterPage(variable_id);
 }
 
+bool watcher_set_sampling_policy(const char* variable_id, uint32_t mode, uint32_t every_n,
+                                 uint32_t max_per_second, uint32_t window_us) {
+    watcher::SamplingPolicy policy;
+    policy.mode = static_cast<watcher::SamplingPolicy::Mode>(mode);
+    policy.every_n = every_n;
+    policy.max_per_second = max_per_second;
+    policy.window_us = window_us;
+    return watcher::WatcherCore::getInstance().setSamplingPolicy(variable_id, policy);
+}
+
 void* watcher_read_snapshot(const char* variable_id, size_t* out_len) {
-    static thread_local std::vector<uint8_t> snapshot;
-    snapshot = watcher::WatcherCore::getInstance().readSnapshot(variable_id);
-    *out_len = snapshot.size();
-    return snapshot.data();
+    // Holding the view keeps the buffer alive without copying it out
+    static thread_local watcher::SnapshotView snapshot;
+    snapshot = watcher::WatcherCore::getInstance().snapshotView(variable_id);
+    *out_len = snapshot ? snapshot->size() : 0;
+    return snapshot ? const_cast<uint8_t*>(snapshot->data()) : nullptr;
 }
 
 bool watcher_write_snapshot(const char* variable_id, void* data, size_t len) {
-    std::vector<uint8_t> snapshot(static_cast<uint8_t*>(data),
-                                   static_cast<uint8_t*>(data) + len);
-    return watcher::WatcherCore::getInstance().writeSnapshot(variable_id, snapshot);
+    return watcher::WatcherCore::getInstance().writeSnapshotFrom(variable_id, data, len);
+}
+
+size_t watcher_read_snapshot_into(const char* variable_id, void* out, size_t capacity) {
+    return watcher::WatcherCore::getInstance().readSnapshotInto(variable_id, out, capacity);
+}
+
+size_t watcher_read_snapshots(const char* const* variable_ids, size_t count,
+                              void* const* out_buffers, const size_t* capacities,
+                              size_t* out_lens) {
+    auto& core = watcher::WatcherCore::getInstance();
+    size_t written = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t len = core.readSnapshotInto(variable_ids[i], out_buffers[i], capacities[i]);
+        if (out_lens) {
+            out_lens[i] = len;
+        }
+        written += (len != 0 && len <= capacities[i]) ? 1 : 0;
+    }
+    return written;
 }
 
 // Phase 3: Event dequeuing
@@ -71,17 +144,175 @@ const char* watcher_dequeue_fast_path_event() {
     // Serialize to JSON format (minimal representation)
     std::ostringstream oss;
     oss << "{"
-        << "\"event_id\":\"" << event->event_id << "\","
+        << "\"event_id\":\"" << watcher::formatEventId(event->event_seq) << "\","
         << "\"timestamp_ns\":" << event->ts_ns << ","
         << "\"ip\":" << event->ip << ","
         << "\"tid\":" << event->tid << ","
-        << "\"page_base\":\"0x" << std::hex << reinterpret_cast<uintptr_t>(event->page_base) << std::dec << "\""
+        << "\"page_base\":\"0x" << std::hex << reinterpret_cast<uintptr_t>(event->page_base) << std::dec << "\","
+        << "\"variable_id\":\"" << (event->variable_ids.empty() ? "" : event->variable_ids.front()) << "\""
         << "}";
 
     event_json = oss.str();
     return event_json.c_str();
 }
 
+// Batch event dequeuing: one call drains up to max_events enriched events
+const char* watcher_dequeue_events(size_t max_events, size_t* out_count) {
+    static thread_local std::string events_jsonl;
+    static thread_local std::vector<watcher::EnrichedEvent> events;
+
+    events.clear();
+    events_jsonl.clear();
+    size_t n = watcher::WatcherCore::getInstance().dequeueEvents(events, max_events);
+    for (const auto& event : events) {
+        watcher::appendEventJson(event, events_jsonl);
+        events_jsonl += '\n';
+    }
+
+    if (out_count) {
+        *out_count = n;
+    }
+    return events_jsonl.c_str();
+}
+
+// Binary event channel: records are read in place from the shared mapping
+void* watcher_open_event_channel(size_t capacity, size_t* out_size, void** out_channel) {
+    auto* channel = watcher::WatcherCore::getInstance().openEventChannel(capacity);
+    if (out_size) {
+        *out_size = channel ? channel->mappingSize() : 0;
+    }
+    if (out_channel) {
+        *out_channel = channel;
+    }
+    return channel ? channel->base() : nullptr;
+}
+
+int watcher_event_channel_fd() {
+    auto* channel = watcher::WatcherCore::getInstance().openEventChannel(0);
+    return channel ? channel->fd() : -1;
+}
+
+// The channel lives as long as the core, so the handle stays valid and the
+// per-drain calls skip the core's lock
+size_t watcher_event_channel_acquire(void* channel, uint64_t* out_start) {
+    if (!channel) {
+        *out_start = 0;
+        return 0;
+    }
+    return static_cast<watcher::EventChannel*>(channel)->acquire(out_start);
+}
+
+void watcher_event_channel_release(void* channel, size_t count) {
+    if (channel) {
+        static_cast<watcher::EventChannel*>(channel)->release(count);
+    }
+}
+
+uint32_t watcher_variable_index(const char* variable_id) {
+    return watcher::WatcherCore::getInstance().variableIndex(variable_id);
+}
+
+bool watcher_resolve_symbol(uint64_t ip, char* symbol, size_t symbol_cap,
+                            char* file, size_t file_cap, int* line) {
+    std::string sym, path;
+    int ln = 0;
+    bool known = watcher::WatcherCore::getInstance().resolveSymbol(ip, sym, path, ln);
+    auto copy = [](const std::string& src, char* dst, size_t cap) {
+        if (dst && cap) {
+            size_t n = std::min(src.size(), cap - 1);
+            memcpy(dst, src.data(), n);
+            dst[n] = '\0';
+        }
+    };
+    copy(sym, symbol, symbol_cap);
+    copy(path, file, file_cap);
+    if (line) {
+        *line = ln;
+    }
+    return known;
+}
+
+const char* watcher_load_processor(const char* library_path, const char* config) {
+    static thread_local std::string result;
+    if (!library_path) {
+        watcher::processor::installProcessor(nullptr);
+        result = "OK";
+        return result.c_str();
+    }
+    // Scripts run on the embedded host; anything else is a compiled library
+    using watcher::processor::ProcessorFactory;
+    std::string path = library_path;
+    auto has_suffix = [&](const char* suffix) {
+        size_t n = strlen(suffix);
+        return path.size() >= n && path.compare(path.size() - n, n, suffix) == 0;
+    };
+    std::string error;
+    std::shared_ptr<watcher::processor::CustomProcessor> processor =
+        has_suffix(".py")   ? ProcessorFactory::createPythonProcessor(path, {}, &error)
+        : has_suffix(".js") ? ProcessorFactory::createJavaScriptProcessor(path, {}, &error)
+                            : ProcessorFactory::createNativeProcessor(path, config ? config : "", &error);
+    if (!processor) {
+        result = error;
+        return result.c_str();
+    }
+    watcher::processor::installProcessor(std::move(processor));
+    result = "OK";
+    return result.c_str();
+}
+
+// Counters and per-stage latency percentiles as one JSON object
+const char* watcher_get_metrics_json() {
+    static thread_local std::string metrics_json;
+
+    auto& core = watcher::WatcherCore::getInstance();
+    auto basic = core.getMetrics();
+    auto pipeline = core.getPipelineMetrics();
+
+    std::ostringstream oss;
+    auto stage = [&](const char* name, const watcher::WatcherCore::LatencyStats& stats) {
+        oss << "\"" << name << "\":{"
+            << "\"count\":" << stats.count << ","
+            << "\"min_ns\":" << stats.min_ns << ","
+            << "\"max_ns\":" << stats.max_ns << ","
+            << "\"mean_ns\":" << stats.mean_ns << ","
+            << "\"p50_ns\":" << stats.p50_ns << ","
+            << "\"p90_ns\":" << stats.p90_ns << ","
+            << "\"p99_ns\":" << stats.p99_ns << ","
+            << "\"p999_ns\":" << stats.p999_ns
+            << "}";
+    };
+    oss << "{"
+        << "\"events_received\":" << basic.events_received << ","
+        << "\"events_processed\":" << basic.events_processed << ","
+        << "\"events_dropped\":" << basic.events_dropped << ","
+        << "\"policy_drops\":" << basic.policy_drops << ","
+        << "\"callbacks_failed\":" << basic.callbacks_failed << ","
+        << "\"mean_latency_ms\":" << basic.mean_latency_ms << ","
+        << "\"queue_depth\":" << basic.queue_depth << ","
+        << "\"ioctls\":" << pipeline.ioctls << ","
+        << "\"unprotect_failures\":" << pipeline.unprotect_failures << ","
+        << "\"reprotect_failures\":" << pipeline.reprotect_failures << ","
+        << "\"wp_release_failures\":" << pipeline.wp_release_failures << ","
+        << "\"queue_full_drops\":" << pipeline.queue_full_drops << ","
+        << "\"coalesced_windows\":" << pipeline.coalesced_windows << ","
+        << "\"deferred_reprotects\":" << pipeline.deferred_reprotects << ","
+        << "\"recording_failures\":" << pipeline.recording_failures << ","
+        << "\"stages\":{";
+    stage("fault_to_unprotect", pipeline.fault_to_unprotect);
+    oss << ",";
+    stage("queue_residency", pipeline.queue_residency);
+    oss << ",";
+    stage("enrich", pipeline.enrich);
+    oss << ",";
+    stage("persist", pipeline.persist);
+    oss << ",";
+    stage("end_to_end", pipeline.end_to_end);
+    oss << "}}";
+
+    metrics_json = oss.str();
+    return metrics_json.c_str();
+}
+
 int watcher_get_state() {
     return static_cast<int>(watcher::WatcherCore::getInstance().getState());
 }
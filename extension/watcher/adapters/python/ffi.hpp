@@ -7,6 +7,18 @@
 
 namespace watcher::python {
 
+// Bytes reserved per id in watcher_register_pages output (NUL-terminated)
+constexpr size_t VARIABLE_ID_MAX = 64;
+
+// One watcher_register_pages entry (C layout, mirrored by ctypes)
+struct WatcherRange {
+    void* base;
+    size_t len;
+    const char* name;
+    uint32_t flags;
+    size_t byte_range;  // MutationDepth: tracked leading bytes, 0 for all
+};
+
 // FFI interface to C++ core
 extern "C" {
     // Core initialization
@@ -17,11 +29,37 @@ extern "C" {
     // Variable registration
     const char* watcher_register_page(void* page_base, size_t page_size,
                                       const char* name, uint32_t flags);
+    // As watcher_register_page, tracking only the first byte_range bytes
+    // (0 tracks the whole page)
+    const char* watcher_register_page_ex(void* page_base, size_t page_size,
+                                         const char* name, uint32_t flags, size_t byte_range);
+    // One variable spanning many pages (e.g. a numpy buffer)
+    const char* watcher_register_range(void* base, size_t len,
+                                       const char* name, uint32_t flags);
     bool watcher_unregister_page(const char* variable_id);
+    // Sampling policy for a hot variable (SamplingPolicy::Mode: 0 all,
+    // 1 every_n-th fault, 2 max_per_second, 3 coalesce window_us); the
+    // parameters of other modes are ignored. Returns false if the variable
+    // is unknown or the mode's parameter is 0
+    bool watcher_set_sampling_policy(const char* variable_id, uint32_t mode, uint32_t every_n,
+                                     uint32_t max_per_second, uint32_t window_us);
+    // Register count ranges in one call. Ids are written into out_ids at
+    // id_stride-byte steps (>= VARIABLE_ID_MAX); a failed entry gets "".
+    // Returns the number registered
+    size_t watcher_register_pages(const WatcherRange* ranges, size_t count,
+                                  char* out_ids, size_t id_stride);
 
     // Snapshot operations
     void* watcher_read_snapshot(const char* variable_id, size_t* out_len);
     bool watcher_write_snapshot(const char* variable_id, void* data, size_t len);
+    // Read into a caller buffer; returns the snapshot size (0 if unknown),
+    // and writes nothing when capacity is smaller
+    size_t watcher_read_snapshot_into(const char* variable_id, void* out, size_t capacity);
+    // watcher_read_snapshot_into for count ids; out_lens[i] receives each
+    // size. Returns the number of snapshots written
+    size_t watcher_read_snapshots(const char* const* variable_ids, size_t count,
+                                  void* const* out_buffers, const size_t* capacities,
+                                  size_t* out_lens);
 
     // Event dequeuing (Phase 3)
     // Get next fast-path event as JSON string
@@ -29,6 +67,40 @@ extern "C" {
     // Caller must free the returned pointer with free()
     const char* watcher_dequeue_fast_path_event();
 
+    // Get up to max_events enriched events as newline-delimited JSON
+    // (same records as events.jsonl); *out_count receives the event count
+    // Returned buffer is valid until the next call on the same thread
+    const char* watcher_dequeue_events(size_t max_events, size_t* out_count);
+
+    // Binary event channel: switch delivery to a shared-memory ring of
+    // 64-byte BinaryEventRecords (see event_channel.hpp). Returns the mapping
+    // base (header first) and its size, or NULL; idempotent. *out_channel
+    // receives the handle acquire and release take
+    void* watcher_open_event_channel(size_t capacity, size_t* out_size, void** out_channel);
+    // memfd backing the channel (for mapping it in another process), or -1
+    int watcher_event_channel_fd();
+    // Records readable without wrapping; *out_start receives the first cursor
+    // (record slot = cursor & (capacity - 1)). Valid until release
+    size_t watcher_event_channel_acquire(void* channel, uint64_t* out_start);
+    void watcher_event_channel_release(void* channel, size_t count);
+    // var_index carried by the variable's records, or 0 if unknown
+    uint32_t watcher_variable_index(const char* variable_id);
+
+    // In-process symbolization of an instruction pointer (function, source
+    // file, line; see symbolizer.hpp). Strings are truncated to fit their
+    // buffers; returns false if no loaded object contains ip
+    bool watcher_resolve_symbol(uint64_t ip, char* symbol, size_t symbol_cap,
+                                char* file, size_t file_cap, int* line);
+
+    // Load a processor into the slow path: a .py or .js script (run on the
+    // embedded script host) or a compiled library (watcher_processor_abi.h);
+    // NULL library_path removes the current one. Returns "OK" or the error
+    const char* watcher_load_processor(const char* library_path, const char* config);
+
+    // Counters plus per-stage latency percentiles (ns) as a JSON object
+    // Returned buffer is valid until the next call on the same thread
+    const char* watcher_get_metrics_json();
+
     // State queries
     int watcher_get_state();
     const char* watcher_get_error();
@@ -0,0 +1,61 @@
+"""
+Export a binary recording (events.wrec) to JSONL
+
+    python -m watcher.cli.export_jsonl ./watcher_output [-o events.jsonl]
+
+Each line holds the same fields as the core's JSONL records, for tools that
+read the older format.
+"""
+
+import argparse
+import sys
+
+from watcher.core.recording import KIND_KEYFRAMES, RecordingError, RecordingReader, export_jsonl
+
+
+def create_argument_parser() -> argparse.ArgumentParser:
+    parser = argparse.ArgumentParser(
+        description="Export a Watcher binary recording to JSONL",
+        epilog="Example: python -m watcher.cli.export_jsonl ./watcher_output -o events.jsonl"
+    )
+    parser.add_argument(
+        'recording',
+        help='Path to events.wrec, or the output directory that holds it'
+    )
+    parser.add_argument(
+        '-o', '--output',
+        help='JSONL file to write (default: stdout)'
+    )
+    parser.add_argument(
+        '--summary',
+        action='store_true',
+        help='Print segment and event counts instead of exporting'
+    )
+    return parser
+
+
+def main() -> int:
+    args = create_argument_parser().parse_args()
+    try:
+        if args.summary:
+            with RecordingReader(args.recording) as reader:
+                keyframes = sum(s.event_count for s in reader.segments if s.kind == KIND_KEYFRAMES)
+                print(f"{reader.path}: {len(reader.segments)} segments, {reader.event_count} events, "
+                      f"{keyframes} keyframes, {len(reader.directory)} variables"
+                      f"{'' if reader.has_index else ' (no footer index; scanned)'}")
+            return 0
+
+        if args.output:
+            with open(args.output, 'w', encoding='utf-8') as out:
+                count = export_jsonl(args.recording, out)
+        else:
+            count = export_jsonl(args.recording, sys.stdout)
+    except (OSError, RecordingError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        return 2
+    print(f"Exported {count} events", file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
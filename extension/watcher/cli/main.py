@@ -120,9 +120,10 @@ class WatcherCLI:
             proc_path = Path(config.custom_processor)
             if not proc_path.exists():
                 return False, f"Custom processor not found: {config.custom_processor}"
-            if not proc_path.suffix in ['.py', '.js']:
-                return False, f"Processor must be .py or .js, got {proc_path.suffix}"
-            if user_script_path.suffix != proc_path.suffix:
+            if not proc_path.suffix in ['.py', '.js', '.so']:
+                return False, f"Processor must be .py, .js or .so, got {proc_path.suffix}"
+            # Compiled processors run inside the core, for either language
+            if proc_path.suffix != '.so' and user_script_path.suffix != proc_path.suffix:
                 return False, "Custom processor must be same language as user script"
 
         # Validate mutation depth
@@ -234,30 +235,30 @@ class WatcherCLI:
             return self._load_python_processor(str(proc_path))
         elif proc_path.suffix == '.js':
             return self._load_javascript_processor(str(proc_path))
+        elif proc_path.suffix == '.so':
+            # Loaded into the core's slow path once it is initialized
+            self.processor = ("native", str(proc_path.resolve()))
+            return True, "OK"
         else:
             return False, f"Unsupported processor language: {proc_path.suffix}"
     
     def _load_python_processor(self, script_path: str) -> tuple[bool, str]:
-        """Load Python processor"""
+        """Load Python processor (run by the core's embedded interpreter)"""
         try:
-            spec = importlib.util.spec_from_file_location("processor_module", script_path)
-            if not spec or not spec.loader:
-                return False, "Failed to load processor"
-            
-            module = importlib.util.module_from_spec(spec)
-            sys.modules['processor_module'] = module
-            spec.loader.exec_module(module)
+            with open(script_path, 'r') as f:
+                content = f.read()
             
-            if not hasattr(module, 'main'):
-                return False, "Processor must define main(event) function"
+            if 'def main' not in content:
+                return False, "Processor must define main(event) or main_batch(batch)"
             
-            self.processor = module.main
+            # Loaded into the core's slow path once it is initialized
+            self.processor = ("python", str(Path(script_path).resolve()))
             return True, "OK"
         except Exception as e:
             return False, f"Failed to load processor: {str(e)}"
     
     def _load_javascript_processor(self, script_path: str) -> tuple[bool, str]:
-        """Load JavaScript processor (validation only, execution via subprocess)"""
+        """Load JavaScript processor (run by the core's node host process)"""
         try:
             script_file = Path(script_path)
             if not script_file.exists():
@@ -270,7 +271,7 @@ class WatcherCLI:
             if 'main' not in content:
                 return False, "Processor must define/export main(event) function"
             
-            # Store processor path for later execution via subprocess
+            # Loaded into the core's slow path once it is initialized
             self.processor = ("javascript", script_path)
             return True, "OK"
         except Exception as e:
@@ -314,13 +315,16 @@ class WatcherCLI:
                 'output_dir': config.output_dir,
                 'track_threads': config.track_threads,
                 'track_locals': config.track_locals,
-                'track_sql': config.track_sql
+                'track_sql': config.track_sql,
+                'mutation_depth': config.mutation_depth
             }
 
             if config.parsed_scope_config:
                 init_args['scope_config'] = config.parsed_scope_config
 
             self.core.initialize(**init_args)
+            if isinstance(self.processor, tuple) and self.processor[0] in ("native", "python", "javascript"):
+                self.core.load_processor(self.processor[1])
 
             self.logger.info("Watcher core initialized successfully")
         except Exception as e:
@@ -516,7 +520,8 @@ def create_argument_parser() -> argparse.ArgumentParser:
     
     parser.add_argument(
         '--custom-processor',
-        help='Path to custom processor script (.py or .js) with main(event) function'
+        help='Path to custom processor script (.py or .js) with main(event) function, '
+             'or a compiled processor (.so, see processor/include/watcher_processor_abi.h)'
     )
     
     parser.add_argument(
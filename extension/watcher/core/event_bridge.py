@@ -1,8 +1,12 @@
 """
 Event Bridge - Connects C++ core event queue to Python enrichment pipeline
 
-Retrieves fast-path events from C++ core and enriches them using the Phase 2
-enrichment pipeline before persisting to JSONL.
+When the loaded core exports watcher_dequeue_events, events arrive already
+enriched and persisted by the native slow path and are drained in batches,
+either as JSONL or, with channel_capacity set, as binary records read from
+a shared-memory ring (see event_channel.py). Otherwise fast-path events
+are enriched using the Phase 2 enrichment pipeline before persisting to
+JSONL.
 """
 
 import json
@@ -16,7 +20,8 @@ from queue import Queue
 class EventBridge:
     """Bridges C++ event queue to Python enrichment pipeline"""
 
-    def __init__(self, watcher_core, enricher, writer, poll_interval_ms: float = 10):
+    def __init__(self, watcher_core, enricher, writer, poll_interval_ms: float = 10,
+                 channel_capacity: int = 0):
         """
         Initialize the event bridge.
 
@@ -25,6 +30,9 @@ class EventBridge:
             enricher: EventEnricher instance from Phase 2
             writer: EventWriter instance from Phase 2
             poll_interval_ms: Polling interval in milliseconds
+            channel_capacity: With a native core, > 0 switches delivery to the
+                binary event channel with this many records (on_batch gets
+                each decoded batch; on_event gets reduced event dicts)
         """
         self.watcher_core = watcher_core
         self.enricher = enricher
@@ -32,7 +40,32 @@ class EventBridge:
         self.poll_interval = poll_interval_ms / 1000.0  # Convert to seconds
 
         self.lib = watcher_core.lib
+        # Native slow path: deltas, symbols and persistence already done in C++
+        self.native_batches = (isinstance(self.lib, ctypes.CDLL) and
+                               hasattr(self.lib, 'watcher_dequeue_events'))
+        self.on_event: Optional[Callable[[Dict[str, Any]], None]] = None
+        self.on_batch: Optional[Callable[[Any], None]] = None
         self.running = False
+
+        self.channel = None
+        if channel_capacity > 0 and self.native_batches and \
+                hasattr(self.lib, 'watcher_open_event_channel'):
+            from .event_channel import EventChannel
+            self.channel = EventChannel(self.lib, channel_capacity)
+        # var_index -> variable_id for channel records, see _channel_variable_ids
+        self._index_ids: Dict[int, str] = {}
+        self._index_ids_size = -1
+
+        # Set once; reassigning restype costs an attribute write per event
+        if not self.native_batches:
+            try:
+                self.lib.watcher_dequeue_fast_path_event.restype = ctypes.c_char_p
+            except AttributeError:
+                pass
+
+        # page_base -> (variable_id, name, scope), see _lookup_variable
+        self._page_index: Dict[int, tuple] = {}
+        self._page_index_size = -1
         self.worker_thread: Optional[threading.Thread] = None
 
         # Statistics
@@ -68,13 +101,16 @@ class EventBridge:
         Returns:
             Number of events processed
         """
+        if self.channel is not None:
+            return self._process_channel(max_events)
+        if self.native_batches:
+            return self._process_native_batch(max_events)
+
         processed = 0
 
         for _ in range(max_events):
             # Call C++ dequeue function
             try:
-                # The FFI lib should have watcher_dequeue_fast_path_event function
-                self.lib.watcher_dequeue_fast_path_event.restype = ctypes.c_char_p
                 json_bytes = self.lib.watcher_dequeue_fast_path_event()
 
                 if not json_bytes:
@@ -114,6 +150,86 @@ class EventBridge:
 
         return processed
 
+    def _process_native_batch(self, max_events: int) -> int:
+        """
+        Drain up to max_events natively enriched events in one FFI call.
+
+        Returns:
+            Number of events processed
+        """
+        count = ctypes.c_size_t(0)
+        try:
+            payload = self.lib.watcher_dequeue_events(max_events, ctypes.byref(count))
+        except Exception as e:
+            print(f"Error dequeuing events from C++: {e}", flush=True)
+            return 0
+
+        if not payload or count.value == 0:
+            return 0
+
+        processed = 0
+        for line in payload.decode('utf-8').splitlines():
+            self.events_from_cpp += 1
+            try:
+                event_dict = json.loads(line)
+            except ValueError:
+                self.events_failed += 1
+                continue
+
+            self.events_enriched += 1
+            self.events_persisted += 1
+            processed += 1
+
+            if self.on_event is not None:
+                try:
+                    self.on_event(event_dict)
+                except Exception as e:
+                    print(f"Error in event callback: {e}", flush=True)
+
+        return processed
+
+    def _process_channel(self, max_events: int) -> int:
+        """
+        Copy up to max_events binary records out of the event channel.
+
+        Returns:
+            Number of events processed
+        """
+        data = self.channel.read(max_events)
+        processed = len(data) // self.channel.RECORD_SIZE
+        if processed == 0:
+            return 0
+
+        self.events_from_cpp += processed
+        self.events_enriched += processed
+        self.events_persisted += processed
+
+        if self.on_batch is not None:
+            try:
+                self.on_batch(self.channel.decode(data))
+            except Exception as e:
+                print(f"Error in batch callback: {e}", flush=True)
+        if self.on_event is not None:
+            for event_dict in self.channel.to_dicts(data, self._channel_variable_ids()):
+                try:
+                    self.on_event(event_dict)
+                except Exception as e:
+                    print(f"Error in event callback: {e}", flush=True)
+
+        return processed
+
+    def _channel_variable_ids(self) -> Dict[int, str]:
+        """var_index -> variable_id, rebuilt when the registry changes size"""
+        variables = getattr(self.watcher_core, 'variables', None) or {}
+        if self._index_ids_size != len(variables):
+            self._index_ids = {}
+            for var_id in variables:
+                index = self.lib.watcher_variable_index(var_id.encode())
+                if index:
+                    self._index_ids[index] = var_id
+            self._index_ids_size = len(variables)
+        return self._index_ids
+
     def _enrich_event(self, event_dict: Dict[str, Any]):
         """
         Enrich a fast-path event from C++.
@@ -137,8 +253,13 @@ class EventBridge:
         except (ValueError, TypeError):
             page_base = 0
 
-        # Look up variable info from registry
-        variable_id, variable_name, scope = self._lookup_variable(page_base)
+        # The native fast path tags events; fall back to the registry
+        variable_id = event_dict.get('variable_id') or None
+        registry = getattr(self.watcher_core, 'variables', None) or {}
+        if variable_id and variable_id in registry:
+            variable_name, scope = registry[variable_id][1]._name, None
+        else:
+            variable_id, variable_name, scope = self._lookup_variable(page_base)
 
         # Read snapshots from C++ core
         before_snapshot = self.watcher_core.lib.watcher_read_snapshot(
@@ -172,13 +293,20 @@ class EventBridge:
         Returns:
             (variable_id, variable_name, scope) tuple
         """
-        # For now, simplified lookup from watcher_core.variables
-        if hasattr(self.watcher_core, 'variables'):
-            for var_id, (shadow, proxy) in self.watcher_core.variables.items():
-                if shadow.page_base == page_base or id(shadow.mmap_obj) == page_base:
-                    return var_id, proxy._name, None
-
-        return None, None, None
+        variables = getattr(self.watcher_core, 'variables', None)
+        if not variables:
+            return None, None, None
+
+        # Rebuild the page_base index only when the registry changes size
+        if self._page_index_size != len(variables):
+            self._page_index = {}
+            for var_id, (shadow, proxy) in variables.items():
+                entry = (var_id, proxy._name, None)
+                self._page_index.setdefault(shadow.page_base, entry)
+                self._page_index.setdefault(id(shadow.mmap_obj), entry)
+            self._page_index_size = len(variables)
+
+        return self._page_index.get(page_base, (None, None, None))
 
     def _worker_loop(self):
         """Background worker thread continuously drains C++ queue"""
@@ -0,0 +1,164 @@
+"""
+Event Channel - Reads binary events from the C++ core's shared-memory ring
+
+The native slow path writes one fixed 64-byte record per persisted event
+(BinaryEventRecord in core/include/event_channel.hpp) into a ring that this
+process maps directly. A drain is two FFI calls per contiguous run of records
+and no per-event parsing; batches decode to a numpy structured array when
+numpy is available, or to tuples otherwise.
+"""
+
+import ctypes
+import struct
+from typing import Any, Dict, List, Optional
+
+# Wire format of BinaryEventRecord (little-endian, 64 bytes)
+RECORD_FORMAT = '<QQQQQIIIIII'
+RECORD_SIZE = struct.calcsize(RECORD_FORMAT)
+RECORD_FIELDS = ('event_seq', 'ts_ns', 'page_base', 'fault_addr', 'ip',
+                 'tid', 'var_index', 'var_count', 'delta_runs', 'delta_bytes', 'flags')
+
+CHANNEL_MAGIC = 0x48434557
+CHANNEL_VERSION = 1
+EVENT_SEQ_SHARD_SHIFT = 56
+
+# EventChannelHeader: magic, version, record_size, reserved, capacity,
+# records_offset, mapping_size; the cursors sit on their own cache lines
+_HEADER_FORMAT = '<IIIIQQQ'
+_DROPPED_OFFSET = 136
+
+try:
+    import numpy as _np
+    RECORD_DTYPE = _np.dtype({
+        'names': list(RECORD_FIELDS),
+        'formats': ['<u8'] * 5 + ['<u4'] * 6,
+    })
+except ImportError:  # pragma: no cover - numpy is optional
+    _np = None
+    RECORD_DTYPE = None
+
+
+def format_event_id(event_seq: int) -> str:
+    """Same text as the core's formatEventId()"""
+    shard = event_seq >> EVENT_SEQ_SHARD_SHIFT
+    count = event_seq & ((1 << EVENT_SEQ_SHARD_SHIFT) - 1)
+    return f"evt-{shard}-{count}" if shard else f"evt-{count}"
+
+
+class EventChannel:
+    """Consumer end of the core's binary event channel (one reader)"""
+
+    RECORD_SIZE = RECORD_SIZE
+
+    def __init__(self, lib, capacity: int = 0):
+        """
+        Open (or attach to) the core's event channel.
+
+        Once open, the core stops filling watcher_dequeue_events; persisted
+        events arrive here only.
+
+        Args:
+            lib: Loaded core library (ctypes.CDLL with the channel exports)
+            capacity: Ring size in records (0 for the core default)
+        """
+        self.lib = lib
+        size = ctypes.c_size_t(0)
+        # Resolved once: acquire/release then go straight to the ring
+        self._channel = ctypes.c_void_p(None)
+        base = lib.watcher_open_event_channel(capacity, ctypes.byref(size), ctypes.byref(self._channel))
+        if not base:
+            raise RuntimeError("Event channel could not be mapped")
+
+        self._mapping = (ctypes.c_char * size.value).from_address(base)
+        self._view = memoryview(self._mapping).cast('B')
+        magic, version, record_size, _, self.capacity, records_offset, _ = \
+            struct.unpack_from(_HEADER_FORMAT, self._view, 0)
+        if magic != CHANNEL_MAGIC or version != CHANNEL_VERSION or record_size != RECORD_SIZE:
+            raise RuntimeError("Event channel has an unknown layout")
+        self._records = self._view[records_offset:records_offset + self.capacity * RECORD_SIZE]
+        self._start = ctypes.c_uint64(0)
+
+    @property
+    def dropped(self) -> int:
+        """Records the core could not deliver because the ring was full"""
+        return struct.unpack_from('<Q', self._view, _DROPPED_OFFSET)[0]
+
+    def acquire(self, max_events: int) -> memoryview:
+        """
+        View the next contiguous records in place (no copy).
+
+        The view is valid until release(); it holds at most max_events
+        records and stops at the end of the ring.
+        """
+        count = self.lib.watcher_event_channel_acquire(self._channel, ctypes.byref(self._start))
+        count = min(count, max_events)
+        slot = self._start.value & (self.capacity - 1)
+        return self._records[slot * RECORD_SIZE:(slot + count) * RECORD_SIZE]
+
+    def release(self, count: int):
+        """Hand count acquired records back to the core"""
+        if count:
+            self.lib.watcher_event_channel_release(self._channel, count)
+
+    def read(self, max_events: int) -> bytes:
+        """
+        Copy out up to max_events records and release them.
+
+        Returns:
+            Concatenated records (a multiple of RECORD_SIZE bytes)
+        """
+        chunks = []
+        remaining = max_events
+        # A wrapped run takes a second acquire for the part at the ring start
+        for _ in range(2):
+            view = self.acquire(remaining)
+            count = len(view) // RECORD_SIZE
+            if count == 0:
+                break
+            chunks.append(bytes(view))
+            view.release()
+            self.release(count)
+            remaining -= count
+            if remaining == 0:
+                break
+        return chunks[0] if len(chunks) == 1 else b''.join(chunks)
+
+    @staticmethod
+    def decode(data):
+        """
+        Decode records from read() or acquire().
+
+        Returns:
+            numpy structured array (RECORD_DTYPE) if numpy is available,
+            otherwise a list of tuples in RECORD_FIELDS order
+        """
+        if _np is not None:
+            return _np.frombuffer(data, dtype=RECORD_DTYPE)
+        return list(struct.iter_unpack(RECORD_FORMAT, data))
+
+    @staticmethod
+    def to_dicts(data, variable_ids: Optional[Dict[int, str]] = None) -> List[Dict[str, Any]]:
+        """
+        Decode records into event dicts keyed like watcher_dequeue_events.
+
+        Args:
+            data: Records from read()
+            variable_ids: var_index -> variable_id map (ids omitted if None)
+        """
+        events = []
+        for rec in struct.iter_unpack(RECORD_FORMAT, data):
+            var_index = rec[6]
+            events.append({
+                'event_id': format_event_id(rec[0]),
+                'timestamp_ns': rec[1],
+                'page_base': hex(rec[2]),
+                'fault_addr': hex(rec[3]),
+                'ip': rec[4],
+                'tid': rec[5],
+                'variable_id': (variable_ids or {}).get(var_index, ''),
+                'var_index': var_index,
+                'var_count': rec[7],
+                'delta_runs': rec[8],
+                'delta_bytes': rec[9],
+            })
+        return events
@@ -7,6 +7,7 @@ Takes fast-path events and enriches them with detailed information:
 - Context information (SQL context, thread data)
 """
 
+import ctypes
 import struct
 import subprocess
 import threading
@@ -130,9 +131,20 @@ class SymbolCache:
 class SymbolResolver:
     """Resolves instruction pointers to function:file:line"""
 
-    def __init__(self, binary_path: Optional[str] = None):
+    def __init__(self, binary_path: Optional[str] = None, lib=None):
+        """
+        Args:
+            binary_path: Binary for addr2line (defaults to this process)
+            lib: Loaded core library; when it exports watcher_resolve_symbol,
+                 ips are resolved in-process instead of via addr2line
+        """
         self.binary_path = binary_path or "/proc/self/exe"
         self.cache = SymbolCache()
+        self._native = getattr(lib, 'watcher_resolve_symbol', None) if lib is not None else None
+        if self._native is not None:
+            self._symbol_buf = ctypes.create_string_buffer(512)
+            self._file_buf = ctypes.create_string_buffer(1024)
+            self._line = ctypes.c_int(0)
 
     def resolve(self, ip: int) -> Dict[str, str]:
         """
@@ -152,6 +164,11 @@ class SymbolResolver:
         if cached is not None:
             return cached
 
+        if self._native is not None:
+            symbol_info = self._resolve_native(ip)
+            self.cache.set(ip_str, symbol_info)
+            return symbol_info
+
         # Resolve via subprocess
         try:
             result = subprocess.run(
@@ -194,12 +211,22 @@ class SymbolResolver:
         self.cache.set(ip_str, fallback)
         return fallback
 
+    def _resolve_native(self, ip: int) -> Dict[str, str]:
+        """Resolve through the core's in-process symbolizer"""
+        self._native(ip, self._symbol_buf, len(self._symbol_buf),
+                     self._file_buf, len(self._file_buf), ctypes.byref(self._line))
+        return {
+            'function': self._symbol_buf.value.decode(errors='replace'),
+            'file': self._file_buf.value.decode(errors='replace'),
+            'line': self._line.value
+        }
+
 
 class EventEnricher:
     """Enriches fast-path events with detailed information"""
 
-    def __init__(self, binary_path: Optional[str] = None):
-        self.symbol_resolver = SymbolResolver(binary_path)
+    def __init__(self, binary_path: Optional[str] = None, lib=None):
+        self.symbol_resolver = SymbolResolver(binary_path, lib)
         self.delta_computer = DeltaComputer()
 
     def enrich(
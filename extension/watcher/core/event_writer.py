@@ -17,14 +17,31 @@ import time
 class EventWriter:
     """Writes enriched events to JSONL file"""
 
-    def __init__(self, output_dir: str, max_buffer_events: int = 1000):
+    # When buffered events are fsynced:
+    #   none  - never; the OS writes them back on its own
+    #   async - on flush() and close() only
+    #   group - at most once per group_interval_s, and on flush() and close()
+    #   sync  - after every buffer (the default)
+    DURABILITY_MODES = ("none", "async", "group", "sync")
+
+    def __init__(self, output_dir: str, max_buffer_events: int = 1000,
+                 durability: str = "sync", group_interval_s: float = 0.05):
         """
         Initialize event writer.
 
         Args:
             output_dir: Directory to write events to
             max_buffer_events: Max events to buffer before flush
+            durability: One of DURABILITY_MODES
+            group_interval_s: Minimum time between fsyncs in "group" mode
         """
+        if durability not in self.DURABILITY_MODES:
+            raise ValueError(f"Unknown durability mode: {durability!r}")
+        self.durability = durability
+        self.group_interval_s = group_interval_s
+        self._last_sync = time.monotonic()
+        self._unsynced = False
+
         self.output_dir = Path(output_dir)
         self.output_dir.mkdir(parents=True, exist_ok=True)
 
@@ -42,6 +59,7 @@ class EventWriter:
         # Stats
         self.events_written = 0
         self.events_lost = 0
+        self.syncs = 0
 
     def _open_file(self):
         """Open the output file for writing"""
@@ -82,17 +100,32 @@ class EventWriter:
                 print(f"Warning: Failed to write event: {e}", flush=True)
                 return False
 
-    def _flush_internal(self):
+    def _should_sync(self, explicit: bool) -> bool:
+        if self.durability == "none":
+            return False
+        if explicit or self.durability == "sync":
+            return True
+        return (self.durability == "group" and
+                time.monotonic() - self._last_sync >= self.group_interval_s)
+
+    def _flush_internal(self, explicit: bool = False):
         """Flush buffer to disk (must hold lock)"""
-        if not self.buffer:
+        if self.file_handle is None:
+            return
+        if not self.buffer and not (explicit and self._unsynced):
             return
 
         try:
             for json_line in self.buffer:
                 self.file_handle.write(json_line + '\n')
+                self._unsynced = True
 
             self.file_handle.flush()
-            os.fsync(self.file_handle.fileno())  # Force sync to disk
+            if self._unsynced and self._should_sync(explicit):
+                os.fsync(self.file_handle.fileno())  # Force sync to disk
+                self._last_sync = time.monotonic()
+                self._unsynced = False
+                self.syncs += 1
             self.buffer.clear()
 
         except IOError as e:
@@ -104,13 +137,12 @@ class EventWriter:
     def flush(self):
         """Explicitly flush all buffered events"""
         with self.lock:
-            self._flush_internal()
+            self._flush_internal(explicit=True)
 
     def close(self):
         """Close the event writer"""
         with self.lock:
-            if self.buffer:
-                self._flush_internal()
+            self._flush_internal(explicit=True)
 
             if self.file_handle:
                 try:
@@ -127,6 +159,7 @@ class EventWriter:
                 'events_written': self.events_written,
                 'events_lost': self.events_lost,
                 'buffered': len(self.buffer),
+                'syncs': self.syncs,
                 'output_file': str(self.events_file),
             }
 
@@ -140,15 +173,16 @@ class EventWriter:
 class BatchEventWriter:
     """Writes events in batches from a queue (thread-safe)"""
 
-    def __init__(self, output_dir: str, batch_size: int = 100):
+    def __init__(self, output_dir: str, batch_size: int = 100, durability: str = "sync"):
         """
         Initialize batch writer with background thread.
 
         Args:
             output_dir: Directory to write events to
             batch_size: Size of batch to process
+            durability: EventWriter durability mode
         """
-        self.writer = EventWriter(output_dir)
+        self.writer = EventWriter(output_dir, durability=durability)
         self.queue: Queue = Queue(maxsize=10000)
         self.batch_size = batch_size
 
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace watcher {
+
+// ============================================================================
+// Constants & Configuration
+// ============================================================================
+
+/// Unchanged gaps up to this many bytes are folded into the surrounding run,
+/// so a rewritten array of small integers becomes one run, not one per element
+constexpr size_t DELTA_MERGE_GAP = 8;
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/// One changed byte range. Old and new bytes are stored back to back in the
+/// owning DeltaSet arena: old at [arena_offset, arena_offset + length), new
+/// right after.
+struct DeltaRun {
+    uint32_t offset;        // Offset within the snapshot
+    uint32_t length;        // Run length in bytes
+    uint32_t arena_offset;  // Start of the old bytes in DeltaSet::arena
+};
+
+/// Flat delta storage: fixed-size run records plus one byte arena
+struct DeltaSet {
+    std::vector<DeltaRun> runs;
+    std::vector<uint8_t> arena;
+
+    size_t size() const { return runs.size(); }
+    bool empty() const { return runs.empty(); }
+
+    void clear() {
+        runs.clear();
+        arena.clear();
+    }
+
+    const uint8_t* oldBytes(const DeltaRun& run) const {
+        return arena.data() + run.arena_offset;
+    }
+
+    const uint8_t* newBytes(const DeltaRun& run) const {
+        return arena.data() + run.arena_offset + run.length;
+    }
+
+    /// Total changed bytes covered by all runs
+    size_t changedBytes() const {
+        size_t total = 0;
+        for (const auto& run : runs) {
+            total += run.length;
+        }
+        return total;
+    }
+};
+
+// ============================================================================
+// Delta Kernel
+// ============================================================================
+
+/// Compare two snapshots and append the changed runs to out
+/// Uses AVX2 or SSE2 on x86-64 (picked at runtime), NEON on AArch64, and a
+/// word-at-a-time scalar loop elsewhere
+/// @param pre Snapshot before the mutation
+/// @param post Snapshot after the mutation
+/// @param len Bytes to compare
+/// @param out Destination (not cleared)
+/// @param base_offset Added to every run offset (for sub-page diffs)
+/// @param merge_gap Maximum unchanged gap folded into one run
+/// @return Number of runs appended
+size_t computeDeltas(const uint8_t* pre, const uint8_t* post, size_t len, DeltaSet& out,
+                     size_t base_offset = 0, size_t merge_gap = DELTA_MERGE_GAP);
+
+/// Scalar reference implementation (same output as computeDeltas)
+size_t computeDeltasScalar(const uint8_t* pre, const uint8_t* post, size_t len, DeltaSet& out,
+                           size_t base_offset = 0, size_t merge_gap = DELTA_MERGE_GAP);
+
+/// Name of the kernel computeDeltas dispatches to ("avx2", "sse2", "neon", "scalar")
+const char* deltaKernelName();
+
+}  // namespace watcher
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace watcher {
+
+// ============================================================================
+// Constants & Configuration
+// ============================================================================
+
+constexpr uint32_t EVENT_CHANNEL_MAGIC = 0x48434557;  // "WECH"
+constexpr uint32_t EVENT_CHANNEL_VERSION = 1;
+constexpr size_t EVENT_CHANNEL_CAPACITY = 1 << 16;    // Default records
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/// One enriched event as a fixed 64-byte little-endian record. Field order
+/// and widths are the channel's wire format; consumers decode whole batches
+/// (e.g. as a numpy structured array) without parsing.
+struct BinaryEventRecord {
+    uint64_t event_seq;     // Formatted with formatEventId() for display
+    uint64_t ts_ns;         // Wall-clock nanoseconds since the Unix epoch
+    uint64_t page_base;
+    uint64_t fault_addr;
+    uint64_t ip;
+    uint32_t tid;
+    uint32_t var_index;     // VariableMetadata::index of the first variable
+    uint32_t var_count;     // Variables covering fault_addr
+    uint32_t delta_runs;
+    uint32_t delta_bytes;   // Changed bytes over all runs
+    uint32_t flags;         // Reserved, 0
+};
+static_assert(sizeof(BinaryEventRecord) == 64, "BinaryEventRecord is a 64-byte wire format");
+
+/// First bytes of the shared mapping; the records follow at records_offset.
+/// Cursors count records since the channel was created; slot = cursor & (capacity - 1).
+struct EventChannelHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+    uint64_t capacity;          // Records, a power of two
+    uint64_t records_offset;    // Bytes from the start of the mapping
+    uint64_t mapping_size;
+    alignas(64) std::atomic<uint64_t> head;     // Consumer: next record to read
+    alignas(64) std::atomic<uint64_t> tail;     // Producer: next record to write
+    std::atomic<uint64_t> dropped;              // Producer: records lost to a full ring
+};
+
+// ============================================================================
+// Event Channel (shared-memory SPSC ring of BinaryEventRecord)
+// ============================================================================
+
+/// Single-producer ring in a memfd mapping, so the consumer can be another
+/// language runtime in this process (reading the mapping directly) or a
+/// process that maps fd(). The producer is the slow-path thread; a full ring
+/// drops the newest records and counts them in the header.
+class EventChannel {
+public:
+    /// @param capacity Requested records (rounded up to a power of two)
+    /// @return nullptr if the mapping cannot be created
+    static std::unique_ptr<EventChannel> create(size_t capacity);
+
+    ~EventChannel();
+
+    EventChannel(const EventChannel&) = delete;
+    EventChannel& operator=(const EventChannel&) = delete;
+
+    /// Producer side. Appends up to count records with one tail update
+    /// @return Records appended; the rest are counted as dropped
+    size_t push(const BinaryEventRecord* records, size_t count);
+
+    /// Consumer side. Records readable without wrapping, starting at *start
+    /// (a cursor value); they stay valid until release()
+    size_t acquire(uint64_t* start) const;
+
+    /// Consumer side. Hand count acquired records back to the producer
+    void release(size_t count);
+
+    void* base() const { return header_; }
+    size_t mappingSize() const { return header_->mapping_size; }
+    int fd() const { return fd_; }
+    size_t capacity() const { return header_->capacity; }
+    size_t size() const;
+    uint64_t dropped() const { return header_->dropped.load(std::memory_order_relaxed); }
+
+private:
+    EventChannel(EventChannelHeader* header, BinaryEventRecord* records, int fd)
+        : header_(header), records_(records), fd_(fd) {}
+
+    EventChannelHeader* header_;
+    BinaryEventRecord* records_;
+    int fd_;
+    uint64_t cached_head_ = 0;  // Producer's copy of head
+};
+
+}  // namespace watcher
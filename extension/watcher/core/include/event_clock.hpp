@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <time.h>
+
+namespace watcher {
+
+// ============================================================================
+// Event Clock (CLOCK_MONOTONIC_RAW with a calibrated wall-clock offset)
+// ============================================================================
+
+/// Timestamp source for the fault path. now() is a single vDSO read of
+/// CLOCK_MONOTONIC_RAW, which never steps or slews, so timestamps order the
+/// same way events happened. toWall() maps them onto the Unix epoch with the
+/// offset sampled once by calibrate().
+class EventClock {
+public:
+    /// Monotonic nanoseconds (fault path and stage durations)
+    static uint64_t now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    /// Sample the wall-clock offset. Each attempt brackets one
+    /// CLOCK_REALTIME read between two monotonic reads; the tightest bracket
+    /// wins. Call while no thread is converting timestamps.
+    void calibrate() {
+        uint64_t best_window = UINT64_MAX;
+        for (int attempt = 0; attempt < CALIBRATION_ATTEMPTS; ++attempt) {
+            uint64_t before = now();
+            struct timespec wall;
+            clock_gettime(CLOCK_REALTIME, &wall);
+            uint64_t after = now();
+            if (after - before < best_window) {
+                best_window = after - before;
+                uint64_t wall_ns = static_cast<uint64_t>(wall.tv_sec) * 1000000000ull +
+                                   static_cast<uint64_t>(wall.tv_nsec);
+                offset_ns_ = static_cast<int64_t>(wall_ns - (before + (after - before) / 2));
+            }
+        }
+    }
+
+    /// @return Nanoseconds since the Unix epoch for a now() timestamp
+    uint64_t toWall(uint64_t mono_ns) const { return mono_ns + static_cast<uint64_t>(offset_ns_); }
+
+    /// @return Wall-clock minus monotonic time at calibration
+    int64_t wallOffset() const { return offset_ns_; }
+
+private:
+    static constexpr int CALIBRATION_ATTEMPTS = 16;
+
+    int64_t offset_ns_ = 0;
+};
+
+}  // namespace watcher
@@ -0,0 +1,377 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace watcher {
+
+struct EnrichedEvent;
+
+// ============================================================================
+// Constants & Configuration
+// ============================================================================
+
+constexpr uint32_t RECORDING_MAGIC = 0x43455257;          // "WREC"
+constexpr uint32_t RECORDING_SEGMENT_MAGIC = 0x47455357;  // "WSEG"
+constexpr uint32_t RECORDING_INDEX_MAGIC = 0x58444957;    // "WIDX"
+constexpr uint32_t RECORDING_VERSION = 2;                 // 1: no keyframes, no directory
+constexpr const char* RECORDING_FILE_NAME = "events.wrec";
+
+constexpr size_t RECORDING_SEGMENT_EVENTS = 4096;         // Events per segment, at most
+constexpr size_t RECORDING_SEGMENT_BYTES = 4 << 20;       // Raw payload that closes a segment
+constexpr uint64_t RECORDING_SEGMENT_MAX_AGE_NS = 250000000;  // Open segment age that closes it
+constexpr int RECORDING_ZLIB_LEVEL = 1;
+
+// A sub-page gets a keyframe on its first recorded write, then again after
+// this many events or changed bytes, so a seek replays at most that much
+constexpr uint32_t RECORDING_KEYFRAME_EVENTS = 64;
+constexpr uint64_t RECORDING_KEYFRAME_BYTES = 16 << 10;
+
+/// Payload compression of one segment. Values are the on-disk codec ids.
+enum class RecordingCodec : uint16_t {
+    NONE = 0,
+    ZLIB = 1,   // Only when built with zlib (WATCHER_HAVE_ZLIB)
+};
+
+/// What a segment holds. Values are the on-disk kind ids.
+enum class RecordingSegmentKind : uint16_t {
+    EVENTS = 0,
+    KEYFRAMES = 1,  // Sub-page contents after events of the next segment
+};
+
+// ============================================================================
+// On-Disk Layout (little-endian)
+// ============================================================================
+//
+//   RecordingFileHeader
+//   { RecordingSegmentHeader, payload[stored_size] } ...
+//   RecordingIndexEntry[segment_count]       footer index, one per segment
+//   variable directory[directory_size]       per-variable time index
+//   RecordingTrailer                          last 48 bytes of the file
+//
+// A file without a valid trailer (the writer died) is read by walking the
+// segment headers, and its directory is rebuilt from the segments; a
+// reopened writer drops the footer (or a torn tail segment) and appends
+// after the last good segment. Version 1 files have the same segments
+// (all EVENTS), a 32-byte trailer and no directory.
+//
+// Raw EVENTS payload for n events, in order:
+//   u64 event_seq[n], ts_ns[n], ip[n], page_base[n], fault_addr[n]
+//   u32 tid[n], var_index[n]
+//   i32 line[n]
+//   u32 symbol[n], file[n], var_name[n], sql_context[n]   string refs
+//   u32 var_count[n], delta_runs[n], delta_size[n]
+//   u32 byte length, then strings: varint count, { varint len, bytes }
+//   u32 byte length, then var ids: per event, var_count varint string refs
+//   u32 byte length, then deltas: per event, per run,
+//       { zigzag varint offset - previous run end, varint len, old[len], new[len] }
+// String ref 0 is the empty string, k >= 1 the k'th string of the segment.
+// delta_size[i] is the encoded size of event i's runs in the delta section.
+//
+// Raw KEYFRAMES payload for k keyframes; keyframe i is the contents of
+// [offset, offset + size) of the variable right after the event_pos'th
+// event of the EVENTS segment that follows:
+//   u64 ts_ns[k], event_seq[k]
+//   u32 variable[k] (string ref), offset[k], size[k], event_pos[k]
+//   u32 byte length, then strings (as above)
+//   u32 byte length, then contents, size[i] bytes each
+//
+// Variable directory: varint variable count, then per variable
+//   varint id length, id bytes
+//   varint span count, { varint segment, varint events, varint min_ts, varint max_ts - min_ts }
+//   varint keyframe count, { varint segment, varint slot, varint offset, varint ts }
+// A span lists an EVENTS segment with events of the variable (as any of
+// their variable_ids); keyframes are listed in file order.
+
+struct RecordingFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;   // sizeof(RecordingFileHeader)
+    uint32_t flags;         // Reserved, 0
+};
+static_assert(sizeof(RecordingFileHeader) == 16, "RecordingFileHeader is a 16-byte wire format");
+
+struct RecordingSegmentHeader {
+    uint32_t magic;
+    uint16_t codec;         // RecordingCodec
+    uint16_t kind;          // RecordingSegmentKind
+    uint32_t event_count;   // Events, or keyframes
+    uint32_t raw_size;      // Payload bytes before compression
+    uint32_t stored_size;   // Payload bytes that follow this header
+    uint32_t checksum;      // CRC-32 (zlib polynomial) of the stored payload
+    uint64_t min_ts_ns;
+    uint64_t max_ts_ns;
+};
+static_assert(sizeof(RecordingSegmentHeader) == 40, "RecordingSegmentHeader is a 40-byte wire format");
+
+struct RecordingIndexEntry {
+    uint64_t offset;        // File offset of the segment header
+    uint64_t min_ts_ns;
+    uint64_t max_ts_ns;
+    uint32_t event_count;
+    uint32_t kind;          // RecordingSegmentKind
+};
+static_assert(sizeof(RecordingIndexEntry) == 32, "RecordingIndexEntry is a 32-byte wire format");
+
+struct RecordingTrailer {
+    uint64_t index_offset;  // File offset of the first RecordingIndexEntry
+    uint64_t segment_count;
+    uint64_t event_count;   // Events in EVENTS segments
+    uint64_t directory_size;      // Bytes after the index entries
+    uint32_t directory_checksum;  // CRC-32 of the directory
+    uint32_t reserved;
+    uint32_t checksum;      // CRC-32 of the index entries
+    uint32_t magic;         // RECORDING_INDEX_MAGIC
+};
+static_assert(sizeof(RecordingTrailer) == 48, "RecordingTrailer is a 48-byte wire format");
+
+/// CRC-32 as zlib.crc32() computes it
+uint32_t recordingChecksum(const void* data, size_t len, uint32_t crc = 0);
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/// One segment as listed by the footer index (or found by a scan)
+struct RecordingSegmentInfo {
+    uint64_t offset;
+    uint64_t min_ts_ns;
+    uint64_t max_ts_ns;
+    uint32_t event_count;   // Events, or keyframes
+    RecordingSegmentKind kind;
+};
+
+/// Where one variable appears in a recording
+struct RecordingVariableIndex {
+    struct Span {
+        uint32_t segment;   // EVENTS segment ordinal
+        uint32_t events;    // Events of the variable in it
+        uint64_t min_ts_ns;
+        uint64_t max_ts_ns;
+    };
+    struct Keyframe {
+        uint32_t segment;   // KEYFRAMES segment ordinal
+        uint32_t slot;      // Keyframe within it
+        uint32_t offset;    // Variable offset of the captured sub-page
+        uint64_t ts_ns;     // Timestamp of the event it follows
+    };
+    std::vector<Span> spans;          // Ascending segment
+    std::vector<Keyframe> keyframes;  // File order
+};
+
+using RecordingDirectory = std::unordered_map<std::string, RecordingVariableIndex>;
+
+/// Sub-page contents captured after one event
+struct RecordingKeyframe {
+    uint64_t ts_ns;
+    uint64_t event_seq;
+    std::string variable_id;
+    uint32_t offset;
+    uint32_t event_pos;     // Event within the following EVENTS segment
+    std::vector<uint8_t> data;
+};
+
+/// Contents of one recorded sub-page of a variable at some time
+struct RecordedSubPage {
+    uint32_t offset;        // Variable offset
+    std::vector<uint8_t> data;
+};
+
+// ============================================================================
+// Recording Writer (slow-path only)
+// ============================================================================
+
+/// Appends enriched events to a segmented columnar file. Events collect in an
+/// open segment that is encoded, compressed and written with one write() once
+/// it is full or older than RECORDING_SEGMENT_MAX_AGE_NS; close() writes the
+/// footer index and variable directory. Not thread-safe: the slow-path
+/// thread owns it.
+///
+/// Pre/post snapshots are not recorded per event (the JSONL format omits
+/// them too); periodic keyframes of post_snapshot stand in for them.
+class RecordingWriter {
+public:
+    /// Open path for appending, creating it if needed
+    /// @return nullptr if the file cannot be opened or is not a recording
+    static std::unique_ptr<RecordingWriter> open(const std::string& path,
+                                                 RecordingCodec codec = defaultCodec());
+
+    /// Best codec this build supports
+    static RecordingCodec defaultCodec();
+
+    ~RecordingWriter();
+
+    RecordingWriter(const RecordingWriter&) = delete;
+    RecordingWriter& operator=(const RecordingWriter&) = delete;
+
+    /// Add one event to the open segment (written once the segment is full)
+    /// @return false if a full segment could not be written. It stays open
+    ///         and is retried; while it is still full the event is not added.
+    bool append(const EnrichedEvent& event);
+
+    /// Write the open segment if it reached RECORDING_SEGMENT_MAX_AGE_NS
+    /// @param now_ns EventClock::now()
+    bool flush(uint64_t now_ns);
+
+    /// Write the open segment now
+    bool sync();
+
+    /// Write the open segment and the footer; further appends reopen it
+    bool close();
+
+    uint64_t eventsWritten() const { return events_written_; }
+    size_t segmentCount() const { return index_.size(); }
+    uint64_t keyframesWritten() const { return keyframes_written_; }
+
+private:
+    /// Keyframe pacing for one sub-page of one variable
+    struct SubPageCadence {
+        uint32_t events = 0;
+        uint64_t bytes = 0;
+    };
+
+    /// Strings of one segment: { varint len, bytes } each, refs from 1
+    struct StringTable {
+        std::vector<uint8_t> bytes;
+        uint32_t count = 0;
+        std::unordered_map<std::string, uint32_t> refs;
+
+        uint32_t intern(const std::string& s);
+        void clear();
+    };
+
+    RecordingWriter(int fd, RecordingCodec codec) : fd_(fd), codec_(codec) {}
+
+    bool recover(const std::string& path);
+    bool segmentFull() const;
+    bool writeSegment();
+    /// Write raw_ as one segment at offset and advance it; entry receives
+    /// its index entry, which the caller commits
+    bool writePayload(RecordingSegmentKind kind, uint32_t count, const std::vector<uint64_t>& ts,
+                      uint64_t& offset, RecordingIndexEntry& entry);
+
+    int fd_;
+    RecordingCodec codec_;
+    uint64_t end_ = 0;            // File offset after the last good segment
+    bool footer_written_ = false;
+    uint64_t events_written_ = 0;
+    uint64_t keyframes_written_ = 0;
+    std::vector<RecordingIndexEntry> index_;
+    RecordingDirectory directory_;
+    std::unordered_map<std::string, std::unordered_map<uint32_t, SubPageCadence>> cadence_;
+
+    // Open segment, one vector per column
+    uint64_t opened_ns_ = 0;
+    std::vector<uint64_t> seq_, ts_, ip_, page_base_, fault_addr_;
+    std::vector<uint32_t> tid_, var_index_;
+    std::vector<int32_t> line_;
+    std::vector<uint32_t> symbol_, file_, var_name_, sql_;
+    std::vector<uint32_t> var_count_, delta_runs_, delta_size_;
+    std::vector<uint8_t> var_ids_, deltas_;
+    StringTable strings_;
+    std::unordered_map<std::string, RecordingVariableIndex::Span> open_spans_;
+
+    // Keyframes taken for the open segment
+    std::vector<uint64_t> kf_ts_, kf_seq_;
+    std::vector<uint32_t> kf_var_, kf_offset_, kf_size_, kf_pos_;
+    std::vector<uint8_t> kf_data_;
+    StringTable kf_strings_;
+    std::vector<std::string> kf_ids_;  // kf_var_[i] names kf_ids_[kf_var_[i] - 1]
+
+    std::vector<uint8_t> raw_, stored_;
+};
+
+// ============================================================================
+// Recording Reader (streaming, with seeks through the variable directory)
+// ============================================================================
+
+/// Reads a recording one segment at a time; only the current segment is
+/// held in memory, so files larger than RAM stream through. Per-variable
+/// queries read only the segments the directory points at.
+class RecordingReader {
+public:
+    RecordingReader() = default;
+    ~RecordingReader();
+
+    RecordingReader(const RecordingReader&) = delete;
+    RecordingReader& operator=(const RecordingReader&) = delete;
+
+    /// Open a recording and load its segment list and directory
+    /// @return false (see error()) if it is missing or not a recording
+    bool open(const std::string& path);
+
+    /// Segments in file order (EVENTS and KEYFRAMES)
+    const std::vector<RecordingSegmentInfo>& segments() const { return segments_; }
+
+    /// True if the segment list came from the footer (false: scanned)
+    bool hasIndex() const { return has_index_; }
+
+    /// Events in EVENTS segments
+    uint64_t eventCount() const;
+
+    /// File offset just past the last good segment
+    uint64_t dataEnd() const { return data_end_; }
+
+    /// Per-variable time index (from the footer, or rebuilt by a scan)
+    const RecordingDirectory& directory() const { return directory_; }
+
+    /// Decode EVENTS segment i into out (cleared first)
+    /// @return false on a corrupt segment, a read error or a KEYFRAMES segment
+    bool readSegment(size_t i, std::vector<EnrichedEvent>& out);
+
+    /// Decode KEYFRAMES segment i into out (cleared first)
+    bool readKeyframes(size_t i, std::vector<RecordingKeyframe>& out);
+
+    /// Next event in file order
+    /// @return false at the end or on error (error() non-empty)
+    bool next(EnrichedEvent& out);
+
+    /// Events of variable_id (as any of their variable_ids) with
+    /// ts_ns in [start_ns, end_ns], in file order
+    /// @return false on error; an unknown variable yields no events
+    bool variableEvents(const std::string& variable_id, uint64_t start_ns, uint64_t end_ns,
+                        std::vector<EnrichedEvent>& out);
+
+    /// Contents of variable_id's recorded sub-pages at ts_ns: the nearest
+    /// keyframe, then that sub-page's deltas replayed forward to ts_ns (or
+    /// undone back to it, before the first keyframe). Sub-pages never
+    /// written in the recording are absent. Only events whose first
+    /// variable is variable_id carry its deltas.
+    /// @param out One entry per recorded sub-page, ascending offset
+    bool variableState(const std::string& variable_id, uint64_t ts_ns, std::vector<RecordedSubPage>& out);
+
+    const std::string& error() const { return error_; }
+
+private:
+    bool scan(uint64_t file_size);
+    bool loadPayload(size_t i, RecordingSegmentKind kind, RecordingSegmentHeader& header);
+    bool decode(const RecordingSegmentHeader& header, std::vector<EnrichedEvent>& out);
+    bool decodeKeyframes(uint32_t count, std::vector<RecordingKeyframe>& out);
+    bool parseDirectory(const uint8_t* data, size_t len);
+    bool rebuildDirectory();
+    const std::vector<EnrichedEvent>* cachedSegment(size_t i);
+
+    int fd_ = -1;
+    uint32_t version_ = 0;
+    bool has_index_ = false;
+    uint64_t data_end_ = 0;
+    std::vector<RecordingSegmentInfo> segments_;
+    RecordingDirectory directory_;
+    std::string error_;
+
+    // next() state
+    std::vector<EnrichedEvent> current_;
+    size_t next_segment_ = 0;
+    size_t next_event_ = 0;
+
+    // Last segment decoded by a query
+    std::vector<EnrichedEvent> cached_;
+    size_t cached_index_ = SIZE_MAX;
+    std::vector<uint8_t> stored_, raw_;
+};
+
+}  // namespace watcher
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace watcher {
+
+// ============================================================================
+// Constants & Helpers
+// ============================================================================
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/// Round up to the next power of two (minimum 2)
+inline size_t roundUpPowerOfTwo(size_t n) {
+    size_t v = 2;
+    while (v < n) {
+        v <<= 1;
+    }
+    return v;
+}
+
+// ============================================================================
+// Bounded SPSC Ring (Single Producer, Single Consumer)
+// ============================================================================
+
+/// Preallocated ring buffer for trivially copyable records.
+/// Producer and consumer cursors live on separate cache lines, and each side
+/// keeps a cached copy of the other's cursor so the common case touches only
+/// its own line. No allocation happens after construction.
+template <typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscRing requires trivially copyable records");
+
+public:
+    /// @param capacity Requested capacity (rounded up to a power of two)
+    explicit SpscRing(size_t capacity)
+        : capacity_(roundUpPowerOfTwo(capacity)),
+          mask_(capacity_ - 1),
+          slots_(new T[capacity_]()) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /// Producer side. Returns false if the ring is full.
+    bool tryPush(const T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ >= capacity_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ >= capacity_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side. Returns false if the ring is empty.
+    bool tryPop(T& item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        item = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side. Pops up to max_items records with a single cursor update.
+    size_t popBatch(T* out, size_t max_items) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        size_t available = cached_tail_ - head;
+        size_t n = available < max_items ? available : max_items;
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = slots_[(head + i) & mask_];
+        }
+        if (n > 0) {
+            head_.store(head + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+    size_t size() const {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t head = head_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    // Consumer-owned line
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+
+    // Producer-owned line
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;
+
+    // Read-only after construction
+    alignas(CACHE_LINE_SIZE) const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> slots_;
+};
+
+// ============================================================================
+// Bounded MPSC Ring (Multiple Producers, Single Consumer)
+// ============================================================================
+
+/// Per-slot sequence numbers let producers claim slots with one CAS on the
+/// tail cursor and publish them independently (Vyukov-style bounded queue).
+template <typename T>
+class MpscRing {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "MpscRing requires trivially copyable records");
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+public:
+    /// @param capacity Requested capacity (rounded up to a power of two)
+    explicit MpscRing(size_t capacity)
+        : capacity_(roundUpPowerOfTwo(capacity)),
+          mask_(capacity_ - 1),
+          cells_(new Cell[capacity_]) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    /// Producer side (any thread). Returns false if the ring is full.
+    bool tryPush(const T& item) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = item;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // Full
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Consumer side. Returns false if the ring is empty or the next slot
+    /// has been claimed but not yet published.
+    bool tryPop(T& item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[head & mask_];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (seq != head + 1) {
+            return false;
+        }
+        item = cell.data;
+        cell.sequence.store(head + capacity_, std::memory_order_release);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side. Pops up to max_items published records.
+    size_t popBatch(T* out, size_t max_items) {
+        size_t n = 0;
+        while (n < max_items && tryPop(out[n])) {
+            ++n;
+        }
+        return n;
+    }
+
+    size_t size() const {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t head = head_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+    alignas(CACHE_LINE_SIZE) const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+};
+
+}  // namespace watcher
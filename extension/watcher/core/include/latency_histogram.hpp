@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace watcher {
+
+// ============================================================================
+// Latency Histogram (HDR-style log-linear buckets)
+// ============================================================================
+
+/// Fixed-size log-linear histogram of nanosecond values. Each power of two
+/// is split into 2^SUB_BUCKET_BITS linear buckets, so any recorded value is
+/// reported within ~3% of its true value. Values above MAX_VALUE_NS are
+/// clamped into the top bucket.
+/// Single writer: record() uses plain relaxed load/store, never a locked
+/// instruction. Any thread may read concurrently.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr unsigned MAX_VALUE_BITS = 40;  // ~18 minutes
+    static constexpr uint64_t MAX_VALUE_NS = (uint64_t(1) << MAX_VALUE_BITS) - 1;
+    static constexpr size_t BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+    LatencyHistogram() {
+        for (auto& bucket : counts_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    static size_t bucketOf(uint64_t value) {
+        value = std::min(value, MAX_VALUE_NS);
+        unsigned msb = value ? 63 - __builtin_clzll(value) : 0;
+        unsigned shift = msb > SUB_BUCKET_BITS ? msb - SUB_BUCKET_BITS : 0;
+        return (size_t(shift) << SUB_BUCKET_BITS) + (value >> shift);
+    }
+
+    /// @return Highest value that maps to bucket
+    static uint64_t bucketUpper(size_t bucket) {
+        size_t octave = bucket >> SUB_BUCKET_BITS;
+        unsigned shift = octave ? static_cast<unsigned>(octave - 1) : 0;
+        uint64_t mantissa = bucket - (size_t(shift) << SUB_BUCKET_BITS);
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    /// Record count samples of value (owning thread only)
+    void record(uint64_t value, uint64_t count = 1) {
+        bump(counts_[bucketOf(value)], count);
+        bump(total_, count);
+        bump(sum_, value * count);
+        if (value < min_.load(std::memory_order_relaxed)) {
+            min_.store(value, std::memory_order_relaxed);
+        }
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t count(size_t bucket) const { return counts_[bucket].load(std::memory_order_relaxed); }
+    uint64_t total() const { return total_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t min() const { return min_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+private:
+    static void bump(std::atomic<uint64_t>& cell, uint64_t n) {
+        cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> counts_[BUCKETS];
+    std::atomic<uint64_t> total_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> min_{UINT64_MAX};
+    std::atomic<uint64_t> max_{0};
+};
+
+/// Merged view of every thread's histogram for one recorder
+struct LatencySnapshot {
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t min = 0;
+    uint64_t max = 0;
+
+    double mean() const { return total ? static_cast<double>(sum) / total : 0.0; }
+
+    /// @param q Quantile in [0, 1]
+    /// @return Upper bound of the bucket holding the q-th sample, or 0 if empty
+    uint64_t percentile(double q) const {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+        rank = std::max<uint64_t>(1, std::min(rank, total));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < counts.size(); ++b) {
+            seen += counts[b];
+            if (seen >= rank) {
+                return std::min(LatencyHistogram::bucketUpper(b), max);
+            }
+        }
+        return max;
+    }
+};
+
+/// One histogram per recording thread, created on that thread's first
+/// record() and merged on read. The hot path is a thread-local lookup plus
+/// the histogram's store-only update.
+class LatencyRecorder {
+public:
+    LatencyRecorder() : id_(nextId()) {}
+
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+    void record(uint64_t value, uint64_t count = 1) { local().record(value, count); }
+
+    LatencySnapshot snapshot() const {
+        LatencySnapshot snap;
+        snap.counts.assign(LatencyHistogram::BUCKETS, 0);
+        uint64_t min = UINT64_MAX;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& shard : shards_) {
+            for (size_t b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+                snap.counts[b] += shard->count(b);
+            }
+            snap.total += shard->total();
+            snap.sum += shard->sum();
+            min = std::min(min, shard->min());
+            snap.max = std::max(snap.max, shard->max());
+        }
+        snap.min = snap.total ? min : 0;
+        return snap;
+    }
+
+private:
+    static uint64_t nextId() {
+        static std::atomic<uint64_t> next(1);
+        return next.fetch_add(1);
+    }
+
+    /// Histograms outlive their threads; recorder ids are never reused, so
+    /// stale thread-local entries can never match a live recorder
+    LatencyHistogram& local() {
+        thread_local std::vector<std::pair<uint64_t, LatencyHistogram*>> cache;
+        for (const auto& entry : cache) {
+            if (entry.first == id_) {
+                return *entry.second;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        shards_.push_back(std::make_unique<LatencyHistogram>());
+        cache.emplace_back(id_, shards_.back().get());
+        return *shards_.back();
+    }
+
+    const uint64_t id_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<LatencyHistogram>> shards_;
+};
+
+}  // namespace watcher
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "page_shadow.hpp"
+#include "sampling_policy.hpp"
+
+namespace watcher {
+
+// ============================================================================
+// Page Address Index (fault address -> watched variables)
+// ============================================================================
+
+/// One watched range as seen by the fault path
+struct IndexedRange {
+    uint64_t start;
+    uint64_t end;
+    uint64_t granule;                    // Backing page size
+    uint32_t var_index;                  // Numeric variable handle (see VariableMetadata)
+    std::shared_ptr<PageShadow> shadow;  // Kept alive until the table is retired
+    uint32_t flags = 0;                  // EventFlags of the variable
+    std::shared_ptr<SamplingGate> sampling;  // nullptr: every fault is an event
+};
+
+/// Immutable sorted interval table. Overlapping ranges are split into
+/// disjoint segments, each listing every range that covers it, so a lookup
+/// is one binary search and returns all variables for the address.
+class PageIndexTable {
+public:
+    struct Segment {
+        uint64_t start;
+        uint64_t end;
+        uint32_t first;  // Offset into members
+        uint32_t count;
+    };
+
+    explicit PageIndexTable(std::vector<IndexedRange> ranges) : ranges_(std::move(ranges)) {
+        ranges_.erase(std::remove_if(ranges_.begin(), ranges_.end(),
+                                     [](const IndexedRange& r) { return r.end <= r.start; }),
+                      ranges_.end());
+        std::sort(ranges_.begin(), ranges_.end(),
+                  [](const IndexedRange& a, const IndexedRange& b) { return a.start < b.start; });
+
+        std::vector<uint64_t> bounds;
+        bounds.reserve(ranges_.size() * 2);
+        for (const auto& range : ranges_) {
+            bounds.push_back(range.start);
+            bounds.push_back(range.end);
+        }
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+        // Sweep the boundaries, keeping the set of ranges open at each one
+        std::vector<uint32_t> active;
+        size_t next = 0;
+        for (size_t b = 0; b + 1 < bounds.size(); ++b) {
+            uint64_t at = bounds[b];
+            active.erase(std::remove_if(active.begin(), active.end(),
+                                        [&](uint32_t r) { return ranges_[r].end <= at; }),
+                         active.end());
+            while (next < ranges_.size() && ranges_[next].start == at) {
+                active.push_back(static_cast<uint32_t>(next++));
+            }
+            if (active.empty()) {
+                continue;
+            }
+            segments_.push_back({at, bounds[b + 1], static_cast<uint32_t>(members_.size()),
+                                 static_cast<uint32_t>(active.size())});
+            members_.insert(members_.end(), active.begin(), active.end());
+        }
+    }
+
+    /// @return Segment covering addr, or nullptr
+    const Segment* find(uint64_t addr) const {
+        auto it = std::upper_bound(segments_.begin(), segments_.end(), addr,
+                                   [](uint64_t a, const Segment& s) { return a < s.start; });
+        if (it == segments_.begin()) {
+            return nullptr;
+        }
+        --it;
+        return addr < it->end ? &*it : nullptr;
+    }
+
+    const IndexedRange& member(const Segment& seg, uint32_t i) const {
+        return ranges_[members_[seg.first + i]];
+    }
+
+    const std::vector<IndexedRange>& ranges() const { return ranges_; }
+    const std::vector<Segment>& segments() const { return segments_; }
+
+private:
+    std::vector<IndexedRange> ranges_;
+    std::vector<Segment> segments_;
+    std::vector<uint32_t> members_;
+};
+
+/// RCU-style holder: readers pin the current table with two atomic
+/// increments and never block; the writer publishes a replacement and waits
+/// for readers of the previous epoch to leave before freeing the old table.
+class PageIndex {
+public:
+    /// Pins the current table for the guard's lifetime
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const PageIndex& index) : index_(index) {
+            for (;;) {
+                epoch_ = index_.epoch_.load();
+                index_.readers_[epoch_ & 1].fetch_add(1);
+                if (index_.epoch_.load() == epoch_) {
+                    break;
+                }
+                index_.readers_[epoch_ & 1].fetch_sub(1);
+            }
+            table_ = index_.table_.load();
+        }
+
+        ~ReadGuard() { index_.readers_[epoch_ & 1].fetch_sub(1); }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        /// @return Current table, or nullptr before the first publish
+        const PageIndexTable* table() const { return table_; }
+
+    private:
+        const PageIndex& index_;
+        uint64_t epoch_;
+        const PageIndexTable* table_;
+    };
+
+    PageIndex() = default;
+    ~PageIndex() { delete table_.load(); }
+
+    PageIndex(const PageIndex&) = delete;
+    PageIndex& operator=(const PageIndex&) = delete;
+
+    /// Replace the table. Writers must be serialized by the caller.
+    void publish(std::vector<IndexedRange> ranges) {
+        auto* next = new PageIndexTable(std::move(ranges));
+        const PageIndexTable* prev = table_.exchange(next);
+
+        // Grace period: readers that may hold prev entered under the old epoch
+        uint64_t old_epoch = epoch_.fetch_add(1);
+        while (readers_[old_epoch & 1].load() != 0) {
+            std::this_thread::yield();
+        }
+        delete prev;
+    }
+
+private:
+    std::atomic<const PageIndexTable*> table_{nullptr};
+    alignas(64) mutable std::atomic<uint64_t> epoch_{0};
+    alignas(64) mutable std::atomic<uint64_t> readers_[2] = {{0}, {0}};
+};
+
+}  // namespace watcher
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace watcher {
+
+// ============================================================================
+// Shadow Arena (memfd-backed store shared by every PageShadow)
+// ============================================================================
+
+/// Backing store for shadows: one memfd mapped in large chunks, so
+/// registering a variable carves a block instead of mapping its own region
+/// (one mmap and one VMA per CHUNK_SIZE, not per variable). Tracked lengths
+/// up to half a sub-page are packed into power-of-two slots; longer ones get
+/// whole sub-pages. Memory is committed on first write. Freed sub-page
+/// blocks are punched out of the memfd and reused for the same size.
+class ShadowArena {
+public:
+    static constexpr size_t SUBPAGE_SIZE = 4096;
+    static constexpr size_t CHUNK_SIZE = size_t(64) << 20;
+    static constexpr size_t MIN_SLOT = 64;
+
+    /// Process-wide arena (shadows keep it alive)
+    static std::shared_ptr<ShadowArena> shared();
+
+    ShadowArena();
+    ~ShadowArena();
+
+    ShadowArena(const ShadowArena&) = delete;
+    ShadowArena& operator=(const ShadowArena&) = delete;
+
+    /// @return Block of at least len bytes (sub-page aligned above
+    ///         SUBPAGE_SIZE / 2), or nullptr if the arena cannot grow
+    uint8_t* allocate(size_t len);
+    /// Return a block from allocate(len)
+    void release(uint8_t* block, size_t len);
+
+    /// Bytes of address space a len-byte allocation takes
+    static size_t blockSize(size_t len);
+    /// memfd behind the chunks, or -1 if anonymous memory is used instead
+    int fd() const { return fd_; }
+    /// Sum of blockSize() over live allocations
+    size_t bytesInUse() const;
+
+private:
+    uint8_t* carve(size_t size);  // Caller holds mutex_
+
+    mutable std::mutex mutex_;
+    int fd_;
+    size_t file_size_;
+    std::vector<std::pair<uint8_t*, size_t>> chunks_;
+    uint8_t* cursor_;     // Next free byte of the newest chunk
+    size_t remaining_;
+    std::unordered_map<size_t, std::vector<uint8_t*>> free_;  // Block size -> free blocks
+    size_t in_use_;
+};
+
+/// Immutable snapshot shared by every reader until the variable changes
+using SnapshotView = std::shared_ptr<const std::vector<uint8_t>>;
+
+// ============================================================================
+// Page Shadow (lazily captured per-sub-page copy of a watched range)
+// ============================================================================
+
+/// Last-seen contents of a watched range, kept per 4 KiB sub-page.
+/// Backing memory comes from a ShadowArena and is only committed for
+/// sub-pages that have been written, so registering a large buffer costs no
+/// copy. Only the tracked length is ever copied: a 16-byte span costs 16
+/// bytes per capture, not a whole sub-page. A sub-page is marked dirty the
+/// first time it is captured; clean sub-pages are known to still match live
+/// memory because every write to them faults first. markDirty() may run on
+/// the fault path concurrently with slow-path work on other sub-pages;
+/// everything else is guarded by variables_mutex_.
+class PageShadow {
+public:
+    static constexpr size_t SUBPAGE_SIZE = 4096;
+
+    /// @param len Tracked length in bytes (the last sub-page may be partial)
+    /// @param arena Backing store (ShadowArena::shared() if null)
+    explicit PageShadow(size_t len, std::shared_ptr<ShadowArena> arena = nullptr);
+    ~PageShadow();
+
+    PageShadow(const PageShadow&) = delete;
+    PageShadow& operator=(const PageShadow&) = delete;
+
+    /// @return false if the backing reservation failed
+    bool valid() const { return data_ != nullptr; }
+
+    /// Tracked length: snapshots and baselines are this many bytes
+    size_t bytes() const { return bytes_; }
+    /// Sub-page span (bytes() rounded up to SUBPAGE_SIZE)
+    size_t size() const { return size_; }
+    size_t subPageCount() const { return size_ / SUBPAGE_SIZE; }
+    /// Tracked bytes of a sub-page (SUBPAGE_SIZE except for the last)
+    size_t subPageBytes(size_t index) const { return std::min(SUBPAGE_SIZE, bytes_ - index * SUBPAGE_SIZE); }
+    size_t dirtyCount() const { return dirty_count_.load(std::memory_order_relaxed); }
+
+    bool isDirty(size_t index) const {
+        return (dirty_[index / 64].load(std::memory_order_acquire) >> (index % 64)) & 1;
+    }
+
+    /// Capture a sub-page's pre-state on its first write
+    /// @param index Sub-page index (ignored past subPageCount())
+    /// @param live Current contents of that sub-page
+    /// @return true if the sub-page was clean and has now been captured
+    bool markDirty(size_t index, const uint8_t* live);
+
+    /// Capture every clean sub-page from live memory (eager baseline)
+    void captureAll(const uint8_t* live);
+
+    /// Replace the baseline: the first len bytes come from baseline, the rest
+    /// from live memory. Marks every sub-page dirty.
+    void assign(const uint8_t* baseline, size_t len, const uint8_t* live);
+
+    /// Take a sub-page's new baseline (after diffing)
+    /// @param contents The post-state just reported, not a second read of
+    ///        live memory: a write in between would be in no event's delta
+    void refresh(size_t index, const uint8_t* contents);
+
+    /// Bumped whenever materialize() output can change (refresh, assign).
+    /// First-write captures do not count: they copy bytes that still match.
+    uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+    /// Shadow bytes of one sub-page (meaningful only when dirty)
+    uint8_t* subPage(size_t index) { return data_ + index * SUBPAGE_SIZE; }
+    const uint8_t* subPage(size_t index) const { return data_ + index * SUBPAGE_SIZE; }
+
+    /// Full baseline: dirty sub-pages from the shadow, clean ones from live
+    /// @param live Live range (at least bytes() bytes)
+    /// @param out Destination (at least bytes() bytes)
+    void materialize(const uint8_t* live, uint8_t* out) const;
+
+    /// materialize() into a shared buffer, reused until generation() moves
+    /// @param live Live range (at least bytes() bytes)
+    SnapshotView view(const uint8_t* live);
+
+private:
+    std::shared_ptr<ShadowArena> arena_;
+    uint8_t* data_;
+    size_t bytes_;
+    size_t size_;
+    size_t words_;
+    std::atomic<size_t> dirty_count_;
+    std::unique_ptr<std::atomic<uint64_t>[]> dirty_;
+    std::atomic<uint64_t> generation_;
+    SnapshotView view_;
+    uint64_t view_generation_;
+};
+
+}  // namespace watcher
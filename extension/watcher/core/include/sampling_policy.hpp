@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace watcher {
+
+// ============================================================================
+// Sampling Policies (per-variable limits for hot pages)
+// ============================================================================
+
+/// How many write faults on a variable become events. Skipped faults lose
+/// no data: the shadow keeps the last emitted state, so the next event's
+/// deltas cover every write since then.
+struct SamplingPolicy {
+    enum Mode : uint32_t {
+        ALL,         // One event per write fault
+        EVERY_NTH,   // One event per every_n write faults
+        RATE_LIMIT,  // At most max_per_second events (token bucket, burst of one second)
+        COALESCE     // The first write opens a window_us window: the page stays
+                     // writable until it closes, then one event carries the
+                     // combined delta. 4 KiB pages in SYNC mode only; elsewhere
+                     // it emits at most one event per window.
+    };
+    Mode mode = ALL;
+    uint32_t every_n = 1;
+    uint32_t max_per_second = 0;
+    uint32_t window_us = 0;
+
+    /// @return false if the mode's parameter is zero or the mode is unknown
+    bool valid() const {
+        switch (mode) {
+            case ALL: return true;
+            case EVERY_NTH: return every_n > 0;
+            case RATE_LIMIT: return max_per_second > 0;
+            case COALESCE: return window_us > 0;
+        }
+        return false;
+    }
+};
+
+/// Admission state of one variable's policy. Only the handler thread that
+/// owns the variable calls admit(), so the counters are plain fields.
+class SamplingGate {
+public:
+    enum Decision { EMIT, SKIP, COALESCE };
+
+    explicit SamplingGate(const SamplingPolicy& policy)
+        : policy_(policy), tokens_(static_cast<uint64_t>(policy.max_per_second) * NS_PER_SEC) {}
+
+    const SamplingPolicy& policy() const { return policy_; }
+    uint64_t windowNs() const { return static_cast<uint64_t>(policy_.window_us) * 1000; }
+
+    /// Decide for one write fault
+    /// @param ts_ns Fault time (EventClock::now())
+    /// @param can_coalesce Whether the caller can hold the page open for a window
+    Decision admit(uint64_t ts_ns, bool can_coalesce) {
+        switch (policy_.mode) {
+            case SamplingPolicy::EVERY_NTH:
+                return ++writes_ % policy_.every_n == 0 ? EMIT : SKIP;
+            case SamplingPolicy::RATE_LIMIT: {
+                // Tokens are kept in event-nanoseconds: one event costs NS_PER_SEC
+                uint64_t capacity = static_cast<uint64_t>(policy_.max_per_second) * NS_PER_SEC;
+                uint64_t elapsed = std::min<uint64_t>(ts_ns - std::min(ts_ns, last_ns_), NS_PER_SEC);
+                tokens_ = std::min(capacity, tokens_ + elapsed * policy_.max_per_second);
+                last_ns_ = ts_ns;
+                if (tokens_ < NS_PER_SEC) {
+                    return SKIP;
+                }
+                tokens_ -= NS_PER_SEC;
+                return EMIT;
+            }
+            case SamplingPolicy::COALESCE:
+                if (can_coalesce) {
+                    return COALESCE;
+                }
+                if (ts_ns < window_end_ns_) {
+                    return SKIP;
+                }
+                window_end_ns_ = ts_ns + windowNs();
+                return EMIT;
+            default:
+                return EMIT;
+        }
+    }
+
+private:
+    static constexpr uint64_t NS_PER_SEC = 1000000000ull;
+
+    SamplingPolicy policy_;
+    uint64_t writes_ = 0;
+    uint64_t tokens_;
+    uint64_t last_ns_ = 0;
+    uint64_t window_end_ns_ = 0;
+};
+
+}  // namespace watcher
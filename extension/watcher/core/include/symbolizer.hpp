@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace watcher {
+
+// ============================================================================
+// Constants & Configuration
+// ============================================================================
+
+constexpr size_t SYMBOL_CACHE_SLOTS = 4096;        // Front cache, power of two
+constexpr size_t SYMBOL_CACHE_MAX_RESULTS = 1 << 16;  // Distinct ips kept resolved
+
+// ============================================================================
+// Symbolizer (in-process ELF symtab + DWARF line tables)
+// ============================================================================
+
+/// Maps instruction pointers in this process to function, source file and
+/// line. Loaded objects are discovered with dl_iterate_phdr (and again when
+/// an ip falls outside every known object, which follows dlopen); each
+/// object's .symtab/.dynsym and .debug_line are read once, on its first
+/// lookup, into address-sorted tables. Repeat lookups are answered from a
+/// lock-free direct-mapped cache; misses serialize on one mutex.
+///
+/// Results are immutable for the symbolizer's lifetime, so an ip whose code
+/// was dlclose'd and replaced keeps its first answer.
+class Symbolizer {
+public:
+    struct Result {
+        uint64_t ip;
+        std::string symbol;   // Demangled function name, or "??"
+        std::string file;     // Source file, else the object's path, else "??"
+        int line;             // 0 without line information
+        bool known;           // ip lies in a loaded object
+    };
+
+    Symbolizer();
+    ~Symbolizer();
+
+    Symbolizer(const Symbolizer&) = delete;
+    Symbolizer& operator=(const Symbolizer&) = delete;
+
+    /// @return Resolution of ip (never null). Valid as long as the symbolizer,
+    ///         except past SYMBOL_CACHE_MAX_RESULTS distinct ips, where it is
+    ///         valid until the calling thread's next uncached lookup
+    const Result* resolve(uint64_t ip);
+
+    /// resolve() into separate fields
+    /// @return false if no loaded object contains ip
+    bool resolve(uint64_t ip, std::string& symbol, std::string& file, int& line);
+
+    /// Re-read the list of loaded objects (parsed tables are kept)
+    void refresh();
+
+    /// Loaded objects currently known
+    size_t moduleCount();
+
+private:
+    struct Module;
+
+    const Result* resolveSlow(uint64_t ip);
+    Module* findModule(uint64_t ip);
+    void refreshLocked();
+
+    static size_t slotFor(uint64_t ip) {
+        return static_cast<size_t>((ip * 0x9E3779B97F4A7C15ull) >> 52) & (SYMBOL_CACHE_SLOTS - 1);
+    }
+
+    std::unique_ptr<std::atomic<const Result*>[]> cache_;
+    std::mutex mutex_;                       // Everything below
+    std::vector<std::unique_ptr<Module>> modules_;
+    std::deque<Result> results_;             // Stable addresses for cache_
+};
+
+}  // namespace watcher
@@ -6,6 +6,12 @@
 #include <vector>
 #include <memory>
 #include <chrono>
+#include <functional>
+#include <sys/types.h>
+#include "delta_engine.hpp"
+#include "event_channel.hpp"
+#include "page_shadow.hpp"
+#include "sampling_policy.hpp"
 
 namespace watcher {
 
@@ -15,8 +21,14 @@ namespace watcher {
 
 constexpr size_t PAGE_SIZE = 4096;
 constexpr size_t HEADER_SIZE = 64;
-constexpr size_t MAX_CONCURRENT_WORKERS = 3;
+constexpr size_t MAX_CONCURRENT_WORKERS = 3;    // Cap on fault handler shards
 constexpr size_t EVENT_QUEUE_CAPACITY = 10000;
+constexpr size_t SLOW_PATH_BATCH_SIZE = 256;
+constexpr size_t FAULT_BATCH_SIZE = 64;          // uffd messages read per wakeup
+constexpr uint64_t RELEASE_WAIT_NS = 20000;      // SYNC: wait for released writes before re-protecting
+constexpr uint32_t ASYNC_SCAN_INTERVAL_US = 1000;
+constexpr size_t FAST_PATH_MAX_VARS = 3;         // Variable tags carried per fast-path event
+constexpr unsigned EVENT_SEQ_SHARD_SHIFT = 56;   // event_seq: shard above, per-shard count below
 constexpr uint32_t MAGIC = 0xFDB10001;
 
 // ============================================================================
@@ -24,6 +36,10 @@ constexpr uint32_t MAGIC = 0xFDB10001;
 // ============================================================================
 
 // Event flags for registration
+// Without FLAG_TRACK_THREADS (or FLAG_TRACK_ALL) the core skips writer
+// attribution for the variable: no IP capture or symbol lookup, and events
+// carry tid 0 and ip 0 (unless another variable on the page asks for it).
+// SQL and locals context is collected by the adapters.
 enum EventFlags : uint32_t {
     FLAG_TRACK_THREADS = 1 << 0,
     FLAG_TRACK_SQL = 1 << 1,
@@ -31,26 +47,82 @@ enum EventFlags : uint32_t {
     FLAG_TRACK_LOCALS = 1 << 3,
 };
 
+/// Whether flags ask for the writing thread and instruction pointer
+inline bool tracksThreads(uint32_t flags) {
+    return (flags & (FLAG_TRACK_THREADS | FLAG_TRACK_ALL)) != 0;
+}
+
 // Mutation depth specification
+// With full_page == false only the first byte_range bytes of the range are
+// armed, snapshotted and diffed (byte_range 0 means the whole range)
 struct MutationDepth {
     bool full_page;
     size_t byte_range;  // Only if full_page == false
 };
 
 // Minimal fast-path event (enqueued immediately on fault)
+// Plain-old-data so it can be copied into the preallocated event ring
+// without touching the allocator on the fault path.
 struct FastPathEvent {
-    std::string event_id;  // UUID
-    uint64_t ts_ns;        // Timestamp in nanoseconds
+    uint64_t event_seq;    // Handler shard << EVENT_SEQ_SHARD_SHIFT | per-shard sequence
+    uint64_t ts_ns;        // CLOCK_MONOTONIC_RAW nanoseconds (see EventClock)
     void* page_base;       // Page address (not offset)
     void* fault_addr;      // Exact fault address
-    pid_t tid;             // Thread ID
+    pid_t tid;             // Thread ID (0 unless a covering variable tracks threads)
+    uint32_t flags;        // EventFlags of the covering variables, OR-ed
     uint64_t ip;           // Instruction pointer
+    uint32_t var_count;    // Variables covering fault_addr (may exceed FAST_PATH_MAX_VARS)
+    uint32_t var_index[FAST_PATH_MAX_VARS];  // Their VariableMetadata::index, in address order
+};
+
+/// How write faults on watched pages are resolved
+enum class FaultMode {
+    SYNC,        // Faulting thread blocks until the handler unprotects the page
+    ASYNC_SCAN   // Kernel resolves faults (UFFD_FEATURE_WP_ASYNC); the handler
+                 // collects written pages with PAGEMAP_SCAN. No tid/ip per event.
 };
 
+/// How the faulting instruction pointer is captured
+enum class IpCapture {
+    PROC_SYSCALL,  // Handler reads /proc/<tid>/syscall through a cached fd (exact)
+    DEFERRED,      // Handler records tid only; slow path samples the thread's
+                   // IP later (approximate, the writer has resumed by then)
+    NONE           // No IP capture (ip = 0)
+};
+
+/// How persisted events are written to output_dir
+enum class RecordingFormat {
+    BINARY,  // Segmented columnar events.wrec (see event_recording.hpp)
+    JSONL    // One appendEventJson() line per event in events.jsonl
+};
+
+/// Core configuration for initialize()
+struct WatcherConfig {
+    std::string output_dir = "./watcher_output";
+    size_t max_queue_size = EVENT_QUEUE_CAPACITY;
+    FaultMode fault_mode = FaultMode::SYNC;          // Falls back to SYNC if unsupported
+    uint32_t scan_interval_us = ASYNC_SCAN_INTERVAL_US;  // ASYNC_SCAN polling period
+    IpCapture ip_capture = IpCapture::PROC_SYSCALL;   // SYNC mode only
+    size_t handler_threads = 1;       // SYNC mode: one userfaultfd + handler per shard,
+                                      // clamped to [1, MAX_CONCURRENT_WORKERS]
+    std::vector<int> handler_cpus;    // Optional pinning: shard i runs on cpus[i % size]
+    RecordingFormat recording_format = RecordingFormat::BINARY;
+};
+
+/// Append the event_id used in output: "evt-<seq>" for shard 0,
+/// "evt-<shard>-<seq>" for the others
+void appendEventId(std::string& out, uint64_t event_seq);
+
+inline std::string formatEventId(uint64_t event_seq) {
+    std::string id;
+    appendEventId(id, event_seq);
+    return id;
+}
+
 // Full event after enrichment (slow-path)
 struct EnrichedEvent {
-    std::string event_id;
-    uint64_t ts_ns;
+    uint64_t event_seq;           // Formatted with formatEventId() only on output
+    uint64_t ts_ns;               // Wall-clock nanoseconds since the Unix epoch
     void* page_base;
     void* fault_addr;
     pid_t tid;
@@ -58,25 +130,57 @@ struct EnrichedEvent {
     std::string symbol;           // Function name or "??"
     std::string file;             // Source file path
     int line;                      // Line number
-    std::vector<uint8_t> pre_snapshot;   // Before state
-    std::vector<uint8_t> post_snapshot;  // After state
-    std::vector<std::pair<size_t, std::pair<std::vector<uint8_t>, std::vector<uint8_t>>>> deltas;  // (offset, (old, new))
+    std::vector<uint8_t> pre_snapshot;   // Before state of the faulting 4 KiB sub-page
+                                         // (its tracked bytes; see MutationDepth)
+    std::vector<uint8_t> post_snapshot;  // After state of the same bytes
+    uint32_t snapshot_offset = 0;        // Variable offset of that sub-page
+    DeltaSet deltas;                // Changed runs (offset, length, old, new)
     std::vector<std::string> variable_ids;
+    uint32_t variable_index = 0;  // VariableMetadata::index of the first matching variable
+    std::string variable_name;    // Name of the first matching variable
     std::string sql_context_id;   // Optional SQL context
 };
 
+/// Slow-path hook run on each enriched event before persistence
+/// Return false to drop the event (not persisted, not handed out)
+using EventProcessorFn = std::function<bool(EnrichedEvent&)>;
+
+/// Slow-path hook run once per enriched batch, before the per-event hook
+/// Clear keep[i] (preset to 1) to drop events[i] before persistence
+using EventBatchProcessorFn = std::function<void(EnrichedEvent* events, size_t count, uint8_t* keep)>;
+
+/// Append one enriched event as a single-line JSON object (no newline)
+/// This is the record format of <output_dir>/events.jsonl, and of recordings
+/// exported to JSONL
+void appendEventJson(const EnrichedEvent& event, std::string& out);
+
 // Variable registration metadata
 struct VariableMetadata {
     std::string variable_id;      // UUID
+    uint32_t index;               // Numeric handle used on the fast path
     void* page_base;
-    size_t page_size;
+    size_t page_size;              // Armed length (multiple of granule)
+    size_t tracked_len;            // Snapshotted and diffed length (mutation_depth)
+    size_t granule;                // Backing page size: 4 KiB, or the hugetlb page size
+    uint32_t shard;                // Handler shard whose userfaultfd owns the range
     std::string name;
     EventFlags flags;
     MutationDepth mutation_depth;
-    std::vector<uint8_t> initial_snapshot;
+    std::shared_ptr<PageShadow> shadow;  // Last-seen contents, per 4 KiB sub-page
+    SamplingPolicy sampling;             // Set through setSamplingPolicy()
+    std::shared_ptr<SamplingGate> sampling_gate;  // nullptr for SamplingPolicy::ALL
     std::chrono::system_clock::time_point registered_at;
 };
 
+// One entry of a registerRanges() batch (same fields as registerRange)
+struct RangeRegistration {
+    void* base;
+    size_t len;
+    const char* name;
+    EventFlags flags;
+    MutationDepth mutation_depth;
+};
+
 // ============================================================================
 // Core API
 // ============================================================================
@@ -87,22 +191,50 @@ public:
     static WatcherCore& getInstance();
     
     /// Initialize with configuration
-    /// @param output_dir Directory for JSONL output
-    /// @param max_queue_size Maximum event queue capacity
+    /// @param output_dir Directory for the event recording
+    /// @param max_queue_size Maximum event queue capacity (rounded up to a power of two)
     /// @return true on success
     virtual bool initialize(const std::string& output_dir, size_t max_queue_size = EVENT_QUEUE_CAPACITY) = 0;
     
+    /// Initialize with a full configuration
+    /// @param config Output, queue and fault-handling settings
+    /// @return true on success
+    virtual bool initialize(const WatcherConfig& config) = 0;
+    
     /// Register a page for watching
     /// Caller guarantees: page is touched, page lifetime >= watch lifetime
     /// @param page_base Base address of the page (must be 4K aligned)
     /// @param page_size Size of page (typically 4096)
     /// @param name Human-readable variable name
     /// @param flags Event flags (TRACK_THREADS, TRACK_SQL, etc.)
-    /// @param mutation_depth How deep to track mutations
+    /// @param mutation_depth How deep to track mutations: the whole page,
+    ///        or only its first byte_range bytes
     /// @return variable_id (UUID) on success, empty string on error
     virtual std::string registerPage(void* page_base, size_t page_size, const std::string& name,
                             EventFlags flags, const MutationDepth& mutation_depth) = 0;
     
+    /// Register a contiguous range as one logical variable
+    /// Armed with one ioctl. hugetlb-backed ranges are protected at their huge
+    /// page size; deltas are still computed per 4 KiB sub-page, and sub-pages
+    /// are only copied once they are first written.
+    /// Caller guarantees: range is mapped, lifetime >= watch lifetime
+    /// @param base Start of the range (aligned to the backing page size)
+    /// @param len Length in bytes (rounded up to the backing page size)
+    /// @param name Human-readable variable name
+    /// @param flags Event flags (TRACK_THREADS, TRACK_SQL, etc.)
+    /// @param mutation_depth How deep to track mutations; a byte_range
+    ///        limits arming to the granules that cover it
+    /// @return variable_id on success, empty string on error
+    virtual std::string registerRange(void* base, size_t len, const std::string& name,
+                                      EventFlags flags, const MutationDepth& mutation_depth) = 0;
+    
+    /// Register many ranges under one lock and one page-index rebuild
+    /// (registering one at a time rebuilds the index per call)
+    /// @param ids Receives one entry per range: variable_id, or empty on error
+    /// @return Number of ranges registered
+    virtual size_t registerRanges(const RangeRegistration* ranges, size_t count,
+                                  std::vector<std::string>& ids) = 0;
+    
     /// Unregister a watched page
     /// @param variable_id The ID returned from registerPage
     /// @return true on success
@@ -110,37 +242,63 @@ public:
     
     /// Read current snapshot of a watched variable
     /// @param variable_id The variable to snapshot
-    /// @return Snapshot bytes, or empty on error
+    /// @return Snapshot bytes (its tracked length), or empty on error
     virtual std::vector<uint8_t> readSnapshot(const std::string& variable_id) = 0;
     
+    /// Read the snapshot into a caller buffer
+    /// Nothing is written if capacity is smaller than the snapshot
+    /// @return Snapshot size in bytes, or 0 if the variable is unknown
+    virtual size_t readSnapshotInto(const std::string& variable_id, void* out, size_t capacity) = 0;
+    
+    /// Reference-counted snapshot: readers share one buffer until the
+    /// variable next changes, and a held view never changes
+    /// @return The view, or nullptr if the variable is unknown
+    virtual SnapshotView snapshotView(const std::string& variable_id) = 0;
+    
     /// Write/update snapshot (for pre-state capture)
     /// @param variable_id The variable to update
     /// @param snapshot New snapshot bytes
     /// @return true on success
     virtual bool writeSnapshot(const std::string& variable_id, const std::vector<uint8_t>& snapshot) = 0;
     
+    /// writeSnapshot() from a caller buffer, without an intermediate copy
+    virtual bool writeSnapshotFrom(const std::string& variable_id, const void* data, size_t len) = 0;
+    
     /// Update metadata for a variable
     /// @param variable_id The variable to update
     /// @param metadata New metadata
     /// @return true on success
     virtual bool updateMetadata(const std::string& variable_id, const VariableMetadata& metadata) = 0;
     
+    /// Limit how many write faults on a variable become events (hot pages)
+    /// Faults skipped by the policy count as Metrics::policy_drops. Replacing
+    /// a policy restarts its counters.
+    /// @param variable_id The variable to limit
+    /// @param policy SamplingPolicy::ALL to record every fault again
+    /// @return false if the variable is unknown or the policy is invalid
+    virtual bool setSamplingPolicy(const std::string& variable_id, const SamplingPolicy& policy) = 0;
+    
     /// Start the userfaultfd handler thread and event processing
     /// @return true on success
     virtual bool start() = 0;
     
-    /// Pause event processing (drain in-flight events)
-    /// @return true on success
-    virtual bool pause() = 0;
+    /// Pause event processing: writes stop producing events (SYNC mode
+    /// lifts write protection) and queued events are persisted
+    /// @param timeout_ms Maximum time to wait for the drain
+    /// @return false if events were still queued at the deadline (the core is paused either way)
+    virtual bool pause(int timeout_ms = 5000) = 0;
     
-    /// Resume event processing after pause
+    /// Resume event processing after pause; writes made while paused show
+    /// up in the deltas of the next event on their page. SYNC mode arms
+    /// ranges registered while paused here.
     /// @return true on success
     virtual bool resume() = 0;
     
     /// Gracefully stop all processing
-    /// Drains queue, stops handler, closes uffd
+    /// Stops the handlers, drains the queue to the writer, stops the slow
+    /// path. Returns as soon as the pipeline is empty.
     /// @param timeout_ms Maximum time to wait for draining (default 5000ms)
-    /// @return true on success
+    /// @return false if events had to be dropped at the deadline
     virtual bool stop(int timeout_ms = 5000) = 0;
     
     /// Get current core state
@@ -150,22 +308,93 @@ public:
     /// Get error message if in ERROR state
     virtual std::string getErrorMessage() const = 0;
     
+    /// Fault mode in effect after initialize() (after any fallback)
+    virtual FaultMode getFaultMode() const = 0;
+    
     /// Dequeue next enriched event (for slow-path processing)
     /// Non-blocking; returns nullptr if queue is empty
+    /// The pointer stays valid until the next dequeueEvent() call
     /// @return Pointer to EnrichedEvent, or nullptr
     virtual EnrichedEvent* dequeueEvent() = 0;
     
+    /// Dequeue a batch of enriched events
+    /// Non-blocking; appends up to max_events events to out
+    /// @return Number of events appended
+    virtual size_t dequeueEvents(std::vector<EnrichedEvent>& out, size_t max_events) = 0;
+    
+    /// Deliver events as BinaryEventRecords through a shared-memory ring
+    /// instead of dequeueEvent(s). Once open, persisted events go only to the
+    /// channel; a consumer that falls behind loses the newest records
+    /// (counted in the channel header). Idempotent; the channel lives as long
+    /// as the core.
+    /// @param capacity Ring size in records (0 for EVENT_CHANNEL_CAPACITY)
+    /// @return The channel, or nullptr if it could not be mapped
+    virtual EventChannel* openEventChannel(size_t capacity = 0) = 0;
+    
+    /// @return VariableMetadata::index of a registered variable (the
+    ///         var_index of its channel records), or 0 if unknown
+    virtual uint32_t variableIndex(const std::string& variable_id) const = 0;
+    
+    /// Resolve an instruction pointer in this process (as done for events)
+    /// @param symbol Demangled function name, or "??"
+    /// @param file Source file with line info, else the object path, else "??"
+    /// @param line Line number, or 0
+    /// @return false if no loaded object contains ip
+    virtual bool resolveSymbol(uint64_t ip, std::string& symbol, std::string& file, int& line) = 0;
+    
+    /// Install the slow-path processor (replaces any previous one)
+    /// @param processor Hook called on the slow-path thread; empty to clear
+    virtual void setEventProcessor(EventProcessorFn processor) = 0;
+    
+    /// Install the slow-path batch processor (replaces any previous one)
+    /// @param processor Hook called on the slow-path thread; empty to clear
+    virtual void setBatchProcessor(EventBatchProcessorFn processor) = 0;
+    
     /// Get metrics snapshot for observability
     struct Metrics {
         uint64_t events_received;
         uint64_t events_processed;
         uint64_t events_dropped;
+        uint64_t policy_drops;         // Faults skipped by a SamplingPolicy (not in events_dropped)
         uint64_t callbacks_failed;
-        double mean_latency_ms;
+        double mean_latency_ms;        // Mean fault-to-persisted latency
         uint32_t queue_depth;
     };
     virtual Metrics getMetrics() const = 0;
     
+    /// Latency distribution of one pipeline stage, in nanoseconds
+    struct LatencyStats {
+        uint64_t count;
+        uint64_t min_ns;
+        uint64_t max_ns;
+        double mean_ns;
+        uint64_t p50_ns;
+        uint64_t p90_ns;
+        uint64_t p99_ns;
+        uint64_t p999_ns;
+    };
+    
+    /// Per-stage latencies and fault-path counters
+    struct PipelineMetrics {
+        LatencyStats fault_to_unprotect;  // SYNC: uffd read to writer released, per fault
+        LatencyStats queue_residency;     // Fault timestamp to slow-path dequeue
+        LatencyStats enrich;              // Per event: snapshot, deltas, symbol
+        LatencyStats persist;             // Per batch: write + flush
+        LatencyStats end_to_end;          // Fault timestamp to persisted
+        uint64_t ioctls;                  // userfaultfd and PAGEMAP_SCAN ioctls issued
+        uint64_t unprotect_failures;
+        uint64_t reprotect_failures;      // Page left writable: later writes are missed
+        uint64_t wp_release_failures;     // Faults in ranges whose release or re-protect
+                                          // failed (their events were still queued)
+        uint64_t queue_full_drops;        // Fast-path events lost to a full ring
+        uint64_t coalesced_windows;       // SamplingPolicy::COALESCE windows closed
+        uint64_t deferred_reprotects;     // SYNC: pages left open because their write had
+                                          // not landed within RELEASE_WAIT_NS
+        uint64_t recording_failures;      // events.wrec appends or segment writes that
+                                          // failed (those events are not on disk)
+    };
+    virtual PipelineMetrics getPipelineMetrics() const = 0;
+    
     virtual ~WatcherCore() = default;
 
 protected:
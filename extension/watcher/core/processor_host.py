@@ -0,0 +1,193 @@
+"""
+Processor Host - Runs a Python processor script on packed event batches
+
+The core's embedded interpreter (processor/python_host.cpp) calls
+run_batch() once per slow-path batch with a read-only view of the packed
+batch (processor/include/processor_batch.hpp) and a writable byte per event
+for its action, so a batch costs one crossing and no per-event marshalling
+unless the script asks for event dicts.
+
+A script defines either:
+
+    main_batch(batch)   Whole batch: batch.records (numpy structured array
+                        with RECORD_DTYPE when numpy is available),
+                        batch.event(i), batch.drop(i), batch.annotate(i, {...})
+    main(event)         Per event dict (keys as in the JSONL output),
+                        returning {"action": "pass" | "drop" | "annotate" |
+                        "enrich", "annotations": {...}, "extra": {...}}
+"""
+
+import importlib.util
+import json
+import struct
+import sys
+from typing import Any, Callable, Dict, List, Tuple
+
+from watcher.core.event_channel import (RECORD_DTYPE, RECORD_FORMAT, RECORD_SIZE,
+                                        format_event_id)
+
+try:
+    import numpy as _np
+except ImportError:  # pragma: no cover - numpy is optional
+    _np = None
+
+BATCH_MAGIC = 0x42505357
+_HEADER_FORMAT = '<IIIIIIII'
+_TEXT_FORMAT = '<IIIIIIiI'
+_TEXT_SIZE = struct.calcsize(_TEXT_FORMAT)
+_RUN_FORMAT = '<II'
+
+# Values of the action bytes (watcher_processor_abi.h)
+ACTION_PASS = 0
+ACTION_ANNOTATE = 1
+ACTION_ENRICH = 2
+ACTION_DROP = 3
+ACTIONS = {'pass': ACTION_PASS, 'annotate': ACTION_ANNOTATE,
+           'enrich': ACTION_ENRICH, 'drop': ACTION_DROP}
+
+
+class ProcessorBatch:
+    """One packed batch; the views are only valid during the script's call"""
+
+    def __init__(self, data: memoryview, actions: memoryview):
+        (magic, count, records_offset, text_offset, strings_offset,
+         deltas_offset, size, _) = struct.unpack_from(_HEADER_FORMAT, data, 0)
+        if magic != BATCH_MAGIC or size != len(data) or count != len(actions):
+            raise ValueError("Malformed processor batch")
+        self.count = count
+        self.actions = actions
+        self._raw = data[records_offset:text_offset]
+        self._text = data[text_offset:strings_offset]
+        self._strings = bytes(data[strings_offset:deltas_offset])  # Small; searched for NULs
+        self._deltas = data[deltas_offset:size]
+        self._annotations: List[Tuple[int, Dict[str, Any]]] = []
+
+    def __len__(self) -> int:
+        return self.count
+
+    def __iter__(self):
+        return (self.event(i) for i in range(self.count))
+
+    @property
+    def records(self):
+        """Fixed-size records: numpy structured array if available, else raw bytes"""
+        if _np is not None:
+            return _np.frombuffer(self._raw, dtype=RECORD_DTYPE)
+        return self._raw
+
+    def record(self, i: int) -> tuple:
+        """Record i as a tuple in RECORD_FIELDS order"""
+        return struct.unpack_from(RECORD_FORMAT, self._raw, i * RECORD_SIZE)
+
+    def _string(self, offset: int) -> str:
+        return self._strings[offset:self._strings.index(0, offset)].decode('utf-8', 'replace')
+
+    def event(self, i: int) -> Dict[str, Any]:
+        """Event i as a dict keyed like the JSONL output"""
+        rec = self.record(i)
+        symbol, file, name, sql, ids, dpos, line, _ = struct.unpack_from(_TEXT_FORMAT, self._text, i * _TEXT_SIZE)
+        variable_ids = []
+        for _ in range(rec[7]):
+            end = self._strings.index(0, ids)
+            variable_ids.append(self._strings[ids:end].decode('utf-8', 'replace'))
+            ids = end + 1
+        deltas = []
+        for _ in range(rec[8]):
+            offset, length = struct.unpack_from(_RUN_FORMAT, self._deltas, dpos)
+            dpos += 8
+            deltas.append({
+                'offset': offset,
+                'len': length,
+                'before': bytes(self._deltas[dpos:dpos + length]).hex(),
+                'after': bytes(self._deltas[dpos + length:dpos + 2 * length]).hex(),
+            })
+            dpos += 2 * length
+        event = {
+            'event_id': format_event_id(rec[0]),
+            'timestamp_ns': rec[1],
+            'variable_id': variable_ids[0] if variable_ids else '',
+            'variable_ids': variable_ids,
+            'variable_name': self._string(name),
+            'function': self._string(symbol),
+            'file': self._string(file),
+            'line': line,
+            'ip': rec[4],
+            'tid': rec[5],
+            'page_base': hex(rec[2]),
+            'fault_addr': hex(rec[3]),
+            'deltas': deltas,
+        }
+        if sql:
+            event['sql_context_id'] = self._string(sql)
+        return event
+
+    def drop(self, i: int):
+        self.actions[i] = ACTION_DROP
+
+    def annotate(self, i: int, annotations: Dict[str, Any]):
+        self.actions[i] = ACTION_ANNOTATE
+        self._annotations.append((i, _flatten(annotations)))
+
+    def enrich(self, i: int, extra: Dict[str, Any]):
+        self.actions[i] = ACTION_ENRICH
+        self._annotations.append((i, _flatten(extra)))
+
+    def close(self):
+        for view in (self._raw, self._text, self._deltas):
+            try:
+                view.release()
+            except BufferError:
+                pass  # Still exported (e.g. a records array the script kept)
+
+
+def _flatten(values: Dict[str, Any]) -> Dict[str, Any]:
+    """Keep int/float/str values; anything else becomes its JSON text"""
+    out = {}
+    for key, value in values.items():
+        if isinstance(value, (bool, int, float, str)):
+            out[str(key)] = value
+        else:
+            out[str(key)] = json.dumps(value, default=str)
+    return out
+
+
+def load(path: str) -> Callable[[ProcessorBatch], None]:
+    """Import a processor script and return its batch handler"""
+    spec = importlib.util.spec_from_file_location("watcher_processor", path)
+    if not spec or not spec.loader:
+        raise ImportError(f"Cannot load processor {path}")
+    module = importlib.util.module_from_spec(spec)
+    sys.modules['watcher_processor'] = module
+    spec.loader.exec_module(module)
+
+    if hasattr(module, 'main_batch'):
+        return module.main_batch
+    if not hasattr(module, 'main'):
+        raise ImportError(f"{path} defines neither main(event) nor main_batch(batch)")
+    main = module.main
+
+    def per_event(batch: ProcessorBatch):
+        for i in range(batch.count):
+            try:
+                response = main(batch.event(i)) or {}
+            except Exception:
+                continue  # A failing event passes
+            action = ACTIONS.get(response.get('action', 'pass'), ACTION_PASS)
+            if action == ACTION_ANNOTATE:
+                batch.annotate(i, response.get('annotations') or {})
+            elif action == ACTION_ENRICH:
+                batch.enrich(i, response.get('extra') or {})
+            else:
+                batch.actions[i] = action
+    return per_event
+
+
+def run_batch(handler: Callable[[ProcessorBatch], None], data: memoryview,
+              actions: memoryview) -> List[Tuple[int, Dict[str, Any]]]:
+    """Run handler on one batch, returning its annotations as (event, {key: value})"""
+    batch = ProcessorBatch(data, actions)
+    try:
+        handler(batch)
+        return batch._annotations
+    finally:
+        batch.close()
@@ -0,0 +1,567 @@
+"""
+Recording Reader - Streams events from the C++ core's binary recording
+
+The native slow path writes <output_dir>/events.wrec (RecordingWriter in
+core/include/event_recording.hpp): fixed-width columns per segment, a
+string table, a varint-encoded delta arena and zlib compression, with a
+footer index of segment offsets and time ranges. Keyframe segments hold
+sub-page contents every few writes, and a per-variable directory in the
+footer points at the segments each variable appears in. This module reads
+it one segment at a time, so recordings larger than memory stream through,
+answers per-variable range and state-at-time queries, and exports it to
+the JSONL records the core's JSONL mode writes.
+"""
+
+import json
+import os
+import struct
+import zlib
+from dataclasses import dataclass
+from typing import Any, Dict, Iterator, List, Optional, TextIO, Tuple
+
+from watcher.core.event_channel import format_event_id
+
+RECORDING_MAGIC = 0x43455257
+RECORDING_SEGMENT_MAGIC = 0x47455357
+RECORDING_INDEX_MAGIC = 0x58444957
+RECORDING_VERSION = 2                          # 1: no keyframes, no directory
+RECORDING_FILE_NAME = "events.wrec"
+
+CODEC_NONE = 0
+CODEC_ZLIB = 1
+
+KIND_EVENTS = 0
+KIND_KEYFRAMES = 1
+
+_FILE_HEADER = struct.Struct('<IIII')          # magic, version, header_size, flags
+_SEGMENT_HEADER = struct.Struct('<IHHIIIIQQ')  # magic, codec, kind, event_count,
+                                               # raw_size, stored_size, checksum, min/max ts
+_INDEX_ENTRY = struct.Struct('<QQQII')         # offset, min/max ts, event_count, kind
+_TRAILER = struct.Struct('<QQQQIIII')          # index_offset, segments, events, directory size,
+                                               # directory checksum, reserved, checksum, magic
+_TRAILER_V1 = struct.Struct('<QQQII')          # index_offset, segments, events, checksum, magic
+
+# Fixed-width columns in payload order: (name, struct code)
+COLUMNS = (
+    ('event_seq', 'Q'), ('ts_ns', 'Q'), ('ip', 'Q'), ('page_base', 'Q'), ('fault_addr', 'Q'),
+    ('tid', 'I'), ('var_index', 'I'), ('line', 'i'),
+    ('symbol', 'I'), ('file', 'I'), ('var_name', 'I'), ('sql_context', 'I'),
+    ('var_count', 'I'), ('delta_runs', 'I'), ('delta_size', 'I'),
+)
+
+_DTYPES = {'Q': '<u8', 'I': '<u4', 'i': '<i4'}
+
+try:
+    import numpy as _np
+except ImportError:  # pragma: no cover - numpy is optional
+    _np = None
+
+
+class RecordingError(Exception):
+    """The file is not a recording, or a segment is corrupt"""
+
+
+@dataclass
+class SegmentInfo:
+    """One segment as listed by the footer index (or found by a scan)"""
+    offset: int
+    min_ts_ns: int
+    max_ts_ns: int
+    event_count: int                           # Events, or keyframes
+    kind: int = KIND_EVENTS
+
+
+@dataclass
+class Span:
+    """An events segment holding events of one variable"""
+    segment: int
+    events: int
+    min_ts_ns: int
+    max_ts_ns: int
+
+
+@dataclass
+class KeyframeRef:
+    """Where one keyframe of a variable is stored"""
+    segment: int
+    slot: int
+    offset: int
+    ts_ns: int
+
+
+@dataclass
+class VariableIndex:
+    """Directory entry of one variable"""
+    spans: List[Span]
+    keyframes: List[KeyframeRef]               # File order
+
+
+@dataclass
+class Keyframe:
+    """Contents of [offset, offset + len(data)) right after one event"""
+    ts_ns: int
+    event_seq: int
+    variable_id: str
+    offset: int
+    event_pos: int                             # Event within the following events segment
+    data: bytes
+
+
+def _varint(buf, pos: int):
+    value = 0
+    shift = 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return value, pos
+        shift += 7
+
+
+class Segment:
+    """
+    One decoded segment.
+
+    columns maps each COLUMNS name to a numpy array (or a tuple without
+    numpy); string columns hold refs into strings (0 is the empty string).
+    """
+
+    def __init__(self, info: SegmentInfo, raw: bytes):
+        self.info = info
+        n = info.event_count
+        self.columns: Dict[str, Any] = {}
+        pos = 0
+        try:
+            for name, code in COLUMNS:
+                size = struct.calcsize(code) * n
+                if pos + size > len(raw):
+                    raise RecordingError(f"Segment at offset {info.offset} is malformed")
+                if _np is not None:
+                    self.columns[name] = _np.frombuffer(raw, dtype=_DTYPES[code], count=n, offset=pos)
+                else:
+                    self.columns[name] = struct.unpack_from(f'<{n}{code}', raw, pos)
+                pos += size
+
+            sections = []
+            for _ in range(3):
+                (length,) = struct.unpack_from('<I', raw, pos)
+                pos += 4
+                if pos + length > len(raw):
+                    raise RecordingError(f"Segment at offset {info.offset} is malformed")
+                sections.append(memoryview(raw)[pos:pos + length])
+                pos += length
+        except struct.error:
+            raise RecordingError(f"Segment at offset {info.offset} is malformed")
+
+        strings, self._var_ids, self._deltas = sections
+        self.strings: List[str] = _parse_strings(strings)
+
+    def __len__(self) -> int:
+        return self.info.event_count
+
+    def events(self) -> Iterator[Dict[str, Any]]:
+        """Event dicts with the same keys and values as the JSONL records"""
+        cols = {name: (col.tolist() if _np is not None else col) for name, col in self.columns.items()}
+        strings = self.strings
+        var_ids = self._var_ids
+        deltas = self._deltas
+        vpos = 0
+        dpos = 0
+        for i in range(self.info.event_count):
+            ids = []
+            for _ in range(cols['var_count'][i]):
+                ref, vpos = _varint(var_ids, vpos)
+                ids.append(strings[ref])
+
+            runs = []
+            prev_end = 0
+            for _ in range(cols['delta_runs'][i]):
+                zz, dpos = _varint(deltas, dpos)
+                offset = prev_end + ((zz >> 1) ^ -(zz & 1))
+                length, dpos = _varint(deltas, dpos)
+                runs.append({
+                    'offset': offset,
+                    'len': length,
+                    'before': deltas[dpos:dpos + length].hex(),
+                    'after': deltas[dpos + length:dpos + 2 * length].hex(),
+                })
+                dpos += 2 * length
+                prev_end = offset + length
+
+            event = {
+                'event_id': format_event_id(cols['event_seq'][i]),
+                'timestamp_ns': cols['ts_ns'][i],
+                'variable_id': ids[0] if ids else '',
+                'variable_ids': ids,
+                'variable_name': strings[cols['var_name'][i]],
+                'function': strings[cols['symbol'][i]],
+                'file': strings[cols['file'][i]],
+                'line': cols['line'][i],
+                'ip': cols['ip'][i],
+                'tid': cols['tid'][i],
+                'page_base': hex(cols['page_base'][i]),
+                'fault_addr': hex(cols['fault_addr'][i]),
+                'deltas': runs,
+            }
+            sql = cols['sql_context'][i]
+            if sql:
+                event['sql_context_id'] = strings[sql]
+            yield event
+
+    def iter_runs(self) -> Iterator[Tuple[int, List[str], List[Tuple[int, bytes, bytes]]]]:
+        """(ts_ns, variable_ids, [(offset, before, after), ...]) per event"""
+        ts_col = self.columns['ts_ns']
+        counts = self.columns['var_count']
+        run_counts = self.columns['delta_runs']
+        vpos = 0
+        dpos = 0
+        for i in range(self.info.event_count):
+            ids = []
+            for _ in range(int(counts[i])):
+                ref, vpos = _varint(self._var_ids, vpos)
+                ids.append(self.strings[ref])
+            runs = []
+            prev_end = 0
+            for _ in range(int(run_counts[i])):
+                zz, dpos = _varint(self._deltas, dpos)
+                offset = prev_end + ((zz >> 1) ^ -(zz & 1))
+                length, dpos = _varint(self._deltas, dpos)
+                runs.append((offset, bytes(self._deltas[dpos:dpos + length]),
+                             bytes(self._deltas[dpos + length:dpos + 2 * length])))
+                dpos += 2 * length
+                prev_end = offset + length
+            yield int(ts_col[i]), ids, runs
+
+
+def _parse_strings(strings) -> List[str]:
+    count, pos = _varint(strings, 0)
+    table = ['']
+    for _ in range(count):
+        length, pos = _varint(strings, pos)
+        table.append(bytes(strings[pos:pos + length]).decode('utf-8', errors='replace'))
+        pos += length
+    return table
+
+
+def _decode_keyframes(info: SegmentInfo, raw: bytes) -> List[Keyframe]:
+    k = info.event_count
+    try:
+        ts = struct.unpack_from(f'<{k}Q', raw, 0)
+        seq = struct.unpack_from(f'<{k}Q', raw, 8 * k)
+        var, offset, size, pos = (struct.unpack_from(f'<{k}I', raw, 16 * k + 4 * k * c) for c in range(4))
+        at = 32 * k
+        sections = []
+        for _ in range(2):
+            (length,) = struct.unpack_from('<I', raw, at)
+            at += 4
+            sections.append(memoryview(raw)[at:at + length])
+            at += length
+        strings = _parse_strings(sections[0])
+    except (struct.error, IndexError):
+        raise RecordingError(f"Keyframes at offset {info.offset} are malformed")
+
+    keyframes = []
+    data_pos = 0
+    for i in range(k):
+        if not 0 < var[i] < len(strings) or data_pos + size[i] > len(sections[1]):
+            raise RecordingError(f"Keyframes at offset {info.offset} are malformed")
+        keyframes.append(Keyframe(ts[i], seq[i], strings[var[i]], offset[i], pos[i],
+                                  bytes(sections[1][data_pos:data_pos + size[i]])))
+        data_pos += size[i]
+    return keyframes
+
+
+def _apply_runs(page: bytearray, offset: int, runs, undo: bool):
+    """Copy the runs' new (or old) bytes that fall inside page at offset"""
+    end = offset + len(page)
+    for run_offset, before, after in runs:
+        lo = max(run_offset, offset)
+        hi = min(run_offset + len(before), end)
+        if lo < hi:
+            src = before if undo else after
+            page[lo - offset:hi - offset] = src[lo - run_offset:hi - run_offset]
+
+
+class RecordingReader:
+    """Reads a recording segment by segment (see module docstring)"""
+
+    def __init__(self, path):
+        """
+        Open a recording and load its segment list.
+
+        Args:
+            path: events.wrec, or the output directory that holds it
+
+        Raises:
+            RecordingError: Not a recording, or an unsupported version
+        """
+        path = os.fspath(path)
+        if os.path.isdir(path):
+            path = os.path.join(path, RECORDING_FILE_NAME)
+        self.path = path
+        self._file = open(path, 'rb')
+        self.segments: List[SegmentInfo] = []
+        self.directory: Dict[str, VariableIndex] = {}
+        self.has_index = False
+        try:
+            self._load_segments()
+        except Exception:
+            self._file.close()
+            raise
+
+    def _read_at(self, offset: int, size: int) -> bytes:
+        self._file.seek(offset)
+        return self._file.read(size)
+
+    def _load_segments(self):
+        file_size = os.fstat(self._file.fileno()).st_size
+        header = self._read_at(0, _FILE_HEADER.size)
+        if len(header) < _FILE_HEADER.size:
+            raise RecordingError(f"{self.path} is not a recording")
+        magic, version, header_size, _ = _FILE_HEADER.unpack(header)
+        if magic != RECORDING_MAGIC or header_size < _FILE_HEADER.size:
+            raise RecordingError(f"{self.path} is not a recording")
+        if not 1 <= version <= RECORDING_VERSION:
+            raise RecordingError(f"{self.path} has unsupported recording version {version}")
+
+        # Footer index (and directory), if the writer closed the file
+        trailer = _TRAILER_V1 if version == 1 else _TRAILER
+        if file_size >= header_size + trailer.size:
+            fields = trailer.unpack(self._read_at(file_size - trailer.size, trailer.size))
+            if version == 1:
+                index_offset, count, _, checksum, magic = fields
+                directory_size = directory_checksum = 0
+            else:
+                index_offset, count, _, directory_size, directory_checksum, _, checksum, magic = fields
+            index_size = count * _INDEX_ENTRY.size
+            if (magic == RECORDING_INDEX_MAGIC and index_offset >= header_size and
+                    index_offset + index_size + directory_size + trailer.size == file_size):
+                entries = self._read_at(index_offset, index_size)
+                directory = self._file.read(directory_size)
+                if zlib.crc32(entries) == checksum:
+                    for offset, min_ts, max_ts, events, kind in _INDEX_ENTRY.iter_unpack(entries):
+                        self.segments.append(SegmentInfo(offset, min_ts, max_ts, events, kind))
+                    self.has_index = True
+                    if (version == 1 or zlib.crc32(directory) != directory_checksum or
+                            not self._parse_directory(directory)):
+                        self._rebuild_directory()
+                    return
+
+        # Otherwise walk the segments up to the first torn or corrupt one
+        offset = header_size
+        while offset + _SEGMENT_HEADER.size <= file_size:
+            fields = _SEGMENT_HEADER.unpack(self._read_at(offset, _SEGMENT_HEADER.size))
+            magic, _, kind, events, _, stored_size, checksum, min_ts, max_ts = fields
+            end = offset + _SEGMENT_HEADER.size + stored_size
+            if magic != RECORDING_SEGMENT_MAGIC or end > file_size:
+                break
+            if zlib.crc32(self._file.read(stored_size)) != checksum:
+                break
+            self.segments.append(SegmentInfo(offset, min_ts, max_ts, events, kind))
+            offset = end
+        self._rebuild_directory()
+
+    def _parse_directory(self, data: bytes) -> bool:
+        directory = {}
+        try:
+            count, pos = _varint(data, 0)
+            for _ in range(count):
+                length, pos = _varint(data, pos)
+                var_id = data[pos:pos + length].decode('utf-8', errors='replace')
+                pos += length
+                spans = []
+                keyframes = []
+                n, pos = _varint(data, pos)
+                for _ in range(n):
+                    fields = []
+                    for _ in range(4):
+                        value, pos = _varint(data, pos)
+                        fields.append(value)
+                    spans.append(Span(fields[0], fields[1], fields[2], fields[2] + fields[3]))
+                n, pos = _varint(data, pos)
+                for _ in range(n):
+                    fields = []
+                    for _ in range(4):
+                        value, pos = _varint(data, pos)
+                        fields.append(value)
+                    keyframes.append(KeyframeRef(*fields))
+                if any(s.segment >= len(self.segments) for s in spans) or \
+                        any(k.segment >= len(self.segments) for k in keyframes):
+                    return False
+                directory[var_id] = VariableIndex(spans, keyframes)
+        except IndexError:
+            return False
+        self.directory = directory
+        return True
+
+    def _rebuild_directory(self):
+        self.directory = {}
+        for i, info in enumerate(self.segments):
+            if info.kind == KIND_KEYFRAMES:
+                for slot, keyframe in enumerate(self.read_keyframes(i)):
+                    entry = self.directory.setdefault(keyframe.variable_id, VariableIndex([], []))
+                    entry.keyframes.append(KeyframeRef(i, slot, keyframe.offset, keyframe.ts_ns))
+                continue
+            for ts, ids, _ in self.read_segment(i).iter_runs():
+                for var_id in ids:
+                    spans = self.directory.setdefault(var_id, VariableIndex([], [])).spans
+                    if not spans or spans[-1].segment != i:
+                        spans.append(Span(i, 0, ts, ts))
+                    span = spans[-1]
+                    span.events += 1
+                    span.min_ts_ns = min(span.min_ts_ns, ts)
+                    span.max_ts_ns = max(span.max_ts_ns, ts)
+
+    @property
+    def event_count(self) -> int:
+        return sum(s.event_count for s in self.segments if s.kind == KIND_EVENTS)
+
+    def _read_payload(self, index: int, kind: int) -> bytes:
+        info = self.segments[index]
+        fields = _SEGMENT_HEADER.unpack(self._read_at(info.offset, _SEGMENT_HEADER.size))
+        magic, codec, stored_kind, _, raw_size, stored_size, checksum, _, _ = fields
+        if magic != RECORDING_SEGMENT_MAGIC:
+            raise RecordingError(f"Bad segment header at offset {info.offset}")
+        if stored_kind != kind:
+            raise RecordingError(f"Segment at offset {info.offset} holds other records")
+        stored = self._file.read(stored_size)
+        if len(stored) != stored_size or zlib.crc32(stored) != checksum:
+            raise RecordingError(f"Segment at offset {info.offset} fails its checksum")
+        if codec == CODEC_ZLIB:
+            raw = zlib.decompress(stored)
+        elif codec == CODEC_NONE:
+            raw = stored
+        else:
+            raise RecordingError(f"Segment codec {codec} is not supported")
+        if len(raw) != raw_size:
+            raise RecordingError(f"Segment at offset {info.offset} has the wrong size")
+        return raw
+
+    def read_segment(self, index: int) -> Segment:
+        """Read, verify and decode one events segment"""
+        return Segment(self.segments[index], self._read_payload(index, KIND_EVENTS))
+
+    def read_keyframes(self, index: int) -> List[Keyframe]:
+        """Read, verify and decode one keyframes segment"""
+        return _decode_keyframes(self.segments[index], self._read_payload(index, KIND_KEYFRAMES))
+
+    def iter_segments(self, start_ns: Optional[int] = None,
+                      end_ns: Optional[int] = None) -> Iterator[Segment]:
+        """
+        Decoded events segments in file order.
+
+        Args:
+            start_ns, end_ns: Skip segments entirely outside [start_ns, end_ns]
+                              without reading them (events inside a kept
+                              segment are not filtered)
+        """
+        for i, info in enumerate(self.segments):
+            if info.kind != KIND_EVENTS:
+                continue
+            if start_ns is not None and info.max_ts_ns < start_ns:
+                continue
+            if end_ns is not None and info.min_ts_ns > end_ns:
+                continue
+            yield self.read_segment(i)
+
+    def __iter__(self) -> Iterator[Dict[str, Any]]:
+        for segment in self.iter_segments():
+            yield from segment.events()
+
+    def variable_events(self, variable_id: str, start_ns: int = 0,
+                        end_ns: Optional[int] = None) -> List[Dict[str, Any]]:
+        """
+        Event dicts of variable_id (as any of their variable_ids) with
+        timestamp_ns in [start_ns, end_ns]; reads only the segments the
+        directory lists for it.
+        """
+        entry = self.directory.get(variable_id)
+        if entry is None:
+            return []
+        events = []
+        for span in entry.spans:
+            if span.max_ts_ns < start_ns or (end_ns is not None and span.min_ts_ns > end_ns):
+                continue
+            for event in self.read_segment(span.segment).events():
+                ts = event['timestamp_ns']
+                if ts >= start_ns and (end_ns is None or ts <= end_ns) and variable_id in event['variable_ids']:
+                    events.append(event)
+        return events
+
+    def variable_state(self, variable_id: str, ts_ns: int) -> Dict[int, bytes]:
+        """
+        Contents of variable_id's recorded sub-pages at ts_ns, keyed by
+        variable offset: the nearest keyframe, with the sub-page's deltas
+        replayed forward to ts_ns (or undone back to it, before the first
+        keyframe). Only events whose first variable is variable_id carry
+        its deltas.
+        """
+        entry = self.directory.get(variable_id)
+        if entry is None:
+            return {}
+        segments: Dict[int, List] = {}
+
+        # (position, ts, runs) of the variable's own events in one segment
+        def owned(index: int):
+            if index not in segments:
+                segments[index] = [(pos, ts, runs) for pos, (ts, ids, runs)
+                                   in enumerate(self.read_segment(index).iter_runs())
+                                   if ids and ids[0] == variable_id]
+            return segments[index]
+
+        state = {}
+        by_offset: Dict[int, List[KeyframeRef]] = {}
+        for ref in entry.keyframes:
+            by_offset.setdefault(ref.offset, []).append(ref)
+        for offset in sorted(by_offset):
+            refs = by_offset[offset]
+            before = [ref for ref in refs if ref.ts_ns <= ts_ns]
+            base = before[-1] if before else refs[0]
+            keyframe = self.read_keyframes(base.segment)[base.slot]
+            page = bytearray(keyframe.data)
+            event_segment = base.segment + 1
+            if before:
+                for span in entry.spans:
+                    if span.segment < event_segment or span.min_ts_ns > ts_ns:
+                        continue
+                    for pos, ts, runs in owned(span.segment):
+                        if (span.segment > event_segment or pos > keyframe.event_pos) and ts <= ts_ns:
+                            _apply_runs(page, offset, runs, undo=False)
+            else:
+                for span in reversed(entry.spans):
+                    if span.segment > event_segment or span.max_ts_ns <= ts_ns:
+                        continue
+                    for pos, ts, runs in reversed(owned(span.segment)):
+                        if (span.segment < event_segment or pos <= keyframe.event_pos) and ts > ts_ns:
+                            _apply_runs(page, offset, runs, undo=True)
+            state[offset] = bytes(page)
+        return state
+
+    def close(self):
+        self._file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+
+def export_jsonl(path, out: TextIO) -> int:
+    """
+    Write a recording as JSONL (one compact JSON object per line).
+
+    Returns:
+        Events written
+    """
+    count = 0
+    with RecordingReader(path) as reader:
+        for segment in reader.iter_segments():
+            lines = [json.dumps(event, separators=(',', ':'), ensure_ascii=False)
+                     for event in segment.events()]
+            if lines:
+                out.write('\n'.join(lines))
+                out.write('\n')
+                count += len(lines)
+    return count
@@ -0,0 +1,255 @@
+#include "delta_engine.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WATCHER_DELTA_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define WATCHER_DELTA_NEON 1
+#endif
+
+namespace watcher {
+
+// ============================================================================
+// Block Mask Kernels
+// ============================================================================
+// Each kernel turns 64-byte blocks into 64-bit masks, bit i set when byte i
+// differs. Run extraction below is shared by every kernel.
+
+constexpr size_t DELTA_BLOCK = 64;
+constexpr size_t DELTA_BLOCKS_PER_PASS = 64;  // 4 KiB of masks per kernel call
+
+using BlockMaskFn = void (*)(const uint8_t* pre, const uint8_t* post, size_t blocks,
+                             uint64_t* masks);
+
+/// Word-at-a-time fallback: XOR 8 bytes, fold each nonzero byte to one bit
+static void blockMasksScalar(const uint8_t* pre, const uint8_t* post, size_t blocks,
+                             uint64_t* masks) {
+    constexpr uint64_t LOW7 = 0x7f7f7f7f7f7f7f7fULL;
+    for (size_t b = 0; b < blocks; ++b) {
+        uint64_t mask = 0;
+        for (size_t w = 0; w < DELTA_BLOCK / 8; ++w) {
+            uint64_t x, y;
+            memcpy(&x, pre + b * DELTA_BLOCK + w * 8, 8);
+            memcpy(&y, post + b * DELTA_BLOCK + w * 8, 8);
+            uint64_t diff = x ^ y;
+            if (!diff) {
+                continue;
+            }
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            diff = __builtin_bswap64(diff);
+#endif
+            // High bit of each byte set iff that byte is nonzero
+            uint64_t hi = (((diff & LOW7) + LOW7) | diff) & ~LOW7;
+            // Gather the eight high bits into the low byte (byte k -> bit k)
+            uint64_t bits = ((hi >> 7) * 0x0102040810204080ULL) >> 56;
+            mask |= bits << (w * 8);
+        }
+        masks[b] = mask;
+    }
+}
+
+#if WATCHER_DELTA_X86
+__attribute__((target("sse2")))
+static void blockMasksSse2(const uint8_t* pre, const uint8_t* post, size_t blocks,
+                           uint64_t* masks) {
+    for (size_t b = 0; b < blocks; ++b) {
+        const uint8_t* a = pre + b * DELTA_BLOCK;
+        const uint8_t* c = post + b * DELTA_BLOCK;
+        uint64_t eq = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i * 16));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + i * 16));
+            uint32_t m = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+            eq |= static_cast<uint64_t>(m & 0xFFFF) << (i * 16);
+        }
+        masks[b] = ~eq;
+    }
+}
+
+__attribute__((target("avx2")))
+static void blockMasksAvx2(const uint8_t* pre, const uint8_t* post, size_t blocks,
+                           uint64_t* masks) {
+    for (size_t b = 0; b < blocks; ++b) {
+        const uint8_t* a = pre + b * DELTA_BLOCK;
+        const uint8_t* c = post + b * DELTA_BLOCK;
+        __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+        __m256i y0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+        __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 32));
+        __m256i y1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + 32));
+        uint32_t lo = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x0, y0)));
+        uint32_t hi = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x1, y1)));
+        masks[b] = ~(static_cast<uint64_t>(hi) << 32 | lo);
+    }
+}
+#endif
+
+#if WATCHER_DELTA_NEON
+static void blockMasksNeon(const uint8_t* pre, const uint8_t* post, size_t blocks,
+                           uint64_t* masks) {
+    static const uint8_t BIT_WEIGHTS[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                            1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t weights = vld1q_u8(BIT_WEIGHTS);
+    for (size_t b = 0; b < blocks; ++b) {
+        const uint8_t* a = pre + b * DELTA_BLOCK;
+        const uint8_t* c = post + b * DELTA_BLOCK;
+        uint64_t mask = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            uint8x16_t ne = vmvnq_u8(vceqq_u8(vld1q_u8(a + i * 16), vld1q_u8(c + i * 16)));
+            uint8x16_t bits = vandq_u8(ne, weights);
+            uint64_t lo = vaddv_u8(vget_low_u8(bits));
+            uint64_t hi = vaddv_u8(vget_high_u8(bits));
+            mask |= (lo | hi << 8) << (i * 16);
+        }
+        masks[b] = mask;
+    }
+}
+#endif
+
+struct DeltaKernel {
+    BlockMaskFn fn;
+    const char* name;
+};
+
+static DeltaKernel selectKernel() {
+#if WATCHER_DELTA_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {blockMasksAvx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return {blockMasksSse2, "sse2"};
+    }
+#elif WATCHER_DELTA_NEON
+    return {blockMasksNeon, "neon"};
+#endif
+    return {blockMasksScalar, "scalar"};
+}
+
+static const DeltaKernel& activeKernel() {
+    static const DeltaKernel kernel = selectKernel();
+    return kernel;
+}
+
+const char* deltaKernelName() {
+    return activeKernel().name;
+}
+
+// ============================================================================
+// Run Extraction
+// ============================================================================
+
+/// Accumulates changed ranges in ascending order, merging across short gaps
+class RunBuilder {
+public:
+    RunBuilder(const uint8_t* pre, const uint8_t* post, DeltaSet& out,
+               size_t base_offset, size_t merge_gap)
+        : pre_(pre), post_(post), out_(out),
+          base_offset_(base_offset), merge_gap_(merge_gap),
+          initial_runs_(out.runs.size()) {}
+
+    /// Add changed range [begin, end)
+    void add(size_t begin, size_t end) {
+        if (open_ && begin - end_ <= merge_gap_) {
+            end_ = end;
+            return;
+        }
+        flush();
+        begin_ = begin;
+        end_ = end;
+        open_ = true;
+    }
+
+    /// Close the pending run
+    /// @return Runs appended since construction
+    size_t finish() {
+        flush();
+        return out_.runs.size() - initial_runs_;
+    }
+
+private:
+    void flush() {
+        if (!open_) {
+            return;
+        }
+        size_t length = end_ - begin_;
+        DeltaRun run;
+        run.offset = static_cast<uint32_t>(base_offset_ + begin_);
+        run.length = static_cast<uint32_t>(length);
+        run.arena_offset = static_cast<uint32_t>(out_.arena.size());
+        out_.arena.insert(out_.arena.end(), pre_ + begin_, pre_ + end_);
+        out_.arena.insert(out_.arena.end(), post_ + begin_, post_ + end_);
+        out_.runs.push_back(run);
+        open_ = false;
+    }
+
+    const uint8_t* pre_;
+    const uint8_t* post_;
+    DeltaSet& out_;
+    size_t base_offset_;
+    size_t merge_gap_;
+    size_t initial_runs_;
+    bool open_ = false;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+};
+
+/// Feed every run of set bits in a block mask to the builder
+static inline void extractRuns(uint64_t mask, size_t base, RunBuilder& builder) {
+    while (mask) {
+        unsigned start = static_cast<unsigned>(__builtin_ctzll(mask));
+        uint64_t zeros = ~(mask >> start);
+        unsigned length = zeros ? static_cast<unsigned>(__builtin_ctzll(zeros)) : 64 - start;
+        builder.add(base + start, base + start + length);
+        unsigned next = start + length;
+        mask = next >= 64 ? 0 : mask & (~0ULL << next);
+    }
+}
+
+// ============================================================================
+// Public Entry Points
+// ============================================================================
+
+size_t computeDeltas(const uint8_t* pre, const uint8_t* post, size_t len, DeltaSet& out,
+                     size_t base_offset, size_t merge_gap) {
+    RunBuilder builder(pre, post, out, base_offset, merge_gap);
+    BlockMaskFn kernel = activeKernel().fn;
+    uint64_t masks[DELTA_BLOCKS_PER_PASS];
+
+    size_t full_blocks = len / DELTA_BLOCK;
+    for (size_t block = 0; block < full_blocks; block += DELTA_BLOCKS_PER_PASS) {
+        size_t count = full_blocks - block;
+        if (count > DELTA_BLOCKS_PER_PASS) {
+            count = DELTA_BLOCKS_PER_PASS;
+        }
+        size_t offset = block * DELTA_BLOCK;
+        kernel(pre + offset, post + offset, count, masks);
+        for (size_t i = 0; i < count; ++i) {
+            if (masks[i]) {
+                extractRuns(masks[i], offset + i * DELTA_BLOCK, builder);
+            }
+        }
+    }
+
+    // Tail shorter than one block
+    for (size_t i = full_blocks * DELTA_BLOCK; i < len; ++i) {
+        if (pre[i] != post[i]) {
+            builder.add(i, i + 1);
+        }
+    }
+    return builder.finish();
+}
+
+size_t computeDeltasScalar(const uint8_t* pre, const uint8_t* post, size_t len, DeltaSet& out,
+                           size_t base_offset, size_t merge_gap) {
+    RunBuilder builder(pre, post, out, base_offset, merge_gap);
+    for (size_t i = 0; i < len; ++i) {
+        if (pre[i] != post[i]) {
+            builder.add(i, i + 1);
+        }
+    }
+    return builder.finish();
+}
+
+}  // namespace watcher
@@ -0,0 +1,96 @@
+#include "event_channel.hpp"
+#include "event_ring.hpp"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+#include <new>
+
+namespace watcher {
+
+std::unique_ptr<EventChannel> EventChannel::create(size_t capacity) {
+    capacity = roundUpPowerOfTwo(capacity ? capacity : EVENT_CHANNEL_CAPACITY);
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t records_offset = (sizeof(EventChannelHeader) + CACHE_LINE_SIZE - 1) /
+                            CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    size_t mapping_size = (records_offset + capacity * sizeof(BinaryEventRecord) + page - 1) /
+                          page * page;
+
+    int fd = memfd_create("watcher-events", MFD_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(mapping_size)) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* mem = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+
+    auto* header = new (mem) EventChannelHeader();
+    header->magic = EVENT_CHANNEL_MAGIC;
+    header->version = EVENT_CHANNEL_VERSION;
+    header->record_size = sizeof(BinaryEventRecord);
+    header->capacity = capacity;
+    header->records_offset = records_offset;
+    header->mapping_size = mapping_size;
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    header->dropped.store(0, std::memory_order_relaxed);
+
+    auto* records = reinterpret_cast<BinaryEventRecord*>(static_cast<uint8_t*>(mem) + records_offset);
+    return std::unique_ptr<EventChannel>(new EventChannel(header, records, fd));
+}
+
+EventChannel::~EventChannel() {
+    size_t mapping_size = header_->mapping_size;
+    header_->~EventChannelHeader();
+    munmap(header_, mapping_size);
+    close(fd_);
+}
+
+size_t EventChannel::push(const BinaryEventRecord* records, size_t count) {
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    uint64_t capacity = header_->capacity;
+    if (tail - cached_head_ + count > capacity) {
+        cached_head_ = header_->head.load(std::memory_order_acquire);
+    }
+    size_t room = static_cast<size_t>(capacity - (tail - cached_head_));
+    size_t n = count < room ? count : room;
+
+    // Copy in at most two contiguous pieces, then publish them with one store
+    size_t slot = static_cast<size_t>(tail & (capacity - 1));
+    size_t first = n < capacity - slot ? n : static_cast<size_t>(capacity - slot);
+    memcpy(records_ + slot, records, first * sizeof(BinaryEventRecord));
+    memcpy(records_, records + first, (n - first) * sizeof(BinaryEventRecord));
+    if (n) {
+        header_->tail.store(tail + n, std::memory_order_release);
+    }
+    if (n < count) {
+        header_->dropped.fetch_add(count - n, std::memory_order_relaxed);
+    }
+    return n;
+}
+
+size_t EventChannel::acquire(uint64_t* start) const {
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    uint64_t tail = header_->tail.load(std::memory_order_acquire);
+    uint64_t capacity = header_->capacity;
+    uint64_t to_end = capacity - (head & (capacity - 1));
+    *start = head;
+    return static_cast<size_t>(tail - head < to_end ? tail - head : to_end);
+}
+
+void EventChannel::release(size_t count) {
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    header_->head.store(head + count, std::memory_order_release);
+}
+
+size_t EventChannel::size() const {
+    return static_cast<size_t>(header_->tail.load(std::memory_order_acquire) -
+                               header_->head.load(std::memory_order_acquire));
+}
+
+}  // namespace watcher
@@ -0,0 +1,1165 @@
+#include "event_recording.hpp"
+#include "event_clock.hpp"
+#include "watcher_core.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#ifdef WATCHER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace watcher {
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "Recordings are written and read in host byte order");
+
+// ============================================================================
+// Encoding Helpers
+// ============================================================================
+
+namespace {
+
+constexpr size_t FIXED_BYTES_PER_EVENT = 5 * sizeof(uint64_t) + 10 * sizeof(uint32_t);
+
+inline void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+inline uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+template <typename T>
+void putColumn(std::vector<uint8_t>& out, const std::vector<T>& column) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(column.data());
+    out.insert(out.end(), bytes, bytes + column.size() * sizeof(T));
+}
+
+void putSection(std::vector<uint8_t>& out, const uint8_t* data, size_t len) {
+    uint32_t len32 = static_cast<uint32_t>(len);
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&len32);
+    out.insert(out.end(), bytes, bytes + sizeof(len32));
+    out.insert(out.end(), data, data + len);
+}
+
+/// Bounds-checked reads over a decoded payload; a failed read clears ok
+struct Cursor {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+
+    Cursor(const uint8_t* data, size_t len) : p(data), end(data + len) {}
+
+    const uint8_t* take(size_t n) {
+        if (static_cast<size_t>(end - p) < n) {
+            ok = false;
+            p = end;
+            return nullptr;
+        }
+        const uint8_t* at = p;
+        p += n;
+        return at;
+    }
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (p == end) {
+                break;
+            }
+            uint8_t b = *p++;
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return v;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    /// u32-length-prefixed section
+    Cursor section() {
+        uint32_t len = 0;
+        if (const uint8_t* at = take(sizeof(len))) {
+            memcpy(&len, at, sizeof(len));
+        }
+        const uint8_t* at = take(len);
+        return at ? Cursor(at, len) : Cursor(end, 0);
+    }
+};
+
+template <typename T>
+const uint8_t* takeColumn(Cursor& c, size_t n) {
+    return c.take(n * sizeof(T));
+}
+
+template <typename T>
+T load(const uint8_t* column, size_t i) {
+    T v;
+    memcpy(&v, column + i * sizeof(T), sizeof(T));
+    return v;
+}
+
+bool readFully(int fd, void* buf, size_t len, uint64_t offset) {
+    auto* p = static_cast<uint8_t*>(buf);
+    while (len) {
+        ssize_t n = pread(fd, p, len, static_cast<off_t>(offset));
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool writeFully(int fd, const void* buf, size_t len, uint64_t offset) {
+    const auto* p = static_cast<const uint8_t*>(buf);
+    while (len) {
+        ssize_t n = pwrite(fd, p, len, static_cast<off_t>(offset));
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+}  // namespace
+
+uint32_t recordingChecksum(const void* data, size_t len, uint32_t crc) {
+#ifdef WATCHER_HAVE_ZLIB
+    const auto* p = static_cast<const Bytef*>(data);
+    uLong value = crc;
+    while (len) {
+        uInt chunk = static_cast<uInt>(std::min<size_t>(len, 1u << 30));
+        value = crc32(value, p, chunk);
+        p += chunk;
+        len -= chunk;
+    }
+    return static_cast<uint32_t>(value);
+#else
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    const auto* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < len; ++i) {
+        crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+#endif
+}
+
+namespace {
+
+/// Version 1 trailer (no directory)
+struct RecordingTrailerV1 {
+    uint64_t index_offset;
+    uint64_t segment_count;
+    uint64_t event_count;
+    uint32_t checksum;
+    uint32_t magic;
+};
+
+/// Parse a strings section into table (table[0] is the empty string)
+bool parseStrings(Cursor strings, size_t limit, std::vector<std::string>& table) {
+    table.assign(1, std::string());
+    uint64_t count = strings.varint();
+    if (count > limit) {
+        return false;
+    }
+    table.reserve(count + 1);
+    for (uint64_t s = 0; s < count && strings.ok; ++s) {
+        uint64_t len = strings.varint();
+        const uint8_t* at = strings.take(len);
+        table.emplace_back(at ? reinterpret_cast<const char*>(at) : "", at ? len : 0);
+    }
+    return strings.ok;
+}
+
+/// Copy one event's new (or, undoing it, old) bytes that fall inside the
+/// sub-page [offset, offset + data.size())
+void applyRuns(const EnrichedEvent& event, uint32_t offset, std::vector<uint8_t>& data, bool undo) {
+    uint64_t lo = offset;
+    uint64_t hi = lo + data.size();
+    for (const DeltaRun& run : event.deltas.runs) {
+        uint64_t start = std::max<uint64_t>(run.offset, lo);
+        uint64_t end = std::min<uint64_t>(uint64_t(run.offset) + run.length, hi);
+        if (start < end) {
+            const uint8_t* src = undo ? event.deltas.oldBytes(run) : event.deltas.newBytes(run);
+            memcpy(data.data() + (start - lo), src + (start - run.offset), end - start);
+        }
+    }
+}
+
+void encodeDirectory(const RecordingDirectory& directory, std::vector<uint8_t>& out) {
+    std::vector<const std::string*> ids;
+    ids.reserve(directory.size());
+    for (const auto& entry : directory) {
+        ids.push_back(&entry.first);
+    }
+    std::sort(ids.begin(), ids.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+
+    putVarint(out, ids.size());
+    for (const std::string* id : ids) {
+        const RecordingVariableIndex& index = directory.at(*id);
+        putVarint(out, id->size());
+        out.insert(out.end(), id->begin(), id->end());
+        putVarint(out, index.spans.size());
+        for (const auto& span : index.spans) {
+            putVarint(out, span.segment);
+            putVarint(out, span.events);
+            putVarint(out, span.min_ts_ns);
+            putVarint(out, span.max_ts_ns - span.min_ts_ns);
+        }
+        putVarint(out, index.keyframes.size());
+        for (const auto& keyframe : index.keyframes) {
+            putVarint(out, keyframe.segment);
+            putVarint(out, keyframe.slot);
+            putVarint(out, keyframe.offset);
+            putVarint(out, keyframe.ts_ns);
+        }
+    }
+}
+
+}  // namespace
+
+// ============================================================================
+// Recording Writer
+// ============================================================================
+
+uint32_t RecordingWriter::StringTable::intern(const std::string& s) {
+    if (s.empty()) {
+        return 0;
+    }
+    auto it = refs.find(s);
+    if (it != refs.end()) {
+        return it->second;
+    }
+    putVarint(bytes, s.size());
+    bytes.insert(bytes.end(), s.begin(), s.end());
+    refs.emplace(s, ++count);
+    return count;
+}
+
+void RecordingWriter::StringTable::clear() {
+    bytes.clear();
+    count = 0;
+    refs.clear();
+}
+
+RecordingCodec RecordingWriter::defaultCodec() {
+#ifdef WATCHER_HAVE_ZLIB
+    return RecordingCodec::ZLIB;
+#else
+    return RecordingCodec::NONE;
+#endif
+}
+
+std::unique_ptr<RecordingWriter> RecordingWriter::open(const std::string& path, RecordingCodec codec) {
+#ifndef WATCHER_HAVE_ZLIB
+    codec = RecordingCodec::NONE;
+#endif
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return nullptr;
+    }
+    std::unique_ptr<RecordingWriter> writer(new RecordingWriter(fd, codec));
+    if (!writer->recover(path)) {
+        return nullptr;
+    }
+    return writer;
+}
+
+RecordingWriter::~RecordingWriter() {
+    close();
+    ::close(fd_);
+}
+
+bool RecordingWriter::recover(const std::string& path) {
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        return false;
+    }
+    RecordingFileHeader header{RECORDING_MAGIC, RECORDING_VERSION, sizeof(RecordingFileHeader), 0};
+    if (st.st_size == 0) {
+        end_ = sizeof(header);
+        return writeFully(fd_, &header, sizeof(header), 0);
+    }
+
+    // Continue after the last good segment; the footer is rewritten on close.
+    // Version 1 segments are valid version 2 segments.
+    RecordingReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+    for (const auto& segment : reader.segments()) {
+        index_.push_back({segment.offset, segment.min_ts_ns, segment.max_ts_ns, segment.event_count,
+                          static_cast<uint32_t>(segment.kind)});
+    }
+    directory_ = reader.directory();
+    end_ = reader.dataEnd();
+    return ftruncate(fd_, static_cast<off_t>(end_)) == 0 && writeFully(fd_, &header, sizeof(header), 0);
+}
+
+bool RecordingWriter::append(const EnrichedEvent& event) {
+    // Still full: the last write failed. Retry it rather than let the
+    // segment grow past its limits.
+    if (segmentFull() && !writeSegment()) {
+        return false;
+    }
+    if (seq_.empty()) {
+        opened_ns_ = EventClock::now();
+    }
+    uint32_t pos = static_cast<uint32_t>(seq_.size());
+    seq_.push_back(event.event_seq);
+    ts_.push_back(event.ts_ns);
+    ip_.push_back(event.ip);
+    page_base_.push_back(reinterpret_cast<uintptr_t>(event.page_base));
+    fault_addr_.push_back(reinterpret_cast<uintptr_t>(event.fault_addr));
+    tid_.push_back(static_cast<uint32_t>(event.tid));
+    var_index_.push_back(event.variable_index);
+    line_.push_back(event.line);
+    symbol_.push_back(strings_.intern(event.symbol));
+    file_.push_back(strings_.intern(event.file));
+    var_name_.push_back(strings_.intern(event.variable_name));
+    sql_.push_back(strings_.intern(event.sql_context_id));
+
+    var_count_.push_back(static_cast<uint32_t>(event.variable_ids.size()));
+    for (const auto& id : event.variable_ids) {
+        putVarint(var_ids_, strings_.intern(id));
+        auto span = open_spans_.try_emplace(id, RecordingVariableIndex::Span{0, 0, event.ts_ns, event.ts_ns});
+        RecordingVariableIndex::Span& s = span.first->second;
+        s.events++;
+        s.min_ts_ns = std::min(s.min_ts_ns, event.ts_ns);
+        s.max_ts_ns = std::max(s.max_ts_ns, event.ts_ns);
+    }
+
+    size_t delta_start = deltas_.size();
+    int64_t prev_end = 0;
+    for (const DeltaRun& run : event.deltas.runs) {
+        putVarint(deltas_, zigzag(static_cast<int64_t>(run.offset) - prev_end));
+        putVarint(deltas_, run.length);
+        const uint8_t* old_bytes = event.deltas.oldBytes(run);
+        deltas_.insert(deltas_.end(), old_bytes, old_bytes + 2 * size_t(run.length));  // old, then new
+        prev_end = static_cast<int64_t>(run.offset) + run.length;
+    }
+    delta_runs_.push_back(static_cast<uint32_t>(event.deltas.runs.size()));
+    delta_size_.push_back(static_cast<uint32_t>(deltas_.size() - delta_start));
+
+    // Keyframe the diffed sub-page (it belongs to the first variable) on its
+    // first write and then every RECORDING_KEYFRAME_EVENTS / _BYTES
+    if (!event.post_snapshot.empty() && !event.variable_ids.empty()) {
+        const std::string& id = event.variable_ids.front();
+        auto cadence = cadence_[id].try_emplace(event.snapshot_offset);
+        SubPageCadence& c = cadence.first->second;
+        c.events++;
+        c.bytes += event.deltas.changedBytes();
+        if (cadence.second || c.events >= RECORDING_KEYFRAME_EVENTS || c.bytes >= RECORDING_KEYFRAME_BYTES) {
+            c = SubPageCadence{};
+            uint32_t ref = kf_strings_.intern(id);
+            if (ref > kf_ids_.size()) {
+                kf_ids_.push_back(id);
+            }
+            kf_ts_.push_back(event.ts_ns);
+            kf_seq_.push_back(event.event_seq);
+            kf_var_.push_back(ref);
+            kf_offset_.push_back(event.snapshot_offset);
+            kf_size_.push_back(static_cast<uint32_t>(event.post_snapshot.size()));
+            kf_pos_.push_back(pos);
+            kf_data_.insert(kf_data_.end(), event.post_snapshot.begin(), event.post_snapshot.end());
+        }
+    }
+
+    return segmentFull() ? writeSegment() : true;
+}
+
+bool RecordingWriter::segmentFull() const {
+    size_t raw_estimate = seq_.size() * FIXED_BYTES_PER_EVENT + strings_.bytes.size() + var_ids_.size() +
+                          deltas_.size() + kf_data_.size();
+    return seq_.size() >= RECORDING_SEGMENT_EVENTS || raw_estimate >= RECORDING_SEGMENT_BYTES;
+}
+
+bool RecordingWriter::flush(uint64_t now_ns) {
+    if (seq_.empty() || now_ns - opened_ns_ < RECORDING_SEGMENT_MAX_AGE_NS) {
+        return true;
+    }
+    return writeSegment();
+}
+
+bool RecordingWriter::sync() {
+    return writeSegment();
+}
+
+bool RecordingWriter::writePayload(RecordingSegmentKind kind, uint32_t count, const std::vector<uint64_t>& ts,
+                                   uint64_t& offset, RecordingIndexEntry& entry) {
+    RecordingSegmentHeader header{};
+    header.magic = RECORDING_SEGMENT_MAGIC;
+    header.codec = static_cast<uint16_t>(RecordingCodec::NONE);
+    header.kind = static_cast<uint16_t>(kind);
+    header.event_count = count;
+    header.raw_size = static_cast<uint32_t>(raw_.size());
+    header.min_ts_ns = *std::min_element(ts.begin(), ts.end());
+    header.max_ts_ns = *std::max_element(ts.begin(), ts.end());
+
+    const uint8_t* payload = raw_.data();
+    size_t payload_size = raw_.size();
+#ifdef WATCHER_HAVE_ZLIB
+    if (codec_ == RecordingCodec::ZLIB) {
+        uLongf bound = compressBound(static_cast<uLong>(raw_.size()));
+        stored_.resize(bound);
+        if (compress2(stored_.data(), &bound, raw_.data(), static_cast<uLong>(raw_.size()),
+                      RECORDING_ZLIB_LEVEL) == Z_OK && bound < raw_.size()) {
+            header.codec = static_cast<uint16_t>(RecordingCodec::ZLIB);
+            payload = stored_.data();
+            payload_size = bound;
+        }
+    }
+#endif
+    header.stored_size = static_cast<uint32_t>(payload_size);
+    header.checksum = recordingChecksum(payload, payload_size);
+
+    if (!writeFully(fd_, &header, sizeof(header), offset) ||
+        !writeFully(fd_, payload, payload_size, offset + sizeof(header))) {
+        return false;
+    }
+    entry = {offset, header.min_ts_ns, header.max_ts_ns, count, static_cast<uint32_t>(kind)};
+    offset += sizeof(header) + payload_size;
+    return true;
+}
+
+bool RecordingWriter::writeSegment() {
+    size_t n = seq_.size();
+    if (n == 0) {
+        return true;
+    }
+
+    // An earlier close() left a footer at end_; the new footer goes after this segment
+    if (footer_written_) {
+        if (ftruncate(fd_, static_cast<off_t>(end_)) != 0) {
+            return false;
+        }
+        footer_written_ = false;
+    }
+
+    // Nothing is indexed or cleared until both payloads are on disk: after a
+    // failed write the segment stays open and the next attempt rewrites it
+    // at end_
+    uint64_t offset = end_;
+    RecordingIndexEntry kf_entry{};
+    RecordingIndexEntry entry{};
+
+    // Keyframes first: they describe events of the segment written next
+    size_t keyframes = kf_ts_.size();
+    bool ok = true;
+    if (keyframes) {
+        raw_.clear();
+        putColumn(raw_, kf_ts_);
+        putColumn(raw_, kf_seq_);
+        putColumn(raw_, kf_var_);
+        putColumn(raw_, kf_offset_);
+        putColumn(raw_, kf_size_);
+        putColumn(raw_, kf_pos_);
+        std::vector<uint8_t>& strings = stored_;  // Scratch until compression
+        strings.clear();
+        putVarint(strings, kf_strings_.count);
+        strings.insert(strings.end(), kf_strings_.bytes.begin(), kf_strings_.bytes.end());
+        putSection(raw_, strings.data(), strings.size());
+        putSection(raw_, kf_data_.data(), kf_data_.size());
+        ok = writePayload(RecordingSegmentKind::KEYFRAMES, static_cast<uint32_t>(keyframes), kf_ts_,
+                          offset, kf_entry);
+    }
+
+    if (ok) {
+        raw_.clear();
+        putColumn(raw_, seq_);
+        putColumn(raw_, ts_);
+        putColumn(raw_, ip_);
+        putColumn(raw_, page_base_);
+        putColumn(raw_, fault_addr_);
+        putColumn(raw_, tid_);
+        putColumn(raw_, var_index_);
+        putColumn(raw_, line_);
+        putColumn(raw_, symbol_);
+        putColumn(raw_, file_);
+        putColumn(raw_, var_name_);
+        putColumn(raw_, sql_);
+        putColumn(raw_, var_count_);
+        putColumn(raw_, delta_runs_);
+        putColumn(raw_, delta_size_);
+        std::vector<uint8_t>& strings = stored_;
+        strings.clear();
+        putVarint(strings, strings_.count);
+        strings.insert(strings.end(), strings_.bytes.begin(), strings_.bytes.end());
+        putSection(raw_, strings.data(), strings.size());
+        putSection(raw_, var_ids_.data(), var_ids_.size());
+        putSection(raw_, deltas_.data(), deltas_.size());
+        ok = writePayload(RecordingSegmentKind::EVENTS, static_cast<uint32_t>(n), ts_, offset, entry);
+    }
+    if (!ok) {
+        return false;
+    }
+
+    if (keyframes) {
+        uint32_t segment = static_cast<uint32_t>(index_.size());
+        index_.push_back(kf_entry);
+        for (size_t i = 0; i < keyframes; ++i) {
+            directory_[kf_ids_[kf_var_[i] - 1]].keyframes.push_back(
+                {segment, static_cast<uint32_t>(i), kf_offset_[i], kf_ts_[i]});
+        }
+        keyframes_written_ += keyframes;
+    }
+    uint32_t segment = static_cast<uint32_t>(index_.size());
+    index_.push_back(entry);
+    for (auto& span : open_spans_) {
+        span.second.segment = segment;
+        directory_[span.first].spans.push_back(span.second);
+    }
+    events_written_ += n;
+    end_ = offset;
+
+    for (auto* column : {&seq_, &ts_, &ip_, &page_base_, &fault_addr_, &kf_ts_, &kf_seq_}) {
+        column->clear();
+    }
+    for (auto* column : {&tid_, &var_index_, &symbol_, &file_, &var_name_, &sql_, &var_count_,
+                         &delta_runs_, &delta_size_, &kf_var_, &kf_offset_, &kf_size_, &kf_pos_}) {
+        column->clear();
+    }
+    line_.clear();
+    var_ids_.clear();
+    deltas_.clear();
+    kf_data_.clear();
+    kf_ids_.clear();
+    strings_.clear();
+    kf_strings_.clear();
+    open_spans_.clear();
+    return true;
+}
+
+bool RecordingWriter::close() {
+    bool ok = writeSegment();
+    if (footer_written_) {
+        return ok;
+    }
+
+    std::vector<uint8_t> directory;
+    encodeDirectory(directory_, directory);
+
+    RecordingTrailer trailer{};
+    trailer.index_offset = end_;
+    trailer.segment_count = index_.size();
+    for (const auto& entry : index_) {
+        if (entry.kind == static_cast<uint32_t>(RecordingSegmentKind::EVENTS)) {
+            trailer.event_count += entry.event_count;
+        }
+    }
+    size_t index_bytes = index_.size() * sizeof(RecordingIndexEntry);
+    trailer.checksum = recordingChecksum(index_.data(), index_bytes);
+    trailer.directory_size = directory.size();
+    trailer.directory_checksum = recordingChecksum(directory.data(), directory.size());
+    trailer.magic = RECORDING_INDEX_MAGIC;
+
+    if (writeFully(fd_, index_.data(), index_bytes, end_) &&
+        writeFully(fd_, directory.data(), directory.size(), end_ + index_bytes) &&
+        writeFully(fd_, &trailer, sizeof(trailer), end_ + index_bytes + directory.size())) {
+        footer_written_ = true;
+        return ok;
+    }
+    return false;
+}
+
+// ============================================================================
+// Recording Reader
+// ============================================================================
+
+RecordingReader::~RecordingReader() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool RecordingReader::open(const std::string& path) {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+    segments_.clear();
+    directory_.clear();
+    current_.clear();
+    cached_.clear();
+    cached_index_ = SIZE_MAX;
+    next_segment_ = next_event_ = 0;
+    has_index_ = false;
+    error_.clear();
+
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd_ < 0 || fstat(fd_, &st) != 0) {
+        error_ = "Cannot open " + path;
+        return false;
+    }
+    uint64_t file_size = static_cast<uint64_t>(st.st_size);
+
+    RecordingFileHeader header{};
+    if (!readFully(fd_, &header, sizeof(header), 0) || header.magic != RECORDING_MAGIC ||
+        header.header_size < sizeof(header)) {
+        error_ = path + " is not a recording";
+        return false;
+    }
+    if (header.version < 1 || header.version > RECORDING_VERSION) {
+        error_ = path + " has unsupported recording version " + std::to_string(header.version);
+        return false;
+    }
+    version_ = header.version;
+
+    // Footer index (and directory), if the writer closed the file
+    RecordingTrailer trailer{};
+    uint64_t index_offset = 0, segment_count = 0, directory_size = 0;
+    uint32_t checksum = 0, directory_checksum = 0;
+    bool trailer_ok = false;
+    if (version_ == 1) {
+        RecordingTrailerV1 v1{};
+        trailer_ok = file_size >= header.header_size + sizeof(v1) &&
+                     readFully(fd_, &v1, sizeof(v1), file_size - sizeof(v1)) && v1.magic == RECORDING_INDEX_MAGIC;
+        index_offset = v1.index_offset;
+        segment_count = v1.segment_count;
+        checksum = v1.checksum;
+        trailer_ok = trailer_ok && segment_count <= file_size / sizeof(RecordingIndexEntry) &&
+                     index_offset + segment_count * sizeof(RecordingIndexEntry) + sizeof(v1) == file_size;
+    } else {
+        trailer_ok = file_size >= header.header_size + sizeof(trailer) &&
+                     readFully(fd_, &trailer, sizeof(trailer), file_size - sizeof(trailer)) &&
+                     trailer.magic == RECORDING_INDEX_MAGIC;
+        index_offset = trailer.index_offset;
+        segment_count = trailer.segment_count;
+        directory_size = trailer.directory_size;
+        checksum = trailer.checksum;
+        directory_checksum = trailer.directory_checksum;
+        trailer_ok = trailer_ok && segment_count <= file_size / sizeof(RecordingIndexEntry) &&
+                     directory_size <= file_size &&
+                     index_offset + segment_count * sizeof(RecordingIndexEntry) + directory_size +
+                         sizeof(trailer) == file_size;
+    }
+
+    if (trailer_ok && index_offset >= header.header_size) {
+        std::vector<RecordingIndexEntry> entries(segment_count);
+        size_t index_bytes = entries.size() * sizeof(RecordingIndexEntry);
+        std::vector<uint8_t> directory(directory_size);
+        if (readFully(fd_, entries.data(), index_bytes, index_offset) &&
+            recordingChecksum(entries.data(), index_bytes) == checksum &&
+            readFully(fd_, directory.data(), directory.size(), index_offset + index_bytes)) {
+            for (const auto& entry : entries) {
+                segments_.push_back({entry.offset, entry.min_ts_ns, entry.max_ts_ns, entry.event_count,
+                                     static_cast<RecordingSegmentKind>(entry.kind)});
+            }
+            has_index_ = true;
+            data_end_ = index_offset;
+            if (version_ > 1 && recordingChecksum(directory.data(), directory.size()) == directory_checksum &&
+                parseDirectory(directory.data(), directory.size())) {
+                return true;
+            }
+            return rebuildDirectory();
+        }
+    }
+    return scan(file_size) && rebuildDirectory();
+}
+
+bool RecordingReader::scan(uint64_t file_size) {
+    RecordingFileHeader file_header{};
+    readFully(fd_, &file_header, sizeof(file_header), 0);
+    uint64_t offset = file_header.header_size;
+
+    // Stop at the first segment that is torn or fails its checksum
+    RecordingSegmentHeader header{};
+    while (offset + sizeof(header) <= file_size &&
+           readFully(fd_, &header, sizeof(header), offset) &&
+           header.magic == RECORDING_SEGMENT_MAGIC &&
+           offset + sizeof(header) + header.stored_size <= file_size) {
+        stored_.resize(header.stored_size);
+        if (!readFully(fd_, stored_.data(), stored_.size(), offset + sizeof(header)) ||
+            recordingChecksum(stored_.data(), stored_.size()) != header.checksum) {
+            break;
+        }
+        segments_.push_back({offset, header.min_ts_ns, header.max_ts_ns, header.event_count,
+                             static_cast<RecordingSegmentKind>(header.kind)});
+        offset += sizeof(header) + header.stored_size;
+    }
+    data_end_ = offset;
+    return true;
+}
+
+bool RecordingReader::parseDirectory(const uint8_t* data, size_t len) {
+    Cursor c(data, len);
+    uint64_t variables = c.varint();
+    if (variables > len) {
+        return false;
+    }
+    for (uint64_t v = 0; v < variables && c.ok; ++v) {
+        uint64_t id_len = c.varint();
+        const uint8_t* id = c.take(id_len);
+        if (!id) {
+            return false;
+        }
+        RecordingVariableIndex& index = directory_[std::string(reinterpret_cast<const char*>(id), id_len)];
+        uint64_t spans = c.varint();
+        if (spans > len) {
+            return false;
+        }
+        for (uint64_t s = 0; s < spans && c.ok; ++s) {
+            RecordingVariableIndex::Span span{};
+            span.segment = static_cast<uint32_t>(c.varint());
+            span.events = static_cast<uint32_t>(c.varint());
+            span.min_ts_ns = c.varint();
+            span.max_ts_ns = span.min_ts_ns + c.varint();
+            index.spans.push_back(span);
+        }
+        uint64_t keyframes = c.varint();
+        if (keyframes > len) {
+            return false;
+        }
+        for (uint64_t k = 0; k < keyframes && c.ok; ++k) {
+            RecordingVariableIndex::Keyframe keyframe{};
+            keyframe.segment = static_cast<uint32_t>(c.varint());
+            keyframe.slot = static_cast<uint32_t>(c.varint());
+            keyframe.offset = static_cast<uint32_t>(c.varint());
+            keyframe.ts_ns = c.varint();
+            index.keyframes.push_back(keyframe);
+        }
+    }
+    if (!c.ok) {
+        directory_.clear();
+        return false;
+    }
+    for (const auto& entry : directory_) {
+        for (const auto& span : entry.second.spans) {
+            if (span.segment >= segments_.size()) {
+                directory_.clear();
+                return false;
+            }
+        }
+        for (const auto& keyframe : entry.second.keyframes) {
+            if (keyframe.segment >= segments_.size()) {
+                directory_.clear();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool RecordingReader::rebuildDirectory() {
+    directory_.clear();
+    std::vector<EnrichedEvent> events;
+    std::vector<RecordingKeyframe> keyframes;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        uint32_t segment = static_cast<uint32_t>(i);
+        if (segments_[i].kind == RecordingSegmentKind::KEYFRAMES) {
+            if (!readKeyframes(i, keyframes)) {
+                return false;
+            }
+            for (size_t k = 0; k < keyframes.size(); ++k) {
+                directory_[keyframes[k].variable_id].keyframes.push_back(
+                    {segment, static_cast<uint32_t>(k), keyframes[k].offset, keyframes[k].ts_ns});
+            }
+            continue;
+        }
+        if (!readSegment(i, events)) {
+            return false;
+        }
+        for (const auto& event : events) {
+            for (const auto& id : event.variable_ids) {
+                auto& spans = directory_[id].spans;
+                if (spans.empty() || spans.back().segment != segment) {
+                    spans.push_back({segment, 0, event.ts_ns, event.ts_ns});
+                }
+                auto& span = spans.back();
+                span.events++;
+                span.min_ts_ns = std::min(span.min_ts_ns, event.ts_ns);
+                span.max_ts_ns = std::max(span.max_ts_ns, event.ts_ns);
+            }
+        }
+    }
+    return true;
+}
+
+uint64_t RecordingReader::eventCount() const {
+    uint64_t total = 0;
+    for (const auto& segment : segments_) {
+        if (segment.kind == RecordingSegmentKind::EVENTS) {
+            total += segment.event_count;
+        }
+    }
+    return total;
+}
+
+bool RecordingReader::loadPayload(size_t i, RecordingSegmentKind kind, RecordingSegmentHeader& header) {
+    if (i >= segments_.size()) {
+        error_ = "Segment out of range";
+        return false;
+    }
+    uint64_t offset = segments_[i].offset;
+    if (!readFully(fd_, &header, sizeof(header), offset) || header.magic != RECORDING_SEGMENT_MAGIC) {
+        error_ = "Bad segment header at offset " + std::to_string(offset);
+        return false;
+    }
+    if (header.kind != static_cast<uint16_t>(kind)) {
+        error_ = "Segment at offset " + std::to_string(offset) + " holds other records";
+        return false;
+    }
+    stored_.resize(header.stored_size);
+    if (!readFully(fd_, stored_.data(), stored_.size(), offset + sizeof(header)) ||
+        recordingChecksum(stored_.data(), stored_.size()) != header.checksum) {
+        error_ = "Segment at offset " + std::to_string(offset) + " fails its checksum";
+        return false;
+    }
+
+    switch (static_cast<RecordingCodec>(header.codec)) {
+    case RecordingCodec::NONE:
+        raw_.swap(stored_);
+        break;
+#ifdef WATCHER_HAVE_ZLIB
+    case RecordingCodec::ZLIB: {
+        raw_.resize(header.raw_size);
+        uLongf raw_size = header.raw_size;
+        if (uncompress(raw_.data(), &raw_size, stored_.data(), static_cast<uLong>(stored_.size())) != Z_OK ||
+            raw_size != header.raw_size) {
+            error_ = "Segment at offset " + std::to_string(offset) + " does not decompress";
+            return false;
+        }
+        break;
+    }
+#endif
+    default:
+        error_ = "Segment codec " + std::to_string(header.codec) + " is not supported by this build";
+        return false;
+    }
+    if (raw_.size() != header.raw_size) {
+        error_ = "Segment at offset " + std::to_string(offset) + " has the wrong size";
+        return false;
+    }
+    return true;
+}
+
+bool RecordingReader::readSegment(size_t i, std::vector<EnrichedEvent>& out) {
+    out.clear();
+    RecordingSegmentHeader header{};
+    if (!loadPayload(i, RecordingSegmentKind::EVENTS, header)) {
+        return false;
+    }
+    if (!decode(header, out)) {
+        error_ = "Segment at offset " + std::to_string(segments_[i].offset) + " is malformed";
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+bool RecordingReader::readKeyframes(size_t i, std::vector<RecordingKeyframe>& out) {
+    out.clear();
+    RecordingSegmentHeader header{};
+    if (!loadPayload(i, RecordingSegmentKind::KEYFRAMES, header)) {
+        return false;
+    }
+    if (!decodeKeyframes(header.event_count, out)) {
+        error_ = "Keyframes at offset " + std::to_string(segments_[i].offset) + " are malformed";
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+bool RecordingReader::decode(const RecordingSegmentHeader& header, std::vector<EnrichedEvent>& out) {
+    size_t n = header.event_count;
+    Cursor c(raw_.data(), raw_.size());
+    const uint8_t* seq = takeColumn<uint64_t>(c, n);
+    const uint8_t* ts = takeColumn<uint64_t>(c, n);
+    const uint8_t* ip = takeColumn<uint64_t>(c, n);
+    const uint8_t* page_base = takeColumn<uint64_t>(c, n);
+    const uint8_t* fault_addr = takeColumn<uint64_t>(c, n);
+    const uint8_t* tid = takeColumn<uint32_t>(c, n);
+    const uint8_t* var_index = takeColumn<uint32_t>(c, n);
+    const uint8_t* line = takeColumn<int32_t>(c, n);
+    const uint8_t* symbol = takeColumn<uint32_t>(c, n);
+    const uint8_t* file = takeColumn<uint32_t>(c, n);
+    const uint8_t* var_name = takeColumn<uint32_t>(c, n);
+    const uint8_t* sql = takeColumn<uint32_t>(c, n);
+    const uint8_t* var_count = takeColumn<uint32_t>(c, n);
+    const uint8_t* delta_runs = takeColumn<uint32_t>(c, n);
+    takeColumn<uint32_t>(c, n);  // delta_size, for readers that skip events
+    Cursor strings = c.section();
+    Cursor var_ids = c.section();
+    Cursor deltas = c.section();
+    std::vector<std::string> table;
+    if (!c.ok || !parseStrings(strings, raw_.size(), table)) {
+        return false;
+    }
+    auto lookup = [&](uint64_t ref, std::string& dst) {
+        if (ref >= table.size()) {
+            return false;
+        }
+        dst = table[ref];
+        return true;
+    };
+
+    out.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        EnrichedEvent& event = out[i];
+        event.event_seq = load<uint64_t>(seq, i);
+        event.ts_ns = load<uint64_t>(ts, i);
+        event.ip = load<uint64_t>(ip, i);
+        event.page_base = reinterpret_cast<void*>(static_cast<uintptr_t>(load<uint64_t>(page_base, i)));
+        event.fault_addr = reinterpret_cast<void*>(static_cast<uintptr_t>(load<uint64_t>(fault_addr, i)));
+        event.tid = static_cast<pid_t>(load<uint32_t>(tid, i));
+        event.variable_index = load<uint32_t>(var_index, i);
+        event.line = load<int32_t>(line, i);
+        if (!lookup(load<uint32_t>(symbol, i), event.symbol) || !lookup(load<uint32_t>(file, i), event.file) ||
+            !lookup(load<uint32_t>(var_name, i), event.variable_name) ||
+            !lookup(load<uint32_t>(sql, i), event.sql_context_id)) {
+            return false;
+        }
+
+        uint32_t ids = load<uint32_t>(var_count, i);
+        if (ids > static_cast<size_t>(var_ids.end - var_ids.p)) {
+            return false;
+        }
+        event.variable_ids.resize(ids);
+        for (uint32_t v = 0; v < ids; ++v) {
+            if (!lookup(var_ids.varint(), event.variable_ids[v])) {
+                return false;
+            }
+        }
+
+        uint32_t runs = load<uint32_t>(delta_runs, i);
+        if (runs > static_cast<size_t>(deltas.end - deltas.p)) {
+            return false;
+        }
+        event.deltas.clear();
+        event.deltas.runs.reserve(runs);
+        int64_t prev_end = 0;
+        for (uint32_t r = 0; r < runs; ++r) {
+            int64_t run_offset = prev_end + unzigzag(deltas.varint());
+            uint64_t len = deltas.varint();
+            const uint8_t* bytes = deltas.take(2 * len);
+            if (!bytes || run_offset < 0 || run_offset > UINT32_MAX) {
+                return false;
+            }
+            DeltaRun run{static_cast<uint32_t>(run_offset), static_cast<uint32_t>(len),
+                         static_cast<uint32_t>(event.deltas.arena.size())};
+            event.deltas.arena.insert(event.deltas.arena.end(), bytes, bytes + 2 * len);
+            event.deltas.runs.push_back(run);
+            prev_end = run_offset + static_cast<int64_t>(len);
+        }
+        event.pre_snapshot.clear();
+        event.post_snapshot.clear();
+        // Runs of one event lie in one sub-page
+        event.snapshot_offset = event.deltas.empty() ? 0 : event.deltas.runs[0].offset / PAGE_SIZE * PAGE_SIZE;
+    }
+    return var_ids.ok && deltas.ok;
+}
+
+bool RecordingReader::decodeKeyframes(uint32_t count, std::vector<RecordingKeyframe>& out) {
+    size_t k = count;
+    Cursor c(raw_.data(), raw_.size());
+    const uint8_t* ts = takeColumn<uint64_t>(c, k);
+    const uint8_t* seq = takeColumn<uint64_t>(c, k);
+    const uint8_t* var = takeColumn<uint32_t>(c, k);
+    const uint8_t* offset = takeColumn<uint32_t>(c, k);
+    const uint8_t* size = takeColumn<uint32_t>(c, k);
+    const uint8_t* pos = takeColumn<uint32_t>(c, k);
+    Cursor strings = c.section();
+    Cursor data = c.section();
+    std::vector<std::string> table;
+    if (!c.ok || !parseStrings(strings, raw_.size(), table)) {
+        return false;
+    }
+
+    out.resize(k);
+    for (size_t i = 0; i < k; ++i) {
+        RecordingKeyframe& keyframe = out[i];
+        uint32_t ref = load<uint32_t>(var, i);
+        const uint8_t* bytes = data.take(load<uint32_t>(size, i));
+        if (ref == 0 || ref >= table.size() || !bytes) {
+            return false;
+        }
+        keyframe.ts_ns = load<uint64_t>(ts, i);
+        keyframe.event_seq = load<uint64_t>(seq, i);
+        keyframe.variable_id = table[ref];
+        keyframe.offset = load<uint32_t>(offset, i);
+        keyframe.event_pos = load<uint32_t>(pos, i);
+        keyframe.data.assign(bytes, bytes + load<uint32_t>(size, i));
+    }
+    return true;
+}
+
+bool RecordingReader::next(EnrichedEvent& out) {
+    while (next_event_ >= current_.size()) {
+        // Keyframes are reached through variableState()
+        while (next_segment_ < segments_.size() &&
+               segments_[next_segment_].kind != RecordingSegmentKind::EVENTS) {
+            ++next_segment_;
+        }
+        if (next_segment_ >= segments_.size()) {
+            return false;
+        }
+        if (!readSegment(next_segment_++, current_)) {
+            return false;
+        }
+        next_event_ = 0;
+    }
+    out = std::move(current_[next_event_++]);
+    return true;
+}
+
+const std::vector<EnrichedEvent>* RecordingReader::cachedSegment(size_t i) {
+    if (cached_index_ != i) {
+        cached_index_ = SIZE_MAX;
+        if (!readSegment(i, cached_)) {
+            return nullptr;
+        }
+        cached_index_ = i;
+    }
+    return &cached_;
+}
+
+bool RecordingReader::variableEvents(const std::string& variable_id, uint64_t start_ns, uint64_t end_ns,
+                                     std::vector<EnrichedEvent>& out) {
+    out.clear();
+    auto found = directory_.find(variable_id);
+    if (found == directory_.end()) {
+        return true;
+    }
+    for (const auto& span : found->second.spans) {
+        if (span.max_ts_ns < start_ns || span.min_ts_ns > end_ns) {
+            continue;
+        }
+        const std::vector<EnrichedEvent>* events = cachedSegment(span.segment);
+        if (!events) {
+            return false;
+        }
+        for (const auto& event : *events) {
+            if (event.ts_ns >= start_ns && event.ts_ns <= end_ns &&
+                std::find(event.variable_ids.begin(), event.variable_ids.end(), variable_id) !=
+                    event.variable_ids.end()) {
+                out.push_back(event);
+            }
+        }
+    }
+    return true;
+}
+
+bool RecordingReader::variableState(const std::string& variable_id, uint64_t ts_ns,
+                                    std::vector<RecordedSubPage>& out) {
+    out.clear();
+    auto found = directory_.find(variable_id);
+    if (found == directory_.end()) {
+        return true;
+    }
+    const RecordingVariableIndex& index = found->second;
+
+    // Per sub-page: the last keyframe at or before ts_ns, else the first one
+    std::vector<uint32_t> offsets;
+    for (const auto& keyframe : index.keyframes) {
+        offsets.push_back(keyframe.offset);
+    }
+    std::sort(offsets.begin(), offsets.end());
+    offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+    std::vector<RecordingKeyframe> keyframes;
+    size_t keyframes_segment = SIZE_MAX;
+    for (uint32_t offset : offsets) {
+        const RecordingVariableIndex::Keyframe* base = nullptr;
+        const RecordingVariableIndex::Keyframe* first = nullptr;
+        for (const auto& keyframe : index.keyframes) {
+            if (keyframe.offset != offset) {
+                continue;
+            }
+            if (!first) {
+                first = &keyframe;
+            }
+            if (keyframe.ts_ns <= ts_ns) {
+                base = &keyframe;
+            }
+        }
+        bool forward = base != nullptr;
+        if (!forward) {
+            base = first;
+        }
+
+        if (keyframes_segment != base->segment) {
+            keyframes_segment = SIZE_MAX;
+            if (!readKeyframes(base->segment, keyframes) || base->slot >= keyframes.size()) {
+                return false;
+            }
+            keyframes_segment = base->segment;
+        }
+        RecordedSubPage page{offset, keyframes[base->slot].data};
+        uint32_t event_segment = base->segment + 1;
+        uint32_t event_pos = keyframes[base->slot].event_pos;
+
+        // Replay later events up to ts_ns, or undo the keyframe's own event
+        // (and anything before it) back past ts_ns
+        auto owns = [&](const EnrichedEvent& event) {
+            return !event.variable_ids.empty() && event.variable_ids.front() == variable_id;
+        };
+        if (forward) {
+            for (const auto& span : index.spans) {
+                if (span.segment < event_segment || span.min_ts_ns > ts_ns) {
+                    continue;
+                }
+                const std::vector<EnrichedEvent>* events = cachedSegment(span.segment);
+                if (!events) {
+                    return false;
+                }
+                size_t start = span.segment == event_segment ? event_pos + 1 : 0;
+                for (size_t e = start; e < events->size(); ++e) {
+                    if ((*events)[e].ts_ns <= ts_ns && owns((*events)[e])) {
+                        applyRuns((*events)[e], offset, page.data, false);
+                    }
+                }
+            }
+        } else {
+            for (auto span = index.spans.rbegin(); span != index.spans.rend(); ++span) {
+                if (span->segment > event_segment || span->max_ts_ns <= ts_ns) {
+                    continue;
+                }
+                const std::vector<EnrichedEvent>* events = cachedSegment(span->segment);
+                if (!events) {
+                    return false;
+                }
+                size_t end = span->segment == event_segment ? std::min<size_t>(event_pos + 1, events->size())
+                                                            : events->size();
+                for (size_t e = end; e-- > 0;) {
+                    if ((*events)[e].ts_ns > ts_ns && owns((*events)[e])) {
+                        applyRuns((*events)[e], offset, page.data, true);
+                    }
+                }
+            }
+        }
+        out.push_back(std::move(page));
+    }
+    return true;
+}
+
+}  // namespace watcher
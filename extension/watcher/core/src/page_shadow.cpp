@@ -0,0 +1,207 @@
+#include "page_shadow.hpp"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+
+namespace watcher {
+
+std::shared_ptr<ShadowArena> ShadowArena::shared() {
+    static std::shared_ptr<ShadowArena> arena = std::make_shared<ShadowArena>();
+    return arena;
+}
+
+ShadowArena::ShadowArena()
+    : fd_(memfd_create("watcher-shadow", MFD_CLOEXEC)), file_size_(0), cursor_(nullptr),
+      remaining_(0), in_use_(0) {}
+
+ShadowArena::~ShadowArena() {
+    for (const auto& chunk : chunks_) {
+        munmap(chunk.first, chunk.second);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+size_t ShadowArena::blockSize(size_t len) {
+    if (len == 0) {
+        return 0;
+    }
+    if (len > SUBPAGE_SIZE / 2) {
+        return (len + SUBPAGE_SIZE - 1) / SUBPAGE_SIZE * SUBPAGE_SIZE;
+    }
+    size_t slot = MIN_SLOT;
+    while (slot < len) {
+        slot <<= 1;
+    }
+    return slot;
+}
+
+uint8_t* ShadowArena::allocate(size_t len) {
+    size_t size = blockSize(len);
+    if (size == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<uint8_t*>& free_blocks = free_[size];
+    if (free_blocks.empty()) {
+        if (size >= SUBPAGE_SIZE) {
+            uint8_t* block = carve(size);
+            if (!block) {
+                return nullptr;
+            }
+            free_blocks.push_back(block);
+        } else {
+            // Slots are cut from a whole sub-page so none straddles two
+            uint8_t* page = carve(SUBPAGE_SIZE);
+            if (!page) {
+                return nullptr;
+            }
+            for (size_t offset = SUBPAGE_SIZE; offset > 0; offset -= size) {
+                free_blocks.push_back(page + offset - size);
+            }
+        }
+    }
+    uint8_t* block = free_blocks.back();
+    free_blocks.pop_back();
+    in_use_ += size;
+    return block;
+}
+
+void ShadowArena::release(uint8_t* block, size_t len) {
+    size_t size = blockSize(len);
+    if (!block || size == 0) {
+        return;
+    }
+    if (size >= SUBPAGE_SIZE) {
+        // Give the memory back; the range stays reserved for reuse
+        madvise(block, size, fd_ >= 0 ? MADV_REMOVE : MADV_DONTNEED);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_[size].push_back(block);
+    in_use_ -= size;
+}
+
+size_t ShadowArena::bytesInUse() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_use_;
+}
+
+uint8_t* ShadowArena::carve(size_t size) {
+    if (size > remaining_) {
+        // The old chunk's tail is abandoned (address space only)
+        size_t chunk = std::max(size, CHUNK_SIZE);
+        void* mem = MAP_FAILED;
+        if (fd_ >= 0 && ftruncate(fd_, static_cast<off_t>(file_size_ + chunk)) == 0) {
+            mem = mmap(nullptr, chunk, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, fd_,
+                       static_cast<off_t>(file_size_));
+        } else if (fd_ < 0) {
+            mem = mmap(nullptr, chunk, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        }
+        if (mem == MAP_FAILED) {
+            return nullptr;
+        }
+        // A forked child must not write into the parent's shadows
+        madvise(mem, chunk, MADV_DONTFORK);
+        file_size_ += chunk;
+        chunks_.emplace_back(static_cast<uint8_t*>(mem), chunk);
+        cursor_ = static_cast<uint8_t*>(mem);
+        remaining_ = chunk;
+    }
+    uint8_t* block = cursor_;
+    cursor_ += size;
+    remaining_ -= size;
+    return block;
+}
+
+PageShadow::PageShadow(size_t len, std::shared_ptr<ShadowArena> arena)
+    : arena_(arena ? std::move(arena) : ShadowArena::shared()),
+      data_(nullptr),
+      bytes_(len),
+      size_((len + SUBPAGE_SIZE - 1) / SUBPAGE_SIZE * SUBPAGE_SIZE),
+      words_((size_ / SUBPAGE_SIZE + 63) / 64),
+      dirty_count_(0),
+      dirty_(new std::atomic<uint64_t>[words_]),
+      generation_(0),
+      view_generation_(0) {
+    for (size_t w = 0; w < words_; ++w) {
+        dirty_[w].store(0, std::memory_order_relaxed);
+    }
+    // Only bytes_ is ever copied, so a short span needs only a slot
+    data_ = arena_->allocate(bytes_);
+}
+
+PageShadow::~PageShadow() {
+    arena_->release(data_, bytes_);
+}
+
+bool PageShadow::markDirty(size_t index, const uint8_t* live) {
+    if (index >= subPageCount() || isDirty(index)) {
+        return false;
+    }
+    // Copy before publishing the bit so readers never see a dirty sub-page
+    // with missing contents
+    memcpy(subPage(index), live, subPageBytes(index));
+    uint64_t bit = uint64_t(1) << (index % 64);
+    if (dirty_[index / 64].fetch_or(bit, std::memory_order_acq_rel) & bit) {
+        return false;
+    }
+    dirty_count_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void PageShadow::captureAll(const uint8_t* live) {
+    for (size_t i = 0; i < subPageCount(); ++i) {
+        markDirty(i, live + i * SUBPAGE_SIZE);
+    }
+}
+
+void PageShadow::assign(const uint8_t* baseline, size_t len, const uint8_t* live) {
+    if (len > bytes_) {
+        len = bytes_;
+    }
+    memcpy(data_, baseline, len);
+    memcpy(data_ + len, live + len, bytes_ - len);
+    for (size_t w = 0; w < words_; ++w) {
+        dirty_[w].store(~uint64_t(0), std::memory_order_release);
+    }
+    size_t tail = subPageCount() % 64;
+    if (tail) {
+        dirty_[words_ - 1].store((uint64_t(1) << tail) - 1, std::memory_order_release);
+    }
+    dirty_count_.store(subPageCount(), std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_release);
+}
+
+void PageShadow::refresh(size_t index, const uint8_t* contents) {
+    if (index >= subPageCount()) {
+        return;
+    }
+    if (!markDirty(index, contents)) {
+        memcpy(subPage(index), contents, subPageBytes(index));
+    }
+    generation_.fetch_add(1, std::memory_order_release);
+}
+
+void PageShadow::materialize(const uint8_t* live, uint8_t* out) const {
+    for (size_t i = 0; i < subPageCount(); ++i) {
+        const uint8_t* src = isDirty(i) ? subPage(i) : live + i * SUBPAGE_SIZE;
+        memcpy(out + i * SUBPAGE_SIZE, src, subPageBytes(i));
+    }
+}
+
+SnapshotView PageShadow::view(const uint8_t* live) {
+    // Read the generation first: a refresh during the copy forces a new view
+    uint64_t generation = this->generation();
+    if (view_ && view_generation_ == generation) {
+        return view_;
+    }
+    auto snapshot = std::make_shared<std::vector<uint8_t>>(bytes_);
+    materialize(live, snapshot->data());
+    view_ = std::move(snapshot);
+    view_generation_ = generation;
+    return view_;
+}
+
+}  // namespace watcher
@@ -0,0 +1,747 @@
+#include "symbolizer.hpp"
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <link.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+namespace watcher {
+
+// ============================================================================
+// ELF Image (read-only mapping of one object file)
+// ============================================================================
+
+namespace {
+
+constexpr uint32_t END_OF_SEQUENCE = UINT32_MAX;
+
+class ElfImage {
+public:
+    explicit ElfImage(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(Elf64_Ehdr))) {
+            void* mem = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mem != MAP_FAILED) {
+                data_ = static_cast<const uint8_t*>(mem);
+                size_ = static_cast<size_t>(st.st_size);
+            }
+        }
+        close(fd);
+        if (data_ && !parse()) {
+            munmap(const_cast<uint8_t*>(data_), size_);
+            data_ = nullptr;
+        }
+    }
+
+    ~ElfImage() {
+        if (data_) {
+            munmap(const_cast<uint8_t*>(data_), size_);
+        }
+    }
+
+    ElfImage(const ElfImage&) = delete;
+    ElfImage& operator=(const ElfImage&) = delete;
+
+    bool valid() const { return data_ != nullptr; }
+
+    const Elf64_Shdr* section(const char* name) const {
+        for (size_t i = 0; i < count_; ++i) {
+            if (sections_[i].sh_name < shstr_size_ && strcmp(shstr_ + sections_[i].sh_name, name) == 0) {
+                return &sections_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    /// Contents of a section; empty for missing, NOBITS or compressed sections
+    bool contents(const Elf64_Shdr* shdr, const uint8_t*& out, size_t& len) const {
+        if (!shdr || shdr->sh_type == SHT_NOBITS || (shdr->sh_flags & SHF_COMPRESSED) ||
+            shdr->sh_offset > size_ || shdr->sh_size > size_ - shdr->sh_offset) {
+            return false;
+        }
+        out = data_ + shdr->sh_offset;
+        len = shdr->sh_size;
+        return true;
+    }
+
+    bool contents(const char* name, const uint8_t*& out, size_t& len) const {
+        return contents(section(name), out, len);
+    }
+
+private:
+    bool parse() {
+        auto* ehdr = reinterpret_cast<const Elf64_Ehdr*>(data_);
+        if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 || ehdr->e_ident[EI_CLASS] != ELFCLASS64 ||
+            ehdr->e_ident[EI_DATA] != ELFDATA2LSB || ehdr->e_shentsize != sizeof(Elf64_Shdr) ||
+            ehdr->e_shoff > size_ || ehdr->e_shnum > (size_ - ehdr->e_shoff) / sizeof(Elf64_Shdr) ||
+            ehdr->e_shstrndx >= ehdr->e_shnum) {
+            return false;
+        }
+        sections_ = reinterpret_cast<const Elf64_Shdr*>(data_ + ehdr->e_shoff);
+        count_ = ehdr->e_shnum;
+        const Elf64_Shdr& shstr = sections_[ehdr->e_shstrndx];
+        if (shstr.sh_offset > size_ || shstr.sh_size > size_ - shstr.sh_offset) {
+            return false;
+        }
+        shstr_ = reinterpret_cast<const char*>(data_ + shstr.sh_offset);
+        shstr_size_ = shstr.sh_size;
+        return true;
+    }
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    const Elf64_Shdr* sections_ = nullptr;
+    size_t count_ = 0;
+    const char* shstr_ = nullptr;
+    size_t shstr_size_ = 0;
+};
+
+/// Bounds-checked little-endian reader over DWARF data
+struct Cursor {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+
+    bool need(size_t n) {
+        if (static_cast<size_t>(end - p) < n) {
+            ok = false;
+            p = end;
+            return false;
+        }
+        return true;
+    }
+    template <typename T> T fixed() {
+        T value = 0;
+        if (need(sizeof(T))) {
+            memcpy(&value, p, sizeof(T));
+            p += sizeof(T);
+        }
+        return value;
+    }
+    uint64_t uleb() {
+        uint64_t value = 0;
+        for (unsigned shift = 0; need(1); shift += 7) {
+            uint8_t byte = *p++;
+            if (shift < 64) {
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            }
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        return value;
+    }
+    int64_t sleb() {
+        int64_t value = 0;
+        unsigned shift = 0;
+        uint8_t byte = 0;
+        while (need(1)) {
+            byte = *p++;
+            if (shift < 64) {
+                value |= static_cast<int64_t>(byte & 0x7F) << shift;
+            }
+            shift += 7;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        if (shift < 64 && (byte & 0x40)) {
+            value |= -(static_cast<int64_t>(1) << shift);
+        }
+        return value;
+    }
+    const char* cstr() {
+        const uint8_t* nul = static_cast<const uint8_t*>(memchr(p, 0, end - p));
+        if (!nul) {
+            ok = false;
+            p = end;
+            return "";
+        }
+        const char* s = reinterpret_cast<const char*>(p);
+        p = nul + 1;
+        return s;
+    }
+    void skip(uint64_t n) {
+        if (need(n)) {
+            p += n;
+        }
+    }
+};
+
+struct StringSection {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    const char* at(uint64_t offset) const {
+        if (!data || offset >= size || !memchr(data + offset, 0, size - offset)) {
+            return "";
+        }
+        return reinterpret_cast<const char*>(data + offset);
+    }
+};
+
+// DWARF constants (dwarf.h is not always installed)
+enum : uint8_t {
+    DW_LNS_copy = 1, DW_LNS_advance_pc, DW_LNS_advance_line, DW_LNS_set_file,
+    DW_LNS_set_column, DW_LNS_negate_stmt, DW_LNS_set_basic_block, DW_LNS_const_add_pc,
+    DW_LNS_fixed_advance_pc,
+};
+enum : uint8_t { DW_LNE_end_sequence = 1, DW_LNE_set_address, DW_LNE_define_file };
+enum : uint64_t { DW_LNCT_path = 1, DW_LNCT_directory_index = 2 };
+enum : uint64_t {
+    DW_FORM_block = 0x09, DW_FORM_block1 = 0x0a, DW_FORM_data1 = 0x0b, DW_FORM_data2 = 0x05,
+    DW_FORM_data4 = 0x06, DW_FORM_data8 = 0x07, DW_FORM_data16 = 0x1e, DW_FORM_string = 0x08,
+    DW_FORM_strp = 0x0e, DW_FORM_udata = 0x0f, DW_FORM_line_strp = 0x1f,
+};
+
+}  // namespace
+
+// ============================================================================
+// Module (one loaded object and its address tables)
+// ============================================================================
+
+struct Symbolizer::Module {
+    struct Function {
+        uint64_t start;   // Link-time addresses (runtime minus bias)
+        uint64_t end;
+        uint32_t name;    // Offset into names
+    };
+    struct Row {
+        uint64_t addr;
+        uint32_t file;    // Index into files, or END_OF_SEQUENCE
+        uint32_t line;
+    };
+
+    std::string path;     // File to read
+    std::string name;     // Reported when there is no line information
+    uint64_t bias = 0;
+    std::vector<std::pair<uint64_t, uint64_t>> segments;  // Runtime PT_LOAD ranges
+    bool parsed = false;
+
+    std::vector<Function> functions;
+    std::string names;
+    std::vector<Row> rows;
+    std::vector<std::string> files;
+
+    bool contains(uint64_t ip) const {
+        for (const auto& seg : segments) {
+            if (ip >= seg.first && ip < seg.second) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void parse() {
+        parsed = true;
+        ElfImage image(path);
+        if (!image.valid()) {
+            return;
+        }
+        // Stripped objects may ship symbols and lines in a build-id debug file
+        std::unique_ptr<ElfImage> debug;
+        std::string debug_path = buildIdDebugPath(image);
+        if (!debug_path.empty()) {
+            debug.reset(new ElfImage(debug_path));
+        }
+        bool has_debug = debug && debug->valid();
+
+        bool symbols = has_debug && loadSymbols(*debug, ".symtab", ".strtab");
+        symbols = symbols || loadSymbols(image, ".symtab", ".strtab");
+        if (!symbols) {
+            loadSymbols(image, ".dynsym", ".dynstr");
+        }
+        if (!(has_debug && loadLines(*debug))) {
+            loadLines(image);
+        }
+    }
+
+    static std::string buildIdDebugPath(const ElfImage& image) {
+        const uint8_t* note;
+        size_t len;
+        if (!image.contents(".note.gnu.build-id", note, len) || len < sizeof(Elf64_Nhdr)) {
+            return "";
+        }
+        auto* nhdr = reinterpret_cast<const Elf64_Nhdr*>(note);
+        size_t desc_offset = sizeof(Elf64_Nhdr) + ((nhdr->n_namesz + 3) & ~size_t(3));
+        if (nhdr->n_type != NT_GNU_BUILD_ID || nhdr->n_descsz < 2 ||
+            desc_offset + nhdr->n_descsz > len) {
+            return "";
+        }
+        static const char hex[] = "0123456789abcdef";
+        const uint8_t* id = note + desc_offset;
+        std::string out = "/usr/lib/debug/.build-id/";
+        out += hex[id[0] >> 4];
+        out += hex[id[0] & 0xF];
+        out += '/';
+        for (size_t i = 1; i < nhdr->n_descsz; ++i) {
+            out += hex[id[i] >> 4];
+            out += hex[id[i] & 0xF];
+        }
+        out += ".debug";
+        return access(out.c_str(), R_OK) == 0 ? out : "";
+    }
+
+    bool loadSymbols(const ElfImage& image, const char* symtab_name, const char* strtab_name) {
+        const uint8_t* symtab;
+        const uint8_t* strtab;
+        size_t symtab_len, strtab_len;
+        if (!image.contents(symtab_name, symtab, symtab_len) ||
+            !image.contents(strtab_name, strtab, strtab_len)) {
+            return false;
+        }
+
+        struct Candidate {
+            uint64_t start;
+            uint64_t size;
+            const char* name;
+            bool global;
+        };
+        std::vector<Candidate> candidates;
+        size_t count = symtab_len / sizeof(Elf64_Sym);
+        auto* syms = reinterpret_cast<const Elf64_Sym*>(symtab);
+        for (size_t i = 0; i < count; ++i) {
+            const Elf64_Sym& sym = syms[i];
+            unsigned type = ELF64_ST_TYPE(sym.st_info);
+            if ((type != STT_FUNC && type != STT_GNU_IFUNC) || sym.st_shndx == SHN_UNDEF ||
+                sym.st_value == 0 || sym.st_name >= strtab_len) {
+                continue;
+            }
+            const char* name = reinterpret_cast<const char*>(strtab + sym.st_name);
+            if (!memchr(name, 0, strtab_len - sym.st_name) || !*name) {
+                continue;
+            }
+            candidates.push_back({sym.st_value, sym.st_size, name,
+                                  ELF64_ST_BIND(sym.st_info) == STB_GLOBAL});
+        }
+        if (candidates.empty()) {
+            return false;
+        }
+
+        // Aliases share a start: keep the sized, global one
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            if (a.start != b.start) return a.start < b.start;
+            if ((a.size != 0) != (b.size != 0)) return a.size != 0;
+            return a.global && !b.global;
+        });
+        functions.clear();
+        names.clear();
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (i > 0 && candidates[i].start == candidates[i - 1].start) {
+                continue;
+            }
+            uint64_t end = candidates[i].start + candidates[i].size;
+            if (candidates[i].size == 0) {
+                end = i + 1 < candidates.size() ? candidates[i + 1].start : candidates[i].start + 1;
+            }
+            functions.push_back({candidates[i].start, end, static_cast<uint32_t>(names.size())});
+            names += candidates[i].name;
+            names += '\0';
+        }
+        return true;
+    }
+
+    bool loadLines(const ElfImage& image) {
+        const uint8_t* data;
+        size_t len;
+        if (!image.contents(".debug_line", data, len)) {
+            return false;
+        }
+        StringSection line_str, str;
+        image.contents(".debug_line_str", line_str.data, line_str.size);
+        image.contents(".debug_str", str.data, str.size);
+
+        std::unordered_map<std::string, uint32_t> file_ids;
+        Cursor units{data, data + len};
+        while (units.ok && units.p < units.end) {
+            uint64_t unit_length = units.fixed<uint32_t>();
+            bool dwarf64 = unit_length == 0xFFFFFFFFu;
+            if (dwarf64) {
+                unit_length = units.fixed<uint64_t>();
+            }
+            if (!units.ok || unit_length > static_cast<uint64_t>(units.end - units.p)) {
+                break;
+            }
+            Cursor unit{units.p, units.p + unit_length};
+            units.p += unit_length;
+            parseUnit(unit, dwarf64, line_str, str, file_ids);
+        }
+
+        std::stable_sort(rows.begin(), rows.end(),
+                         [](const Row& a, const Row& b) { return a.addr < b.addr; });
+        return !rows.empty();
+    }
+
+    void parseUnit(Cursor& c, bool dwarf64, const StringSection& line_str, const StringSection& str,
+                   std::unordered_map<std::string, uint32_t>& file_ids) {
+        uint16_t version = c.fixed<uint16_t>();
+        if (version < 2 || version > 5) {
+            return;
+        }
+        if (version >= 5) {
+            c.fixed<uint8_t>();  // address_size
+            c.fixed<uint8_t>();  // segment_selector_size
+        }
+        uint64_t header_length = dwarf64 ? c.fixed<uint64_t>() : c.fixed<uint32_t>();
+        if (!c.ok || header_length > static_cast<uint64_t>(c.end - c.p)) {
+            return;
+        }
+        const uint8_t* program = c.p + header_length;
+        uint8_t min_inst = c.fixed<uint8_t>();
+        if (version >= 4) {
+            c.fixed<uint8_t>();  // maximum_operations_per_instruction (VLIW only)
+        }
+        c.fixed<uint8_t>();  // default_is_stmt
+        int8_t line_base = static_cast<int8_t>(c.fixed<uint8_t>());
+        uint8_t line_range = c.fixed<uint8_t>();
+        uint8_t opcode_base = c.fixed<uint8_t>();
+        if (!c.ok || line_range == 0 || opcode_base == 0) {
+            return;
+        }
+        std::vector<uint8_t> opcode_lengths(opcode_base, 0);
+        for (uint8_t i = 1; i < opcode_base; ++i) {
+            opcode_lengths[i] = c.fixed<uint8_t>();
+        }
+
+        // Unit file table, as indices into files
+        std::vector<std::string> dirs;
+        std::vector<uint32_t> unit_files;
+        auto add_file = [&](const char* name, uint64_t dir) {
+            std::string path = name;
+            if (!path.empty() && path[0] != '/' && dir < dirs.size() && !dirs[dir].empty()) {
+                path = dirs[dir] + "/" + path;
+            }
+            auto found = file_ids.emplace(path, static_cast<uint32_t>(files.size()));
+            if (found.second) {
+                files.push_back(path);
+            }
+            unit_files.push_back(found.first->second);
+        };
+
+        if (version >= 5) {
+            if (!readEntries(c, dwarf64, line_str, str, [&](const char* path, uint64_t) {
+                    dirs.push_back(path);
+                }) ||
+                !readEntries(c, dwarf64, line_str, str, add_file)) {
+                return;
+            }
+        } else {
+            dirs.push_back("");  // Index 0: the compilation directory (not recorded here)
+            for (const char* dir = c.cstr(); c.ok && *dir; dir = c.cstr()) {
+                dirs.push_back(dir);
+            }
+            unit_files.push_back(END_OF_SEQUENCE);  // File numbers start at 1
+            for (const char* name = c.cstr(); c.ok && *name; name = c.cstr()) {
+                uint64_t dir = c.uleb();
+                c.uleb();  // mtime
+                c.uleb();  // length
+                add_file(name, dir);
+            }
+        }
+        if (!c.ok) {
+            return;
+        }
+
+        // Line-number program
+        c.p = program;
+        uint64_t addr = 0;
+        uint64_t file = 1;
+        int64_t line = 1;
+        std::vector<Row> sequence;
+        auto emit = [&]() {
+            uint32_t id = file < unit_files.size() ? unit_files[file] : END_OF_SEQUENCE;
+            if (id != END_OF_SEQUENCE && line > 0) {
+                sequence.push_back({addr, id, static_cast<uint32_t>(line)});
+            }
+        };
+        while (c.ok && c.p < c.end) {
+            uint8_t op = c.fixed<uint8_t>();
+            if (op >= opcode_base) {
+                uint8_t adjusted = op - opcode_base;
+                addr += static_cast<uint64_t>(adjusted / line_range) * min_inst;
+                line += line_base + adjusted % line_range;
+                emit();
+                continue;
+            }
+            switch (op) {
+                case 0: {
+                    uint64_t len = c.uleb();
+                    if (len == 0 || !c.need(len)) {
+                        return;
+                    }
+                    const uint8_t* next = c.p + len;
+                    uint8_t sub = c.fixed<uint8_t>();
+                    if (sub == DW_LNE_end_sequence) {
+                        // Sequences at address 0 belong to discarded sections
+                        if (!sequence.empty() && sequence.front().addr != 0) {
+                            rows.insert(rows.end(), sequence.begin(), sequence.end());
+                            rows.push_back({addr, END_OF_SEQUENCE, 0});
+                        }
+                        sequence.clear();
+                        addr = 0;
+                        file = 1;
+                        line = 1;
+                    } else if (sub == DW_LNE_set_address) {
+                        if (len - 1 == 8) {
+                            addr = c.fixed<uint64_t>();
+                        } else if (len - 1 == 4) {
+                            addr = c.fixed<uint32_t>();
+                        }
+                    } else if (sub == DW_LNE_define_file) {
+                        const char* name = c.cstr();
+                        uint64_t dir = c.uleb();
+                        add_file(name, dir);
+                    }
+                    c.p = next;
+                    break;
+                }
+                case DW_LNS_copy:
+                    emit();
+                    break;
+                case DW_LNS_advance_pc:
+                    addr += c.uleb() * min_inst;
+                    break;
+                case DW_LNS_advance_line:
+                    line += c.sleb();
+                    break;
+                case DW_LNS_set_file:
+                    file = c.uleb();
+                    break;
+                case DW_LNS_const_add_pc:
+                    addr += static_cast<uint64_t>((255 - opcode_base) / line_range) * min_inst;
+                    break;
+                case DW_LNS_fixed_advance_pc:
+                    addr += c.fixed<uint16_t>();
+                    break;
+                default:
+                    for (uint8_t i = 0; i < opcode_lengths[op]; ++i) {
+                        c.uleb();
+                    }
+                    break;
+            }
+        }
+    }
+
+    /// DWARF 5 directory or file table: formats, then entries
+    template <typename Fn>
+    static bool readEntries(Cursor& c, bool dwarf64, const StringSection& line_str,
+                            const StringSection& str, Fn&& emit) {
+        uint8_t format_count = c.fixed<uint8_t>();
+        std::vector<std::pair<uint64_t, uint64_t>> formats;
+        for (uint8_t i = 0; i < format_count; ++i) {
+            uint64_t type = c.uleb();
+            formats.emplace_back(type, c.uleb());
+        }
+        uint64_t count = c.uleb();
+        for (uint64_t e = 0; c.ok && e < count; ++e) {
+            const char* path = "";
+            uint64_t dir = 0;
+            for (const auto& format : formats) {
+                uint64_t value = 0;
+                const char* text = nullptr;
+                switch (format.second) {
+                    case DW_FORM_string: text = c.cstr(); break;
+                    case DW_FORM_line_strp:
+                        text = line_str.at(dwarf64 ? c.fixed<uint64_t>() : c.fixed<uint32_t>());
+                        break;
+                    case DW_FORM_strp:
+                        text = str.at(dwarf64 ? c.fixed<uint64_t>() : c.fixed<uint32_t>());
+                        break;
+                    case DW_FORM_udata: value = c.uleb(); break;
+                    case DW_FORM_data1: value = c.fixed<uint8_t>(); break;
+                    case DW_FORM_data2: value = c.fixed<uint16_t>(); break;
+                    case DW_FORM_data4: value = c.fixed<uint32_t>(); break;
+                    case DW_FORM_data8: value = c.fixed<uint64_t>(); break;
+                    case DW_FORM_data16: c.skip(16); break;
+                    case DW_FORM_block: c.skip(c.uleb()); break;
+                    case DW_FORM_block1: c.skip(c.fixed<uint8_t>()); break;
+                    default: return false;  // Forms that need other sections (strx, ...)
+                }
+                if (format.first == DW_LNCT_path && text) {
+                    path = text;
+                } else if (format.first == DW_LNCT_directory_index) {
+                    dir = value;
+                }
+            }
+            emit(path, dir);
+        }
+        return c.ok;
+    }
+
+    const Function* function(uint64_t rel) const {
+        auto it = std::upper_bound(functions.begin(), functions.end(), rel,
+                                   [](uint64_t a, const Function& f) { return a < f.start; });
+        if (it == functions.begin()) {
+            return nullptr;
+        }
+        --it;
+        return rel < it->end ? &*it : nullptr;
+    }
+
+    const Row* row(uint64_t rel) const {
+        auto it = std::upper_bound(rows.begin(), rows.end(), rel,
+                                   [](uint64_t a, const Row& r) { return a < r.addr; });
+        if (it == rows.begin()) {
+            return nullptr;
+        }
+        --it;
+        return it->file == END_OF_SEQUENCE ? nullptr : &*it;
+    }
+};
+
+// ============================================================================
+// Symbolizer
+// ============================================================================
+
+Symbolizer::Symbolizer() : cache_(new std::atomic<const Result*>[SYMBOL_CACHE_SLOTS]) {
+    for (size_t i = 0; i < SYMBOL_CACHE_SLOTS; ++i) {
+        cache_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+Symbolizer::~Symbolizer() = default;
+
+const Symbolizer::Result* Symbolizer::resolve(uint64_t ip) {
+    const Result* hit = cache_[slotFor(ip)].load(std::memory_order_acquire);
+    if (hit && hit->ip == ip) {
+        return hit;
+    }
+    return resolveSlow(ip);
+}
+
+bool Symbolizer::resolve(uint64_t ip, std::string& symbol, std::string& file, int& line) {
+    const Result* result = resolve(ip);
+    symbol = result->symbol;
+    file = result->file;
+    line = result->line;
+    return result->known;
+}
+
+void Symbolizer::refresh() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refreshLocked();
+}
+
+size_t Symbolizer::moduleCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (modules_.empty()) {
+        refreshLocked();
+    }
+    return modules_.size();
+}
+
+const Symbolizer::Result* Symbolizer::resolveSlow(uint64_t ip) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::atomic<const Result*>& slot = cache_[slotFor(ip)];
+    const Result* hit = slot.load(std::memory_order_relaxed);
+    if (hit && hit->ip == ip) {
+        return hit;
+    }
+
+    Result result{ip, "??", "??", 0, false};
+    Module* module = findModule(ip);
+    if (!module) {
+        refreshLocked();  // Loaded since the last refresh (dlopen)?
+        module = findModule(ip);
+    }
+    if (module) {
+        if (!module->parsed) {
+            module->parse();
+        }
+        result.known = true;
+        result.file = module->name;
+        uint64_t rel = ip - module->bias;
+        if (const Module::Function* fn = module->function(rel)) {
+            const char* name = module->names.c_str() + fn->name;
+            int status = 0;
+            char* demangled = name[0] == '_' && name[1] == 'Z'
+                                  ? abi::__cxa_demangle(name, nullptr, nullptr, &status) : nullptr;
+            result.symbol = demangled && status == 0 ? demangled : name;
+            free(demangled);
+        } else {
+            // No symbol table (e.g. the vDSO): ask the dynamic linker
+            Dl_info info = {};
+            if (dladdr(reinterpret_cast<void*>(ip), &info) != 0 && info.dli_sname) {
+                result.symbol = info.dli_sname;
+            }
+        }
+        if (const Module::Row* row = module->row(rel)) {
+            result.file = module->files[row->file];
+            result.line = static_cast<int>(row->line);
+        }
+    }
+
+    if (results_.size() >= SYMBOL_CACHE_MAX_RESULTS) {
+        // Past the cap results are not kept; valid until this thread's next overflow
+        static thread_local Result overflow;
+        overflow = std::move(result);
+        return &overflow;
+    }
+    results_.push_back(std::move(result));
+    slot.store(&results_.back(), std::memory_order_release);
+    return &results_.back();
+}
+
+Symbolizer::Module* Symbolizer::findModule(uint64_t ip) {
+    for (auto& module : modules_) {
+        if (module->contains(ip)) {
+            return module.get();
+        }
+    }
+    return nullptr;
+}
+
+void Symbolizer::refreshLocked() {
+    std::vector<std::unique_ptr<Module>> found;
+    dl_iterate_phdr([](struct dl_phdr_info* info, size_t, void* data) {
+        auto& out = *static_cast<std::vector<std::unique_ptr<Module>>*>(data);
+        std::unique_ptr<Module> module(new Module());
+        module->bias = info->dlpi_addr;
+        if (info->dlpi_name && info->dlpi_name[0]) {
+            module->path = info->dlpi_name;
+            module->name = info->dlpi_name;
+        } else if (out.empty()) {
+            // The main program has no name in the link map
+            char exe[PATH_MAX];
+            ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+            module->path = "/proc/self/exe";
+            module->name = n > 0 ? std::string(exe, static_cast<size_t>(n)) : module->path;
+        }
+        for (int i = 0; i < info->dlpi_phnum; ++i) {
+            const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+            if (phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X)) {
+                uint64_t start = info->dlpi_addr + phdr.p_vaddr;
+                module->segments.emplace_back(start, start + phdr.p_memsz);
+            }
+        }
+        if (!module->segments.empty()) {
+            out.push_back(std::move(module));
+        }
+        return 0;
+    }, &found);
+
+    // Keep tables already parsed for objects that are still loaded
+    for (auto& module : found) {
+        for (auto& old : modules_) {
+            if (old && old->bias == module->bias && old->name == module->name) {
+                module = std::move(old);
+                break;
+            }
+        }
+    }
+    modules_ = std::move(found);
+}
+
+}  // namespace watcher
@@ -1,143 +1,432 @@
 #include "watcher_core.hpp"
+#include "event_clock.hpp"
+#include "event_recording.hpp"
+#include "event_ring.hpp"
+#include "latency_histogram.hpp"
+#include "page_index.hpp"
+#include "symbolizer.hpp"
 #include <sys/ioctl.h>
 #include <linux/userfaultfd.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <poll.h>
 #include <string.h>
-#include <fstream>
 #include <sstream>
 #include <thread>
 #include <mutex>
-#include <queue>
+#include <condition_variable>
 #include <unordered_map>
 #include <atomic>
 #include <cstring>
 #include <cstdio>
+#include <deque>
+#include <algorithm>
 #include <errno.h>
 #include <sys/syscall.h>
+#include <sys/stat.h>
 #include <linux/fs.h>
 
+// Async write-protect (Linux 6.7+); older uapi headers lack these
+#ifndef UFFD_FEATURE_WP_UNPOPULATED
+#define UFFD_FEATURE_WP_UNPOPULATED (1 << 13)
+#endif
+#ifndef UFFD_FEATURE_WP_ASYNC
+#define UFFD_FEATURE_WP_ASYNC (1 << 15)
+#endif
+#ifndef PAGEMAP_SCAN
+#define PAGE_IS_WRITTEN (1 << 1)
+#define PM_SCAN_WP_MATCHING (1 << 0)
+#define PM_SCAN_CHECK_WPASYNC (1 << 1)
+struct page_region {
+    __u64 start;
+    __u64 end;
+    __u64 categories;
+};
+struct pm_scan_arg {
+    __u64 size;
+    __u64 flags;
+    __u64 start;
+    __u64 end;
+    __u64 walk_end;
+    __u64 vec;
+    __u64 vec_len;
+    __u64 max_pages;
+    __u64 category_inverted;
+    __u64 category_mask;
+    __u64 category_anyof_mask;
+    __u64 return_mask;
+};
+#define PAGEMAP_SCAN _IOWR('f', 16, struct pm_scan_arg)
+#endif
+
 namespace watcher {
 
 // ============================================================================
-// Lock-Free Event Queue (SPSC - Single Producer, Single Consumer pattern)
+// Event Queue (preallocated ring; SPSC, or MPSC for multi-handler mode)
 // ============================================================================
 
 class EventQueue {
 private:
-    struct Node {
-        FastPathEvent event;
-        Node* next;
-    };
-    
-    std::atomic<Node*> head_;
-    std::atomic<Node*> tail_;
-    size_t capacity_;
-    std::atomic<size_t> size_;
+    std::unique_ptr<SpscRing<FastPathEvent>> spsc_;
+    std::unique_ptr<MpscRing<FastPathEvent>> mpsc_;
 
 public:
-    EventQueue(size_t capacity) : capacity_(capacity), size_(0) {
-        Node* sentinel = new Node();
-        head_.store(sentinel, std::memory_order_relaxed);
-        tail_.store(sentinel, std::memory_order_relaxed);
-    }
-    
-    ~EventQueue() {
-        Node* node = head_.load(std::memory_order_relaxed);
-        while (node) {
-            Node* next = node->next;
-            delete node;
-            node = next;
+    /// @param capacity Ring capacity (rounded up to a power of two)
+    /// @param producers Number of handler threads that enqueue concurrently
+    EventQueue(size_t capacity, size_t producers = 1) {
+        if (producers > 1) {
+            mpsc_ = std::make_unique<MpscRing<FastPathEvent>>(capacity);
+        } else {
+            spsc_ = std::make_unique<SpscRing<FastPathEvent>>(capacity);
         }
     }
     
     bool enqueue(const FastPathEvent& event) {
-        if (size_.load(std::memory_order_acquire) >= capacity_) {
-            return false;  // Queue full
-        }
-        
-        Node* new_node = new Node();
-        new_node->event = event;
-        new_node->next = nullptr;
-        
-        Node* old_tail = tail_.load(std::memory_order_relaxed);
-        tail_.store(new_node, std::memory_order_release);
-        old_tail->next = new_node;
-        
-        size_.fetch_add(1, std::memory_order_acq_rel);
-        return true;
+        return spsc_ ? spsc_->tryPush(event) : mpsc_->tryPush(event);
     }
     
     bool dequeue(FastPathEvent& event) {
-        Node* old_head = head_.load(std::memory_order_relaxed);
-        Node* next = old_head->next;
-        
-        if (!next) {
-            return false;  // Queue empty
-        }
-        
-        event = next->event;
-        head_.store(next, std::memory_order_release);
-        
-        delete old_head;
-        size_.fetch_sub(1, std::memory_order_acq_rel);
-        return true;
+        return spsc_ ? spsc_->tryPop(event) : mpsc_->tryPop(event);
+    }
+    
+    size_t dequeueBatch(FastPathEvent* out, size_t max_events) {
+        return spsc_ ? spsc_->popBatch(out, max_events) : mpsc_->popBatch(out, max_events);
     }
     
     size_t size() const {
-        return size_.load(std::memory_order_acquire);
+        return spsc_ ? spsc_->size() : mpsc_->size();
+    }
+    
+    size_t capacity() const {
+        return spsc_ ? spsc_->capacity() : mpsc_->capacity();
     }
 };
 
 // ============================================================================
-// Symbol Cache (LRU with TTL)
+// Instruction Pointer Reader (/proc/<tid>/syscall)
 // ============================================================================
 
-class SymbolCache {
+/// Reads the user-space PC of a thread from /proc/<tid>/syscall. The file is
+/// regenerated on every read, so fds stay open in a small direct-mapped table
+/// and each lookup costs one pread with no allocation. Not thread-safe; each
+/// thread that samples IPs owns its own reader.
+class InstructionPointerReader {
 private:
-    struct Entry {
-        std::string symbol;
-        std::string file;
-        int line;
-        std::chrono::system_clock::time_point timestamp;
+    struct Slot {
+        pid_t tid;
+        int fd;
     };
     
-    std::unordered_map<uint64_t, Entry> cache_;
-    std::mutex mutex_;
-    static constexpr int64_t TTL_SECONDS = 3600;
+    static constexpr size_t SLOTS = 64;
+    Slot slots_[SLOTS];
+    
+    static int openFor(pid_t tid) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/syscall", static_cast<int>(tid));
+        return open(path, O_RDONLY | O_CLOEXEC);
+    }
+    
+    /// Last whitespace-separated field, parsed as 0x-prefixed hex
+    static uint64_t parsePc(const char* buf, ssize_t len) {
+        while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == ' ')) {
+            --len;
+        }
+        ssize_t start = len;
+        while (start > 0 && buf[start - 1] != ' ') {
+            --start;
+        }
+        if (len - start < 3 || buf[start] != '0' || buf[start + 1] != 'x') {
+            return 0;  // "running", or no PC available
+        }
+        uint64_t value = 0;
+        for (ssize_t i = start + 2; i < len; ++i) {
+            char c = buf[i];
+            uint64_t digit;
+            if (c >= '0' && c <= '9') {
+                digit = c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                digit = c - 'a' + 10;
+            } else {
+                return 0;
+            }
+            value = (value << 4) | digit;
+        }
+        return value;
+    }
     
 public:
-    bool get(uint64_t ip, std::string& symbol, std::string& file, int& line) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        auto it = cache_.find(ip);
-        if (it == cache_.end()) {
-            return false;
+    InstructionPointerReader() {
+        for (auto& slot : slots_) {
+            slot = {0, -1};
         }
-        
-        // Check TTL
-        auto now = std::chrono::system_clock::now();
-        auto age = std::chrono::duration_cast<std::chrono::seconds>(now - it->second.timestamp).count();
-        if (age > TTL_SECONDS) {
-            cache_.erase(it);
-            return false;
+    }
+    
+    ~InstructionPointerReader() {
+        for (auto& slot : slots_) {
+            if (slot.fd >= 0) {
+                close(slot.fd);
+            }
         }
-        
-        symbol = it->second.symbol;
-        file = it->second.file;
-        line = it->second.line;
-        return true;
     }
     
-    void set(uint64_t ip, const std::string& symbol, const std::string& file, int line) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        cache_[ip] = {symbol, file, line, std::chrono::system_clock::now()};
+    InstructionPointerReader(const InstructionPointerReader&) = delete;
+    InstructionPointerReader& operator=(const InstructionPointerReader&) = delete;
+    
+    /// @return Instruction pointer, or 0 if unavailable
+    uint64_t read(pid_t tid) {
+        if (tid <= 0) {
+            return 0;
+        }
+        Slot& slot = slots_[static_cast<size_t>(tid) & (SLOTS - 1)];
+        char buf[256];
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            if (slot.tid != tid || slot.fd < 0) {
+                if (slot.fd >= 0) {
+                    close(slot.fd);
+                }
+                slot.tid = tid;
+                slot.fd = openFor(tid);
+                if (slot.fd < 0) {
+                    return 0;
+                }
+            }
+            ssize_t n = pread(slot.fd, buf, sizeof(buf) - 1, 0);
+            if (n > 0) {
+                return parsePc(buf, n);
+            }
+            // Thread exited (or tid reused): reopen once
+            close(slot.fd);
+            slot.fd = -1;
+        }
+        return 0;
+    }
+};
+
+// ============================================================================
+// Mapping Helpers
+// ============================================================================
+
+/// backingPageSize() for many addresses with one pass over smaps
+/// (reading smaps walks every VMA, so per-address reads add up quickly)
+static void backingPageSizes(const std::vector<uintptr_t>& addrs, std::vector<size_t>& sizes) {
+    sizes.assign(addrs.size(), PAGE_SIZE);
+    FILE* smaps = fopen("/proc/self/smaps", "re");
+    if (!smaps) {
+        return;
+    }
+    
+    // smaps lists VMAs in address order: walk the sorted targets alongside
+    std::vector<size_t> order(addrs.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return addrs[a] < addrs[b]; });
+    
+    size_t next = 0;   // First target not below the current VMA
+    size_t last = 0;   // One past the targets inside it
+    char line[512];
+    while (next < order.size() && fgets(line, sizeof(line), smaps)) {
+        unsigned long start, end;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            while (next < order.size() && addrs[order[next]] < start) {
+                ++next;
+            }
+            last = next;
+            while (last < order.size() && addrs[order[last]] < end) {
+                ++last;
+            }
+            continue;
+        }
+        unsigned long kb;
+        if (last > next && sscanf(line, "KernelPageSize: %lu kB", &kb) == 1) {
+            for (; next < last; ++next) {
+                sizes[order[next]] = kb * 1024;
+            }
+        }
+    }
+    fclose(smaps);
+}
+
+/// Kernel page size backing addr (hugetlb page size, else PAGE_SIZE)
+/// THP-backed ranges report 4 KiB: the kernel splits huge PMDs on write-protect
+static size_t backingPageSize(const void* addr) {
+    std::vector<size_t> sizes;
+    backingPageSizes({reinterpret_cast<uintptr_t>(addr)}, sizes);
+    return sizes[0];
+}
+
+// ============================================================================
+// JSONL Serialization
+// ============================================================================
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static void appendHex(std::string& out, uint64_t value) {
+    char buf[16];
+    int n = 0;
+    do {
+        buf[n++] = HEX_DIGITS[value & 0xF];
+        value >>= 4;
+    } while (value);
+    out += "0x";
+    while (n > 0) {
+        out += buf[--n];
+    }
+}
+
+static void appendHexBytes(std::string& out, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        out += HEX_DIGITS[data[i] >> 4];
+        out += HEX_DIGITS[data[i] & 0xF];
+    }
+}
+
+static void appendJsonString(std::string& out, const std::string& value) {
+    out += '"';
+    for (char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += "\\u00";
+                    out += HEX_DIGITS[(c >> 4) & 0xF];
+                    out += HEX_DIGITS[c & 0xF];
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+static void appendDecimal(std::string& out, uint64_t value) {
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n) {
+        out += digits[--n];
+    }
+}
+
+void appendEventId(std::string& out, uint64_t event_seq) {
+    uint64_t shard = event_seq >> EVENT_SEQ_SHARD_SHIFT;
+    out += "evt-";
+    if (shard) {
+        appendDecimal(out, shard);
+        out += '-';
+    }
+    appendDecimal(out, event_seq & ((uint64_t(1) << EVENT_SEQ_SHARD_SHIFT) - 1));
+}
+
+void appendEventJson(const EnrichedEvent& event, std::string& out) {
+    out += "{\"event_id\":\"";
+    appendEventId(out, event.event_seq);
+    out += '"';
+    out += ",\"timestamp_ns\":";
+    appendDecimal(out, event.ts_ns);
+    out += ",\"variable_id\":";
+    appendJsonString(out, event.variable_ids.empty() ? std::string() : event.variable_ids.front());
+    out += ",\"variable_ids\":[";
+    for (size_t i = 0; i < event.variable_ids.size(); ++i) {
+        if (i) out += ',';
+        appendJsonString(out, event.variable_ids[i]);
+    }
+    out += "],\"variable_name\":";
+    appendJsonString(out, event.variable_name);
+    out += ",\"function\":";
+    appendJsonString(out, event.symbol);
+    out += ",\"file\":";
+    appendJsonString(out, event.file);
+    out += ",\"line\":";
+    out += std::to_string(event.line);
+    out += ",\"ip\":";
+    out += std::to_string(event.ip);
+    out += ",\"tid\":";
+    out += std::to_string(event.tid);
+    out += ",\"page_base\":\"";
+    appendHex(out, reinterpret_cast<uintptr_t>(event.page_base));
+    out += "\",\"fault_addr\":\"";
+    appendHex(out, reinterpret_cast<uintptr_t>(event.fault_addr));
+    out += "\",\"deltas\":[";
+    for (size_t i = 0; i < event.deltas.runs.size(); ++i) {
+        const DeltaRun& run = event.deltas.runs[i];
+        if (i) out += ',';
+        out += "{\"offset\":";
+        out += std::to_string(run.offset);
+        out += ",\"len\":";
+        out += std::to_string(run.length);
+        out += ",\"before\":\"";
+        appendHexBytes(out, event.deltas.oldBytes(run), run.length);
+        out += "\",\"after\":\"";
+        appendHexBytes(out, event.deltas.newBytes(run), run.length);
+        out += "\"}";
+    }
+    out += "]";
+    if (!event.sql_context_id.empty()) {
+        out += ",\"sql_context_id\":";
+        appendJsonString(out, event.sql_context_id);
+    }
+    out += "}";
+}
+
+// ============================================================================
+// Event Writer (JSONL persistence, RecordingFormat::JSONL, slow-path only)
+// ============================================================================
+
+class EventWriter {
+private:
+    FILE* file_;
+    std::vector<char> io_buffer_;
+    std::string line_;
+    
+public:
+    explicit EventWriter(const std::string& output_dir) : file_(nullptr), io_buffer_(1 << 20) {
+        if (output_dir.empty()) {
+            return;
+        }
+        mkdir(output_dir.c_str(), 0755);  // EEXIST is fine
+        std::string path = output_dir + "/events.jsonl";
+        file_ = fopen(path.c_str(), "a");
+        if (file_) {
+            setvbuf(file_, io_buffer_.data(), _IOFBF, io_buffer_.size());
+        }
+    }
+    
+    ~EventWriter() {
+        if (file_) {
+            fclose(file_);
+        }
+    }
+    
+    bool isOpen() const {
+        return file_ != nullptr;
+    }
+    
+    bool write(const EnrichedEvent& event) {
+        if (!file_) {
+            return false;
+        }
+        line_.clear();
+        appendEventJson(event, line_);
+        line_ += '\n';
+        return fwrite(line_.data(), 1, line_.size(), file_) == line_.size();
     }
     
-    void clear() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        cache_.clear();
+    void flush() {
+        if (file_) {
+            fflush(file_);
+        }
     }
 };
 
@@ -154,19 +443,130 @@ private:
     
     std::unique_ptr<EventQueue> event_queue_;
     std::unordered_map<std::string, VariableMetadata> variables_;
+    std::unordered_map<uint32_t, VariableMetadata*> variables_by_index_;
+    uint32_t next_var_index_;
+    
+    // Address -> variable lookup for the fault path (no variables_mutex_)
+    PageIndex page_index_;
     std::mutex variables_mutex_;
     
-    SymbolCache symbol_cache_;
+    Symbolizer symbolizer_;
+    std::unique_ptr<EventWriter> writer_;          // RecordingFormat::JSONL
+    std::unique_ptr<RecordingWriter> recording_;   // RecordingFormat::BINARY
+    
+    // Slow-path processor hooks
+    EventProcessorFn processor_;
+    EventBatchProcessorFn batch_processor_;
+    std::mutex processor_mutex_;
+    std::vector<uint8_t> keep_;  // Slow-path thread only
+    
+    // Enriched events waiting to be handed out through dequeueEvent(s)
+    std::deque<EnrichedEvent> ready_events_;
+    EnrichedEvent current_event_;
+    size_t max_ready_events_;
+    std::mutex ready_mutex_;
+    
+    // Binary delivery; replaces ready_events_ once opened (guarded by ready_mutex_)
+    std::unique_ptr<EventChannel> channel_;
+    std::vector<BinaryEventRecord> channel_batch_;
+    
+    /// Page left writable by SamplingPolicy::COALESCE until deadline_ns,
+    /// then re-protected and reported as one event
+    struct CoalesceWindow {
+        uint64_t start;        // Released page [start, end)
+        uint64_t end;
+        uint64_t deadline_ns;
+        uint64_t page_base;    // First fault of the window
+        uint64_t fault_addr;
+        pid_t tid;
+        uint64_t ip;
+    };
+    
+    /// A released write the handler waits on before re-protecting its page:
+    /// the bytes at its exact fault address, which change once it lands
+    struct PendingWrite {
+        uint64_t start;      // Released page [start, end)
+        uint64_t end;
+        uint64_t addr;       // Exact fault address
+        uint32_t len;        // Bytes compared from addr
+        uint8_t bytes[16];   // Their contents at the fault
+        size_t held;         // Its event in HandlerShard::held, or SIZE_MAX (policy drop)
+        bool landed;
+    };
+    
+    /// Page whose released write had not landed after RELEASE_WAIT_NS: left
+    /// writable until deadline_ns, then re-protected and its event published
+    struct DeferredRelease {
+        uint64_t start;
+        uint64_t end;
+        uint64_t deadline_ns;
+        bool has_event;
+        FastPathEvent event;
+    };
+    
+    /// One userfaultfd and the reactor thread that drains it. Each watched
+    /// range is registered on exactly one shard.
+    struct HandlerShard {
+        int uffd = -1;
+        int epoll_fd = -1;  // uffd + wake_fd_
+        int cpu = -1;       // Pinned CPU, or -1
+        uint64_t id = 0;
+        uint64_t next_seq = 0;  // Written only by the shard's own thread
+        std::vector<CoalesceWindow> windows;  // Open windows (shard thread only)
+        std::vector<DeferredRelease> deferred;  // Pages left open for a late write (shard thread only)
+        std::vector<PendingWrite> awaiting;  // This batch's released writes (shard thread only)
+        std::vector<FastPathEvent> held;  // This batch's events, published once their writes land
+        std::thread thread;
+    };
     
-    int uffd_;
-    std::thread handler_thread_;
+    std::vector<HandlerShard> shards_;
+    int wake_fd_;  // eventfd, signalled once by stop() to wake every shard
+    int slow_wake_fd_;  // eventfd, wakes the slow path out of its idle poll
+    uint64_t uffd_features_;
+    FaultMode fault_mode_;
+    uint32_t scan_interval_us_;
+    int pagemap_fd_;  // /proc/self/pagemap, ASYNC_SCAN only
+    IpCapture ip_capture_;
     std::thread slow_path_thread_;
-    std::atomic<bool> running_;
+    std::atomic<bool> running_;            // Handler threads
+    std::atomic<bool> slow_path_running_;  // Cleared by stop() once the queue is drained
+    std::atomic<bool> slow_path_idle_;     // Slow path is (about to be) parked in poll()
+    std::atomic<bool> paused_;
+    std::atomic<int> active_threads_;
+    
+    // Drain handshake: pause() and stop() wait on lifecycle_cv_ until the
+    // slow path has retired every received event and synced the recording
+    std::atomic<uint64_t> events_retired_;   // Processed, or discarded at shutdown
+    std::atomic<uint64_t> events_held_;      // SYNC: on a shard until their writes land
+    std::atomic<uint64_t> flush_requested_;
+    std::atomic<uint64_t> flush_completed_;
+    std::atomic<int> lifecycle_waiters_;
+    std::mutex lifecycle_mutex_;
+    std::condition_variable lifecycle_cv_;
+    uint64_t next_session_seq_;  // First per-shard sequence of the next session
+    EventClock clock_;
     
     // Metrics
     std::atomic<uint64_t> events_received_;
     std::atomic<uint64_t> events_processed_;
     std::atomic<uint64_t> events_dropped_;
+    std::atomic<uint64_t> policy_drops_;
+    std::atomic<uint64_t> callbacks_failed_;
+    std::atomic<uint64_t> ioctls_;
+    std::atomic<uint64_t> unprotect_failures_;
+    std::atomic<uint64_t> reprotect_failures_;
+    std::atomic<uint64_t> wp_release_failures_;
+    std::atomic<uint64_t> queue_full_drops_;
+    std::atomic<uint64_t> coalesced_windows_;
+    std::atomic<uint64_t> deferred_reprotects_;
+    std::atomic<uint64_t> recording_failures_;
+    
+    // Stage latencies (per-thread histograms, merged in getPipelineMetrics)
+    LatencyRecorder fault_latency_;
+    LatencyRecorder queue_latency_;
+    LatencyRecorder enrich_latency_;
+    LatencyRecorder persist_latency_;
+    LatencyRecorder end_to_end_latency_;
     
     static WatcherCoreImpl& getInstanceImpl() {
         static WatcherCoreImpl instance;
@@ -177,103 +577,263 @@ private:
     
 public:
     WatcherCoreImpl() 
-        : state_(UNINITIALIZED), uffd_(-1), running_(false),
-          events_received_(0), events_processed_(0), events_dropped_(0) {}
+        : state_(UNINITIALIZED), next_var_index_(1), max_ready_events_(EVENT_QUEUE_CAPACITY),
+          wake_fd_(-1), slow_wake_fd_(-1), uffd_features_(0), fault_mode_(FaultMode::SYNC),
+          scan_interval_us_(ASYNC_SCAN_INTERVAL_US), pagemap_fd_(-1), ip_capture_(IpCapture::PROC_SYSCALL), running_(false),
+          slow_path_running_(false), slow_path_idle_(false), paused_(false), active_threads_(0),
+          events_retired_(0), events_held_(0), flush_requested_(0), flush_completed_(0), lifecycle_waiters_(0), next_session_seq_(0),
+          events_received_(0), events_processed_(0), events_dropped_(0), policy_drops_(0),
+          callbacks_failed_(0), ioctls_(0), unprotect_failures_(0), reprotect_failures_(0), wp_release_failures_(0),
+          queue_full_drops_(0), coalesced_windows_(0), deferred_reprotects_(0), recording_failures_(0) {}
     
     ~WatcherCoreImpl() {
         if (state_ != UNINITIALIZED && state_ != STOPPED && state_ != ERROR) {
             stop(1000);
         }
-        if (uffd_ >= 0) {
-            close(uffd_);
+        closeShards();
+        if (pagemap_fd_ >= 0) {
+            close(pagemap_fd_);
         }
     }
     
     bool initialize(const std::string& output_dir, size_t max_queue_size) override {
+        WatcherConfig config;
+        config.output_dir = output_dir;
+        config.max_queue_size = max_queue_size;
+        return initialize(config);
+    }
+    
+    bool initialize(const WatcherConfig& config) override {
         std::lock_guard<std::mutex> lock(state_mutex_);
+        const std::string& output_dir = config.output_dir;
+        size_t max_queue_size = config.max_queue_size;
         
-        if (state_ != UNINITIALIZED) {
+        // A stopped core may be re-initialized once its threads have exited
+        if (state_ == STOPPED && active_threads_.load() == 0) {
+            closeShards();
+            if (pagemap_fd_ >= 0) {
+                close(pagemap_fd_);
+                pagemap_fd_ = -1;
+            }
+        } else if (state_ != UNINITIALIZED) {
             error_message_ = "Core already initialized";
             return false;
         }
         
         output_dir_ = output_dir;
-        event_queue_ = std::make_unique<EventQueue>(max_queue_size);
+        bool binary = config.recording_format == RecordingFormat::BINARY;
+        writer_ = std::make_unique<EventWriter>(binary ? std::string() : output_dir);
+        recording_.reset();
+        if (binary && !output_dir.empty()) {
+            mkdir(output_dir.c_str(), 0755);  // EEXIST is fine
+            std::string path = output_dir + "/" + RECORDING_FILE_NAME;
+            recording_ = RecordingWriter::open(path);
+            if (!recording_) {
+                error_message_ = "Failed to open recording " + path;
+                return false;
+            }
+        }
+        max_ready_events_ = max_queue_size;
+        {
+            std::lock_guard<std::mutex> ready_lock(ready_mutex_);
+            ready_events_.clear();
+        }
         
-        // Initialize userfaultfd
-        uffd_ = syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK);
-        if (uffd_ < 0) {
-            error_message_ = std::string("Failed to create userfaultfd: ") + strerror(errno);
-            state_ = ERROR;
-            return false;
+        // Probe supported features on a throwaway fd (UFFDIO_API is one-shot)
+        uint64_t available = 0;
+        int probe = syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+        if (probe >= 0) {
+            struct uffdio_api probe_api = {};
+            probe_api.api = UFFD_API;
+            if (ioctl(probe, UFFDIO_API, &probe_api) == 0) {
+                available = probe_api.features;
+            }
+            close(probe);
         }
         
-        // Enable thread ID feature
-        struct uffdio_api api = {};
-        api.api = UFFD_API;
-        api.features = UFFD_FEATURE_THREAD_ID | UFFD_FEATURE_PAGEFAULT_FLAG_WP;
+        // Enable thread ID feature, plus WP on shmem (Python adapter pages are
+        // MAP_SHARED anonymous) and exact fault addresses when the kernel has them
+        uint64_t features = UFFD_FEATURE_THREAD_ID | UFFD_FEATURE_PAGEFAULT_FLAG_WP;
+        features |= available & (UFFD_FEATURE_WP_HUGETLBFS_SHMEM | UFFD_FEATURE_EXACT_ADDRESS);
         
-        if (ioctl(uffd_, UFFDIO_API, &api) < 0) {
-            error_message_ = std::string("Failed to configure userfaultfd: ") + strerror(errno);
+        // Async WP needs kernel support and PAGEMAP_SCAN on our own pagemap
+        fault_mode_ = FaultMode::SYNC;
+        ip_capture_ = config.ip_capture;
+        scan_interval_us_ = config.scan_interval_us ? config.scan_interval_us : ASYNC_SCAN_INTERVAL_US;
+        if (config.fault_mode == FaultMode::ASYNC_SCAN && (available & UFFD_FEATURE_WP_ASYNC)) {
+            pagemap_fd_ = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+            if (pagemap_fd_ >= 0) {
+                features |= UFFD_FEATURE_WP_ASYNC;
+                features |= available & UFFD_FEATURE_WP_UNPOPULATED;
+                fault_mode_ = FaultMode::ASYNC_SCAN;
+            }
+        }
+        
+        // PAGEMAP_SCAN covers the whole address space, so async mode runs a
+        // single scanner over a single userfaultfd
+        size_t shard_count = std::max<size_t>(1, std::min(config.handler_threads, MAX_CONCURRENT_WORKERS));
+        if (fault_mode_ == FaultMode::ASYNC_SCAN) {
+            shard_count = 1;
+        }
+        
+        wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        slow_wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (wake_fd_ < 0 || slow_wake_fd_ < 0) {
+            error_message_ = std::string("Failed to create wake eventfd: ") + strerror(errno);
+            closeShards();
             state_ = ERROR;
-            close(uffd_);
-            uffd_ = -1;
             return false;
         }
         
+        shards_.resize(shard_count);
+        for (size_t i = 0; i < shard_count; ++i) {
+            HandlerShard& shard = shards_[i];
+            shard.id = i;
+            shard.next_seq = next_session_seq_;
+            shard.cpu = config.handler_cpus.empty() ? -1 : config.handler_cpus[i % config.handler_cpus.size()];
+            if (!openShard(shard, features)) {
+                closeShards();
+                state_ = ERROR;
+                return false;
+            }
+        }
+        uffd_features_ = features;
+        clock_.calibrate();
+        event_queue_ = std::make_unique<EventQueue>(max_queue_size, shard_count);
+        
+        // Ranges kept from an earlier session move onto the new shard set;
+        // overlapping ranges shared a shard before and still do
+        {
+            std::lock_guard<std::mutex> vars_lock(variables_mutex_);
+            for (auto& entry : variables_) {
+                entry.second.shard %= shard_count;
+            }
+        }
+        
         state_ = INITIALIZED;
         return true;
     }
     
     std::string registerPage(void* page_base, size_t page_size, const std::string& name,
                             EventFlags flags, const MutationDepth& mutation_depth) override {
+        return registerRange(page_base, page_size, name, flags, mutation_depth);
+    }
+    
+    std::string registerRange(void* base, size_t len, const std::string& name,
+                              EventFlags flags, const MutationDepth& mutation_depth) override {
         std::lock_guard<std::mutex> lock(variables_mutex_);
+        std::string variable_id = registerRangeLocked(base, len, name, flags, mutation_depth,
+                                                      backingPageSize(base));
+        if (!variable_id.empty()) {
+            rebuildIndex();
+        }
+        return variable_id;
+    }
+    
+    size_t registerRanges(const RangeRegistration* ranges, size_t count,
+                          std::vector<std::string>& ids) override {
+        // One smaps pass for the whole batch
+        std::vector<uintptr_t> bases(count);
+        for (size_t i = 0; i < count; ++i) {
+            bases[i] = reinterpret_cast<uintptr_t>(ranges[i].base);
+        }
+        std::vector<size_t> granules;
+        backingPageSizes(bases, granules);
         
+        std::lock_guard<std::mutex> lock(variables_mutex_);
+        ids.clear();
+        ids.reserve(count);
+        size_t registered = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const RangeRegistration& range = ranges[i];
+            ids.push_back(registerRangeLocked(range.base, range.len, range.name ? range.name : "",
+                                              range.flags, range.mutation_depth, granules[i]));
+            registered += ids.back().empty() ? 0 : 1;
+        }
+        if (registered) {
+            rebuildIndex();
+        }
+        return registered;
+    }
+    
+    /// registerRange() body; caller holds variables_mutex_ and rebuilds the index
+    /// @param granule backingPageSize(base)
+    std::string registerRangeLocked(void* base, size_t len, const std::string& name,
+                                    EventFlags flags, const MutationDepth& mutation_depth,
+                                    size_t granule) {
         if (state_ == STOPPED || state_ == ERROR) {
             return "";
         }
         
         // Generate UUID (simplified - using timestamp + counter in production use uuid lib)
         static std::atomic<uint64_t> counter(0);
-        std::stringstream ss;
-        ss << "var-" << std::chrono::system_clock::now().time_since_epoch().count() 
-           << "-" << counter.fetch_add(1);
-        std::string variable_id = ss.str();
+        std::string variable_id = "var-";
+        appendDecimal(variable_id, static_cast<uint64_t>(
+            std::chrono::system_clock::now().time_since_epoch().count()));
+        variable_id += '-';
+        appendDecimal(variable_id, counter.fetch_add(1));
+        
+        if (!base) {
+            error_message_ = "Cannot snapshot null page_base address";
+            return "";
+        }
+        
+        // hugetlb ranges can only be write-protected in whole huge pages
+        if (granule > PAGE_SIZE && reinterpret_cast<uintptr_t>(base) % granule != 0) {
+            error_message_ = "Range base is not aligned to its backing page size";
+            return "";
+        }
+        
+        // A byte range narrows the variable to its first bytes: only the
+        // granules covering them are armed, and only they are copied
+        size_t tracked = len;
+        if (!mutation_depth.full_page && mutation_depth.byte_range > 0 && mutation_depth.byte_range < len) {
+            tracked = mutation_depth.byte_range;
+        }
+        len = (tracked + granule - 1) / granule * granule;
         
-        // Register with userfaultfd if running
+        auto shadow = std::make_shared<PageShadow>(tracked);
+        if (!shadow->valid()) {
+            error_message_ = "Failed to reserve shadow memory";
+            return "";
+        }
+        
+        // Register with userfaultfd if running. A SYNC pause has lifted
+        // protection everywhere, so the range is armed by resume() instead.
+        uint32_t shard = pickShard(reinterpret_cast<uint64_t>(base), len);
+        bool deferred = state_ == PAUSED && fault_mode_ == FaultMode::SYNC;
         if (state_ == RUNNING || state_ == PAUSED) {
-            struct uffdio_register reg = {};
-            reg.range.start = reinterpret_cast<uint64_t>(page_base);
-            reg.range.len = page_size;
-            reg.mode = UFFDIO_REGISTER_MODE_WP;
-            
-            if (ioctl(uffd_, UFFDIO_REGISTER, &reg) < 0) {
+            if (!protectRange(shards_[shard].uffd, base, len, !deferred)) {
                 return "";  // Registration failed
             }
         }
         
-        // Read initial snapshot
-        std::vector<uint8_t> snapshot(page_size);
-        if (!page_base) {
-            error_message_ = "Cannot snapshot null page_base address";
-            return "";
+        // SYNC mode captures each sub-page's pre-state at its first fault.
+        // Async faults are resolved before we see them, and writes to a
+        // deferred range do not fault at all, so copy those up front.
+        // Caller guarantees the range is touched and valid.
+        if (fault_mode_ == FaultMode::ASYNC_SCAN || deferred) {
+            shadow->captureAll(static_cast<uint8_t*>(base));
         }
-        // Note: memcpy will fail at runtime if page_base is invalid
-        // Caller guarantees page is touched and valid
-        memcpy(snapshot.data(), page_base, page_size);
         
         // Store metadata
         VariableMetadata meta;
         meta.variable_id = variable_id;
-        meta.page_base = page_base;
-        meta.page_size = page_size;
+        meta.index = next_var_index_++;
+        meta.page_base = base;
+        meta.page_size = len;
+        meta.tracked_len = tracked;
+        meta.granule = granule;
+        meta.shard = shard;
         meta.name = name;
         meta.flags = flags;
         meta.mutation_depth = mutation_depth;
-        meta.initial_snapshot = snapshot;
+        meta.shadow = std::move(shadow);
         meta.registered_at = std::chrono::system_clock::now();
         
-        variables_[variable_id] = meta;
+        VariableMetadata& stored = variables_[variable_id];
+        stored = std::move(meta);
+        variables_by_index_[stored.index] = &stored;
         return variable_id;
     }
     
@@ -286,12 +846,17 @@ public:
         }
         
         if (state_ == RUNNING || state_ == PAUSED) {
-            // Note: uffdio_unregister is not always available in all Linux versions
-            // For now, we just track the variable removal in our registry
-            // Kernel will clean up on close(uffd)
+            // Best effort: the kernel also drops registrations on close(uffd)
+            struct uffdio_range range = {};
+            range.start = reinterpret_cast<uint64_t>(it->second.page_base);
+            range.len = it->second.page_size;
+            ioctl(shards_[it->second.shard].uffd, UFFDIO_UNREGISTER, &range);
+            ioctls_.fetch_add(1, std::memory_order_relaxed);
         }
         
+        variables_by_index_.erase(it->second.index);
         variables_.erase(it);
+        rebuildIndex();
         return true;
     }
     
@@ -303,10 +868,42 @@ public:
             return {};
         }
         
-        return it->second.initial_snapshot;
+        const VariableMetadata& meta = it->second;
+        std::vector<uint8_t> snapshot(meta.tracked_len);
+        meta.shadow->materialize(static_cast<uint8_t*>(meta.page_base), snapshot.data());
+        return snapshot;
+    }
+    
+    size_t readSnapshotInto(const std::string& variable_id, void* out, size_t capacity) override {
+        std::lock_guard<std::mutex> lock(variables_mutex_);
+        
+        auto it = variables_.find(variable_id);
+        if (it == variables_.end()) {
+            return 0;
+        }
+        
+        const VariableMetadata& meta = it->second;
+        if (capacity >= meta.tracked_len) {
+            meta.shadow->materialize(static_cast<uint8_t*>(meta.page_base), static_cast<uint8_t*>(out));
+        }
+        return meta.tracked_len;
+    }
+    
+    SnapshotView snapshotView(const std::string& variable_id) override {
+        std::lock_guard<std::mutex> lock(variables_mutex_);
+        
+        auto it = variables_.find(variable_id);
+        if (it == variables_.end()) {
+            return nullptr;
+        }
+        return it->second.shadow->view(static_cast<uint8_t*>(it->second.page_base));
     }
     
     bool writeSnapshot(const std::string& variable_id, const std::vector<uint8_t>& snapshot) override {
+        return writeSnapshotFrom(variable_id, snapshot.data(), snapshot.size());
+    }
+    
+    bool writeSnapshotFrom(const std::string& variable_id, const void* data, size_t len) override {
         std::lock_guard<std::mutex> lock(variables_mutex_);
         
         auto it = variables_.find(variable_id);
@@ -314,7 +911,9 @@ public:
             return false;
         }
         
-        it->second.initial_snapshot = snapshot;
+        // Becomes the pre-state of the next delta on every sub-page
+        VariableMetadata& meta = it->second;
+        meta.shadow->assign(static_cast<const uint8_t*>(data), len, static_cast<uint8_t*>(meta.page_base));
         return true;
     }
     
@@ -326,7 +925,41 @@ public:
             return false;
         }
         
-        variables_[variable_id] = metadata;
+        // The armed range and its shadow cannot be moved through metadata;
+        // new flags reach the fault path with the next index
+        VariableMetadata updated = metadata;
+        updated.index = it->second.index;
+        updated.page_base = it->second.page_base;
+        updated.page_size = it->second.page_size;
+        updated.tracked_len = it->second.tracked_len;
+        updated.mutation_depth = it->second.mutation_depth;
+        updated.granule = it->second.granule;
+        updated.shard = it->second.shard;
+        updated.shadow = it->second.shadow;
+        updated.sampling = it->second.sampling;
+        updated.sampling_gate = it->second.sampling_gate;
+        it->second = std::move(updated);
+        rebuildIndex();
+        return true;
+    }
+    
+    bool setSamplingPolicy(const std::string& variable_id, const SamplingPolicy& policy) override {
+        if (!policy.valid()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(variables_mutex_);
+        
+        auto it = variables_.find(variable_id);
+        if (it == variables_.end()) {
+            return false;
+        }
+        
+        // A fresh gate: the fault path may still be admitting through the
+        // old one until it moves to the new index
+        VariableMetadata& meta = it->second;
+        meta.sampling = policy;
+        meta.sampling_gate = policy.mode == SamplingPolicy::ALL ? nullptr : std::make_shared<SamplingGate>(policy);
+        rebuildIndex();
         return true;
     }
     
@@ -338,16 +971,34 @@ public:
             return false;
         }
         
+        // Arm pages that were registered before start()
+        {
+            std::lock_guard<std::mutex> vars_lock(variables_mutex_);
+            for (auto& entry : variables_) {
+                const VariableMetadata& meta = entry.second;
+                if (!protectRange(shards_[meta.shard].uffd, meta.page_base, meta.page_size)) {
+                    error_message_ = "Failed to arm page for " + entry.first + ": " + strerror(errno);
+                }
+            }
+        }
+        
         running_ = true;
+        slow_path_running_ = true;
+        paused_ = false;
         state_ = RUNNING;
         
-        handler_thread_ = std::thread(&WatcherCoreImpl::handlerLoop, this);
+        active_threads_.fetch_add(static_cast<int>(shards_.size()) + 1);
+        for (HandlerShard& shard : shards_) {
+            shard.thread = fault_mode_ == FaultMode::ASYNC_SCAN
+                ? std::thread(&WatcherCoreImpl::asyncScanLoop, this, &shard)
+                : std::thread(&WatcherCoreImpl::handlerLoop, this, &shard);
+        }
         slow_path_thread_ = std::thread(&WatcherCoreImpl::slowPathLoop, this);
         
         return true;
     }
     
-    bool pause() override {
+    bool pause(int timeout_ms) override {
         std::lock_guard<std::mutex> lock(state_mutex_);
         
         if (state_ != RUNNING) {
@@ -355,7 +1006,27 @@ public:
             return false;
         }
         
+        // Pin every clean sub-page's baseline while writes still fault, so
+        // writes made while paused land in the next event's delta
+        if (fault_mode_ == FaultMode::SYNC) {
+            std::lock_guard<std::mutex> vars_lock(variables_mutex_);
+            for (auto& entry : variables_) {
+                const VariableMetadata& meta = entry.second;
+                meta.shadow->captureAll(static_cast<uint8_t*>(meta.page_base));
+            }
+        }
+        
+        // Faults that race the unprotect are let through without an event
+        paused_ = true;
+        if (fault_mode_ == FaultMode::SYNC) {
+            writeProtectAll(false);
+        }
         state_ = PAUSED;
+        
+        if (!drainPipeline(deadlineAfter(timeout_ms))) {
+            error_message_ = "Timed out draining events before pause";
+            return false;
+        }
         return true;
     }
     
@@ -367,10 +1038,18 @@ public:
             return false;
         }
         
+        paused_ = false;
+        if (fault_mode_ == FaultMode::SYNC) {
+            writeProtectAll(true);
+        }
         state_ = RUNNING;
         return true;
     }
     
+    /// Stop the handlers, let the slow path persist what they queued, then
+    /// stop it. Returns as soon as the pipeline is empty; threads still
+    /// running at the deadline are detached and keep the core from being
+    /// re-initialized until they exit.
     bool stop(int timeout_ms) override {
         std::lock_guard<std::mutex> lock(state_mutex_);
         
@@ -378,24 +1057,40 @@ public:
             return state_ != ERROR;
         }
         
+        auto deadline = deadlineAfter(timeout_ms);
+        bool started = state_ != INITIALIZED;
         running_ = false;
         state_ = STOPPED;
-        
-        // Wait for threads with timeout
-        auto start = std::chrono::system_clock::now();
-        while (handler_thread_.joinable() && 
-               std::chrono::duration_cast<std::chrono::milliseconds>(
-                   std::chrono::system_clock::now() - start).count() < timeout_ms) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (!started) {
+            return true;
         }
         
-        if (handler_thread_.joinable()) {
-            handler_thread_.detach();
+        // Wake every shard's reactor; the counter is never reset, so each
+        // epoll_wait sees it as readable. Handlers close their coalesce
+        // windows on the way out, so their last events are queued by now.
+        uint64_t one = 1;
+        ssize_t woken = write(wake_fd_, &one, sizeof(one));
+        (void)woken;
+        bool handlers_exited = waitLifecycle([&] { return active_threads_.load() <= 1; }, deadline);
+        bool drained = handlers_exited && drainPipeline(deadline);
+        
+        slow_path_running_ = false;
+        wakeSlowPath(true);
+        bool all_exited = waitLifecycle([&] { return active_threads_.load() == 0; }, deadline);
+        
+        for (HandlerShard& shard : shards_) {
+            if (shard.thread.joinable()) {
+                handlers_exited ? shard.thread.join() : shard.thread.detach();
+            }
         }
         if (slow_path_thread_.joinable()) {
-            slow_path_thread_.detach();
+            all_exited ? slow_path_thread_.join() : slow_path_thread_.detach();
         }
         
+        if (!drained) {
+            error_message_ = "Timed out draining events; the rest were dropped";
+            return false;
+        }
         return true;
     }
     
@@ -409,9 +1104,59 @@ public:
         return error_message_;
     }
     
+    FaultMode getFaultMode() const override {
+        return fault_mode_;
+    }
+    
     EnrichedEvent* dequeueEvent() override {
-        // Not implemented in this phase - placeholder
-        return nullptr;
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        if (ready_events_.empty()) {
+            return nullptr;
+        }
+        current_event_ = std::move(ready_events_.front());
+        ready_events_.pop_front();
+        return &current_event_;
+    }
+    
+    size_t dequeueEvents(std::vector<EnrichedEvent>& out, size_t max_events) override {
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        size_t n = std::min(max_events, ready_events_.size());
+        for (size_t i = 0; i < n; ++i) {
+            out.push_back(std::move(ready_events_.front()));
+            ready_events_.pop_front();
+        }
+        return n;
+    }
+    
+    EventChannel* openEventChannel(size_t capacity) override {
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        if (!channel_) {
+            channel_ = EventChannel::create(capacity);
+            if (channel_) {
+                ready_events_.clear();
+            }
+        }
+        return channel_.get();
+    }
+    
+    uint32_t variableIndex(const std::string& variable_id) const override {
+        std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(variables_mutex_));
+        auto it = variables_.find(variable_id);
+        return it == variables_.end() ? 0 : it->second.index;
+    }
+    
+    bool resolveSymbol(uint64_t ip, std::string& symbol, std::string& file, int& line) override {
+        return symbolizer_.resolve(ip, symbol, file, line);
+    }
+    
+    void setEventProcessor(EventProcessorFn processor) override {
+        std::lock_guard<std::mutex> lock(processor_mutex_);
+        processor_ = std::move(processor);
+    }
+    
+    void setBatchProcessor(EventBatchProcessorFn processor) override {
+        std::lock_guard<std::mutex> lock(processor_mutex_);
+        batch_processor_ = std::move(processor);
     }
     
     Metrics getMetrics() const override {
@@ -419,119 +1164,1022 @@ public:
             events_received_.load(),
             events_processed_.load(),
             events_dropped_.load(),
-            0,  // callbacks_failed
-            0.0,  // mean_latency_ms
+            policy_drops_.load(),
+            callbacks_failed_.load(),
+            end_to_end_latency_.snapshot().mean() / 1e6,
             static_cast<uint32_t>(event_queue_ ? event_queue_->size() : 0)
         };
     }
+    
+    PipelineMetrics getPipelineMetrics() const override {
+        PipelineMetrics metrics;
+        metrics.fault_to_unprotect = toStats(fault_latency_.snapshot());
+        metrics.queue_residency = toStats(queue_latency_.snapshot());
+        metrics.enrich = toStats(enrich_latency_.snapshot());
+        metrics.persist = toStats(persist_latency_.snapshot());
+        metrics.end_to_end = toStats(end_to_end_latency_.snapshot());
+        metrics.ioctls = ioctls_.load();
+        metrics.unprotect_failures = unprotect_failures_.load();
+        metrics.reprotect_failures = reprotect_failures_.load();
+        metrics.wp_release_failures = wp_release_failures_.load();
+        metrics.queue_full_drops = queue_full_drops_.load();
+        metrics.coalesced_windows = coalesced_windows_.load();
+        metrics.deferred_reprotects = deferred_reprotects_.load();
+        metrics.recording_failures = recording_failures_.load();
+        return metrics;
+    }
 
 private:
-    void handlerLoop() {
-        struct pollfd pfd = {};
-        pfd.fd = uffd_;
-        pfd.events = POLLIN;
-        
-        std::vector<struct uffd_msg> msgs(16);
-        
-        while (running_) {
-            int poll_ret = poll(&pfd, 1, 100);  // 100ms timeout
+    static LatencyStats toStats(const LatencySnapshot& snap) {
+        return LatencyStats{snap.total, snap.min, snap.max, snap.mean(),
+                            snap.percentile(0.50), snap.percentile(0.90),
+                            snap.percentile(0.99), snap.percentile(0.999)};
+    }
+    
+    static std::chrono::steady_clock::time_point deadlineAfter(int timeout_ms) {
+        return std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeout_ms, 0));
+    }
+    
+    /// Block until pred() holds or the deadline passes. Threads that change
+    /// what pred() reads call notifyLifecycle() afterwards.
+    /// @return pred() at return
+    template <typename Pred>
+    bool waitLifecycle(Pred pred, std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(lifecycle_mutex_);
+        lifecycle_waiters_.fetch_add(1);
+        bool ok = lifecycle_cv_.wait_until(lock, deadline, pred);
+        lifecycle_waiters_.fetch_sub(1);
+        return ok;
+    }
+    
+    void notifyLifecycle() {
+        if (lifecycle_waiters_.load() > 0) {
+            std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+            lifecycle_cv_.notify_all();
+        }
+    }
+    
+    /// A handler or slow-path thread is about to return
+    void threadExited() {
+        active_threads_.fetch_sub(1);
+        notifyLifecycle();
+    }
+    
+    /// Wait until the slow path has retired every event received so far and
+    /// written out the open recording segment
+    bool drainPipeline(std::chrono::steady_clock::time_point deadline) {
+        uint64_t request = flush_requested_.fetch_add(1) + 1;
+        wakeSlowPath(true);
+        return waitLifecycle([&] {
+            return flush_completed_.load() >= request && events_retired_.load() >= events_received_.load();
+        }, deadline);
+    }
+    
+    /// Kick the slow path out of its idle poll. Producers call this with
+    /// force=false once per batch, after enqueueing, and only pay for the
+    /// write when it is actually parked.
+    void wakeSlowPath(bool force) {
+        if (!force) {
+            // Pairs with the idle store in idleSlowPath(): either we see it
+            // parked, or it sees our event in the queue before parking
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!slow_path_idle_.load(std::memory_order_relaxed) || !slow_path_idle_.exchange(false)) {
+                return;
+            }
+        }
+        uint64_t one = 1;
+        ssize_t woken = write(slow_wake_fd_, &one, sizeof(one));
+        (void)woken;
+    }
+    
+    /// Write-protect (or release) every registered range, SYNC mode only
+    void writeProtectAll(bool protect) {
+        std::lock_guard<std::mutex> lock(variables_mutex_);
+        for (const auto& entry : variables_) {
+            const VariableMetadata& meta = entry.second;
+            struct uffdio_writeprotect wp = {};
+            wp.range.start = reinterpret_cast<uint64_t>(meta.page_base);
+            wp.range.len = meta.page_size;
+            wp.mode = protect ? UFFDIO_WRITEPROTECT_MODE_WP : 0;
+            ioctls_.fetch_add(1, std::memory_order_relaxed);
+            if (ioctl(shards_[meta.shard].uffd, UFFDIO_WRITEPROTECT, &wp) < 0) {
+                (protect ? reprotect_failures_ : unprotect_failures_).fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    
+    /// Publish a fresh page index from variables_
+    /// Caller holds variables_mutex_ (serializes writers); waits out readers
+    /// of the previous table, which never take variables_mutex_
+    void rebuildIndex() {
+        std::vector<IndexedRange> ranges;
+        ranges.reserve(variables_.size());
+        for (const auto& entry : variables_) {
+            const VariableMetadata& meta = entry.second;
+            uint64_t start = reinterpret_cast<uint64_t>(meta.page_base);
+            ranges.push_back({start, start + meta.page_size, meta.granule, meta.index, meta.shadow,
+                              meta.flags, meta.sampling_gate});
+        }
+        page_index_.publish(std::move(ranges));
+    }
+    
+    /// Create a shard's userfaultfd and its epoll set
+    /// @param features Features to negotiate (UFFDIO_API is per-fd)
+    bool openShard(HandlerShard& shard, uint64_t features) {
+        shard.uffd = syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+        if (shard.uffd < 0) {
+            error_message_ = std::string("Failed to create userfaultfd: ") + strerror(errno);
+            return false;
+        }
+        
+        struct uffdio_api api = {};
+        api.api = UFFD_API;
+        api.features = features;
+        if (ioctl(shard.uffd, UFFDIO_API, &api) < 0) {
+            error_message_ = std::string("Failed to configure userfaultfd: ") + strerror(errno);
+            return false;
+        }
+        
+        shard.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (shard.epoll_fd < 0) {
+            error_message_ = std::string("Failed to create epoll instance: ") + strerror(errno);
+            return false;
+        }
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = shard.uffd;
+        if (epoll_ctl(shard.epoll_fd, EPOLL_CTL_ADD, shard.uffd, &ev) < 0) {
+            error_message_ = std::string("Failed to watch userfaultfd: ") + strerror(errno);
+            return false;
+        }
+        ev.data.fd = wake_fd_;
+        if (epoll_ctl(shard.epoll_fd, EPOLL_CTL_ADD, wake_fd_, &ev) < 0) {
+            error_message_ = std::string("Failed to watch wake eventfd: ") + strerror(errno);
+            return false;
+        }
+        return true;
+    }
+    
+    /// Close every shard's descriptors (threads must have exited)
+    void closeShards() {
+        for (HandlerShard& shard : shards_) {
+            // Keep event IDs unique across sessions on this core
+            next_session_seq_ = std::max(next_session_seq_, shard.next_seq);
+            if (shard.epoll_fd >= 0) {
+                close(shard.epoll_fd);
+            }
+            if (shard.uffd >= 0) {
+                close(shard.uffd);
+            }
+            if (shard.thread.joinable()) {
+                shard.thread.detach();
+            }
+        }
+        shards_.clear();
+        if (wake_fd_ >= 0) {
+            close(wake_fd_);
+            wake_fd_ = -1;
+        }
+        if (slow_wake_fd_ >= 0) {
+            close(slow_wake_fd_);
+            slow_wake_fd_ = -1;
+        }
+    }
+    
+    /// Choose the shard for a new range. A VMA can belong to only one
+    /// userfaultfd, so a range overlapping an existing one joins its shard;
+    /// otherwise ranges are spread round-robin.
+    /// Caller holds variables_mutex_
+    uint32_t pickShard(uint64_t start, size_t len) {
+        uint64_t end = start + len;
+        for (const auto& entry : variables_) {
+            uint64_t other = reinterpret_cast<uint64_t>(entry.second.page_base);
+            if (start < other + entry.second.page_size && other < end) {
+                return entry.second.shard;
+            }
+        }
+        return shards_.empty() ? 0 : static_cast<uint32_t>(next_var_index_ % shards_.size());
+    }
+    
+    /// Register a range with userfaultfd and write-protect it
+    /// Caller holds variables_mutex_
+    /// @param arm false to register only (writeProtectAll() arms it later)
+    bool protectRange(int uffd, void* base, size_t len, bool arm = true) {
+        struct uffdio_register reg = {};
+        reg.range.start = reinterpret_cast<uint64_t>(base);
+        reg.range.len = len;
+        reg.mode = UFFDIO_REGISTER_MODE_WP;
+        ioctls_.fetch_add(arm ? 2 : 1, std::memory_order_relaxed);
+        if (ioctl(uffd, UFFDIO_REGISTER, &reg) < 0) {
+            return false;
+        }
+        if (!arm) {
+            return true;
+        }
+        
+        struct uffdio_writeprotect wp = {};
+        wp.range.start = reg.range.start;
+        wp.range.len = len;
+        wp.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+        if (ioctl(uffd, UFFDIO_WRITEPROTECT, &wp) < 0) {
+            struct uffdio_range range = reg.range;
+            ioctl(uffd, UFFDIO_UNREGISTER, &range);
+            return false;
+        }
+        return true;
+    }
+    
+    /// SYNC mode reactor for one shard: read faults in batches, then release
+    /// every faulting page with one unprotect/re-protect pair per contiguous
+    /// page range. Blocks in epoll_wait until a fault arrives, a coalesce
+    /// window is due, or stop() fires the wake eventfd.
+    void handlerLoop(HandlerShard* shard) {
+        if (shard->cpu >= 0) {
+            // Best effort: an offline or disallowed CPU leaves the thread unpinned
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(shard->cpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+        
+        std::vector<struct uffd_msg> msgs(FAULT_BATCH_SIZE);
+        InstructionPointerReader ip_reader;
+        std::vector<std::pair<uint64_t, uint64_t>> pages;  // [start, end) to release
+        std::vector<std::pair<uint64_t, uint64_t>> opened;  // Released without re-protecting
+        std::vector<size_t> faults;  // Per merged range of pages
+        std::vector<uint64_t> late;  // Pages of writes that have not landed, left open
+        pages.reserve(FAULT_BATCH_SIZE);
+        faults.reserve(FAULT_BATCH_SIZE);
+        late.reserve(FAULT_BATCH_SIZE);
+        shard->awaiting.reserve(FAULT_BATCH_SIZE);
+        shard->held.reserve(FAULT_BATCH_SIZE);
+        struct epoll_event ready[2];
+        
+        while (running_) {
+            int n = epoll_wait(shard->epoll_fd, ready, 2, windowTimeoutMs(*shard));
+            if (!shard->windows.empty() || !shard->deferred.empty()) {
+                closeWindows(*shard, false);
+                wakeSlowPath(false);
+            }
+            if (n <= 0) {
+                continue;  // EINTR
+            }
             
-            if (poll_ret <= 0) {
-                continue;
+            bool fault_ready = false;
+            for (int e = 0; e < n; ++e) {
+                fault_ready |= ready[e].data.fd == shard->uffd;
+            }
+            if (!fault_ready) {
+                continue;  // Wakeup only; running_ is rechecked
             }
             
-            ssize_t nread = read(uffd_, msgs.data(), msgs.size() * sizeof(struct uffd_msg));
+            ssize_t nread = read(shard->uffd, msgs.data(), msgs.size() * sizeof(struct uffd_msg));
             if (nread <= 0) {
                 continue;
             }
             
+            uint64_t read_ns = EventClock::now();
+            pages.clear();
+            opened.clear();
+            shard->awaiting.clear();
+            shard->held.clear();
             size_t num_msgs = nread / sizeof(struct uffd_msg);
-            for (size_t i = 0; i < num_msgs; ++i) {
-                if (msgs[i].event & UFFD_EVENT_PAGEFAULT) {
-                    handlePageFault(msgs[i]);
+            {
+                // Held through the re-protect, so the writers waited on
+                // cannot unregister and unmap their pages meanwhile
+                PageIndex::ReadGuard guard(page_index_);
+                for (size_t i = 0; i < num_msgs; ++i) {
+                    if (msgs[i].event & UFFD_EVENT_PAGEFAULT) {
+                        handlePageFault(*shard, msgs[i], ip_reader, guard.table(), read_ns, pages, opened);
+                    }
+                }
+                // Not yet received, but a drain must still wait for them
+                events_held_.fetch_add(shard->held.size());
+                size_t released = pages.size() + opened.size();
+                unprotectPages(shard->uffd, opened, faults);
+                unprotectPages(shard->uffd, pages, faults);
+                if (released > 0) {
+                    fault_latency_.record(EventClock::now() - read_ns, released);
                 }
+                // Re-protecting before a woken writer runs would fault its
+                // write again, still pending, and count it twice
+                awaitWrites(*shard);
+                deferLateWrites(*shard, late);
+                reprotectPages(shard->uffd, pages, faults, late);
             }
+            // Published only once their writes landed, or the slow path
+            // could read the post-state first
+            for (FastPathEvent& event : shard->held) {
+                publishHeld(*shard, event);
+            }
+            events_held_.fetch_sub(shard->held.size());
+            wakeSlowPath(false);
+        }
+        
+        // Pages still held open are re-protected and reported now
+        closeWindows(*shard, true);
+        wakeSlowPath(false);
+        threadExited();
+    }
+    
+    /// epoll_wait timeout: until the earliest window or deferred release
+    /// deadline (rounded up to a millisecond), or -1 with neither open
+    static int windowTimeoutMs(const HandlerShard& shard) {
+        if (shard.windows.empty() && shard.deferred.empty()) {
+            return -1;
+        }
+        uint64_t deadline = UINT64_MAX;
+        for (const CoalesceWindow& window : shard.windows) {
+            deadline = std::min(deadline, window.deadline_ns);
+        }
+        for (const DeferredRelease& release : shard.deferred) {
+            deadline = std::min(deadline, release.deadline_ns);
         }
+        uint64_t now = EventClock::now();
+        return deadline <= now ? 0 : static_cast<int>((deadline - now + 999999) / 1000000);
     }
     
-    void handlePageFault(const struct uffd_msg& msg) {
+    /// Re-protect coalesce windows and deferred releases that are due (or all
+    /// of them) and enqueue their events; the slow path diffs the pre-state
+    /// captured at the first fault against the page as it is now
+    void closeWindows(HandlerShard& shard, bool all) {
+        uint64_t now = EventClock::now();
+        PageIndex::ReadGuard guard(page_index_);
+        const PageIndexTable* table = guard.table();
+        
+        size_t d = 0;
+        while (d < shard.deferred.size()) {
+            DeferredRelease release = shard.deferred[d];
+            if (!all && release.deadline_ns > now) {
+                ++d;
+                continue;
+            }
+            shard.deferred[d] = shard.deferred.back();
+            shard.deferred.pop_back();
+            
+            // Unregistered meanwhile: nothing left to protect or report
+            bool registered = table && table->find(release.start);
+            if (registered && !paused_) {
+                struct uffdio_writeprotect wp = {};
+                wp.range.start = release.start;
+                wp.range.len = release.end - release.start;
+                wp.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+                ioctls_.fetch_add(1, std::memory_order_relaxed);
+                if (ioctl(shard.uffd, UFFDIO_WRITEPROTECT, &wp) < 0) {
+                    reprotect_failures_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            if (release.has_event) {
+                if (registered) {
+                    publishHeld(shard, release.event);
+                }
+                events_held_.fetch_sub(1);
+            }
+        }
+        
+        size_t i = 0;
+        while (i < shard.windows.size()) {
+            CoalesceWindow window = shard.windows[i];
+            if (!all && window.deadline_ns > now) {
+                ++i;
+                continue;
+            }
+            shard.windows[i] = shard.windows.back();
+            shard.windows.pop_back();
+            
+            // Unregistered while open: nothing left to protect or report
+            const PageIndexTable::Segment* seg = table ? table->find(window.fault_addr) : nullptr;
+            if (!seg) {
+                continue;
+            }
+            struct uffdio_writeprotect wp = {};
+            wp.range.start = window.start;
+            wp.range.len = window.end - window.start;
+            wp.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+            if (!paused_) {
+                ioctls_.fetch_add(1, std::memory_order_relaxed);
+                if (ioctl(shard.uffd, UFFDIO_WRITEPROTECT, &wp) < 0) {
+                    reprotect_failures_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            coalesced_windows_.fetch_add(1, std::memory_order_relaxed);
+            enqueueFault(shard, now, window.page_base, window.fault_addr, window.tid, window.ip, table, seg);
+        }
+    }
+    
+    /// Record one fault on the fast path and capture the sub-page's
+    /// pre-state if this is its first write. Sampling policies of the
+    /// covering variables decide whether it becomes an event: the fault is
+    /// emitted if any of them admits it, held open if they coalesce, and
+    /// otherwise counted as a policy drop.
+    /// @param table Pinned page index (may be nullptr)
+    /// @param ts_ns Time the fault batch was read (one clock read per batch)
+    /// @param pages Receives the faulting page at its backing page size,
+    ///        to release and re-protect
+    /// @param opened Receives it instead when a coalesce window opens
+    void handlePageFault(HandlerShard& shard, const struct uffd_msg& msg,
+                         InstructionPointerReader& ip_reader, const PageIndexTable* table, uint64_t ts_ns,
+                         std::vector<std::pair<uint64_t, uint64_t>>& pages,
+                         std::vector<std::pair<uint64_t, uint64_t>>& opened) {
         uint64_t page_base = msg.arg.pagefault.address & ~(PAGE_SIZE - 1);
         uint64_t fault_addr = msg.arg.pagefault.address;
         pid_t tid = msg.arg.pagefault.feat.ptid;
         
-        // Extract instruction pointer from /proc/<tid>/syscall
-        uint64_t ip = extractInstructionPointer(tid);
+        uint64_t granule = PAGE_SIZE;
+        uint32_t flags = 0;
+        bool emit = true;
+        uint64_t window_ns = UINT64_MAX;
+        const PageIndexTable::Segment* seg = table ? table->find(fault_addr) : nullptr;
+        if (paused_.load(std::memory_order_relaxed)) {
+            // Raced pause() lifting protection: let it through unrecorded
+            for (uint32_t i = 0; seg && i < seg->count; ++i) {
+                granule = std::max<uint64_t>(granule, table->member(*seg, i).granule);
+            }
+            uint64_t start = fault_addr & ~(granule - 1);
+            opened.emplace_back(start, start + granule);
+            return;
+        }
+        if (seg) {
+            emit = false;
+            for (uint32_t i = 0; i < seg->count; ++i) {
+                const IndexedRange& range = table->member(*seg, i);
+                granule = std::max<uint64_t>(granule, range.granule);
+                flags |= range.flags;
+                size_t sub = (fault_addr - range.start) / PAGE_SIZE;
+                range.shadow->markDirty(sub, reinterpret_cast<const uint8_t*>(range.start + sub * PAGE_SIZE));
+                
+                // A hugetlb page held open would let writes to its other
+                // sub-pages bypass their pre-state capture
+                SamplingGate::Decision decision = range.sampling
+                    ? range.sampling->admit(ts_ns, range.granule == PAGE_SIZE)
+                    : SamplingGate::EMIT;
+                emit |= decision == SamplingGate::EMIT;
+                if (decision == SamplingGate::COALESCE) {
+                    window_ns = std::min(window_ns, range.sampling->windowNs());
+                }
+            }
+        }
+        uint64_t start = fault_addr & ~(granule - 1);
+        
+        if (!emit && window_ns == UINT64_MAX) {
+            policy_drops_.fetch_add(1, std::memory_order_relaxed);
+            pages.emplace_back(start, start + granule);
+            awaitWrite(shard, start, granule, fault_addr, SIZE_MAX);
+            return;
+        }
+        
+        // The writer is still blocked here, so its PC is the faulting
+        // instruction and the page still holds the pre-write bytes
+        uint64_t ip = ip_capture_ == IpCapture::PROC_SYSCALL && tracksThreads(flags) ? ip_reader.read(tid) : 0;
         
-        // Create fast-path event
+        if (emit) {
+            enqueueFault(shard, ts_ns, page_base, fault_addr, tid, ip, table, seg, &shard.held);
+            pages.emplace_back(start, start + granule);
+            if (seg) {
+                awaitWrite(shard, start, granule, fault_addr, shard.held.size() - 1);
+            }
+            return;
+        }
+        
+        // Faults already queued for a page that is open belong to its window
+        opened.emplace_back(start, start + granule);
+        for (const CoalesceWindow& window : shard.windows) {
+            if (window.start == start) {
+                return;
+            }
+        }
+        shard.windows.push_back({start, start + granule, ts_ns + window_ns, page_base, fault_addr, tid, ip});
+    }
+    
+    /// Remember the bytes at a released write's address, so the release can
+    /// wait for it to land. Needs exact fault addresses; a hugetlb page is
+    /// never left open (its other sub-pages' pre-state would be bypassed),
+    /// so it is not waited on either.
+    void awaitWrite(HandlerShard& shard, uint64_t start, uint64_t granule, uint64_t fault_addr, size_t held) {
+        if (!(uffd_features_ & UFFD_FEATURE_EXACT_ADDRESS) || granule != PAGE_SIZE) {
+            return;
+        }
+        PendingWrite write;
+        write.start = start;
+        write.end = start + granule;
+        write.addr = fault_addr;
+        write.len = static_cast<uint32_t>(std::min<uint64_t>(sizeof(write.bytes), write.end - fault_addr));
+        memcpy(write.bytes, reinterpret_cast<const void*>(fault_addr), write.len);
+        write.held = held;
+        write.landed = false;
+        shard.awaiting.push_back(write);
+    }
+    
+    /// Build and enqueue a fast-path event (POD, no allocation)
+    /// @param shard Producing shard (owns the sequence counter)
+    /// @param seg Index segment covering fault_addr, used to tag the event
+    /// @param held Collects the event instead of publishing it
+    void enqueueFault(HandlerShard& shard, uint64_t ts_ns, uint64_t page_base, uint64_t fault_addr,
+                      pid_t tid, uint64_t ip, const PageIndexTable* table,
+                      const PageIndexTable::Segment* seg, std::vector<FastPathEvent>* held = nullptr) {
         FastPathEvent event;
-        event.event_id = "evt-" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
-        event.ts_ns = std::chrono::system_clock::now().time_since_epoch().count() * 1000000;
+        event.var_count = seg ? seg->count : 0;
+        event.flags = 0;
+        for (uint32_t i = 0; i < event.var_count; ++i) {
+            const IndexedRange& range = table->member(*seg, i);
+            event.flags |= range.flags;
+            if (i < FAST_PATH_MAX_VARS) {
+                event.var_index[i] = range.var_index;
+            }
+        }
+        if (!tracksThreads(event.flags)) {
+            tid = 0;  // Nobody asked who wrote
+        }
+        event.event_seq = 0;  // Numbered when published, so held events keep shard order
+        event.ts_ns = ts_ns;
         event.page_base = reinterpret_cast<void*>(page_base);
         event.fault_addr = reinterpret_cast<void*>(fault_addr);
         event.tid = tid;
         event.ip = ip;
         
-        // Enqueue event
+        if (held) {
+            held->push_back(event);
+        } else {
+            publishHeld(shard, event);
+        }
+    }
+    
+    /// Number an event in its shard's sequence and hand it to the slow path
+    void publishHeld(HandlerShard& shard, FastPathEvent& event) {
+        event.event_seq = (shard.id << EVENT_SEQ_SHARD_SHIFT) | shard.next_seq++;
         if (!event_queue_->enqueue(event)) {
             events_dropped_.fetch_add(1);
+            queue_full_drops_.fetch_add(1, std::memory_order_relaxed);
         } else {
             events_received_.fetch_add(1);
         }
+    }
+    
+    /// Unprotect faulting pages, waking the blocked writers. Merges
+    /// duplicate and adjacent pages into ranges first, in place; ranges that
+    /// fail to unprotect are dropped, so pages ends up holding the ranges to
+    /// re-protect and faults the faults merged into each.
+    void unprotectPages(int uffd, std::vector<std::pair<uint64_t, uint64_t>>& pages, std::vector<size_t>& faults) {
+        std::sort(pages.begin(), pages.end());
+        faults.clear();
         
-        // Unprotect page (allow write to complete)
-        struct uffdio_writeprotect wp = {};
-        wp.range.start = page_base;
-        wp.range.len = PAGE_SIZE;
-        wp.mode = 0;  // Unprotect
-        if (ioctl(uffd_, UFFDIO_WRITEPROTECT, &wp) < 0) {
-            events_dropped_.fetch_add(1);
-            return;
+        size_t i = 0;
+        size_t kept = 0;
+        while (i < pages.size()) {
+            uint64_t start = pages[i].first;
+            uint64_t end = pages[i].second;
+            size_t count = 1;
+            while (++i < pages.size() && pages[i].first <= end) {
+                end = std::max(end, pages[i].second);
+                ++count;
+            }
+            
+            struct uffdio_writeprotect wp = {};
+            wp.range.start = start;
+            wp.range.len = end - start;
+            wp.mode = 0;  // Unprotect (allow writes to complete)
+            ioctls_.fetch_add(1, std::memory_order_relaxed);
+            // The faults' events are already queued; count them apart from
+            // events_dropped, which means events lost
+            if (ioctl(uffd, UFFDIO_WRITEPROTECT, &wp) < 0) {
+                wp_release_failures_.fetch_add(count, std::memory_order_relaxed);
+                unprotect_failures_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            pages[kept++] = {start, end};
+            faults.push_back(count);
+        }
+        pages.resize(kept);
+    }
+    
+    /// Re-protect the ranges unprotectPages() released, except the sorted
+    /// pages in late
+    void reprotectPages(int uffd, const std::vector<std::pair<uint64_t, uint64_t>>& pages,
+                        const std::vector<size_t>& faults, const std::vector<uint64_t>& late) {
+        size_t next_late = 0;
+        for (size_t i = 0; i < pages.size(); ++i) {
+            uint64_t cursor = pages[i].first;
+            while (cursor < pages[i].second) {
+                while (next_late < late.size() && late[next_late] < cursor) {
+                    ++next_late;
+                }
+                uint64_t end = next_late < late.size() && late[next_late] < pages[i].second
+                    ? late[next_late] : pages[i].second;
+                if (end > cursor) {
+                    struct uffdio_writeprotect wp = {};
+                    wp.range.start = cursor;
+                    wp.range.len = end - cursor;
+                    wp.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+                    ioctls_.fetch_add(1, std::memory_order_relaxed);
+                    if (ioctl(uffd, UFFDIO_WRITEPROTECT, &wp) < 0) {
+                        wp_release_failures_.fetch_add(faults[i], std::memory_order_relaxed);
+                        reprotect_failures_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                cursor = end + (end < pages[i].second ? PAGE_SIZE : 0);
+            }
         }
+    }
+    
+    /// Yield until the bytes at each released write's address change (it
+    /// landed), for at most RELEASE_WAIT_NS
+    void awaitWrites(HandlerShard& shard) {
+        uint64_t deadline = EventClock::now() + RELEASE_WAIT_NS;
+        size_t pending = shard.awaiting.size();
+        while (pending > 0) {
+            pending = 0;
+            for (PendingWrite& write : shard.awaiting) {
+                if (!write.landed) {
+                    write.landed = memcmp(write.bytes, reinterpret_cast<const void*>(write.addr), write.len) != 0;
+                    pending += !write.landed;
+                }
+            }
+            if (pending == 0 || EventClock::now() >= deadline) {
+                return;
+            }
+            sched_yield();
+        }
+    }
+    
+    /// Leave the pages of writes that have not landed (slow writers, or
+    /// stores of the value already there) open instead of re-protecting
+    /// them under the writer, which would fault the same write again. Their
+    /// events move from held into a DeferredRelease each.
+    /// @param late Receives those pages, sorted
+    void deferLateWrites(HandlerShard& shard, std::vector<uint64_t>& late) {
+        late.clear();
+        uint64_t deadline = EventClock::now() + RELEASE_WAIT_NS;
+        // Backwards, so erasing a held event leaves earlier indices valid
+        for (size_t i = shard.awaiting.size(); i-- > 0;) {
+            const PendingWrite& write = shard.awaiting[i];
+            if (write.landed) {
+                continue;
+            }
+            DeferredRelease release = {write.start, write.end, deadline, write.held != SIZE_MAX, {}};
+            if (release.has_event) {
+                release.event = shard.held[write.held];
+                shard.held.erase(shard.held.begin() + write.held);
+            }
+            shard.deferred.push_back(release);
+            late.push_back(write.start);
+            deferred_reprotects_.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::sort(late.begin(), late.end());
+    }
+    
+    /// ASYNC_SCAN mode: writers never block. Each pass collects the pages
+    /// written since the last pass and re-protects them in the same ioctl.
+    void asyncScanLoop(HandlerShard* shard) {
+        std::vector<struct page_region> regions(FAULT_BATCH_SIZE);
         
-        // Re-protect page
-        wp.mode = UFFDIO_WRITEPROTECT_MODE_WP;
-        if (ioctl(uffd_, UFFDIO_WRITEPROTECT, &wp) < 0) {
-            events_dropped_.fetch_add(1);
+        while (running_) {
+            std::this_thread::sleep_for(std::chrono::microseconds(scan_interval_us_));
+            
+            PageIndex::ReadGuard guard(page_index_);
+            const PageIndexTable* table = guard.table();
+            if (!table) {
+                continue;
+            }
+            
+            // Segments are sorted and disjoint; scan each adjacent run once
+            const auto& segments = table->segments();
+            size_t i = 0;
+            while (i < segments.size()) {
+                uint64_t start = segments[i].start;
+                uint64_t end = segments[i].end;
+                while (++i < segments.size() && segments[i].start == end) {
+                    end = segments[i].end;
+                }
+                scanWrittenPages(*shard, start, end, regions, table);
+            }
+            wakeSlowPath(false);
         }
+        
+        threadExited();
     }
     
-    uint64_t extractInstructionPointer(pid_t tid) {
-        // Read /proc/<tid>/syscall to get instruction pointer
-        std::string path = "/proc/" + std::to_string(tid) + "/syscall";
-        std::ifstream file(path);
-        if (!file) {
-            return 0;
+    /// Enqueue one event per page written in [start, end) and re-protect them
+    void scanWrittenPages(HandlerShard& shard, uint64_t start, uint64_t end,
+                          std::vector<struct page_region>& regions, const PageIndexTable* table) {
+        uint64_t cursor = start;
+        while (cursor < end) {
+            struct pm_scan_arg arg = {};
+            arg.size = sizeof(arg);
+            arg.flags = PM_SCAN_WP_MATCHING | PM_SCAN_CHECK_WPASYNC;
+            arg.start = cursor;
+            arg.end = end;
+            arg.vec = reinterpret_cast<uint64_t>(regions.data());
+            arg.vec_len = regions.size();
+            arg.category_mask = PAGE_IS_WRITTEN;
+            arg.return_mask = PAGE_IS_WRITTEN;
+            
+            ioctls_.fetch_add(1, std::memory_order_relaxed);
+            long n = ioctl(pagemap_fd_, PAGEMAP_SCAN, &arg);
+            if (n < 0) {
+                return;
+            }
+            uint64_t ts_ns = EventClock::now();
+            // Paused: the scan still re-protects, but written pages are not reported
+            for (long r = 0; !paused_.load(std::memory_order_relaxed) && r < n; ++r) {
+                for (uint64_t page = regions[r].start; page < regions[r].end; page += PAGE_SIZE) {
+                    const PageIndexTable::Segment* seg = table->find(page);
+                    if (!admitScanned(table, seg, ts_ns)) {
+                        policy_drops_.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    enqueueFault(shard, ts_ns, page, page, 0, 0, table, seg);
+                }
+            }
+            
+            // walk_end stops short of end only when the region vector filled up
+            if (arg.walk_end <= cursor) {
+                return;
+            }
+            cursor = arg.walk_end;
+        }
+    }
+    
+    /// Sampling decision for a page found written by a scan. The kernel
+    /// already let the writes through, so COALESCE emits one event per window.
+    static bool admitScanned(const PageIndexTable* table, const PageIndexTable::Segment* seg, uint64_t ts_ns) {
+        if (!seg) {
+            return true;
+        }
+        bool emit = false;
+        for (uint32_t i = 0; i < seg->count; ++i) {
+            const IndexedRange& range = table->member(*seg, i);
+            emit |= !range.sampling || range.sampling->admit(ts_ns, false) == SamplingGate::EMIT;
+        }
+        return emit;
+    }
+    
+    /// Consume the queue until stop() clears slow_path_running_; park on
+    /// slow_wake_fd_ whenever it is empty
+    void slowPathLoop() {
+        std::vector<FastPathEvent> batch(SLOW_PATH_BATCH_SIZE);
+        std::vector<EnrichedEvent> enriched;
+        enriched.reserve(SLOW_PATH_BATCH_SIZE);
+        InstructionPointerReader ip_reader;
+        
+        while (slow_path_running_) {
+            size_t n = event_queue_->dequeueBatch(batch.data(), batch.size());
+            if (n == 0) {
+                idleSlowPath();
+                continue;
+            }
+            uint64_t now_ns = EventClock::now();
+            for (size_t i = 0; i < n; ++i) {
+                queue_latency_.record(now_ns - batch[i].ts_ns);
+            }
+            if (ip_capture_ == IpCapture::DEFERRED) {
+                for (size_t i = 0; i < n; ++i) {
+                    batch[i].ip = tracksThreads(batch[i].flags) ? ip_reader.read(batch[i].tid) : 0;
+                }
+            }
+            processBatch(batch.data(), n, enriched);
+            events_retired_.fetch_add(n);
+            notifyLifecycle();
+        }
+        
+        // stop() gave up on draining: whatever is left is lost
+        size_t n;
+        while ((n = event_queue_->dequeueBatch(batch.data(), batch.size())) > 0) {
+            events_dropped_.fetch_add(n);
+            events_retired_.fetch_add(n);
+        }
+        
+        // Seal the open segment and write the footer index
+        if (recording_ && !recording_->close()) {
+            recording_failures_.fetch_add(1, std::memory_order_relaxed);
+        }
+        threadExited();
+    }
+    
+    /// Queue found empty: answer pending drain requests, then sleep until a
+    /// producer or stop() signals slow_wake_fd_. With a recording open the
+    /// sleep is bounded so an aged segment still gets written.
+    void idleSlowPath() {
+        uint64_t requested = flush_requested_.load();
+        // Events a shard still holds are published (and wake us) shortly
+        bool answer = requested > flush_completed_.load() && events_held_.load() == 0;
+        if (recording_) {
+            bool written = answer ? recording_->sync() : recording_->flush(EventClock::now());
+            if (!written) {
+                recording_failures_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (answer) {
+            flush_completed_.store(requested);
+            notifyLifecycle();
+        }
+        
+        slow_path_idle_.store(true);
+        if (event_queue_->size() == 0 && slow_path_running_ && flush_requested_.load() == requested) {
+            struct pollfd pfd = {slow_wake_fd_, POLLIN, 0};
+            poll(&pfd, 1, recording_ ? static_cast<int>(RECORDING_SEGMENT_MAX_AGE_NS / 1000000) : -1);
+        }
+        slow_path_idle_.store(false);
+        
+        uint64_t count;
+        ssize_t consumed = read(slow_wake_fd_, &count, sizeof(count));  // Reset; EAGAIN if unsignalled
+        (void)consumed;
+    }
+    
+    /// Enrich, filter, persist and hand out one batch of fast-path events
+    void processBatch(const FastPathEvent* events, size_t count, std::vector<EnrichedEvent>& enriched) {
+        enriched.clear();
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t enrich_start = EventClock::now();
+            enriched.emplace_back();
+            if (!enrichEvent(events[i], enriched.back())) {
+                enriched.pop_back();  // Page no longer registered
+            }
+            enrich_latency_.record(EventClock::now() - enrich_start);
+        }
+        
+        EventProcessorFn processor;
+        EventBatchProcessorFn batch_processor;
+        {
+            std::lock_guard<std::mutex> lock(processor_mutex_);
+            processor = processor_;
+            batch_processor = batch_processor_;
         }
         
-        std::string line;
-        if (std::getline(file, line)) {
-            // Last field is the instruction pointer in hex
-            size_t last_space = line.rfind(' ');
-            if (last_space != std::string::npos) {
-                std::string hex_str = line.substr(last_space + 1);
+        // A failed batch hook keeps the whole batch
+        keep_.assign(enriched.size(), 1);
+        if (batch_processor && !enriched.empty()) {
+            try {
+                batch_processor(enriched.data(), enriched.size(), keep_.data());
+            } catch (...) {
+                callbacks_failed_.fetch_add(1);
+                keep_.assign(enriched.size(), 1);
+            }
+        }
+        
+        size_t kept = 0;
+        for (size_t i = 0; i < enriched.size(); ++i) {
+            bool keep = keep_[i] != 0;
+            if (keep && processor) {
                 try {
-                    return std::stoull(hex_str, nullptr, 16);
+                    keep = processor(enriched[i]);
                 } catch (...) {
-                    return 0;
+                    callbacks_failed_.fetch_add(1);
+                }
+            }
+            if (keep) {
+                if (kept != i) {
+                    enriched[kept] = std::move(enriched[i]);
                 }
+                ++kept;
             }
         }
+        enriched.resize(kept);
         
-        return 0;
+        uint64_t persist_start = EventClock::now();
+        if (recording_) {
+            for (const auto& event : enriched) {
+                if (!recording_->append(event)) {
+                    recording_failures_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            if (!recording_->flush(EventClock::now())) {
+                recording_failures_.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else {
+            for (const auto& event : enriched) {
+                writer_->write(event);
+            }
+            writer_->flush();
+        }
+        if (!enriched.empty()) {
+            persist_latency_.record(EventClock::now() - persist_start);
+        }
+        
+        uint64_t persisted_ns = clock_.toWall(EventClock::now());
+        for (const auto& event : enriched) {
+            end_to_end_latency_.record(persisted_ns - event.ts_ns);
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(ready_mutex_);
+            if (channel_) {
+                channel_batch_.resize(enriched.size());
+                for (size_t i = 0; i < enriched.size(); ++i) {
+                    toBinaryRecord(enriched[i], channel_batch_[i]);
+                }
+                channel_->push(channel_batch_.data(), channel_batch_.size());
+                enriched.clear();
+            }
+            for (auto& event : enriched) {
+                // Consumers that fall behind lose the oldest undelivered events;
+                // those are already persisted
+                if (ready_events_.size() >= max_ready_events_) {
+                    ready_events_.pop_front();
+                }
+                ready_events_.push_back(std::move(event));
+            }
+        }
+        
+        events_processed_.fetch_add(count);
     }
     
-    void slowPathLoop() {
-        while (running_) {
-            // Process queued events in batches
-            // This is a placeholder - actual implementation will:
-            // 1. Dequeue event
-            // 2. Read post-snapshot
-            // 3. Compute deltas
-            // 4. Resolve symbols
-            // 5. Persist to JSONL
-            // 6. Call custom processor
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    static void toBinaryRecord(const EnrichedEvent& event, BinaryEventRecord& out) {
+        out.event_seq = event.event_seq;
+        out.ts_ns = event.ts_ns;
+        out.page_base = reinterpret_cast<uintptr_t>(event.page_base);
+        out.fault_addr = reinterpret_cast<uintptr_t>(event.fault_addr);
+        out.ip = event.ip;
+        out.tid = static_cast<uint32_t>(event.tid);
+        out.var_index = event.variable_index;
+        out.var_count = static_cast<uint32_t>(event.variable_ids.size());
+        out.delta_runs = static_cast<uint32_t>(event.deltas.size());
+        out.delta_bytes = static_cast<uint32_t>(event.deltas.changedBytes());
+        out.flags = 0;
+    }
+    
+    /// Slow-path steps for one event: post-snapshot, deltas, symbol
+    /// @return false if no registered variable covers the fault address
+    bool enrichEvent(const FastPathEvent& fast, EnrichedEvent& out) {
+        out.event_seq = fast.event_seq;
+        out.ts_ns = clock_.toWall(fast.ts_ns);
+        out.page_base = fast.page_base;
+        out.fault_addr = fast.fault_addr;
+        out.tid = fast.tid;
+        out.ip = fast.ip;
+        
+        uintptr_t addr = reinterpret_cast<uintptr_t>(fast.fault_addr);
+        
+        // Tags from the fast path; re-resolve only when they overflowed
+        std::vector<uint32_t> overflow;
+        const uint32_t* indices = fast.var_index;
+        size_t count = fast.var_count;
+        if (count > FAST_PATH_MAX_VARS) {
+            PageIndex::ReadGuard guard(page_index_);
+            const PageIndexTable* table = guard.table();
+            const PageIndexTable::Segment* seg = table ? table->find(addr) : nullptr;
+            for (uint32_t i = 0; seg && i < seg->count; ++i) {
+                overflow.push_back(table->member(*seg, i).var_index);
+            }
+            indices = overflow.data();
+            count = overflow.size();
         }
+        
+        // Live address out.post_snapshot was copied from. Baselines are taken
+        // from that copy: a write landing after it must stay out of them, or
+        // it would be in no event's delta.
+        const uint8_t* post_live = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(variables_mutex_);
+            for (size_t t = 0; t < count; ++t) {
+                auto found = variables_by_index_.find(indices[t]);
+                if (found == variables_by_index_.end()) {
+                    continue;  // Unregistered since the fault
+                }
+                VariableMetadata& meta = *found->second;
+                uintptr_t base = reinterpret_cast<uintptr_t>(meta.page_base);
+                // Only the faulting sub-page is diffed, and of it only the
+                // tracked bytes; its shadow copy is the pre-state and the
+                // reported post-state becomes the next pre-state. Faults past
+                // the tracked bytes (elsewhere in the armed granule) carry no
+                // deltas.
+                size_t sub = (addr - base) / PAGE_SIZE;
+                const uint8_t* live = static_cast<uint8_t*>(meta.page_base) + sub * PAGE_SIZE;
+                PageShadow& shadow = *meta.shadow;
+                bool tracked = sub < shadow.subPageCount();
+                size_t len = tracked ? shadow.subPageBytes(sub) : 0;
+                if (out.variable_ids.empty()) {
+                    out.variable_name = meta.name;
+                    out.variable_index = meta.index;
+                    if (tracked && shadow.isDirty(sub)) {
+                        out.pre_snapshot.assign(shadow.subPage(sub), shadow.subPage(sub) + len);
+                        out.post_snapshot.assign(live, live + len);
+                        post_live = live;
+                        out.snapshot_offset = static_cast<uint32_t>(sub * PAGE_SIZE);
+                        computeDeltas(out.pre_snapshot.data(), out.post_snapshot.data(), len,
+                                      out.deltas, sub * PAGE_SIZE);
+                    }
+                }
+                // Overlapping variables share the copy where it covers them
+                const uint8_t* baseline = live;
+                if (post_live && live >= post_live && live + len <= post_live + out.post_snapshot.size()) {
+                    baseline = out.post_snapshot.data() + (live - post_live);
+                }
+                shadow.refresh(sub, baseline);
+                out.variable_ids.push_back(meta.variable_id);
+            }
+        }
+        if (out.variable_ids.empty()) {
+            return false;
+        }
+        
+        if (out.ip) {
+            symbolizer_.resolve(out.ip, out.symbol, out.file, out.line);
+        } else {
+            out.symbol = "??";  // Not captured (see tracksThreads)
+            out.file = "??";
+            out.line = 0;
+        }
+        return true;
     }
 };
 
@@ -548,6 +2196,10 @@ bool WatcherCore::initialize(const std::string& output_dir, size_t max_queue_siz
     return static_cast<WatcherCoreImpl&>(*this).initialize(output_dir, max_queue_size);
 }
 
+bool WatcherCore::initialize(const WatcherConfig& config) {
+    return static_cast<WatcherCoreImpl&>(*this).initialize(config);
+}
+
 std::string WatcherCore::registerPage(void* page_base, size_t page_size, const std::string& name,
                                      EventFlags flags, const MutationDepth& mutation_depth) {
     return static_cast<WatcherCoreImpl&>(*this).registerPage(page_base, page_size, name, flags, mutation_depth);
@@ -565,6 +2217,19 @@ bool WatcherCore::writeSnapshot(const std::string& variable_id, const std::vecto
     return static_cast<WatcherCoreImpl&>(*this).writeSnapshot(variable_id, snapshot);
 }
 
+size_t WatcherCore::registerRanges(const RangeRegistration* ranges, size_t count,
+                                  std::vector<std::string>& ids) {
+    return static_cast<WatcherCoreImpl&>(*this).registerRanges(ranges, count, ids);
+}
+
+size_t WatcherCore::readSnapshotInto(const std::string& variable_id, void* out, size_t capacity) {
+    return static_cast<WatcherCoreImpl&>(*this).readSnapshotInto(variable_id, out, capacity);
+}
+
+bool WatcherCore::writeSnapshotFrom(const std::string& variable_id, const void* data, size_t len) {
+    return static_cast<WatcherCoreImpl&>(*this).writeSnapshotFrom(variable_id, data, len);
+}
+
 bool WatcherCore::updateMetadata(const std::string& variable_id, const VariableMetadata& metadata) {
     return static_cast<WatcherCoreImpl&>(*this).updateMetadata(variable_id, metadata);
 }
@@ -573,8 +2238,8 @@ bool WatcherCore::start() {
     return static_cast<WatcherCoreImpl&>(*this).start();
 }
 
-bool WatcherCore::pause() {
-    return static_cast<WatcherCoreImpl&>(*this).pause();
+bool WatcherCore::pause(int timeout_ms) {
+    return static_cast<WatcherCoreImpl&>(*this).pause(timeout_ms);
 }
 
 bool WatcherCore::resume() {
@@ -593,12 +2258,44 @@ std::string WatcherCore::getErrorMessage() const {
     return static_cast<const WatcherCoreImpl&>(*this).getErrorMessage();
 }
 
+FaultMode WatcherCore::getFaultMode() const {
+    return static_cast<const WatcherCoreImpl&>(*this).getFaultMode();
+}
+
 EnrichedEvent* WatcherCore::dequeueEvent() {
     return static_cast<WatcherCoreImpl&>(*this).dequeueEvent();
 }
 
+size_t WatcherCore::dequeueEvents(std::vector<EnrichedEvent>& out, size_t max_events) {
+    return static_cast<WatcherCoreImpl&>(*this).dequeueEvents(out, max_events);
+}
+
+EventChannel* WatcherCore::openEventChannel(size_t capacity) {
+    return static_cast<WatcherCoreImpl&>(*this).openEventChannel(capacity);
+}
+
+uint32_t WatcherCore::variableIndex(const std::string& variable_id) const {
+    return static_cast<const WatcherCoreImpl&>(*this).variableIndex(variable_id);
+}
+
+bool WatcherCore::resolveSymbol(uint64_t ip, std::string& symbol, std::string& file, int& line) {
+    return static_cast<WatcherCoreImpl&>(*this).resolveSymbol(ip, symbol, file, line);
+}
+
+void WatcherCore::setEventProcessor(EventProcessorFn processor) {
+    static_cast<WatcherCoreImpl&>(*this).setEventProcessor(std::move(processor));
+}
+
+void WatcherCore::setBatchProcessor(EventBatchProcessorFn processor) {
+    static_cast<WatcherCoreImpl&>(*this).setBatchProcessor(std::move(processor));
+}
+
 WatcherCore::Metrics WatcherCore::getMetrics() const {
     return static_cast<const WatcherCoreImpl&>(*this).getMetrics();
 }
 
+WatcherCore::PipelineMetrics WatcherCore::getPipelineMetrics() const {
+    return static_cast<const WatcherCoreImpl&>(*this).getPipelineMetrics();
+}
+
 }  // namespace watcher
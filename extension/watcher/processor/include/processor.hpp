@@ -1,12 +1,15 @@
 #pragma once
 
 #include <watcher_core.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <vector>
 #include <functional>
-#include <map>
-#include <any>
 #include <iostream>
 
 namespace watcher::processor {
@@ -22,10 +25,118 @@ enum class ProcessorAction {
     PASS       // Pass through unchanged
 };
 
+/// Verdict for one event; annotations go to the batch's AnnotationArena
 struct ProcessorResponse {
-    ProcessorAction action;
-    std::map<std::string, std::any> annotations;  // For ANNOTATE action
-    std::map<std::string, std::any> extra;        // For ENRICH action
+    ProcessorAction action = ProcessorAction::PASS;
+};
+
+// ============================================================================
+// Batch Views
+// ============================================================================
+
+/// Non-owning view of contiguous elements (std::span stand-in for C++17)
+template <typename T>
+class Span {
+public:
+    Span() = default;
+    Span(T* data, size_t size) : data_(data), size_(size) {}
+
+    /// Any container with data() and size() (e.g. std::vector)
+    template <typename Container,
+              typename = decltype(static_cast<T*>(std::declval<Container&>().data()))>
+    Span(Container& container) : data_(container.data()), size_(container.size()) {}
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T& operator[](size_t i) const { return data_[i]; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+
+    Span subspan(size_t offset, size_t count) const { return Span(data_ + offset, count); }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+enum class AnnotationType : uint8_t {
+    INT,
+    DOUBLE,
+    STRING
+};
+
+/// One typed annotation; key and string values live in the arena's bytes
+struct Annotation {
+    uint32_t event;         // Index within the batch
+    AnnotationType type;
+    uint32_t key_offset;
+    uint32_t key_length;
+    uint32_t value_offset;  // STRING
+    uint32_t value_length;
+    int64_t int_value;      // INT
+    double double_value;    // DOUBLE
+};
+
+/// Flat storage for a batch's annotations: fixed-size records plus one byte
+/// arena, reused across batches so steady-state annotation allocates nothing
+class AnnotationArena {
+public:
+    void addInt(uint32_t event, std::string_view key, int64_t value) {
+        Annotation& a = add(event, AnnotationType::INT, key);
+        a.int_value = value;
+    }
+
+    void addDouble(uint32_t event, std::string_view key, double value) {
+        Annotation& a = add(event, AnnotationType::DOUBLE, key);
+        a.double_value = value;
+    }
+
+    void addString(uint32_t event, std::string_view key, std::string_view value) {
+        Annotation& a = add(event, AnnotationType::STRING, key);
+        a.value_offset = static_cast<uint32_t>(bytes_.size());
+        a.value_length = static_cast<uint32_t>(value.size());
+        bytes_.insert(bytes_.end(), value.begin(), value.end());
+    }
+
+    /// Annotations in the order they were added
+    const std::vector<Annotation>& entries() const { return entries_; }
+    size_t size() const { return entries_.size(); }
+
+    std::string_view key(const Annotation& a) const {
+        return std::string_view(bytes_.data() + a.key_offset, a.key_length);
+    }
+
+    std::string_view text(const Annotation& a) const {
+        return std::string_view(bytes_.data() + a.value_offset, a.value_length);
+    }
+
+    /// Added to the event index of later annotations; set by ProcessorChain
+    /// when it hands a processor part of a batch
+    uint32_t eventBase() const { return event_base_; }
+    void setEventBase(uint32_t base) { event_base_ = base; }
+
+    void clear() {
+        entries_.clear();
+        bytes_.clear();
+        event_base_ = 0;
+    }
+
+private:
+    Annotation& add(uint32_t event, AnnotationType type, std::string_view key) {
+        Annotation a{};
+        a.event = event_base_ + event;
+        a.type = type;
+        a.key_offset = static_cast<uint32_t>(bytes_.size());
+        a.key_length = static_cast<uint32_t>(key.size());
+        bytes_.insert(bytes_.end(), key.begin(), key.end());
+        entries_.push_back(a);
+        return entries_.back();
+    }
+
+    std::vector<Annotation> entries_;
+    std::vector<char> bytes_;
+    uint32_t event_base_ = 0;
 };
 
 // ============================================================================
@@ -35,11 +146,63 @@ struct ProcessorResponse {
 class CustomProcessor {
 public:
     virtual ~CustomProcessor() = default;
-    
-    /// Process an enriched event
-    /// @param event Event to process
-    /// @return ProcessorResponse with action and optional data
-    virtual ProcessorResponse processEvent(const watcher::EnrichedEvent& event) = 0;
+
+    /// Process a batch of enriched events
+    /// @param events Events to process
+    /// @param responses One per event, preset to PASS
+    /// @param annotations Arena for annotations (event = index into events)
+    virtual void processBatch(Span<const watcher::EnrichedEvent> events, Span<ProcessorResponse> responses,
+                              AnnotationArena& annotations) = 0;
+};
+
+/// Runs processors in order; later processors only see events no earlier
+/// one dropped, and a later non-PASS action replaces an earlier one
+class ProcessorChain : public CustomProcessor {
+public:
+    void add(std::shared_ptr<CustomProcessor> processor) {
+        if (processor) {
+            stages_.push_back(std::move(processor));
+        }
+    }
+
+    size_t size() const { return stages_.size(); }
+
+    void processBatch(Span<const watcher::EnrichedEvent> events, Span<ProcessorResponse> responses,
+                      AnnotationArena& annotations) override;
+
+private:
+    std::vector<std::shared_ptr<CustomProcessor>> stages_;
+    std::vector<ProcessorResponse> stage_responses_;
+};
+
+// ============================================================================
+// Script Processors
+// ============================================================================
+
+struct ScriptProcessorOptions {
+    /// Longest a batch waits for the script (including for its previous
+    /// batch to finish); past it the batch passes unprocessed
+    std::chrono::milliseconds batch_deadline{100};
+    /// Longest the script may take to load
+    std::chrono::milliseconds load_timeout{10000};
+    /// JavaScript runtime, looked up in PATH
+    std::string node_path = "node";
+};
+
+/// Processors that run a user script off the slow-path thread: one
+/// crossing per batch, bounded by ScriptProcessorOptions::batch_deadline
+class ScriptProcessor : public CustomProcessor {
+public:
+    uint64_t batches() const { return batches_.load(); }
+    /// Batches that passed unprocessed because the script was too slow
+    uint64_t deadlineMisses() const { return deadline_misses_.load(); }
+    /// Batches the script failed on (they pass unprocessed)
+    uint64_t failures() const { return failures_.load(); }
+
+protected:
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> deadline_misses_{0};
+    std::atomic<uint64_t> failures_{0};
 };
 
 // ============================================================================
@@ -48,34 +211,56 @@ public:
 
 class ProcessorFactory {
 public:
-    /// Create processor from Python file
-    /// @param script_path Path to Python file with processor main() function
-    /// @return Pointer to processor, nullptr on error
-    static std::unique_ptr<CustomProcessor> createPythonProcessor(const std::string& script_path);
-    
-    /// Create processor from JavaScript file
-    /// @param script_path Path to JavaScript file with processor main() function
+    /// Create processor from Python file, run on an embedded interpreter
+    /// thread (script contract in watcher/core/processor_host.py)
+    /// @param script_path Path to Python file with main(event) or main_batch(batch)
+    /// @param error Receives the reason on failure, if non-null
+    /// @return Pointer to a ScriptProcessor, nullptr on error
+    static std::unique_ptr<CustomProcessor> createPythonProcessor(const std::string& script_path,
+                                                                  const ScriptProcessorOptions& options = {},
+                                                                  std::string* error = nullptr);
+
+    /// Create processor from JavaScript file, run by a Node.js host process
+    /// (script contract in watcher/adapters/javascript/processor_host.js)
+    /// @param script_path Path to JavaScript file exporting main(event) or main_batch(batch)
+    /// @param error Receives the reason on failure, if non-null
+    /// @return Pointer to a ScriptProcessor, nullptr on error
+    static std::unique_ptr<CustomProcessor> createJavaScriptProcessor(const std::string& script_path,
+                                                                      const ScriptProcessorOptions& options = {},
+                                                                      std::string* error = nullptr);
+
+    /// Load a compiled processor (see watcher_processor_abi.h) with dlopen
+    /// @param library_path Shared library exporting watcher_processor_entry
+    /// @param config Passed to the library's create()
+    /// @param error Receives the reason on failure, if non-null
     /// @return Pointer to processor, nullptr on error
-    static std::unique_ptr<CustomProcessor> createJavaScriptProcessor(const std::string& script_path);
+    static std::unique_ptr<CustomProcessor> createNativeProcessor(const std::string& library_path,
+                                                                  const std::string& config = "",
+                                                                  std::string* error = nullptr);
 };
 
+/// Route the core's slow-path batches through a processor, before they are
+/// persisted or serialized for consumers
+/// DROP removes the event; other actions keep it
+/// @param processor Processor to install, or nullptr to remove the current one
+void installProcessor(std::shared_ptr<CustomProcessor> processor);
+
 // ============================================================================
 // Built-in Processors
 // ============================================================================
 
 class NoOpProcessor : public CustomProcessor {
 public:
-    ProcessorResponse processEvent(const watcher::EnrichedEvent& event) override {
-        return {ProcessorAction::PASS, {}, {}};
-    }
+    void processBatch(Span<const watcher::EnrichedEvent>, Span<ProcessorResponse>, AnnotationArena&) override {}
 };
 
 class LoggingProcessor : public CustomProcessor {
 public:
     explicit LoggingProcessor(std::ostream& out = std::cout) : out_(out) {}
-    
-    ProcessorResponse processEvent(const watcher::EnrichedEvent& event) override;
-    
+
+    void processBatch(Span<const watcher::EnrichedEvent> events, Span<ProcessorResponse> responses,
+                      AnnotationArena& annotations) override;
+
 private:
     std::ostream& out_;
 };
@@ -83,17 +268,18 @@ private:
 class FilteringProcessor : public CustomProcessor {
 public:
     using FilterFunc = std::function<bool(const watcher::EnrichedEvent&)>;
-    
+
     explicit FilteringProcessor(FilterFunc filter) : filter_(filter) {}
-    
-    ProcessorResponse processEvent(const watcher::EnrichedEvent& event) override {
-        if (filter_(event)) {
-            return {ProcessorAction::PASS, {}, {}};
-        } else {
-            return {ProcessorAction::DROP, {}, {}};
+
+    void processBatch(Span<const watcher::EnrichedEvent> events, Span<ProcessorResponse> responses,
+                      AnnotationArena&) override {
+        for (size_t i = 0; i < events.size(); ++i) {
+            if (!filter_(events[i])) {
+                responses[i].action = ProcessorAction::DROP;
+            }
         }
     }
-    
+
 private:
     FilterFunc filter_;
 };
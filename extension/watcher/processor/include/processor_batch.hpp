@@ -0,0 +1,82 @@
+#pragma once
+
+#include "processor.hpp"
+#include "watcher_processor_abi.h"
+#include <event_channel.hpp>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace watcher::processor {
+
+// ============================================================================
+// Packed Batch Format (little-endian)
+// ============================================================================
+//
+// One slow-path batch in a single buffer, handed to script processors as a
+// zero-copy view (a memoryview / numpy structured array in Python, typed
+// arrays over a Buffer in JavaScript):
+//
+//   ProcessorBatchHeader
+//   BinaryEventRecord records[count]     event_channel.hpp, 64 bytes each
+//   ProcessorEventText text[count]
+//   strings                              NUL-terminated; offset 0 is ""
+//   deltas                               per event, delta_runs times
+//       { u32 offset, u32 length, old[length], new[length] }
+//
+// String and delta offsets are relative to their section.
+
+constexpr uint32_t PROCESSOR_BATCH_MAGIC = 0x42505357;  // "WSPB"
+
+struct ProcessorBatchHeader {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t records_offset;
+    uint32_t text_offset;
+    uint32_t strings_offset;
+    uint32_t deltas_offset;
+    uint32_t size;          // Whole buffer
+    uint32_t reserved;
+};
+static_assert(sizeof(ProcessorBatchHeader) == 32, "ProcessorBatchHeader is a 32-byte wire format");
+
+/// Variable-length fields of one event
+struct ProcessorEventText {
+    uint32_t symbol;        // String offsets
+    uint32_t file;
+    uint32_t variable_name;
+    uint32_t sql_context_id;
+    uint32_t variable_ids;  // First of var_count consecutive strings
+    uint32_t deltas;        // Offset of the event's first run
+    int32_t line;
+    uint32_t reserved;
+};
+static_assert(sizeof(ProcessorEventText) == 32, "ProcessorEventText is a 32-byte wire format");
+
+/// Map a WATCHER_ACTION_* byte written by a script or library
+inline ProcessorAction actionFromAbi(uint8_t action) {
+    switch (action) {
+    case WATCHER_ACTION_ANNOTATE: return ProcessorAction::ANNOTATE;
+    case WATCHER_ACTION_ENRICH: return ProcessorAction::ENRICH;
+    case WATCHER_ACTION_DROP: return ProcessorAction::DROP;
+    default: return ProcessorAction::PASS;
+    }
+}
+
+/// Packs batches into one reused buffer (strings interned per batch)
+class ProcessorBatchPacker {
+public:
+    /// @return The packed batch, valid until the next pack()
+    const std::vector<uint8_t>& pack(Span<const watcher::EnrichedEvent> events);
+
+private:
+    uint32_t intern(std::string_view s);
+
+    std::vector<uint8_t> buffer_;
+    std::vector<char> strings_;
+    std::vector<uint8_t> deltas_;
+    std::unordered_map<std::string_view, uint32_t> refs_;
+};
+
+}  // namespace watcher::processor
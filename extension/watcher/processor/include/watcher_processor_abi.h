@@ -0,0 +1,103 @@
+#ifndef WATCHER_PROCESSOR_ABI_H
+#define WATCHER_PROCESSOR_ABI_H
+
+/*
+ * Stable C ABI for compiled processors.
+ *
+ * A processor is a shared library exporting WATCHER_PROCESSOR_ENTRY, which
+ * returns a static watcher_processor_api. The host (ProcessorFactory::
+ * createNativeProcessor) loads it with dlopen, creates one state per load
+ * and calls process_batch on the slow-path thread with every enriched
+ * batch. Only fields are appended in later ABI versions; a library built
+ * for a newer version than the host is refused.
+ *
+ *     static void process(void* state, const watcher_event_view* events, size_t count,
+ *                         uint8_t* actions, const watcher_processor_host* host) {
+ *         for (size_t i = 0; i < count; ++i) {
+ *             if (events[i].delta_count == 0) {
+ *                 actions[i] = WATCHER_ACTION_DROP;
+ *             }
+ *         }
+ *     }
+ *     static const watcher_processor_api api = {WATCHER_PROCESSOR_ABI_VERSION, 0, NULL, NULL, process};
+ *     const watcher_processor_api* watcher_processor_entry(void) { return &api; }
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WATCHER_PROCESSOR_ABI_VERSION 1
+#define WATCHER_PROCESSOR_ENTRY "watcher_processor_entry"
+
+/* Values of actions[i] */
+enum {
+    WATCHER_ACTION_PASS = 0,
+    WATCHER_ACTION_ANNOTATE = 1,
+    WATCHER_ACTION_ENRICH = 2,
+    WATCHER_ACTION_DROP = 3
+};
+
+/* One changed byte range; old bytes at delta_arena + arena_offset, new right after */
+typedef struct watcher_delta_run {
+    uint32_t offset;            /* Offset within the variable */
+    uint32_t length;
+    uint32_t arena_offset;
+} watcher_delta_run;
+
+/* Read-only view of one enriched event, valid for the duration of the call.
+   Strings are NUL-terminated and never NULL. */
+typedef struct watcher_event_view {
+    uint64_t event_seq;
+    uint64_t ts_ns;             /* Wall-clock nanoseconds since the Unix epoch */
+    uint64_t ip;
+    uint64_t page_base;
+    uint64_t fault_addr;
+    uint32_t tid;
+    uint32_t variable_index;
+    int32_t line;
+    uint32_t variable_count;
+    const char* symbol;
+    const char* file;
+    const char* variable_name;
+    const char* sql_context_id;
+    const char* const* variable_ids;    /* variable_count entries */
+    const watcher_delta_run* deltas;    /* delta_count entries */
+    uint32_t delta_count;
+    uint32_t reserved;
+    const uint8_t* delta_arena;
+} watcher_event_view;
+
+/* Host callbacks; event is the index within the current batch */
+typedef struct watcher_processor_host {
+    uint32_t abi_version;
+    uint32_t reserved;
+    void* context;
+    void (*annotate_int)(void* context, uint32_t event, const char* key, int64_t value);
+    void (*annotate_double)(void* context, uint32_t event, const char* key, double value);
+    void (*annotate_string)(void* context, uint32_t event, const char* key,
+                            const char* value, size_t length);
+} watcher_processor_host;
+
+typedef struct watcher_processor_api {
+    uint32_t abi_version;       /* WATCHER_PROCESSOR_ABI_VERSION the library was built for */
+    uint32_t reserved;
+    /* Optional: per-load state from the config string; NULL fails the load */
+    void* (*create)(const char* config);
+    /* Optional: release create()'s state */
+    void (*destroy)(void* state);
+    /* Set actions[i] (preset to WATCHER_ACTION_PASS) for each of count events */
+    void (*process_batch)(void* state, const watcher_event_view* events, size_t count,
+                          uint8_t* actions, const watcher_processor_host* host);
+} watcher_processor_api;
+
+typedef const watcher_processor_api* (*watcher_processor_entry_fn)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WATCHER_PROCESSOR_ABI_H */
@@ -0,0 +1,291 @@
+#include "processor.hpp"
+#include "processor_batch.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace watcher::processor {
+
+// ============================================================================
+// Node.js Processor Host
+// ============================================================================
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t REPLY_FAILED = 0xffffffff;
+
+enum class IoResult {
+    OK,
+    TIMEOUT,
+    CLOSED
+};
+
+/// Runs a script in a node process (adapters/javascript/processor_host.js)
+/// over a socket pair: one request frame per batch, answered with the
+/// actions and annotations. Replies that miss the batch deadline are read
+/// and discarded before the next batch, so a slow script costs at most the
+/// deadline per batch and never reorders verdicts.
+class JavaScriptProcessor : public ScriptProcessor {
+public:
+    static std::unique_ptr<JavaScriptProcessor> load(const std::string& script_path,
+                                                     const ScriptProcessorOptions& options, std::string& error) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+            error = std::string("socketpair: ") + strerror(errno);
+            return nullptr;
+        }
+        // The child end becomes fd 3; keep it off 3 so the dup2 clears CLOEXEC
+        int child_fd = fds[1];
+        if (child_fd == 3) {
+            child_fd = fcntl(fds[1], F_DUPFD_CLOEXEC, 4);
+            close(fds[1]);
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, child_fd, 3);
+        std::string host_script = WATCHER_JS_HOST_SCRIPT;
+        std::vector<char*> argv = {const_cast<char*>(options.node_path.c_str()),
+                                   const_cast<char*>(host_script.c_str()),
+                                   const_cast<char*>(script_path.c_str()), nullptr};
+        pid_t pid = -1;
+        int rc = posix_spawnp(&pid, options.node_path.c_str(), &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(child_fd);
+        if (rc != 0) {
+            close(fds[0]);
+            error = "Cannot run " + options.node_path + ": " + strerror(rc);
+            return nullptr;
+        }
+
+        std::unique_ptr<JavaScriptProcessor> processor(new JavaScriptProcessor(options, fds[0], pid));
+        std::vector<uint8_t> hello;
+        switch (processor->readFrame(Clock::now() + options.load_timeout, hello)) {
+        case IoResult::OK:
+            if (!hello.empty() && hello[0] == 1) {
+                return processor;
+            }
+            error = hello.size() > 1 ? std::string(hello.begin() + 1, hello.end()) : script_path + " failed to load";
+            return nullptr;
+        case IoResult::TIMEOUT:
+            error = script_path + " did not load within " + std::to_string(options.load_timeout.count()) + " ms";
+            return nullptr;
+        case IoResult::CLOSED:
+            error = options.node_path + " exited while loading " + script_path;
+            return nullptr;
+        }
+        return nullptr;
+    }
+
+    ~JavaScriptProcessor() override {
+        // Closing the socket ends the host; a script stuck in a batch is killed
+        close(fd_);
+        for (int i = 0; i < 100; ++i) {
+            if (waitpid(pid_, nullptr, WNOHANG) != 0) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        kill(pid_, SIGKILL);
+        waitpid(pid_, nullptr, 0);
+    }
+
+    void processBatch(Span<const watcher::EnrichedEvent> events, Span<ProcessorResponse> responses,
+                      AnnotationArena& annotations) override {
+        if (events.empty() || closed_) {
+            return;
+        }
+        auto deadline = Clock::now() + options_.batch_deadline;
+
+        // Catch up with batches that missed their deadline
+        if (!settle(flush(deadline))) {
+            return;
+        }
+        while (stale_ > 0) {
+            if (!settle(readFrame(deadline, reply_))) {
+                return;
+            }
+            --stale_;
+        }
+
+        const std::vector<uint8_t>& batch = packer_.pack(events);
+        uint32_t length = static_cast<uint32_t>(batch.size());
+        const auto* prefix = reinterpret_cast<const uint8_t*>(&length);
+        out_.insert(out_.end(), prefix, prefix + sizeof(length));
+        out_.insert(out_.end(), batch.begin(), batch.end());
+        ++stale_;  // Until its reply is read
+        if (!settle(flush(deadline)) || !settle(readFrame(deadline, reply_))) {
+            return;
+        }
+        --stale_;
+
+        batches_.fetch_add(1);
+        if (!applyReply(events.size(), responses, annotations)) {
+            failures_.fetch_add(1);
+        }
+    }
+
+private:
+    JavaScriptProcessor(const ScriptProcessorOptions& options, int fd, pid_t pid)
+        : options_(options), fd_(fd), pid_(pid) {
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+    }
+
+    /// Count a timeout or a dead host; true to carry on
+    bool settle(IoResult result) {
+        if (result == IoResult::TIMEOUT) {
+            deadline_misses_.fetch_add(1);
+        } else if (result == IoResult::CLOSED) {
+            closed_ = true;
+            failures_.fetch_add(1);
+        }
+        return result == IoResult::OK;
+    }
+
+    bool waitFor(short events, Clock::time_point deadline) {
+        auto remaining = deadline - Clock::now();
+        if (remaining <= Clock::duration::zero()) {
+            return false;
+        }
+        // Rounded up: a deadline under a millisecond away still waits
+        auto timeout = std::chrono::ceil<std::chrono::milliseconds>(remaining);
+        pollfd pfd{fd_, events, 0};
+        int rc;
+        do {
+            rc = poll(&pfd, 1, static_cast<int>(timeout.count()));
+        } while (rc < 0 && errno == EINTR);
+        return rc > 0;
+    }
+
+    /// Write out_ (possibly left over from an earlier batch)
+    IoResult flush(Clock::time_point deadline) {
+        while (!out_.empty()) {
+            ssize_t n = send(fd_, out_.data(), out_.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n > 0) {
+                out_.erase(out_.begin(), out_.begin() + n);
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if (!waitFor(POLLOUT, deadline)) {
+                    return IoResult::TIMEOUT;
+                }
+            } else {
+                return IoResult::CLOSED;
+            }
+        }
+        return IoResult::OK;
+    }
+
+    /// Next frame's payload; a partial frame stays in in_ for the next call
+    IoResult readFrame(Clock::time_point deadline, std::vector<uint8_t>& payload) {
+        for (;;) {
+            if (in_.size() >= sizeof(uint32_t)) {
+                uint32_t length;
+                memcpy(&length, in_.data(), sizeof(length));
+                if (in_.size() >= sizeof(length) + length) {
+                    payload.assign(in_.begin() + sizeof(length), in_.begin() + sizeof(length) + length);
+                    in_.erase(in_.begin(), in_.begin() + sizeof(length) + length);
+                    return IoResult::OK;
+                }
+            }
+            uint8_t chunk[65536];
+            ssize_t n = recv(fd_, chunk, sizeof(chunk), MSG_DONTWAIT);
+            if (n > 0) {
+                in_.insert(in_.end(), chunk, chunk + n);
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if (!waitFor(POLLIN, deadline)) {
+                    return IoResult::TIMEOUT;
+                }
+            } else {
+                return IoResult::CLOSED;
+            }
+        }
+    }
+
+    /// Decode reply_: u32 count, actions[count], then annotations
+    bool applyReply(size_t count, Span<ProcessorResponse> responses, AnnotationArena& annotations) {
+        const uint8_t* p = reply_.data();
+        const uint8_t* end = p + reply_.size();
+        auto take = [&](void* out, size_t n) {
+            if (static_cast<size_t>(end - p) < n) {
+                return false;
+            }
+            memcpy(out, p, n);
+            p += n;
+            return true;
+        };
+        uint32_t n = 0;
+        if (!take(&n, sizeof(n)) || n == REPLY_FAILED || n != count || static_cast<size_t>(end - p) < n) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            responses[i].action = actionFromAbi(p[i]);
+        }
+        p += n;
+
+        while (p < end) {
+            uint32_t event, key_length;
+            uint8_t type;
+            if (!take(&event, sizeof(event)) || !take(&type, sizeof(type)) || !take(&key_length, sizeof(key_length)) ||
+                static_cast<size_t>(end - p) < key_length || event >= count) {
+                return false;
+            }
+            std::string_view key(reinterpret_cast<const char*>(p), key_length);
+            p += key_length;
+            if (type == static_cast<uint8_t>(AnnotationType::INT)) {
+                int64_t value;
+                if (!take(&value, sizeof(value))) return false;
+                annotations.addInt(event, key, value);
+            } else if (type == static_cast<uint8_t>(AnnotationType::DOUBLE)) {
+                double value;
+                if (!take(&value, sizeof(value))) return false;
+                annotations.addDouble(event, key, value);
+            } else {
+                uint32_t length;
+                if (!take(&length, sizeof(length)) || static_cast<size_t>(end - p) < length) return false;
+                annotations.addString(event, key, std::string_view(reinterpret_cast<const char*>(p), length));
+                p += length;
+            }
+        }
+        return true;
+    }
+
+    ScriptProcessorOptions options_;
+    int fd_;
+    pid_t pid_;
+    bool closed_ = false;
+    uint32_t stale_ = 0;            // Requests sent whose replies were not read
+    std::vector<uint8_t> out_;      // Unsent bytes of the last request
+    std::vector<uint8_t> in_;       // Received bytes not yet framed
+    std::vector<uint8_t> reply_;
+    ProcessorBatchPacker packer_;
+};
+
+}  // namespace
+
+std::unique_ptr<CustomProcessor> ProcessorFactory::createJavaScriptProcessor(const std::string& script_path,
+                                                                             const ScriptProcessorOptions& options,
+                                                                             std::string* error) {
+    std::string reason;
+    auto processor = JavaScriptProcessor::load(script_path, options, reason);
+    if (!processor && error) {
+        *error = reason;
+    }
+    return processor;
+}
+
+}  // namespace watcher::processor
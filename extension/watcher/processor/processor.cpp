@@ -1,5 +1,8 @@
 #include "processor.hpp"
+#include "processor_batch.hpp"
+#include <dlfcn.h>
 #include <iostream>
+#include <cstddef>
 #include <sstream>
 namespace watcher::processor {
 
@@ -7,28 +10,205 @@ namespace watcher::processor {
 // Processor Implementations
 // ============================================================================
 
-ProcessorResponse LoggingProcessor::processEvent(const watcher::EnrichedEvent& event) {
-    out_ << "Event: " << event.event_id << std::endl;
-    out_ << "  Symbol: " << event.symbol << std::endl;
-    out_ << "  File: " << event.file << ":" << event.line << std::endl;
-    out_ << "  TID: " << event.tid << std::endl;
-    out_ << "  Deltas: " << event.deltas.size() << std::endl;
-    
-    return {ProcessorAction::PASS, {}, {}};
+void LoggingProcessor::processBatch(Span<const watcher::EnrichedEvent> events, Span<ProcessorResponse>,
+                                    AnnotationArena&) {
+    for (const auto& event : events) {
+        out_ << "Event: " << formatEventId(event.event_seq) << std::endl;
+        out_ << "  Symbol: " << event.symbol << std::endl;
+        out_ << "  File: " << event.file << ":" << event.line << std::endl;
+        out_ << "  TID: " << event.tid << std::endl;
+        out_ << "  Deltas: " << event.deltas.size() << std::endl;
+    }
 }
 
+void ProcessorChain::processBatch(Span<const watcher::EnrichedEvent> events, Span<ProcessorResponse> responses,
+                                  AnnotationArena& annotations) {
+    uint32_t base = annotations.eventBase();
+    for (const auto& stage : stages_) {
+        // Hand the stage each run of events still alive, so a DROP
+        // short-circuits every later stage for that event
+        size_t i = 0;
+        while (i < events.size()) {
+            if (responses[i].action == ProcessorAction::DROP) {
+                ++i;
+                continue;
+            }
+            size_t end = i + 1;
+            while (end < events.size() && responses[end].action != ProcessorAction::DROP) {
+                ++end;
+            }
+            stage_responses_.assign(end - i, ProcessorResponse{});
+            annotations.setEventBase(base + static_cast<uint32_t>(i));
+            stage->processBatch(events.subspan(i, end - i), stage_responses_, annotations);
+            for (size_t k = 0; k < stage_responses_.size(); ++k) {
+                if (stage_responses_[k].action != ProcessorAction::PASS) {
+                    responses[i + k].action = stage_responses_[k].action;
+                }
+            }
+            i = end;
+        }
+    }
+    annotations.setEventBase(base);
+}
+
+// ============================================================================
+// Native Processors (C ABI)
+// ============================================================================
+
+namespace {
+
+class NativeProcessor : public CustomProcessor {
+public:
+    NativeProcessor(void* handle, const watcher_processor_api* api, void* state)
+        : handle_(handle), api_(api), state_(state) {}
+
+    ~NativeProcessor() override {
+        if (api_->destroy) {
+            api_->destroy(state_);
+        }
+        dlclose(handle_);
+    }
+
+    void processBatch(Span<const watcher::EnrichedEvent> events, Span<ProcessorResponse> responses,
+                      AnnotationArena& annotations) override {
+        views_.resize(events.size());
+        ids_.clear();
+        for (const auto& event : events) {
+            for (const auto& id : event.variable_ids) {
+                ids_.push_back(id.c_str());
+            }
+        }
+        size_t next_id = 0;
+        for (size_t i = 0; i < events.size(); ++i) {
+            const watcher::EnrichedEvent& event = events[i];
+            watcher_event_view& view = views_[i];
+            view.event_seq = event.event_seq;
+            view.ts_ns = event.ts_ns;
+            view.ip = event.ip;
+            view.page_base = reinterpret_cast<uintptr_t>(event.page_base);
+            view.fault_addr = reinterpret_cast<uintptr_t>(event.fault_addr);
+            view.tid = static_cast<uint32_t>(event.tid);
+            view.variable_index = event.variable_index;
+            view.line = event.line;
+            view.variable_count = static_cast<uint32_t>(event.variable_ids.size());
+            view.symbol = event.symbol.c_str();
+            view.file = event.file.c_str();
+            view.variable_name = event.variable_name.c_str();
+            view.sql_context_id = event.sql_context_id.c_str();
+            view.variable_ids = ids_.data() + next_id;
+            next_id += event.variable_ids.size();
+            // DeltaRun and watcher_delta_run share one layout
+            view.deltas = reinterpret_cast<const watcher_delta_run*>(event.deltas.runs.data());
+            view.delta_count = static_cast<uint32_t>(event.deltas.runs.size());
+            view.reserved = 0;
+            view.delta_arena = event.deltas.arena.data();
+        }
+
+        actions_.assign(events.size(), WATCHER_ACTION_PASS);
+        watcher_processor_host host{};
+        host.abi_version = WATCHER_PROCESSOR_ABI_VERSION;
+        host.context = &annotations;
+        host.annotate_int = [](void* context, uint32_t event, const char* key, int64_t value) {
+            static_cast<AnnotationArena*>(context)->addInt(event, key, value);
+        };
+        host.annotate_double = [](void* context, uint32_t event, const char* key, double value) {
+            static_cast<AnnotationArena*>(context)->addDouble(event, key, value);
+        };
+        host.annotate_string = [](void* context, uint32_t event, const char* key, const char* value,
+                                  size_t length) {
+            static_cast<AnnotationArena*>(context)->addString(event, key, std::string_view(value, length));
+        };
+        api_->process_batch(state_, views_.data(), views_.size(), actions_.data(), &host);
+
+        for (size_t i = 0; i < events.size(); ++i) {
+            responses[i].action = actionFromAbi(actions_[i]);
+        }
+    }
+
+private:
+    void* handle_;
+    const watcher_processor_api* api_;
+    void* state_;
+    std::vector<watcher_event_view> views_;
+    std::vector<const char*> ids_;
+    std::vector<uint8_t> actions_;
+};
+
+static_assert(sizeof(watcher_delta_run) == sizeof(watcher::DeltaRun) &&
+              offsetof(watcher_delta_run, arena_offset) == offsetof(watcher::DeltaRun, arena_offset),
+              "watcher_delta_run mirrors DeltaRun");
+
+}  // namespace
+
 // ============================================================================
 // Processor Factory
 // ============================================================================
 
-std::unique_ptr<CustomProcessor> ProcessorFactory::createPythonProcessor(const std::string& script_path) {
-    // Placeholder - will be implemented in next phase
-    return std::make_unique<NoOpProcessor>();
+// createPythonProcessor: python_host.cpp
+// createJavaScriptProcessor: javascript_host.cpp
+
+std::unique_ptr<CustomProcessor> ProcessorFactory::createNativeProcessor(const std::string& library_path,
+                                                                         const std::string& config,
+                                                                         std::string* error) {
+    auto fail = [&](const std::string& reason) -> std::unique_ptr<CustomProcessor> {
+        if (error) {
+            *error = reason;
+        }
+        return nullptr;
+    };
+
+    void* handle = dlopen(library_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        const char* reason = dlerror();
+        return fail(reason ? reason : "Cannot load " + library_path);
+    }
+    auto entry = reinterpret_cast<watcher_processor_entry_fn>(dlsym(handle, WATCHER_PROCESSOR_ENTRY));
+    const watcher_processor_api* api = entry ? entry() : nullptr;
+    if (!api || !api->process_batch) {
+        dlclose(handle);
+        return fail(library_path + " does not export " + WATCHER_PROCESSOR_ENTRY);
+    }
+    if (api->abi_version == 0 || api->abi_version > WATCHER_PROCESSOR_ABI_VERSION) {
+        dlclose(handle);
+        return fail(library_path + " needs processor ABI version " + std::to_string(api->abi_version));
+    }
+    void* state = nullptr;
+    if (api->create && !(state = api->create(config.c_str()))) {
+        dlclose(handle);
+        return fail(library_path + " rejected its configuration");
+    }
+    return std::make_unique<NativeProcessor>(handle, api, state);
 }
 
-std::unique_ptr<CustomProcessor> ProcessorFactory::createJavaScriptProcessor(const std::string& script_path) {
-    // Placeholder - will be implemented in next phase
-    return std::make_unique<NoOpProcessor>();
+// ============================================================================
+// Core Integration
+// ============================================================================
+
+void installProcessor(std::shared_ptr<CustomProcessor> processor) {
+    auto& core = watcher::WatcherCore::getInstance();
+    if (!processor) {
+        core.setBatchProcessor(nullptr);
+        return;
+    }
+
+    // Scratch reused across batches (the core calls the hook from its one
+    // slow-path thread)
+    struct Installed {
+        std::shared_ptr<CustomProcessor> processor;
+        std::vector<ProcessorResponse> responses;
+        AnnotationArena annotations;
+    };
+    auto installed = std::make_shared<Installed>();
+    installed->processor = std::move(processor);
+    core.setBatchProcessor([installed](watcher::EnrichedEvent* events, size_t count, uint8_t* keep) {
+        installed->responses.assign(count, ProcessorResponse{});
+        installed->annotations.clear();
+        installed->processor->processBatch(Span<const watcher::EnrichedEvent>(events, count),
+                                           installed->responses, installed->annotations);
+        for (size_t i = 0; i < count; ++i) {
+            keep[i] = installed->responses[i].action != ProcessorAction::DROP;
+        }
+    });
 }
 
 }  // namespace watcher::processor
@@ -0,0 +1,88 @@
+#include "processor_batch.hpp"
+#include <cstring>
+
+namespace watcher::processor {
+
+// ============================================================================
+// Batch Packing
+// ============================================================================
+
+uint32_t ProcessorBatchPacker::intern(std::string_view s) {
+    if (s.empty()) {
+        return 0;
+    }
+    auto found = refs_.find(s);
+    if (found != refs_.end()) {
+        return found->second;
+    }
+    uint32_t offset = static_cast<uint32_t>(strings_.size());
+    strings_.insert(strings_.end(), s.begin(), s.end());
+    strings_.push_back('\0');
+    refs_.emplace(s, offset);
+    return offset;
+}
+
+const std::vector<uint8_t>& ProcessorBatchPacker::pack(Span<const watcher::EnrichedEvent> events) {
+    size_t n = events.size();
+    strings_.assign(1, '\0');
+    deltas_.clear();
+    refs_.clear();
+
+    ProcessorBatchHeader header{};
+    header.magic = PROCESSOR_BATCH_MAGIC;
+    header.count = static_cast<uint32_t>(n);
+    header.records_offset = sizeof(ProcessorBatchHeader);
+    header.text_offset = header.records_offset + static_cast<uint32_t>(n * sizeof(BinaryEventRecord));
+    header.strings_offset = header.text_offset + static_cast<uint32_t>(n * sizeof(ProcessorEventText));
+    buffer_.resize(header.strings_offset);
+
+    auto* records = reinterpret_cast<BinaryEventRecord*>(buffer_.data() + header.records_offset);
+    auto* text = reinterpret_cast<ProcessorEventText*>(buffer_.data() + header.text_offset);
+    for (size_t i = 0; i < n; ++i) {
+        const watcher::EnrichedEvent& event = events[i];
+        BinaryEventRecord& record = records[i];
+        record.event_seq = event.event_seq;
+        record.ts_ns = event.ts_ns;
+        record.page_base = reinterpret_cast<uintptr_t>(event.page_base);
+        record.fault_addr = reinterpret_cast<uintptr_t>(event.fault_addr);
+        record.ip = event.ip;
+        record.tid = static_cast<uint32_t>(event.tid);
+        record.var_index = event.variable_index;
+        record.var_count = static_cast<uint32_t>(event.variable_ids.size());
+        record.delta_runs = static_cast<uint32_t>(event.deltas.size());
+        record.delta_bytes = static_cast<uint32_t>(event.deltas.changedBytes());
+        record.flags = 0;
+
+        ProcessorEventText& t = text[i];
+        t.symbol = intern(event.symbol);
+        t.file = intern(event.file);
+        t.variable_name = intern(event.variable_name);
+        t.sql_context_id = intern(event.sql_context_id);
+        // Ids are stored back to back, even when repeated, so var_count
+        // strings from variable_ids name them
+        t.variable_ids = static_cast<uint32_t>(strings_.size());
+        for (const auto& id : event.variable_ids) {
+            strings_.insert(strings_.end(), id.begin(), id.end());
+            strings_.push_back('\0');
+        }
+        t.deltas = static_cast<uint32_t>(deltas_.size());
+        t.line = event.line;
+        t.reserved = 0;
+        for (const DeltaRun& run : event.deltas.runs) {
+            uint32_t fields[2] = {run.offset, run.length};
+            const auto* bytes = reinterpret_cast<const uint8_t*>(fields);
+            deltas_.insert(deltas_.end(), bytes, bytes + sizeof(fields));
+            const uint8_t* old_bytes = event.deltas.oldBytes(run);
+            deltas_.insert(deltas_.end(), old_bytes, old_bytes + 2 * size_t(run.length));  // old, then new
+        }
+    }
+
+    header.deltas_offset = header.strings_offset + static_cast<uint32_t>(strings_.size());
+    header.size = header.deltas_offset + static_cast<uint32_t>(deltas_.size());
+    buffer_.insert(buffer_.end(), strings_.begin(), strings_.end());
+    buffer_.insert(buffer_.end(), deltas_.begin(), deltas_.end());
+    memcpy(buffer_.data(), &header, sizeof(header));
+    return buffer_;
+}
+
+}  // namespace watcher::processor
@@ -0,0 +1,323 @@
+#ifdef WATCHER_HAVE_PYTHON
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#endif
+
+#include "processor.hpp"
+#include "processor_batch.hpp"
+#include "watcher_processor_abi.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace watcher::processor {
+
+#ifdef WATCHER_HAVE_PYTHON
+
+// ============================================================================
+// Embedded Python Host
+// ============================================================================
+
+namespace {
+
+/// Start an interpreter unless this process already runs one (the adapter
+/// is usually loaded into Python through ctypes); threads then enter it
+/// with PyGILState_Ensure()
+void ensureInterpreter() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        if (!Py_IsInitialized()) {
+            Py_InitializeEx(0);
+            PyEval_SaveThread();
+        }
+    });
+}
+
+/// Message of the pending Python exception, which is cleared
+std::string takePythonError() {
+    PyObject *type = nullptr, *value = nullptr, *traceback = nullptr;
+    PyErr_Fetch(&type, &value, &traceback);
+    PyErr_NormalizeException(&type, &value, &traceback);
+    std::string message = "Python error";
+    PyObject* text = value ? PyObject_Str(value) : nullptr;
+    const char* utf8 = text ? PyUnicode_AsUTF8(text) : nullptr;
+    if (utf8) {
+        message = utf8;
+    }
+    PyErr_Clear();
+    Py_XDECREF(text);
+    Py_XDECREF(type);
+    Py_XDECREF(value);
+    Py_XDECREF(traceback);
+    return message;
+}
+
+/// Copy {key: value} into the arena: bool/int, float, str (else str(value))
+void addAnnotations(PyObject* dict, uint32_t event, AnnotationArena& annotations) {
+    PyObject *key, *value;
+    Py_ssize_t pos = 0;
+    while (PyDict_Next(dict, &pos, &key, &value)) {
+        const char* name = PyUnicode_Check(key) ? PyUnicode_AsUTF8(key) : nullptr;
+        if (!name) {
+            PyErr_Clear();
+            continue;
+        }
+        if (PyLong_Check(value)) {
+            int overflow = 0;
+            long long v = PyLong_AsLongLongAndOverflow(value, &overflow);
+            if (!overflow) {
+                annotations.addInt(event, name, v);
+                continue;
+            }
+        } else if (PyFloat_Check(value)) {
+            annotations.addDouble(event, name, PyFloat_AsDouble(value));
+            continue;
+        }
+        PyObject* text = PyUnicode_Check(value) ? (Py_INCREF(value), value) : PyObject_Str(value);
+        Py_ssize_t len = 0;
+        const char* utf8 = text ? PyUnicode_AsUTF8AndSize(text, &len) : nullptr;
+        if (utf8) {
+            annotations.addString(event, name, std::string_view(utf8, static_cast<size_t>(len)));
+        } else {
+            PyErr_Clear();
+        }
+        Py_XDECREF(text);
+    }
+}
+
+/// Runs a script's processor on one interpreter thread. The slow-path
+/// thread packs a batch, hands it over and waits until the batch deadline;
+/// the interpreter thread takes the GIL once for the whole batch. A batch
+/// is only handed over once the previous one finished, so a slow script
+/// holds the slow path back by at most the deadline per batch.
+class PythonProcessor : public ScriptProcessor {
+public:
+    static std::unique_ptr<PythonProcessor> load(const std::string& script_path,
+                                                 const ScriptProcessorOptions& options, std::string& error) {
+        std::unique_ptr<PythonProcessor> processor(new PythonProcessor(options));
+        auto state = processor->state_;
+        state->script_path = script_path;
+        std::thread(&PythonProcessor::interpreterLoop, state).detach();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        if (!state->cv.wait_for(lock, options.load_timeout, [&] { return state->loaded; })) {
+            error = script_path + " did not load within " + std::to_string(options.load_timeout.count()) + " ms";
+            return nullptr;
+        }
+        if (!state->error.empty()) {
+            error = state->error;
+            return nullptr;
+        }
+        return processor;
+    }
+
+    ~PythonProcessor() override {
+        // The thread exits after its current batch; it owns a reference to
+        // the state, so a script stuck in a batch only leaks that thread
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->stop = true;
+        state_->cv.notify_all();
+    }
+
+    void processBatch(Span<const watcher::EnrichedEvent> events, Span<ProcessorResponse> responses,
+                      AnnotationArena& annotations) override {
+        if (events.empty()) {
+            return;
+        }
+        auto deadline = std::chrono::steady_clock::now() + options_.batch_deadline;
+        State& s = *state_;
+        std::unique_lock<std::mutex> lock(s.mutex);
+        if (!s.cv.wait_until(lock, deadline, [&] { return s.completed == s.submitted; })) {
+            deadline_misses_.fetch_add(1);
+            return;
+        }
+
+        s.buffer = packer_.pack(events);
+        s.count = events.size();
+        s.actions.assign(events.size(), WATCHER_ACTION_PASS);
+        s.annotations.clear();
+        s.failed = false;
+        uint64_t ticket = ++s.submitted;
+        s.cv.notify_all();
+        if (!s.cv.wait_until(lock, deadline, [&] { return s.completed == ticket; })) {
+            deadline_misses_.fetch_add(1);
+            return;
+        }
+
+        batches_.fetch_add(1);
+        if (s.failed) {
+            failures_.fetch_add(1);
+            return;
+        }
+        for (size_t i = 0; i < events.size(); ++i) {
+            responses[i].action = actionFromAbi(s.actions[i]);
+        }
+        for (const auto& a : s.annotations.entries()) {
+            switch (a.type) {
+            case AnnotationType::INT: annotations.addInt(a.event, s.annotations.key(a), a.int_value); break;
+            case AnnotationType::DOUBLE: annotations.addDouble(a.event, s.annotations.key(a), a.double_value); break;
+            case AnnotationType::STRING:
+                annotations.addString(a.event, s.annotations.key(a), s.annotations.text(a));
+                break;
+            }
+        }
+    }
+
+private:
+    /// Shared with the interpreter thread; guarded by mutex
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::string script_path;
+        bool loaded = false;
+        bool stop = false;
+        std::string error;              // Load failure
+
+        // Current batch; owned by the interpreter thread while
+        // completed != submitted
+        std::vector<uint8_t> buffer;
+        size_t count = 0;
+        std::vector<uint8_t> actions;
+        AnnotationArena annotations;
+        bool failed = false;
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+    };
+
+    explicit PythonProcessor(const ScriptProcessorOptions& options)
+        : options_(options), state_(std::make_shared<State>()) {}
+
+    static void interpreterLoop(std::shared_ptr<State> state) {
+        ensureInterpreter();
+        PyGILState_STATE gil = PyGILState_Ensure();
+        PyObject* host = loadHost();
+        PyObject* handler = host ? PyObject_CallMethod(host, "load", "s", state->script_path.c_str()) : nullptr;
+        PyObject* run_batch = handler ? PyObject_GetAttrString(host, "run_batch") : nullptr;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!run_batch) {
+                state->error = state->script_path + ": " + takePythonError();
+            }
+            state->loaded = true;
+            state->cv.notify_all();
+        }
+        PyGILState_Release(gil);
+
+        while (run_batch) {
+            {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                state->cv.wait(lock, [&] { return state->stop || state->submitted != state->completed; });
+                if (state->stop) {
+                    break;
+                }
+            }
+            // The slow-path thread leaves the batch alone until completed
+            // catches up, so it is read here without the lock
+            gil = PyGILState_Ensure();
+            bool ok = runBatch(run_batch, handler, *state);
+            PyGILState_Release(gil);
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->failed = !ok;
+            state->completed = state->submitted;
+            state->cv.notify_all();
+        }
+
+        gil = PyGILState_Ensure();
+        Py_XDECREF(run_batch);
+        Py_XDECREF(handler);
+        Py_XDECREF(host);
+        PyGILState_Release(gil);
+    }
+
+    /// Import watcher.core.processor_host, from the source tree if the
+    /// watcher package is not on sys.path
+    static PyObject* loadHost() {
+        PyObject* host = PyImport_ImportModule("watcher.core.processor_host");
+#ifdef WATCHER_PYTHON_ROOT
+        if (!host) {
+            PyErr_Clear();
+            PyObject* path = PySys_GetObject("path");  // Borrowed
+            PyObject* root = PyUnicode_FromString(WATCHER_PYTHON_ROOT);
+            if (path && root && PyList_Insert(path, 0, root) == 0) {
+                host = PyImport_ImportModule("watcher.core.processor_host");
+            }
+            Py_XDECREF(root);
+        }
+#endif
+        return host;
+    }
+
+    /// One batch, GIL held: run_batch(handler, batch view, actions view)
+    /// returns [(event, {key: value}), ...]
+    static bool runBatch(PyObject* run_batch, PyObject* handler, State& s) {
+        PyObject* batch = PyMemoryView_FromMemory(reinterpret_cast<char*>(s.buffer.data()),
+                                                  static_cast<Py_ssize_t>(s.buffer.size()), PyBUF_READ);
+        PyObject* actions = PyMemoryView_FromMemory(reinterpret_cast<char*>(s.actions.data()),
+                                                    static_cast<Py_ssize_t>(s.actions.size()), PyBUF_WRITE);
+        PyObject* result = batch && actions ? PyObject_CallFunctionObjArgs(run_batch, handler, batch, actions, nullptr)
+                                            : nullptr;
+        bool ok = result != nullptr;
+        if (ok && PyList_Check(result)) {
+            for (Py_ssize_t i = 0; i < PyList_GET_SIZE(result); ++i) {
+                PyObject* item = PyList_GET_ITEM(result, i);
+                if (PyTuple_Check(item) && PyTuple_GET_SIZE(item) == 2 && PyDict_Check(PyTuple_GET_ITEM(item, 1))) {
+                    size_t event = PyLong_AsSize_t(PyTuple_GET_ITEM(item, 0));
+                    if (!PyErr_Occurred() && event < s.count) {
+                        addAnnotations(PyTuple_GET_ITEM(item, 1), static_cast<uint32_t>(event), s.annotations);
+                    }
+                    PyErr_Clear();
+                }
+            }
+        }
+        if (!ok) {
+            PyErr_Print();  // The script's traceback, once per failed batch
+        }
+
+        // Views into reused buffers must not outlive the call
+        for (PyObject* view : {batch, actions}) {
+            if (view) {
+                PyObject* released = PyObject_CallMethod(view, "release", nullptr);
+                if (!released) {
+                    PyErr_Clear();
+                }
+                Py_XDECREF(released);
+                Py_DECREF(view);
+            }
+        }
+        Py_XDECREF(result);
+        return ok;
+    }
+
+    ScriptProcessorOptions options_;
+    std::shared_ptr<State> state_;
+    ProcessorBatchPacker packer_;
+};
+
+}  // namespace
+
+std::unique_ptr<CustomProcessor> ProcessorFactory::createPythonProcessor(const std::string& script_path,
+                                                                         const ScriptProcessorOptions& options,
+                                                                         std::string* error) {
+    std::string reason;
+    auto processor = PythonProcessor::load(script_path, options, reason);
+    if (!processor && error) {
+        *error = reason;
+    }
+    return processor;
+}
+
+#else
+
+std::unique_ptr<CustomProcessor> ProcessorFactory::createPythonProcessor(const std::string& script_path,
+                                                                         const ScriptProcessorOptions&,
+                                                                         std::string* error) {
+    if (error) {
+        *error = "Cannot run " + script_path + ": built without Python (WATCHER_HAVE_PYTHON)";
+    }
+    return nullptr;
+}
+
+#endif
+
+}  // namespace watcher::processor
@@ -5,13 +5,20 @@
  * 1. Zero-copy operations using direct pointer arithmetic
  * 2. Cache-line aligned structures (64-byte alignment)
  * 3. Prefetching hints for predictable access patterns
- * 4. Lock-free reads using atomic operations
+ * 4. Lock-free reads alongside a single writer: readers see published
+ *    views (mapping + index) reclaimed by epoch, never a slot being reused
  * 5. Batch write buffering to reduce syscalls
  * 6. SIMD-accelerated memory operations where possible
  * 7. Huge pages support for reduced TLB misses
  * 8. Direct I/O bypass for initial allocation
- * 9. Custom high-performance hash table with open addressing
+ * 9. Flat SwissTable-style index: SIMD-probed tag bytes, short keys inline
  * 10. Eliminated all bounds checking in hot paths
+ * 11. Index checkpointed to a sidecar file and mapped at open; only the
+ *     log tail written after the checkpoint is replayed
+ * 12. CRC32C record checksums (SSE4.2 / ARMv8 CRC instructions) and a
+ *     checksummed commit marker; durability is selectable per handle
+ * 13. Mapping policy (populate, mlock, huge pages, advice, read-only) chosen
+ *     at open; by default pages are faulted in just ahead of the writes
  */
 
 #define _GNU_SOURCE
@@ -25,6 +32,12 @@
 #include <stdio.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "faststorage.h"
 
 #ifdef __linux__
 #include <linux/falloc.h>
@@ -36,6 +49,12 @@
 #include <immintrin.h>  // AVX if available
 #endif
 
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>  // crc32
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
 /* ============================================================================
  * Constants and Configuration
  * ============================================================================ */
@@ -46,8 +65,27 @@
 #define HUGE_PAGE_SIZE (2 * 1024 * 1024)
 #define CACHE_LINE_SIZE 64
 #define PREFETCH_DISTANCE 8     // Prefetch 8 cache lines ahead
-#define WRITE_BUFFER_SIZE 8192  // Buffer small writes
-#define HASH_TABLE_LOAD_FACTOR 0.7
+#define BATCH_CHUNK 16          // Batch keys hashed and prefetched ahead of their probes
+#define COMPACT_MIN_DEAD (1024 * 1024)  // Dead bytes before growth tries compaction first
+#define RECORD_TOMBSTONE 1u     // record_header_t.reserved flag: key removed
+#define RECORD_CHECKSUMMED 2u   // record_header_t.reserved flag: checksum is valid
+#define HEADER_COMMIT 1         // Log header word: end of the committed log
+#define HEADER_GENERATION 5     // Log header word identifying this log's contents
+#define HEADER_COMMIT_CHECK 6   // Log header word: checksum of COMMIT (0 in older logs)
+#define WRITEBACK_CHUNK (1024 * 1024)   // FAST_STORAGE_ASYNC starts writeback this often
+#define GROUP_COMMIT_INTERVAL_MS 10     // FAST_STORAGE_GROUP default interval
+#define POPULATE_AHEAD (2 * 1024 * 1024)  // Default fast_storage_options_t.populate_ahead
+#define LEGACY_MAX_KEY 10000    // Sanity bound for records written without a checksum
+#define CHECKPOINT_MAGIC 0xFDB1C0DE
+#define CHECKPOINT_VERSION 2
+#define CHECKPOINT_SUFFIX ".idx"
+#define MAX_READERS 64          // Concurrent reader slots; more readers share an overflow count
+
+#define INDEX_GROUP_SIZE 16         // Control bytes probed per SIMD compare
+#define INDEX_INLINE_KEY 16         // Keys up to this length are stored in the slot
+#define INDEX_INITIAL_CAPACITY 1024 // Slots; power of two, multiple of INDEX_GROUP_SIZE
+#define CTRL_EMPTY ((uint8_t)0x80)
+#define CTRL_DELETED ((uint8_t)0xFE)
 
 /* Force alignment to cache line boundaries */
 #define ALIGNED(x) __attribute__((aligned(x)))
@@ -70,44 +108,139 @@ typedef struct PACKED {
     uint32_t magic;
     uint32_t key_len;
     uint64_t value_len;
-    uint32_t checksum;      // For integrity checking
-    uint32_t reserved;      // Padding to 24 bytes
+    uint32_t checksum;      // CRC32C, see record_checksum()
+    uint32_t reserved;      // Record flags (RECORD_TOMBSTONE, RECORD_CHECKSUMMED)
 } record_header_t;
 
-/* Hash table entry with open addressing */
+/* Index slot - two per cache line, read only after a tag match */
+typedef struct ALIGNED(32) {
+    uint64_t offset;                // Record offset in file
+    uint32_t key_len;
+    uint32_t hash_lo;               // Low hash bits; screens long keys before the record is touched
+    char key[INDEX_INLINE_KEY];     // Inline copy of short keys
+} index_slot_t;
+
+/*
+ * Flat open-addressing index (SwissTable layout). One control byte per slot
+ * holds a 7-bit hash tag, CTRL_EMPTY or CTRL_DELETED; a lookup compares a
+ * whole 16-byte group of tags at once and reads a slot only on a tag match.
+ * Control bytes and slots sit in one allocation after this header.
+ */
 typedef struct CACHE_ALIGNED {
-    uint64_t hash;          // Full hash for faster comparison
-    uint64_t offset;        // Offset in file
-    uint32_t key_len;       // Key length
-    uint32_t tombstone;     // Deletion marker
-    char key[0];            // Flexible array member for inline key storage
-} hash_entry_t;
+    size_t capacity;        // Slots (power of two, >= INDEX_GROUP_SIZE)
+    size_t count;           // Live keys
+    size_t tombstones;      // CTRL_DELETED slots
+    uint8_t *ctrl;          // capacity control bytes, 64-byte aligned
+    index_slot_t *slots;    // capacity slots
+    size_t mapped_size;     // Nonzero: block is a private mapping of a checkpoint
+} flat_index_t;
 
-/* Main storage structure */
+/*
+ * Sidecar checkpoint (<path>.idx): this page, then the index block exactly
+ * as index_alloc() lays it out. The block is mapped MAP_PRIVATE at open and
+ * used in place; pages are copied only when written.
+ */
+typedef struct {
+    uint64_t magic;
+    uint64_t version;
+    uint64_t generation;    // Log the index belongs to (log header word)
+    uint64_t log_offset;    // Records before this offset are in the index
+    uint64_t capacity;
+    uint64_t count;
+    uint64_t tombstones;
+    uint64_t live_bytes;
+    uint64_t dead_bytes;
+    uint64_t block_size;    // Bytes of index block after the header page
+    uint64_t index_crc;     // CRC32C of the index block
+} checkpoint_header_t;
+
+/*
+ * What readers see. The writer mutates the current index in place only in
+ * reader-safe ways (slot body before its control byte, offsets as single
+ * stores, slots never reused); anything else - rehash, growth into a new
+ * mapping, compaction - builds a replacement and publishes a new view.
+ */
+typedef struct {
+    uint8_t *log;
+    size_t file_size;
+    flat_index_t *index;
+} storage_view_t;
+
+/* One in-flight reader. Claimed per read (or pin), so reads are counted
+ * without sharing a cache line between threads */
 typedef struct CACHE_ALIGNED {
+    uint64_t epoch;     // 0: free, else the epoch the reader entered in
+    uint64_t reads;     // Written only by the slot's current holder
+} reader_slot_t;
+
+enum { RETIRE_VIEW, RETIRE_INDEX, RETIRE_MAPPING };
+
+/* Replaced by the writer; released once no reader can still hold it */
+typedef struct {
+    void *ptr;
+    size_t size;
+    uint64_t epoch;
+    int kind;
+} retired_t;
+
+/* Main storage structure */
+struct CACHE_ALIGNED fast_storage {
     int fd;
     uint8_t *mmap_ptr;
     size_t file_size;
+    size_t min_size;        // Size requested at create; floor for compaction
+    char *path;             // Needed to swap in a compacted segment
     
-    /* Hash table with open addressing */
-    hash_entry_t **hash_table;
-    size_t hash_capacity;
-    size_t hash_count;
+    /* Key -> record offset */
+    flat_index_t *index;
     
     uint64_t next_free_offset;
+    uint64_t generation;        // Changes whenever the log is rewritten
+    uint64_t checkpoint_offset; // Log offset the sidecar index covers (0: none)
+    uint64_t replayed;          // Records replayed at open
+    uint64_t recovered;         // Of those, records past the commit marker
+    
+    /* Commit protocol. The group committer thread shares only what
+     * commit_lock guards: the mapping, generation and the offsets below */
+    fast_storage_durability_t durability;
+    unsigned commit_interval_ms;
+    uint64_t committed_offset;  // Commit marker last written to the header
+    uint64_t synced_offset;     // Log known durable up to here
+    uint64_t writeback_offset;  // FAST_STORAGE_ASYNC: writeback started up to here
+    uint64_t syncs;
+    pthread_mutex_t commit_lock;
+    pthread_cond_t commit_wake;
+    pthread_t committer;
+    bool committer_running;
+    bool committer_stop;
+    
+    /* Performance counters (reads live in the reader slots) */
+    uint64_t write_count;
     
-    /* Write buffer for batching */
-    uint8_t write_buffer[WRITE_BUFFER_SIZE];
-    size_t write_buffer_pos;
+    /* Log accounting */
+    uint64_t live_bytes;    // Records reachable through the index
+    uint64_t dead_bytes;    // Overwritten, removed and tombstone records
+    uint64_t compactions;
+    uint64_t grows;
     
-    /* Performance counters */
-    uint64_t read_count;
-    uint64_t write_count;
+    /* Mapping policy */
+    fast_storage_options_t options;
+    uint64_t populated_offset;  // Pages below are faulted in (UINT64_MAX: not tracked)
     
     /* Flags */
     bool dirty;
     bool use_huge_pages;
-} fast_storage_t;
+    
+    /* Concurrent readers. Everything above is the writer's own state */
+    storage_view_t *view;       // Current view, published seq_cst
+    uint64_t epoch;             // Bumped on every retire; starts at 1
+    uint64_t overflow_readers;  // Readers that found every slot taken
+    uint64_t overflow_reads;
+    retired_t *retired;
+    size_t retired_count;
+    size_t retired_capacity;
+    reader_slot_t readers[MAX_READERS];
+};
 
 /* ============================================================================
  * High-Performance Hash Function (XXHash-inspired)
@@ -185,6 +318,81 @@ static HOT uint64_t fast_hash(const char *key, size_t len) {
     return h;
 }
 
+/* ============================================================================
+ * CRC32C (Castagnoli) - SSE4.2 / ARMv8 CRC instructions, table fallback
+ * ============================================================================ */
+
+#if !defined(__SSE4_2__) && !defined(__ARM_FEATURE_CRC32)
+static uint32_t crc32c_table[256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+static void crc32c_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0x82F63B78u & -(c & 1));
+        crc32c_table[i] = c;
+    }
+}
+#endif
+
+static HOT uint32_t crc32c_update(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = data;
+#if defined(__SSE4_2__) && defined(__x86_64__)
+    uint64_t c = crc;
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        c = _mm_crc32_u64(c, word);
+    }
+    crc = (uint32_t)c;
+    for (; len; p++, len--) crc = _mm_crc32_u8(crc, *p);
+#elif defined(__SSE4_2__)
+    for (; len >= 4; p += 4, len -= 4) {
+        uint32_t word;
+        memcpy(&word, p, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; len; p++, len--) crc = _mm_crc32_u8(crc, *p);
+#elif defined(__ARM_FEATURE_CRC32)
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+    for (; len; p++, len--) crc = __crc32cb(crc, *p);
+#else
+    pthread_once(&crc32c_once, crc32c_init);
+    for (; len; p++, len--) crc = crc32c_table[(crc ^ *p) & 0xFF] ^ (crc >> 8);
+#endif
+    return crc;
+}
+
+/*
+ * Covers the header (except the checksum itself), key and value, seeded with
+ * the log generation so records left over from an earlier log never verify
+ */
+static ALWAYS_INLINE uint32_t record_checksum(uint64_t generation, const record_header_t *hdr,
+                                              const void *key, const void *value) {
+    uint32_t crc = crc32c_update(~0u, &generation, sizeof(generation));
+    crc = crc32c_update(crc, hdr, offsetof(record_header_t, checksum));
+    crc = crc32c_update(crc, &hdr->reserved, sizeof(hdr->reserved));
+    crc = crc32c_update(crc, key, hdr->key_len);
+    crc = crc32c_update(crc, value, hdr->value_len);
+    return ~crc;
+}
+
+static ALWAYS_INLINE bool record_verifies(uint64_t generation, const record_header_t *hdr) {
+    const char *key = (const char *)(hdr + 1);
+    return record_checksum(generation, hdr, key, key + hdr->key_len) == hdr->checksum;
+}
+
+/* Nonzero, so older logs (which leave the word 0) are told apart */
+static ALWAYS_INLINE uint64_t commit_check(uint64_t generation, uint64_t offset) {
+    uint32_t crc = crc32c_update(~0u, &generation, sizeof(generation));
+    crc = crc32c_update(crc, &offset, sizeof(offset));
+    return (1ull << 32) | (uint32_t)~crc;
+}
+
 /* ============================================================================
  * Memory Operations - SIMD Accelerated
  * ============================================================================ */
@@ -233,126 +441,404 @@ static COLD void prefault_range(uint8_t *start, size_t len) {
 }
 
 /* ============================================================================
- * Hash Table Operations - Open Addressing with Linear Probing
+ * Reader Epochs - one writer, lock-free readers
  * ============================================================================ */
 
-static ALWAYS_INLINE size_t hash_probe(uint64_t hash, size_t capacity) {
-    return hash & (capacity - 1);
+static void index_free(flat_index_t *index);
+
+static __thread unsigned reader_hint;   // Slot this thread last claimed
+
+/* The thread's pin: reads inside it reuse the pinned reader slot */
+static __thread struct {
+    const fast_storage_t *storage;
+    reader_slot_t *slot;
+    uint32_t depth;
+} pinned;
+
+/* Claim a reader slot announcing the current epoch. NULL means every slot
+ * was taken and the reader is counted in overflow_readers instead */
+static ALWAYS_INLINE reader_slot_t *reader_enter(fast_storage_t *storage) {
+    if (pinned.storage == storage) return pinned.slot;
+    
+    uint64_t epoch = __atomic_load_n(&storage->epoch, __ATOMIC_SEQ_CST);
+    for (unsigned i = 0; i < MAX_READERS; i++) {
+        unsigned index = (reader_hint + i) % MAX_READERS;
+        reader_slot_t *slot = &storage->readers[index];
+        uint64_t expected = 0;
+        if (__atomic_load_n(&slot->epoch, __ATOMIC_RELAXED) == 0 &&
+            __atomic_compare_exchange_n(&slot->epoch, &expected, epoch, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            reader_hint = index;
+            return slot;
+        }
+    }
+    __atomic_fetch_add(&storage->overflow_readers, 1, __ATOMIC_SEQ_CST);
+    return NULL;
 }
 
-static hash_entry_t *hash_entry_alloc(const char *key, size_t key_len, uint64_t hash, uint64_t offset) {
-    hash_entry_t *entry = aligned_alloc(CACHE_LINE_SIZE, sizeof(hash_entry_t) + key_len + 1);
-    if (!entry) return NULL;
-    
-    entry->hash = hash;
-    entry->offset = offset;
-    entry->key_len = key_len;
-    entry->tombstone = 0;
-    memcpy(entry->key, key, key_len);
-    entry->key[key_len] = '\0';
-    
-    return entry;
+static ALWAYS_INLINE void reader_exit(fast_storage_t *storage, reader_slot_t *slot) {
+    if (pinned.storage == storage) return;
+    if (LIKELY(slot != NULL)) {
+        __atomic_store_n(&slot->epoch, 0, __ATOMIC_RELEASE);
+    } else {
+        __atomic_fetch_sub(&storage->overflow_readers, 1, __ATOMIC_RELEASE);
+    }
 }
 
-static HOT hash_entry_t *hash_table_lookup(fast_storage_t *storage, const char *key, size_t key_len, uint64_t hash) {
-    size_t idx = hash_probe(hash, storage->hash_capacity);
-    size_t start_idx = idx;
+static ALWAYS_INLINE void reader_count(fast_storage_t *storage, reader_slot_t *slot, uint64_t reads) {
+    if (LIKELY(slot != NULL)) {
+        __atomic_store_n(&slot->reads, slot->reads + reads, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(&storage->overflow_reads, reads, __ATOMIC_RELAXED);
+    }
+}
+
+static ALWAYS_INLINE const storage_view_t *current_view(const fast_storage_t *storage) {
+    return __atomic_load_n(&storage->view, __ATOMIC_SEQ_CST);
+}
+
+static uint64_t total_reads(const fast_storage_t *storage) {
+    uint64_t reads = __atomic_load_n(&storage->overflow_reads, __ATOMIC_RELAXED);
+    for (unsigned i = 0; i < MAX_READERS; i++) {
+        reads += __atomic_load_n(&storage->readers[i].reads, __ATOMIC_RELAXED);
+    }
+    return reads;
+}
+
+static void release_retired(const retired_t *item) {
+    switch (item->kind) {
+    case RETIRE_VIEW:
+        free(item->ptr);
+        break;
+    case RETIRE_INDEX:
+        index_free(item->ptr);
+        break;
+    case RETIRE_MAPPING:
+#ifdef __linux__
+        munlock(item->ptr, item->size);
+#endif
+        munmap(item->ptr, item->size);
+        break;
+    }
+}
+
+/* True while a reader that entered at or before epoch may still run */
+static bool readers_before(const fast_storage_t *storage, uint64_t epoch) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&storage->overflow_readers, __ATOMIC_ACQUIRE)) return true;
+    for (unsigned i = 0; i < MAX_READERS; i++) {
+        uint64_t entered = __atomic_load_n(&storage->readers[i].epoch, __ATOMIC_ACQUIRE);
+        if (entered && entered <= epoch) return true;
+    }
+    return false;
+}
+
+/* Release everything no reader can still reach; all=true at destroy */
+static void reclaim(fast_storage_t *storage, bool all) {
+    if (!storage->retired_count) return;
+    
+    uint64_t oldest = UINT64_MAX;
+    if (!all) {
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&storage->overflow_readers, __ATOMIC_ACQUIRE)) return;
+        for (unsigned i = 0; i < MAX_READERS; i++) {
+            uint64_t entered = __atomic_load_n(&storage->readers[i].epoch, __ATOMIC_ACQUIRE);
+            if (entered && entered < oldest) oldest = entered;
+        }
+    }
     
-    do {
-        hash_entry_t *entry = storage->hash_table[idx];
-        
-        /* Prefetch next entry for next iteration */
-        size_t next_idx = (idx + 1) & (storage->hash_capacity - 1);
-        PREFETCH_READ(storage->hash_table[next_idx]);
-        
-        if (!entry) return NULL;  /* Empty slot, key not found */
-        
-        if (entry->tombstone) {
-            /* Skip deleted entries */
-            idx = next_idx;
-            continue;
+    size_t kept = 0;
+    for (size_t i = 0; i < storage->retired_count; i++) {
+        if (storage->retired[i].epoch < oldest) {
+            release_retired(&storage->retired[i]);
+        } else {
+            storage->retired[kept++] = storage->retired[i];
         }
-        
-        /* Fast path: compare hash first */
-        if (LIKELY(entry->hash == hash && entry->key_len == key_len)) {
-            /* Verify actual key */
-            if (LIKELY(memcmp(entry->key, key, key_len) == 0)) {
-                return entry;
-            }
+    }
+    storage->retired_count = kept;
+}
+
+/* Hand ptr to epoch reclamation; the replacement must already be published */
+static void retire(fast_storage_t *storage, void *ptr, size_t size, int kind) {
+    retired_t item = { ptr, size, __atomic_load_n(&storage->epoch, __ATOMIC_RELAXED), kind };
+    __atomic_fetch_add(&storage->epoch, 1, __ATOMIC_SEQ_CST);
+    
+    if (storage->retired_count == storage->retired_capacity) {
+        size_t capacity = storage->retired_capacity ? storage->retired_capacity * 2 : 16;
+        retired_t *grown = realloc(storage->retired, capacity * sizeof(retired_t));
+        if (!grown) {
+            /* No room to defer: wait out the readers that may hold it */
+            while (readers_before(storage, item.epoch)) sched_yield();
+            release_retired(&item);
+            return;
         }
-        
-        idx = next_idx;
-    } while (idx != start_idx);
-    
-    return NULL;
+        storage->retired = grown;
+        storage->retired_capacity = capacity;
+    }
+    storage->retired[storage->retired_count++] = item;
+    reclaim(storage, false);
 }
 
-static int hash_table_resize(fast_storage_t *storage) {
-    size_t new_capacity = storage->hash_capacity * 2;
-    hash_entry_t **new_table = calloc(new_capacity, sizeof(hash_entry_t *));
-    if (!new_table) return -1;
-    
-    /* Rehash all entries */
-    for (size_t i = 0; i < storage->hash_capacity; i++) {
-        hash_entry_t *entry = storage->hash_table[i];
-        if (!entry || entry->tombstone) continue;
-        
-        /* Find new position */
-        size_t idx = hash_probe(entry->hash, new_capacity);
-        while (new_table[idx]) {
-            idx = (idx + 1) & (new_capacity - 1);
+/* Publish the writer's mapping and index through view (preallocated so
+ * publishing cannot fail after the change it describes) */
+static void view_publish(fast_storage_t *storage, storage_view_t *view) {
+    view->log = storage->mmap_ptr;
+    view->file_size = storage->file_size;
+    view->index = storage->index;
+    
+    storage_view_t *old = storage->view;
+    __atomic_store_n(&storage->view, view, __ATOMIC_SEQ_CST);
+    if (old) retire(storage, old, 0, RETIRE_VIEW);
+}
+
+/* ============================================================================
+ * Index Operations - Flat Open Addressing with SIMD Group Probing
+ * ============================================================================ */
+
+static ALWAYS_INLINE uint8_t hash_tag(uint64_t hash) {
+    return (uint8_t)(hash & 0x7F);
+}
+
+/* Bitmask of the group's control bytes equal to value */
+static ALWAYS_INLINE uint32_t group_match(const uint8_t *group, uint8_t value) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_load_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)value)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < INDEX_GROUP_SIZE; i++) {
+        mask |= (uint32_t)(group[i] == value) << i;
+    }
+    return mask;
+#endif
+}
+
+/* Bitmask of the group's EMPTY control bytes. DELETED slots are not
+ * reused: a reader may still be comparing the old key, so they are only
+ * reclaimed by the next rehash */
+static ALWAYS_INLINE uint32_t group_match_free(const uint8_t *group) {
+    return group_match(group, CTRL_EMPTY);
+}
+
+/* Triangular probing over aligned groups visits every group once */
+static ALWAYS_INLINE size_t probe_start(const flat_index_t *index, uint64_t hash) {
+    return (size_t)(hash >> 7) & (index->capacity / INDEX_GROUP_SIZE - 1);
+}
+
+static ALWAYS_INLINE size_t probe_next(const flat_index_t *index, size_t group, size_t step) {
+    return (group + step) & (index->capacity / INDEX_GROUP_SIZE - 1);
+}
+
+/* Block layout: header, control bytes, slots; each part 64-byte aligned */
+static ALWAYS_INLINE size_t index_ctrl_offset(void) {
+    return (sizeof(flat_index_t) + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+}
+
+static ALWAYS_INLINE size_t index_slots_offset(size_t capacity) {
+    return index_ctrl_offset() + ((capacity + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1));
+}
+
+static ALWAYS_INLINE size_t index_block_size(size_t capacity) {
+    return index_slots_offset(capacity) + capacity * sizeof(index_slot_t);
+}
+
+/* Point ctrl/slots into the block; needed after mapping a checkpoint */
+static void index_bind(flat_index_t *index, size_t capacity) {
+    index->capacity = capacity;
+    index->ctrl = (uint8_t *)index + index_ctrl_offset();
+    index->slots = (index_slot_t *)((uint8_t *)index + index_slots_offset(capacity));
+}
+
+static flat_index_t *index_alloc(size_t capacity) {
+    flat_index_t *index = aligned_alloc(CACHE_LINE_SIZE, index_block_size(capacity));
+    if (!index) return NULL;
+    
+    index_bind(index, capacity);
+    index->count = 0;
+    index->tombstones = 0;
+    index->mapped_size = 0;
+    memset(index->ctrl, CTRL_EMPTY, capacity);
+    return index;
+}
+
+/* Private copy of index, for changes readers of the original must not see */
+static flat_index_t *index_clone(const flat_index_t *index) {
+    size_t size = index_block_size(index->capacity);
+    flat_index_t *copy = aligned_alloc(CACHE_LINE_SIZE, size);
+    if (!copy) return NULL;
+    
+    memcpy(copy, index, size);
+    index_bind(copy, index->capacity);
+    copy->mapped_size = 0;
+    return copy;
+}
+
+static void index_free(flat_index_t *index) {
+    if (!index) return;
+    if (index->mapped_size) {
+        munmap((uint8_t *)index - PAGE_SIZE, index->mapped_size);
+    } else {
+        free(index);
+    }
+}
+
+#define LOOKUP_STALE (-2)  // Record lies past the view's mapping: reload the view
+
+static ALWAYS_INLINE uint64_t slot_offset(const index_slot_t *slot) {
+    return __atomic_load_n(&slot->offset, __ATOMIC_ACQUIRE);
+}
+
+/* 1 on match, 0 on mismatch, LOOKUP_STALE if the record is not in log[0, log_size) */
+static ALWAYS_INLINE int slot_matches(const uint8_t *log, size_t log_size, const index_slot_t *slot,
+                                      const char *key, size_t key_len, uint64_t hash) {
+    if (slot->key_len != key_len) return 0;
+    if (key_len <= INDEX_INLINE_KEY) {
+        return memcmp(slot->key, key, key_len) == 0;
+    }
+    /* Long key: compare against the mmap'd record */
+    if (slot->hash_lo != (uint32_t)hash) return 0;
+    uint64_t offset = slot_offset(slot);
+    if (UNLIKELY(offset + sizeof(record_header_t) + key_len > log_size)) return LOOKUP_STALE;
+    return memcmp(log + offset + sizeof(record_header_t), key, key_len) == 0;
+}
+
+/* Returns the slot holding key, -1, or LOOKUP_STALE. Safe against the
+ * writer's concurrent in-place changes */
+static HOT ssize_t index_lookup(const flat_index_t *index, const uint8_t *log, size_t log_size,
+                                const char *key, size_t key_len, uint64_t hash) {
+    uint8_t tag = hash_tag(hash);
+    size_t group = probe_start(index, hash);
+    
+    for (size_t step = 1; step <= index->capacity / INDEX_GROUP_SIZE; step++) {
+        const uint8_t *ctrl = index->ctrl + group * INDEX_GROUP_SIZE;
+        uint32_t match = group_match(ctrl, tag);
+        /* Pairs with the release store that published each control byte */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        while (match) {
+            size_t slot = group * INDEX_GROUP_SIZE + __builtin_ctz(match);
+            int matched = slot_matches(log, log_size, &index->slots[slot], key, key_len, hash);
+            if (LIKELY(matched > 0)) {
+                return (ssize_t)slot;
+            }
+            if (UNLIKELY(matched == LOOKUP_STALE)) return LOOKUP_STALE;
+            match &= match - 1;
         }
-        new_table[idx] = entry;
+        /* A group with an EMPTY byte ends every probe sequence through it */
+        if (LIKELY(group_match(ctrl, CTRL_EMPTY))) return -1;
+        group = probe_next(index, group, step);
+    }
+    return -1;
+}
+
+/* Place a key known to be absent; the index must have a free slot */
+static void index_place(flat_index_t *index, const char *key, size_t key_len, uint64_t hash, uint64_t offset) {
+    size_t group = probe_start(index, hash);
+    size_t step = 1;
+    uint32_t free_mask;
+    while (!(free_mask = group_match_free(index->ctrl + group * INDEX_GROUP_SIZE))) {
+        group = probe_next(index, group, step++);
     }
     
-    free(storage->hash_table);
-    storage->hash_table = new_table;
-    storage->hash_capacity = new_capacity;
+    size_t slot = group * INDEX_GROUP_SIZE + __builtin_ctz(free_mask);
+    index_slot_t *entry = &index->slots[slot];
+    entry->offset = offset;
+    entry->key_len = (uint32_t)key_len;
+    entry->hash_lo = (uint32_t)hash;
+    if (key_len <= INDEX_INLINE_KEY) {
+        memcpy(entry->key, key, key_len);
+    }
     
-    return 0;
+    /* Publish: readers matching the tag see the whole slot */
+    __atomic_store_n(&index->ctrl[slot], hash_tag(hash), __ATOMIC_RELEASE);
+    __atomic_store_n(&index->count, index->count + 1, __ATOMIC_RELAXED);
+}
+
+/* The writer's index always covers its own mapping, so never LOOKUP_STALE */
+static ALWAYS_INLINE ssize_t writer_lookup(const fast_storage_t *storage, const char *key, size_t key_len,
+                                           uint64_t hash) {
+    return index_lookup(storage->index, storage->mmap_ptr, storage->file_size, key, key_len, hash);
 }
 
-static HOT int hash_table_insert(fast_storage_t *storage, const char *key, size_t key_len, uint64_t hash, uint64_t offset) {
-    /* Check load factor */
-    if (UNLIKELY(storage->hash_count >= storage->hash_capacity * HASH_TABLE_LOAD_FACTOR)) {
-        if (hash_table_resize(storage) < 0) return -1;
+/* Rebuild at new_capacity, dropping tombstones; published as a new view */
+static COLD int index_rehash(fast_storage_t *storage, size_t new_capacity) {
+    flat_index_t *old = storage->index;
+    flat_index_t *fresh = index_alloc(new_capacity);
+    if (!fresh) return -1;
+    
+    for (size_t i = 0; i < old->capacity; i++) {
+        if (old->ctrl[i] & 0x80) continue;
+        const index_slot_t *entry = &old->slots[i];
+        const char *key = entry->key_len <= INDEX_INLINE_KEY
+            ? entry->key
+            : (const char *)storage->mmap_ptr + entry->offset + sizeof(record_header_t);
+        uint64_t hash = fast_hash(key, entry->key_len);
+        index_place(fresh, key, entry->key_len, hash, entry->offset);
     }
     
-    size_t idx = hash_probe(hash, storage->hash_capacity);
-    
-    while (1) {
-        hash_entry_t *entry = storage->hash_table[idx];
-        
-        if (!entry || entry->tombstone) {
-            /* Empty or deleted slot */
-            hash_entry_t *new_entry = hash_entry_alloc(key, key_len, hash, offset);
-            if (!new_entry) return -1;
-            
-            if (entry) free(entry);  /* Free tombstone */
-            
-            storage->hash_table[idx] = new_entry;
-            storage->hash_count++;
-            return 0;
-        }
-        
-        /* Check if updating existing key */
-        if (entry->hash == hash && entry->key_len == key_len && 
-            memcmp(entry->key, key, key_len) == 0) {
-            entry->offset = offset;
-            return 0;
-        }
-        
-        idx = (idx + 1) & (storage->hash_capacity - 1);
+    storage_view_t *view = malloc(sizeof(storage_view_t));
+    if (!view) {
+        index_free(fresh);
+        return -1;
     }
+    storage->index = fresh;
+    view_publish(storage, view);
+    retire(storage, old, 0, RETIRE_INDEX);
+    return 0;
 }
 
-static int hash_table_remove(fast_storage_t *storage, const char *key, size_t key_len, uint64_t hash) {
-    hash_entry_t *entry = hash_table_lookup(storage, key, key_len, hash);
-    if (!entry) return -1;
-    
-    /* Mark as tombstone */
-    entry->tombstone = 1;
-    storage->hash_count--;
+/* Grow once so extra more keys insert without rehashing. At least 1/8 of
+ * the slots stay EMPTY so probes stay short; when they are mostly
+ * tombstones the rehash keeps the size instead of growing. */
+static int index_reserve(fast_storage_t *storage, size_t extra) {
+    flat_index_t *index = storage->index;
+    if (LIKELY((index->count + index->tombstones + extra) * 8 <= index->capacity * 7)) return 0;
+    
+    size_t new_capacity = index->capacity;
+    while ((index->count + extra) * 8 > new_capacity * 7) new_capacity *= 2;
+    return index_rehash(storage, new_capacity);
+}
+
+/* index_insert within room made by index_reserve: never rehashes, so a
+ * record already written to the log is always applied */
+static HOT void index_insert_reserved(fast_storage_t *storage, const char *key, size_t key_len, uint64_t hash,
+                                      uint64_t offset, uint64_t *replaced) {
+    ssize_t existing = writer_lookup(storage, key, key_len, hash);
+    if (existing >= 0) {
+        /* One store: readers see the old record or the new one */
+        *replaced = storage->index->slots[existing].offset;
+        __atomic_store_n(&storage->index->slots[existing].offset, offset, __ATOMIC_RELEASE);
+        return;
+    }
+    *replaced = UINT64_MAX;
+    index_place(storage->index, key, key_len, hash, offset);
+}
+
+/* replaced receives the key's previous record offset, or UINT64_MAX */
+static int index_insert(fast_storage_t *storage, const char *key, size_t key_len, uint64_t hash,
+                        uint64_t offset, uint64_t *replaced) {
+    if (UNLIKELY(index_reserve(storage, 1) < 0)) return -1;
+    index_insert_reserved(storage, key, key_len, hash, offset, replaced);
+    return 0;
+}
+
+/* Pull in the control group a lookup for hash starts at */
+static ALWAYS_INLINE void prefetch_probe(const flat_index_t *index, uint64_t hash) {
+    PREFETCH_READ(index->ctrl + probe_start(index, hash) * INDEX_GROUP_SIZE);
+}
+
+/* removed receives the key's record offset */
+static int index_remove(fast_storage_t *storage, const char *key, size_t key_len, uint64_t hash,
+                        uint64_t *removed) {
+    ssize_t slot = writer_lookup(storage, key, key_len, hash);
+    if (slot < 0) return -1;
+    
+    /* Always DELETED, never back to EMPTY: an EMPTY slot could be refilled
+     * while a reader is still comparing its old key */
+    flat_index_t *index = storage->index;
+    *removed = index->slots[slot].offset;
+    __atomic_store_n(&index->ctrl[slot], CTRL_DELETED, __ATOMIC_RELEASE);
+    index->tombstones++;
+    __atomic_store_n(&index->count, index->count - 1, __ATOMIC_RELAXED);
     
     return 0;
 }
@@ -366,24 +852,114 @@ static COLD void update_header(fast_storage_t *storage) {
     
     uint64_t *header = (uint64_t *)storage->mmap_ptr;
     header[0] = MAGIC;
-    header[1] = storage->next_free_offset;
-    header[2] = storage->hash_count;
+    header[2] = storage->index->count;
     header[3] = storage->write_count;
-    header[4] = storage->read_count;
+    header[4] = total_reads(storage);
+    header[HEADER_GENERATION] = storage->generation;
     
     storage->dirty = false;
 }
 
-static COLD int rebuild_index(fast_storage_t *storage) {
-    uint64_t offset = HEADER_SIZE;
+/*
+ * Move the commit marker to the end of the log. With sync, the records are
+ * made durable before the marker is written and the marker after, so a
+ * marker on disk never covers records that are not. Caller holds commit_lock.
+ */
+static int storage_commit_locked(fast_storage_t *storage, bool sync) {
+    uint64_t end = __atomic_load_n(&storage->next_free_offset, __ATOMIC_ACQUIRE);
+    uint64_t *header = (uint64_t *)storage->mmap_ptr;
+    
+    if (sync && end != storage->synced_offset) {
+        size_t start = storage->synced_offset < end ? storage->synced_offset : HEADER_SIZE;
+        start &= ~(size_t)(PAGE_SIZE - 1);
+        if (end > start && msync(storage->mmap_ptr + start, end - start, MS_SYNC) == -1) return -1;
+    }
+    if (end != storage->committed_offset || header[HEADER_COMMIT] != end) {
+        header[HEADER_COMMIT] = end;
+        header[HEADER_COMMIT_CHECK] = commit_check(storage->generation, end);
+        storage->committed_offset = end;
+    }
+    if (sync && end != storage->synced_offset) {
+        if (msync(storage->mmap_ptr, PAGE_SIZE, MS_SYNC) == -1) return -1;
+        storage->synced_offset = end;
+        storage->syncs++;
+    }
+    return 0;
+}
+
+static int storage_commit(fast_storage_t *storage, bool sync) {
+    pthread_mutex_lock(&storage->commit_lock);
+    int result = storage_commit_locked(storage, sync);
+    pthread_mutex_unlock(&storage->commit_lock);
+    return result;
+}
+
+/* Per-write part of the durability mode; GROUP is left to the committer */
+static ALWAYS_INLINE int storage_after_write(fast_storage_t *storage) {
+    if (LIKELY(storage->durability == FAST_STORAGE_NONE || storage->durability == FAST_STORAGE_GROUP)) {
+        return 0;
+    }
+    if (storage->durability == FAST_STORAGE_SYNC) return storage_commit(storage, true);
+    
+    /* ASYNC: marker on every write; writeback started once a chunk is dirty */
+    if (storage_commit(storage, false) < 0) return -1;
+    uint64_t end = storage->next_free_offset;
+    if (end - storage->writeback_offset >= WRITEBACK_CHUNK) {
+        size_t start = storage->writeback_offset & ~(size_t)(PAGE_SIZE - 1);
+#ifdef __linux__
+        sync_file_range(storage->fd, start, end - start, SYNC_FILE_RANGE_WRITE);
+        sync_file_range(storage->fd, 0, PAGE_SIZE, SYNC_FILE_RANGE_WRITE);
+#else
+        msync(storage->mmap_ptr + start, end - start, MS_ASYNC);
+#endif
+        storage->writeback_offset = end;
+    }
+    return 0;
+}
+
+static ALWAYS_INLINE uint64_t record_size_at(const fast_storage_t *storage, uint64_t offset) {
+    const record_header_t *hdr = (const record_header_t *)(storage->mmap_ptr + offset);
+    return sizeof(record_header_t) + hdr->key_len + hdr->value_len;
+}
+
+/* Account for a record appended at offset that superseded replaced */
+static ALWAYS_INLINE void account_record(fast_storage_t *storage, uint64_t record_size, uint64_t replaced,
+                                         bool tombstone) {
+    if (replaced != UINT64_MAX) {
+        uint64_t old_size = record_size_at(storage, replaced);
+        storage->live_bytes -= old_size;
+        storage->dead_bytes += old_size;
+    }
+    if (tombstone) {
+        storage->dead_bytes += record_size;
+    } else {
+        storage->live_bytes += record_size;
+    }
+}
+
+/*
+ * Apply the records from offset on to the index, stopping at the first one
+ * that does not verify. Checksummed records past the commit marker (written
+ * but not yet committed when the process died) are recovered; records from
+ * before checksums are trusted only up to the marker.
+ */
+static COLD int replay_log(fast_storage_t *storage, uint64_t offset) {
     uint8_t *ptr = storage->mmap_ptr + offset;
-    uint8_t *end_ptr = storage->mmap_ptr + storage->next_free_offset;
+    uint8_t *end_ptr = storage->mmap_ptr + storage->file_size;
+    uint64_t committed = storage->committed_offset;
     
     while (ptr + sizeof(record_header_t) <= end_ptr) {
         record_header_t *hdr = (record_header_t *)ptr;
         
-        if (hdr->magic != MAGIC) break;
-        if (hdr->key_len == 0 || hdr->key_len > 10000) break;
+        if (hdr->magic != MAGIC || hdr->key_len == 0) break;
+        
+        size_t record_size = sizeof(record_header_t) + hdr->key_len + hdr->value_len;
+        if (hdr->value_len > storage->file_size || offset + record_size > storage->file_size) break;
+        if (hdr->reserved & RECORD_CHECKSUMMED) {
+            if (!record_verifies(storage->generation, hdr)) break;
+        } else if (offset >= committed || hdr->key_len > LEGACY_MAX_KEY) {
+            break;
+        }
         
         ptr += sizeof(record_header_t);
         
@@ -391,32 +967,527 @@ static COLD int rebuild_index(fast_storage_t *storage) {
         char *key = (char *)ptr;
         size_t key_len = hdr->key_len;
         
-        size_t record_size = sizeof(record_header_t) + hdr->key_len + hdr->value_len;
-        if (offset + record_size > storage->file_size) break;
-        
-        /* Compute hash and insert */
+        /* Compute hash and replay the record */
         uint64_t hash = fast_hash(key, key_len);
-        if (hash_table_insert(storage, key, key_len, hash, offset) < 0) {
+        uint64_t replaced = UINT64_MAX;
+        bool tombstone = hdr->reserved & RECORD_TOMBSTONE;
+        if (tombstone) {
+            index_remove(storage, key, key_len, hash, &replaced);
+        } else if (index_insert(storage, key, key_len, hash, offset, &replaced) < 0) {
             return -1;
         }
+        account_record(storage, record_size, replaced, tombstone);
+        storage->replayed++;
+        if (offset >= committed) storage->recovered++;
         
         offset += record_size;
         ptr += hdr->key_len + hdr->value_len;
     }
     
+    /* Anything after the last valid record is overwritten by new writes */
+    storage->next_free_offset = offset;
     return 0;
 }
 
+/* Map mapping flags used for every view of the file */
+/* Distinct per log rewrite; a checkpoint of another generation is stale */
+static uint64_t new_generation(void) {
+    static uint64_t counter;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t seed = ((uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec) ^
+                    ((uint64_t)getpid() << 40) ^ ++counter;
+    return fast_hash((const char *)&seed, sizeof(seed)) | 1;
+}
+
+static char *sidecar_path(const fast_storage_t *storage, const char *suffix) {
+    size_t path_len = strlen(storage->path);
+    size_t suffix_len = strlen(suffix);
+    char *path = malloc(path_len + suffix_len + 1);
+    if (!path) return NULL;
+    memcpy(path, storage->path, path_len);
+    memcpy(path + path_len, suffix, suffix_len + 1);
+    return path;
+}
+
+static int write_all(int fd, const void *data, size_t len, off_t offset) {
+    const uint8_t *p = data;
+    while (len > 0) {
+        ssize_t n = pwrite(fd, p, len, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+        offset += n;
+    }
+    return 0;
+}
+
+/* Write the index to <path>.idx.tmp and rename it over <path>.idx. The
+ * log is committed first: open trusts a checkpoint only up to the marker */
+static COLD int write_checkpoint(fast_storage_t *storage) {
+    if (storage_commit(storage, storage->durability != FAST_STORAGE_NONE) < 0) return -1;
+    
+    char *path = sidecar_path(storage, CHECKPOINT_SUFFIX);
+    char *tmp_path = sidecar_path(storage, CHECKPOINT_SUFFIX ".tmp");
+    int fd = -1;
+    if (!path || !tmp_path) goto fail;
+    
+    const flat_index_t *index = storage->index;
+    uint8_t page[PAGE_SIZE] = {0};
+    checkpoint_header_t *hdr = (checkpoint_header_t *)page;
+    hdr->magic = CHECKPOINT_MAGIC;
+    hdr->version = CHECKPOINT_VERSION;
+    hdr->generation = storage->generation;
+    hdr->log_offset = storage->next_free_offset;
+    hdr->capacity = index->capacity;
+    hdr->count = index->count;
+    hdr->tombstones = index->tombstones;
+    hdr->live_bytes = storage->live_bytes;
+    hdr->dead_bytes = storage->dead_bytes;
+    hdr->block_size = index_block_size(index->capacity);
+    hdr->index_crc = crc32c_update(0, index, hdr->block_size);
+    
+    fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) goto fail;
+    if (write_all(fd, page, PAGE_SIZE, 0) == -1 ||
+        write_all(fd, index, hdr->block_size, PAGE_SIZE) == -1 ||
+        fsync(fd) == -1) {
+        goto fail;
+    }
+    close(fd);
+    fd = -1;
+    if (rename(tmp_path, path) == -1) goto fail;
+    
+    storage->checkpoint_offset = storage->next_free_offset;
+    free(path);
+    free(tmp_path);
+    return 0;
+    
+fail:
+    if (fd != -1) {
+        close(fd);
+        unlink(tmp_path);
+    }
+    free(path);
+    free(tmp_path);
+    return -1;
+}
+
+/* Map a checkpoint that matches this log; NULL if absent or stale */
+static COLD flat_index_t *load_checkpoint(fast_storage_t *storage) {
+    char *path = sidecar_path(storage, CHECKPOINT_SUFFIX);
+    if (!path) return NULL;
+    int fd = open(path, O_RDONLY);
+    free(path);
+    if (fd == -1) return NULL;
+    
+    checkpoint_header_t hdr;
+    struct stat st;
+    bool valid = pread(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr) &&
+                 fstat(fd, &st) == 0 &&
+                 hdr.magic == CHECKPOINT_MAGIC &&
+                 hdr.version == CHECKPOINT_VERSION &&
+                 hdr.generation == storage->generation &&
+                 hdr.log_offset >= HEADER_SIZE &&
+                 hdr.log_offset <= storage->next_free_offset &&
+                 hdr.capacity >= INDEX_GROUP_SIZE &&
+                 (hdr.capacity & (hdr.capacity - 1)) == 0 &&
+                 hdr.count + hdr.tombstones < hdr.capacity &&
+                 hdr.block_size == index_block_size(hdr.capacity) &&
+                 (uint64_t)st.st_size == PAGE_SIZE + hdr.block_size;
+    if (!valid) {
+        close(fd);
+        return NULL;
+    }
+    
+    size_t mapped_size = PAGE_SIZE + hdr.block_size;
+    uint8_t *base = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+    
+    /* A torn or corrupt block is not trusted; the caller rebuilds from the log */
+    if (crc32c_update(0, base + PAGE_SIZE, hdr.block_size) != hdr.index_crc) {
+        munmap(base, mapped_size);
+        return NULL;
+    }
+    
+    flat_index_t *index = (flat_index_t *)(base + PAGE_SIZE);
+    index_bind(index, hdr.capacity);
+    index->count = hdr.count;
+    index->tombstones = hdr.tombstones;
+    index->mapped_size = mapped_size;
+    
+    storage->live_bytes = hdr.live_bytes;
+    storage->dead_bytes = hdr.dead_bytes;
+    storage->checkpoint_offset = hdr.log_offset;
+    return index;
+}
+
+/* Index the existing log: from the checkpoint if one matches, else from scratch */
+static COLD int load_index(fast_storage_t *storage) {
+    uint64_t replay_from = HEADER_SIZE;
+    flat_index_t *loaded = load_checkpoint(storage);
+    if (loaded) {
+        index_free(storage->index);
+        storage->index = loaded;
+        replay_from = storage->checkpoint_offset;
+    }
+    if (replay_log(storage, replay_from) == 0) return 0;
+    
+    /* Torn checkpoint tail replay, or a corrupt log: start fresh. The new
+     * generation keeps the old records from ever verifying again */
+    index_free(storage->index);
+    storage->index = index_alloc(INDEX_INITIAL_CAPACITY);
+    storage->next_free_offset = HEADER_SIZE;
+    storage->generation = new_generation();
+    storage->live_bytes = 0;
+    storage->dead_bytes = 0;
+    storage->checkpoint_offset = 0;
+    return storage->index ? 0 : -1;
+}
+
+static ALWAYS_INLINE int storage_mmap_flags(const fast_storage_t *storage) {
+    return MAP_SHARED | (storage->options.populate ? MAP_POPULATE : 0);
+}
+
+static ALWAYS_INLINE int storage_prot(const fast_storage_t *storage) {
+    return storage->options.read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+}
+
+/* Apply the lock, huge page and advice options to [offset, offset + len) of a mapping */
+static void storage_map_setup(fast_storage_t *storage, uint8_t *ptr, size_t offset, size_t len) {
+#ifdef __linux__
+    if (storage->options.populate && storage->options.lock) {
+        mlock(ptr + offset, len);
+    }
+#ifdef MADV_HUGEPAGE
+    if (storage->options.huge_pages && !storage->use_huge_pages) {
+        madvise(ptr + offset, len, MADV_HUGEPAGE);
+    }
+#endif
+    static const int advice[] = {
+        [FAST_STORAGE_ADVICE_NORMAL] = MADV_NORMAL,
+        [FAST_STORAGE_ADVICE_RANDOM] = MADV_RANDOM,
+        [FAST_STORAGE_ADVICE_SEQUENTIAL] = MADV_SEQUENTIAL,
+        [FAST_STORAGE_ADVICE_WILLNEED] = MADV_WILLNEED,
+    };
+    madvise(ptr + offset, len, advice[storage->options.advice]);
+#else
+    (void)storage; (void)ptr; (void)offset; (void)len;
+#endif
+}
+
+/* A fresh mapping has nothing faulted in from the write position on (with
+ * lock, locking starts over from the beginning) */
+static void reset_populated(fast_storage_t *storage) {
+    const fast_storage_options_t *options = &storage->options;
+    if (options->populate || options->read_only || (!options->lock && !options->populate_ahead)) {
+        storage->populated_offset = UINT64_MAX;
+    } else {
+        storage->populated_offset = options->lock ? 0 : storage->next_free_offset;
+    }
+}
+
+/* Fault in (or lock) the pages a write up to end touches, plus populate_ahead,
+ * so writes do not take a page fault each */
+static COLD void populate_to(fast_storage_t *storage, uint64_t end) {
+    size_t start = storage->populated_offset & ~(size_t)(PAGE_SIZE - 1);
+    size_t stop = (end + storage->options.populate_ahead + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+    if (stop > storage->file_size) stop = storage->file_size;
+    if (stop > start) {
+        uint8_t *ptr = storage->mmap_ptr + start;
+        size_t len = stop - start;
+        if (storage->options.lock) {
+            mlock(ptr, len);
+        } else {
+#ifdef MADV_POPULATE_WRITE
+            if (madvise(ptr, len, MADV_POPULATE_WRITE) == -1)
+#endif
+            {
+                /* Older kernels: a write fault per page, leaving the data as is */
+                for (size_t i = 0; i < len; i += PAGE_SIZE) {
+                    __atomic_fetch_or(ptr + i, 0, __ATOMIC_RELAXED);
+                }
+            }
+        }
+    }
+    storage->populated_offset = stop > end ? stop : end;
+}
+
+static int allocate_file(int fd, size_t size) {
+#ifdef __linux__
+    /* Try fallocate first (doesn't zero) */
+    if (fallocate(fd, 0, 0, size) == 0) return 0;
+#endif
+    return ftruncate(fd, size);
+}
+
+/* Extend the file and mapping to at least needed_end bytes */
+static COLD int storage_grow(fast_storage_t *storage, size_t needed_end) {
+    size_t unit = storage->use_huge_pages ? HUGE_PAGE_SIZE : PAGE_SIZE;
+    size_t new_size = storage->file_size;
+    while (new_size < needed_end) new_size *= 2;
+    new_size = (new_size + unit - 1) & ~(unit - 1);
+    
+    storage_view_t *view = malloc(sizeof(storage_view_t));
+    if (!view) return -1;
+    if (allocate_file(storage->fd, new_size) == -1) {
+        free(view);
+        return -1;
+    }
+    
+    /* Extend in place if the address range after the mapping is free.
+     * Otherwise map the file afresh: readers may still be in the old
+     * mapping, so it is retired rather than moved */
+    /* The group committer must not msync a mapping being replaced */
+    pthread_mutex_lock(&storage->commit_lock);
+    uint8_t *ptr = MAP_FAILED;
+#ifdef __linux__
+    ptr = mremap(storage->mmap_ptr, storage->file_size, new_size, 0);
+    if (ptr != MAP_FAILED) {
+        size_t grown = new_size - storage->file_size;
+        storage_map_setup(storage, ptr, storage->file_size, grown);
+#ifdef MADV_POPULATE_WRITE
+        if (storage->options.populate && !storage->options.lock) {
+            madvise(ptr + storage->file_size, grown, MADV_POPULATE_WRITE);
+        }
+#endif
+    }
+#endif
+    if (ptr == MAP_FAILED) {
+        ptr = mmap(NULL, new_size, storage_prot(storage), storage_mmap_flags(storage), storage->fd, 0);
+        if (ptr == MAP_FAILED) {
+            pthread_mutex_unlock(&storage->commit_lock);
+            free(view);
+            return -1;
+        }
+        storage_map_setup(storage, ptr, 0, new_size);
+    }
+    
+    uint8_t *old = storage->mmap_ptr;
+    size_t old_size = storage->file_size;
+    storage->mmap_ptr = ptr;
+    storage->file_size = new_size;
+    pthread_mutex_unlock(&storage->commit_lock);
+    if (ptr != old) reset_populated(storage);
+    storage->grows++;
+    view_publish(storage, view);
+    if (ptr != old) retire(storage, old, old_size, RETIRE_MAPPING);
+    return 0;
+}
+
+/* Live slots ordered by record offset; compaction copies them in log order */
+typedef struct {
+    uint64_t offset;
+    size_t slot;
+} live_record_t;
+
+static int compare_live_records(const void *a, const void *b) {
+    uint64_t x = ((const live_record_t *)a)->offset;
+    uint64_t y = ((const live_record_t *)b)->offset;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Copy every live record into a fresh segment, make it durable, then rename
+ * it over the original. The index keeps its layout; only offsets change.
+ * On failure the original file and index are untouched.
+ */
+static COLD int storage_compact(fast_storage_t *storage, size_t reserve) {
+    flat_index_t *index = storage->index;
+    live_record_t *live = malloc((index->count ? index->count : 1) * sizeof(live_record_t));
+    if (!live) return -1;
+    
+    /* Readers keep the old log and index until they leave; the new pair
+     * goes out together as one view */
+    storage_view_t *view = malloc(sizeof(storage_view_t));
+    flat_index_t *fresh = index_clone(index);
+    if (!view || !fresh) {
+        free(view);
+        index_free(fresh);
+        free(live);
+        return -1;
+    }
+    
+    size_t n = 0;
+    for (size_t i = 0; i < index->capacity; i++) {
+        if (!(index->ctrl[i] & 0x80)) {
+            live[n].offset = index->slots[i].offset;
+            live[n].slot = i;
+            n++;
+        }
+    }
+    qsort(live, n, sizeof(live_record_t), compare_live_records);
+    
+    size_t live_end = HEADER_SIZE + storage->live_bytes;
+    size_t new_size = storage->min_size;
+    while (new_size < (live_end + reserve) * 2) new_size *= 2;
+    new_size = (new_size + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+    
+    int fd = -1;
+    uint8_t *ptr = MAP_FAILED;
+    size_t path_len = strlen(storage->path);
+    char *tmp_path = malloc(path_len + sizeof(".compact"));
+    if (!tmp_path) goto fail;
+    memcpy(tmp_path, storage->path, path_len);
+    memcpy(tmp_path + path_len, ".compact", sizeof(".compact"));
+    
+    fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1 || allocate_file(fd, new_size) == -1) goto fail;
+    ptr = mmap(NULL, new_size, PROT_READ | PROT_WRITE, storage_mmap_flags(storage), fd, 0);
+    if (ptr == MAP_FAILED) goto fail;
+    
+    /* Copy in log order, remembering each record's new offset. Checksums
+     * are redone for the new generation (older records gain one) */
+    uint64_t generation = new_generation();
+    uint64_t out = HEADER_SIZE;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t size = record_size_at(storage, live[i].offset);
+        fast_memcpy(ptr + out, storage->mmap_ptr + live[i].offset, size);
+        record_header_t *hdr = (record_header_t *)(ptr + out);
+        hdr->reserved |= RECORD_CHECKSUMMED;
+        const char *key = (const char *)(hdr + 1);
+        hdr->checksum = record_checksum(generation, hdr, key, key + hdr->key_len);
+        live[i].offset = out;
+        out += size;
+    }
+    memcpy(ptr, storage->mmap_ptr, HEADER_SIZE);
+    ((uint64_t *)ptr)[HEADER_COMMIT] = out;
+    ((uint64_t *)ptr)[HEADER_GENERATION] = generation;
+    ((uint64_t *)ptr)[HEADER_COMMIT_CHECK] = commit_check(generation, out);
+    
+    if (msync(ptr, out, MS_SYNC) == -1 || fsync(fd) == -1) goto fail;
+    
+    /* The committer must not sync the old segment once it is replaced */
+    pthread_mutex_lock(&storage->commit_lock);
+    if (rename(tmp_path, storage->path) == -1) {
+        pthread_mutex_unlock(&storage->commit_lock);
+        goto fail;
+    }
+    
+    /* Committed: swap the segment in */
+    storage_map_setup(storage, ptr, 0, new_size);
+    uint8_t *old_log = storage->mmap_ptr;
+    size_t old_size = storage->file_size;
+    close(storage->fd);
+    storage->fd = fd;
+    storage->mmap_ptr = ptr;
+    storage->file_size = new_size;
+    for (size_t i = 0; i < n; i++) {
+        fresh->slots[live[i].slot].offset = live[i].offset;
+    }
+    storage->index = fresh;
+    view_publish(storage, view);
+    retire(storage, index, 0, RETIRE_INDEX);
+    retire(storage, old_log, old_size, RETIRE_MAPPING);
+    storage->next_free_offset = out;
+    storage->generation = generation;
+    storage->committed_offset = out;
+    storage->synced_offset = out;
+    storage->writeback_offset = out;
+    pthread_mutex_unlock(&storage->commit_lock);
+    reset_populated(storage);
+    storage->checkpoint_offset = 0;
+    storage->dead_bytes = 0;
+    storage->compactions++;
+    storage->dirty = true;
+    
+    free(live);
+    free(tmp_path);
+    return 0;
+    
+fail:
+    if (ptr != MAP_FAILED) munmap(ptr, new_size);
+    if (fd != -1) {
+        close(fd);
+        unlink(tmp_path);
+    }
+    free(view);
+    index_free(fresh);
+    free(live);
+    free(tmp_path);
+    return -1;
+}
+
+/* Make room for record_size more bytes: compact when at least half the
+ * log is dead, otherwise (or if that is not enough) grow the file */
+static COLD int storage_make_room(fast_storage_t *storage, size_t record_size) {
+    uint64_t used = storage->next_free_offset - HEADER_SIZE;
+    if (storage->dead_bytes >= COMPACT_MIN_DEAD && storage->dead_bytes * 2 >= used) {
+        storage_compact(storage, record_size);
+    }
+    if (storage->next_free_offset + record_size > storage->file_size) {
+        return storage_grow(storage, storage->next_free_offset + record_size);
+    }
+    return 0;
+}
+
+/* FAST_STORAGE_GROUP: one sync commit per interval, off the writer thread */
+static void *committer_main(void *arg) {
+    fast_storage_t *storage = arg;
+    pthread_mutex_lock(&storage->commit_lock);
+    while (!storage->committer_stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        uint64_t ns = (uint64_t)deadline.tv_nsec + (uint64_t)storage->commit_interval_ms * 1000000ull;
+        deadline.tv_sec += ns / 1000000000ull;
+        deadline.tv_nsec = ns % 1000000000ull;
+        while (!storage->committer_stop &&
+               pthread_cond_timedwait(&storage->commit_wake, &storage->commit_lock, &deadline) != ETIMEDOUT) {
+        }
+        if (storage->committer_stop) break;
+        storage_commit_locked(storage, true);
+    }
+    pthread_mutex_unlock(&storage->commit_lock);
+    return NULL;
+}
+
+static void stop_committer(fast_storage_t *storage) {
+    if (!storage->committer_running) return;
+    pthread_mutex_lock(&storage->commit_lock);
+    storage->committer_stop = true;
+    pthread_cond_signal(&storage->commit_wake);
+    pthread_mutex_unlock(&storage->commit_lock);
+    pthread_join(storage->committer, NULL);
+    storage->committer_running = false;
+    storage->committer_stop = false;
+}
+
+void fast_storage_default_options(fast_storage_options_t *options) {
+    memset(options, 0, sizeof(*options));
+    options->initial_size = 100 * 1024 * 1024;
+    options->populate_ahead = POPULATE_AHEAD;
+    options->advice = FAST_STORAGE_ADVICE_NORMAL;
+}
+
 fast_storage_t *fast_storage_create(const char *filename, size_t size) {
+    fast_storage_options_t options;
+    fast_storage_default_options(&options);
+    options.initial_size = size;
+    return fast_storage_open_ex(filename, &options);
+}
+
+fast_storage_t *fast_storage_open_ex(const char *filename, const fast_storage_options_t *options) {
+    if ((unsigned)options->advice > FAST_STORAGE_ADVICE_WILLNEED) return NULL;
+    
     fast_storage_t *storage = aligned_alloc(CACHE_LINE_SIZE, sizeof(fast_storage_t));
     if (!storage) return NULL;
     
     memset(storage, 0, sizeof(fast_storage_t));
+    storage->epoch = 1;  /* Reader slots use 0 for free */
+    storage->options = *options;
+    bool read_only = options->read_only;
+    pthread_mutex_init(&storage->commit_lock, NULL);
+    pthread_cond_init(&storage->commit_wake, NULL);
     
     /* Open file with optimal flags */
-    storage->fd = open(filename, O_RDWR | O_CREAT | O_NOATIME, 0644);
+    int open_flags = read_only ? O_RDONLY : O_RDWR | O_CREAT;
+    storage->fd = open(filename, open_flags | O_NOATIME, 0644);
     if (storage->fd == -1) {
-        storage->fd = open(filename, O_RDWR | O_CREAT, 0644);
+        storage->fd = open(filename, open_flags, 0644);
     }
     if (storage->fd == -1) {
         free(storage);
@@ -427,97 +1498,134 @@ fast_storage_t *fast_storage_create(const char *filename, size_t size) {
     fstat(storage->fd, &st);
     
     bool is_new = st.st_size < (off_t)HEADER_SIZE;
+    if (is_new && read_only) {
+        close(storage->fd);
+        free(storage);
+        return NULL;
+    }
+    
+    /* size is the initial size; the file grows on demand */
+    size_t size = options->initial_size;
+    if (size < PAGE_SIZE) size = PAGE_SIZE;
+    storage->min_size = size;
+    storage->path = strdup(filename);
+    if (!storage->path) {
+        close(storage->fd);
+        free(storage);
+        return NULL;
+    }
     
     /* Allocate file space */
-    if ((size_t)st.st_size < size) {
-#ifdef __linux__
-        /* Try fallocate first (doesn't zero) */
-        if (fallocate(storage->fd, 0, 0, size) == -1) {
-            if (ftruncate(storage->fd, size) == -1) {
-                close(storage->fd);
-                free(storage);
-                return NULL;
-            }
-        }
-#else
-        if (ftruncate(storage->fd, size) == -1) {
+    if (!read_only && (size_t)st.st_size < size) {
+        if (allocate_file(storage->fd, size) == -1) {
             close(storage->fd);
+            free(storage->path);
             free(storage);
             return NULL;
         }
-#endif
         storage->file_size = size;
     } else {
         storage->file_size = st.st_size;
     }
     
-    /* Try to use huge pages for better TLB performance */
-    int mmap_flags = MAP_SHARED | MAP_POPULATE;
-    
+    /* hugetlbfs pages only work for files on hugetlbfs; elsewhere
+     * storage_map_setup() asks for transparent huge pages instead */
+    int mmap_flags = storage_mmap_flags(storage);
+    int prot = storage_prot(storage);
+    storage->mmap_ptr = MAP_FAILED;
 #ifdef MAP_HUGETLB
-    storage->mmap_ptr = mmap(NULL, storage->file_size, PROT_READ | PROT_WRITE,
-                             mmap_flags | MAP_HUGETLB, storage->fd, 0);
-    if (storage->mmap_ptr == MAP_FAILED) {
-        /* Fallback to regular pages */
-        storage->use_huge_pages = false;
-#endif
-        storage->mmap_ptr = mmap(NULL, storage->file_size, PROT_READ | PROT_WRITE,
-                                 mmap_flags, storage->fd, 0);
-#ifdef MAP_HUGETLB
-    } else {
-        storage->use_huge_pages = true;
+    if (options->huge_pages) {
+        storage->mmap_ptr = mmap(NULL, storage->file_size, prot, mmap_flags | MAP_HUGETLB, storage->fd, 0);
+        storage->use_huge_pages = storage->mmap_ptr != MAP_FAILED;
     }
 #endif
+    if (storage->mmap_ptr == MAP_FAILED) {
+        storage->mmap_ptr = mmap(NULL, storage->file_size, prot, mmap_flags, storage->fd, 0);
+    }
     
     if (storage->mmap_ptr == MAP_FAILED) {
         close(storage->fd);
+        free(storage->path);
         free(storage);
         return NULL;
     }
     
 #ifdef __linux__
-    /* Lock pages in memory */
-    mlock(storage->mmap_ptr, storage->file_size);
-    
-    /* Memory advice for sequential access */
-    madvise(storage->mmap_ptr, storage->file_size, MADV_WILLNEED);
-    madvise(storage->mmap_ptr, storage->file_size, MADV_SEQUENTIAL);
+    /* Replay reads the log front to back; the chosen advice applies after */
+    if (!is_new) {
+        madvise(storage->mmap_ptr, storage->file_size, MADV_SEQUENTIAL);
+    }
 #endif
     
-    /* Prefault all pages upfront */
-    if (is_new) {
+    /* populate: prefault every page of a new file up front */
+    if (is_new && options->populate) {
         prefault_range(storage->mmap_ptr, storage->file_size);
     }
     
-    /* Initialize hash table */
-    storage->hash_capacity = 131072;  /* Start with 128K slots */
-    storage->hash_table = calloc(storage->hash_capacity, sizeof(hash_entry_t *));
-    if (!storage->hash_table) {
+    /* Initialize index */
+    storage->index = index_alloc(INDEX_INITIAL_CAPACITY);
+    storage_view_t *view = malloc(sizeof(storage_view_t));
+    if (!storage->index || !view) {
+        index_free(storage->index);
+        free(view);
         munmap(storage->mmap_ptr, storage->file_size);
         close(storage->fd);
+        free(storage->path);
         free(storage);
         return NULL;
     }
     
     storage->next_free_offset = HEADER_SIZE;
+    storage->generation = new_generation();
     
     /* Load existing data */
     if (!is_new) {
         uint64_t *header = (uint64_t *)storage->mmap_ptr;
         if (header[0] == MAGIC) {
-            uint64_t stored_offset = header[1];
+            uint64_t stored_offset = header[HEADER_COMMIT];
+            /* Logs from before checkpoints have no generation yet */
+            if (header[HEADER_GENERATION]) {
+                storage->generation = header[HEADER_GENERATION];
+            }
+            /* A torn marker commits nothing; checksums still recover the log */
+            if (header[HEADER_COMMIT_CHECK] &&
+                header[HEADER_COMMIT_CHECK] != commit_check(storage->generation, stored_offset)) {
+                stored_offset = HEADER_SIZE;
+            }
             if (stored_offset >= HEADER_SIZE && stored_offset <= storage->file_size) {
                 storage->next_free_offset = stored_offset;
-                if (rebuild_index(storage) < 0) {
-                    /* Index rebuild failed, start fresh */
-                    storage->next_free_offset = HEADER_SIZE;
-                    storage->hash_count = 0;
+                storage->committed_offset = stored_offset;
+                if (load_index(storage) < 0) {
+                    /* Views published by rehashes during replay */
+                    reclaim(storage, true);
+                    free(storage->view);
+                    free(storage->retired);
+                    free(view);
+                    munmap(storage->mmap_ptr, storage->file_size);
+                    close(storage->fd);
+                    free(storage->path);
+                    free(storage);
+                    return NULL;
                 }
+                /* Clear what replay rejected, so a later record that happens
+                 * to end where it did cannot bring stale records back */
+                uint64_t end = storage->next_free_offset;
+                uint64_t clear_end = stored_offset > end ? stored_offset : end + sizeof(record_header_t);
+                if (clear_end > storage->file_size) clear_end = storage->file_size;
+                if (!read_only && clear_end > end) memset(storage->mmap_ptr + end, 0, clear_end - end);
             }
         }
     }
-    
-    update_header(storage);
+    storage_map_setup(storage, storage->mmap_ptr, 0, storage->file_size);
+    reset_populated(storage);
+    storage->synced_offset = storage->committed_offset;
+    storage->writeback_offset = storage->next_free_offset;
+    if (!read_only) {
+        storage->dirty = true;
+        update_header(storage);
+        storage_commit(storage, false);
+    }
+    view_publish(storage, view);
     
     return storage;
 }
@@ -525,12 +1633,16 @@ fast_storage_t *fast_storage_create(const char *filename, size_t size) {
 void fast_storage_destroy(fast_storage_t *storage) {
     if (!storage) return;
     
-    update_header(storage);
+    stop_committer(storage);
+    if (!storage->options.read_only) {
+        update_header(storage);
+        storage_commit(storage, storage->durability != FAST_STORAGE_NONE);
+        if (storage->checkpoint_offset != storage->next_free_offset) {
+            write_checkpoint(storage);
+        }
+    }
     
     if (storage->mmap_ptr && storage->mmap_ptr != MAP_FAILED) {
-#ifdef __linux__
-        munlock(storage->mmap_ptr, storage->file_size);
-#endif
         munmap(storage->mmap_ptr, storage->file_size);
     }
     
@@ -538,33 +1650,27 @@ void fast_storage_destroy(fast_storage_t *storage) {
         close(storage->fd);
     }
     
-    /* Free hash table */
-    if (storage->hash_table) {
-        for (size_t i = 0; i < storage->hash_capacity; i++) {
-            if (storage->hash_table[i]) {
-                free(storage->hash_table[i]);
-            }
-        }
-        free(storage->hash_table);
-    }
+    /* No readers may remain; release everything they could have held */
+    reclaim(storage, true);
+    free(storage->retired);
+    free(storage->view);
+    index_free(storage->index);
+    free(storage->path);
+    pthread_cond_destroy(&storage->commit_wake);
+    pthread_mutex_destroy(&storage->commit_lock);
     
     free(storage);
 }
 
-HOT int fast_storage_write(fast_storage_t *storage, const char *key, size_t key_len, 
-                           const char *value, size_t value_len) {
-    size_t record_size = sizeof(record_header_t) + key_len + value_len;
-    
-    if (UNLIKELY(storage->next_free_offset + record_size > storage->file_size)) {
-        return -1;  /* Storage full */
-    }
-    
-    uint8_t *ptr = storage->mmap_ptr + storage->next_free_offset;
-    uint64_t offset = storage->next_free_offset;
-    
+static ALWAYS_INLINE bool in_mapping(const fast_storage_t *storage, const void *p) {
+    return (const uint8_t *)p >= storage->mmap_ptr && (const uint8_t *)p < storage->mmap_ptr + storage->file_size;
+}
+
+static ALWAYS_INLINE void write_record(uint8_t *ptr, uint64_t generation, const char *key, size_t key_len,
+                                       const char *value, size_t value_len, uint32_t flags) {
     /* Prefetch write location */
     PREFETCH_WRITE(ptr);
-    if (record_size > CACHE_LINE_SIZE) {
+    if (sizeof(record_header_t) + key_len + value_len > CACHE_LINE_SIZE) {
         PREFETCH_WRITE(ptr + CACHE_LINE_SIZE);
     }
     
@@ -573,84 +1679,402 @@ HOT int fast_storage_write(fast_storage_t *storage, const char *key, size_t key_
     hdr->magic = MAGIC;
     hdr->key_len = key_len;
     hdr->value_len = value_len;
-    hdr->checksum = 0;  /* TODO: Add checksum if needed */
-    hdr->reserved = 0;
+    hdr->reserved = flags | RECORD_CHECKSUMMED;
+    hdr->checksum = record_checksum(generation, hdr, key, value);
     ptr += sizeof(record_header_t);
     
     /* Write key and value with optimized copy */
     fast_memcpy(ptr, key, key_len);
     ptr += key_len;
     fast_memcpy(ptr, value, value_len);
+}
+
+/* Append one record (a value, or a tombstone when flags has RECORD_TOMBSTONE)
+ * and apply it to the index */
+static HOT int append_record(fast_storage_t *storage, const char *key, size_t key_len,
+                             const char *value, size_t value_len, uint32_t flags) {
+    size_t record_size = sizeof(record_header_t) + key_len + value_len;
+    
+    if (UNLIKELY(storage->next_free_offset + record_size > storage->file_size)) {
+        if (UNLIKELY(in_mapping(storage, key) || in_mapping(storage, value))) {
+            /* Sources inside the mapping would move with it: copy them out first */
+            char *copy = malloc(key_len + value_len);
+            if (!copy) return -1;
+            memcpy(copy, key, key_len);
+            memcpy(copy + key_len, value, value_len);
+            int result = append_record(storage, copy, key_len, copy + key_len, value_len, flags);
+            free(copy);
+            return result;
+        }
+        if (storage_make_room(storage, record_size) < 0) {
+            return -1;  /* Storage full */
+        }
+    }
+    
+    /* Index room first: a checksummed record must never be left in the log
+     * for a write that fails (recovery would bring it back) */
+    bool tombstone = flags & RECORD_TOMBSTONE;
+    if (!tombstone && UNLIKELY(index_reserve(storage, 1) < 0)) return -1;
+    
+    uint64_t offset = storage->next_free_offset;
+    if (UNLIKELY(offset + record_size > storage->populated_offset)) {
+        populate_to(storage, offset + record_size);
+    }
+    write_record(storage->mmap_ptr + offset, storage->generation, key, key_len, value, value_len, flags);
     
     /* Compute hash and update index */
     uint64_t hash = fast_hash(key, key_len);
-    if (UNLIKELY(hash_table_insert(storage, key, key_len, hash, offset) < 0)) {
-        return -1;
+    uint64_t replaced = UINT64_MAX;
+    if (tombstone) {
+        index_remove(storage, key, key_len, hash, &replaced);
+    } else {
+        index_insert_reserved(storage, key, key_len, hash, offset, &replaced);
     }
+    account_record(storage, record_size, replaced, tombstone);
     
-    storage->next_free_offset += record_size;
+    __atomic_store_n(&storage->next_free_offset, offset + record_size, __ATOMIC_RELEASE);
     storage->dirty = true;
     storage->write_count++;
     
     return 0;
 }
 
-HOT int fast_storage_read(fast_storage_t *storage, const char *key, size_t key_len,
-                          char **value_out, size_t *value_len_out) {
-    uint64_t hash = fast_hash(key, key_len);
-    hash_entry_t *entry = hash_table_lookup(storage, key, key_len, hash);
+HOT int fast_storage_write(fast_storage_t *storage, const char *key, size_t key_len, 
+                           const char *value, size_t value_len) {
+    if (UNLIKELY(storage->options.read_only)) return -1;
+    if (UNLIKELY(append_record(storage, key, key_len, value, value_len, 0) < 0)) return -1;
+    return storage_after_write(storage);
+}
+
+HOT int fast_storage_write_batch(fast_storage_t *storage, size_t count,
+                                 const char *const *keys, const size_t *key_lens,
+                                 const char *const *values, const size_t *value_lens) {
+    if (UNLIKELY(storage->options.read_only)) return -1;
+    
+    size_t total = 0;
+    bool sources_mapped = false;
+    for (size_t i = 0; i < count; i++) {
+        total += sizeof(record_header_t) + key_lens[i] + value_lens[i];
+        sources_mapped |= in_mapping(storage, keys[i]) || in_mapping(storage, values[i]);
+    }
     
-    if (!entry) return -1;
+    /* Reserve the whole batch up front */
+    if (UNLIKELY(storage->next_free_offset + total > storage->file_size)) {
+        if (UNLIKELY(sources_mapped)) {
+            /* Growing could move the sources: copy the batch out first */
+            size_t arrays = count * (2 * sizeof(char *) + 2 * sizeof(size_t));
+            uint8_t *copy = malloc(arrays + total);
+            if (!copy) return -1;
+            const char **copy_keys = (const char **)copy;
+            const char **copy_values = copy_keys + count;
+            size_t *copy_key_lens = (size_t *)(copy_values + count);
+            size_t *copy_value_lens = copy_key_lens + count;
+            char *data = (char *)copy + arrays;
+            for (size_t i = 0; i < count; i++) {
+                memcpy(data, keys[i], key_lens[i]);
+                copy_keys[i] = data;
+                data += key_lens[i];
+                memcpy(data, values[i], value_lens[i]);
+                copy_values[i] = data;
+                data += value_lens[i];
+                copy_key_lens[i] = key_lens[i];
+                copy_value_lens[i] = value_lens[i];
+            }
+            int result = fast_storage_write_batch(storage, count, copy_keys, copy_key_lens,
+                                                  copy_values, copy_value_lens);
+            free(copy);
+            return result;
+        }
+        if (storage_make_room(storage, total) < 0) {
+            return -1;  /* Storage full */
+        }
+    }
+    /* Index room for the whole batch before any record is written: once one
+     * is in the log, every insert is guaranteed to succeed, so a failed
+     * batch never leaves recoverable records behind */
+    if (UNLIKELY(index_reserve(storage, count) < 0)) return -1;
     
-    uint64_t offset = entry->offset;
-    uint8_t *ptr = storage->mmap_ptr + offset;
+    /* Records land back to back from the old end; one offset bump at the end */
+    uint64_t offset = storage->next_free_offset;
+    if (UNLIKELY(offset + total > storage->populated_offset)) {
+        populate_to(storage, offset + total);
+    }
+    uint64_t hashes[BATCH_CHUNK];
+    for (size_t base = 0; base < count; base += BATCH_CHUNK) {
+        size_t n = count - base < BATCH_CHUNK ? count - base : BATCH_CHUNK;
+        
+        /* Hash the chunk first so its probe groups are in flight together */
+        for (size_t j = 0; j < n; j++) {
+            hashes[j] = fast_hash(keys[base + j], key_lens[base + j]);
+            prefetch_probe(storage->index, hashes[j]);
+        }
+        
+        for (size_t j = 0; j < n; j++) {
+            size_t i = base + j;
+            size_t record_size = sizeof(record_header_t) + key_lens[i] + value_lens[i];
+            write_record(storage->mmap_ptr + offset, storage->generation, keys[i], key_lens[i],
+                         values[i], value_lens[i], 0);
+            
+            /* Later duplicates in the batch replace earlier ones */
+            uint64_t replaced = UINT64_MAX;
+            index_insert_reserved(storage, keys[i], key_lens[i], hashes[j], offset, &replaced);
+            account_record(storage, record_size, replaced, false);
+            offset += record_size;
+        }
+    }
     
-    /* Prefetch record data */
-    PREFETCH_READ(ptr);
+    __atomic_store_n(&storage->next_free_offset, offset, __ATOMIC_RELEASE);
+    storage->write_count += count;
+    storage->dirty = true;
     
-    record_header_t *hdr = (record_header_t *)ptr;
-    ptr += sizeof(record_header_t) + hdr->key_len;
+    /* One commit for the whole batch */
+    return storage_after_write(storage);
+}
+
+/* Record slot points at, or NULL if it lies past view's mapping */
+static ALWAYS_INLINE const record_header_t *view_record(const storage_view_t *view, const index_slot_t *slot) {
+    uint64_t offset = slot_offset(slot);
+    if (UNLIKELY(offset + sizeof(record_header_t) > view->file_size)) return NULL;
+    const record_header_t *hdr = (const record_header_t *)(view->log + offset);
+    if (UNLIKELY(offset + sizeof(record_header_t) + hdr->key_len + hdr->value_len > view->file_size)) return NULL;
+    return hdr;
+}
+
+/* Find key's record from a reader. A record past the view's mapping means
+ * the writer grew the log after the view was loaded; the view that covers
+ * it was published before the record, so reloading always makes progress */
+static HOT const record_header_t *reader_find(fast_storage_t *storage, const char *key, size_t key_len,
+                                              uint64_t hash) {
+    for (;;) {
+        const storage_view_t *view = current_view(storage);
+        ssize_t slot = index_lookup(view->index, view->log, view->file_size, key, key_len, hash);
+        if (slot == -1) return NULL;
+        if (slot >= 0) {
+            const record_header_t *hdr = view_record(view, &view->index->slots[slot]);
+            if (LIKELY(hdr != NULL)) return hdr;
+        }
+    }
+}
+
+static ALWAYS_INLINE char *record_value(const record_header_t *hdr) {
+    return (char *)hdr + sizeof(record_header_t) + hdr->key_len;
+}
+
+HOT size_t fast_storage_read_many(fast_storage_t *storage, size_t count,
+                                  const char *const *keys, const size_t *key_lens,
+                                  char **values_out, size_t *value_lens_out) {
+    reader_slot_t *reader = reader_enter(storage);
+    const storage_view_t *view = current_view(storage);
+    const flat_index_t *index = view->index;
+    uint64_t hashes[BATCH_CHUNK];
+    ssize_t slots[BATCH_CHUNK];
+    size_t found = 0;
+    
+    for (size_t base = 0; base < count; base += BATCH_CHUNK) {
+        size_t n = count - base < BATCH_CHUNK ? count - base : BATCH_CHUNK;
+        
+        /* Three passes per chunk: hash + prefetch groups, probe + prefetch
+         * records, then read headers that are by now in cache */
+        for (size_t j = 0; j < n; j++) {
+            hashes[j] = fast_hash(keys[base + j], key_lens[base + j]);
+            prefetch_probe(index, hashes[j]);
+        }
+        for (size_t j = 0; j < n; j++) {
+            slots[j] = index_lookup(index, view->log, view->file_size, keys[base + j], key_lens[base + j], hashes[j]);
+            if (slots[j] >= 0) {
+                PREFETCH_READ(view->log + slot_offset(&index->slots[slots[j]]));
+            }
+        }
+        for (size_t j = 0; j < n; j++) {
+            size_t i = base + j;
+            const record_header_t *hdr = slots[j] >= 0 ? view_record(view, &index->slots[slots[j]]) : NULL;
+            if (UNLIKELY(!hdr && slots[j] != -1)) {
+                /* The writer outgrew this view mid-batch */
+                hdr = reader_find(storage, keys[i], key_lens[i], hashes[j]);
+            }
+            if (!hdr) {
+                values_out[i] = NULL;
+                value_lens_out[i] = 0;
+                continue;
+            }
+            values_out[i] = record_value(hdr);
+            value_lens_out[i] = hdr->value_len;
+            found++;
+        }
+    }
+    
+    reader_count(storage, reader, found);
+    reader_exit(storage, reader);
+    return found;
+}
+
+HOT int fast_storage_read(fast_storage_t *storage, const char *key, size_t key_len,
+                          char **value_out, size_t *value_len_out) {
+    uint64_t hash = fast_hash(key, key_len);
+    reader_slot_t *reader = reader_enter(storage);
+    const record_header_t *hdr = reader_find(storage, key, key_len, hash);
+    
+    if (hdr) {
+        /* Return pointer to value (zero-copy) */
+        *value_out = record_value(hdr);
+        *value_len_out = hdr->value_len;
+        reader_count(storage, reader, 1);
+    }
     
-    /* Return pointer to value (zero-copy) */
-    *value_out = (char *)ptr;
-    *value_len_out = hdr->value_len;
+    reader_exit(storage, reader);
+    return hdr ? 0 : -1;
+}
+
+HOT int fast_storage_read_copy(fast_storage_t *storage, const char *key, size_t key_len,
+                               char *buf, size_t buf_len, size_t *value_len_out) {
+    uint64_t hash = fast_hash(key, key_len);
+    reader_slot_t *reader = reader_enter(storage);
+    const record_header_t *hdr = reader_find(storage, key, key_len, hash);
+    
+    if (hdr) {
+        size_t copy = hdr->value_len < buf_len ? hdr->value_len : buf_len;
+        fast_memcpy(buf, record_value(hdr), copy);
+        *value_len_out = hdr->value_len;
+        reader_count(storage, reader, 1);
+    }
     
-    storage->read_count++;
+    reader_exit(storage, reader);
+    return hdr ? 0 : -1;
+}
+
+int fast_storage_pin(fast_storage_t *storage) {
+    if (pinned.storage == storage) {
+        pinned.depth++;
+        return 0;
+    }
+    if (pinned.storage) return -1;
     
+    reader_slot_t *slot = reader_enter(storage);
+    pinned.storage = storage;
+    pinned.slot = slot;
+    pinned.depth = 1;
     return 0;
 }
 
+void fast_storage_unpin(fast_storage_t *storage) {
+    if (pinned.storage != storage || --pinned.depth) return;
+    
+    pinned.storage = NULL;
+    reader_exit(storage, pinned.slot);
+}
+
 int fast_storage_remove(fast_storage_t *storage, const char *key, size_t key_len) {
+    if (storage->options.read_only) return -1;
+    
     uint64_t hash = fast_hash(key, key_len);
     
-    if (hash_table_remove(storage, key, key_len, hash) < 0) {
+    if (writer_lookup(storage, key, key_len, hash) < 0) {
         return -1;
     }
     
-    storage->dirty = true;
-    return 0;
+    /* Logged so the removal survives reopen; compaction drops both records */
+    if (append_record(storage, key, key_len, "", 0, RECORD_TOMBSTONE) < 0) return -1;
+    return storage_after_write(storage);
 }
 
 void fast_storage_flush(fast_storage_t *storage) {
+    if (storage->options.read_only) return;
+    
     update_header(storage);
+    if (storage->durability >= FAST_STORAGE_GROUP) {
+        storage_commit(storage, true);
+        return;
+    }
+    storage_commit(storage, false);
     if (storage->mmap_ptr && storage->mmap_ptr != MAP_FAILED) {
         msync(storage->mmap_ptr, storage->next_free_offset, MS_ASYNC);
     }
 }
 
+int fast_storage_sync(fast_storage_t *storage) {
+    if (storage->options.read_only) return -1;
+    
+    update_header(storage);
+    return storage_commit(storage, true);
+}
+
+int fast_storage_set_durability(fast_storage_t *storage, fast_storage_durability_t durability,
+                                unsigned interval_ms) {
+    if (durability < FAST_STORAGE_NONE || durability > FAST_STORAGE_SYNC) return -1;
+    if (storage->options.read_only) return durability == FAST_STORAGE_NONE ? 0 : -1;
+    
+    stop_committer(storage);
+    /* Whatever the old mode promised is kept before the new one applies */
+    if (storage->durability >= FAST_STORAGE_GROUP && storage_commit(storage, true) < 0) return -1;
+    storage->durability = durability;
+    storage->commit_interval_ms = interval_ms ? interval_ms : GROUP_COMMIT_INTERVAL_MS;
+    storage->writeback_offset = storage->next_free_offset;
+    if (durability == FAST_STORAGE_GROUP) {
+        if (pthread_create(&storage->committer, NULL, committer_main, storage) != 0) {
+            storage->durability = FAST_STORAGE_NONE;
+            return -1;
+        }
+        storage->committer_running = true;
+    }
+    return 0;
+}
+
 bool fast_storage_contains(fast_storage_t *storage, const char *key, size_t key_len) {
     uint64_t hash = fast_hash(key, key_len);
-    return hash_table_lookup(storage, key, key_len, hash) != NULL;
+    reader_slot_t *reader = reader_enter(storage);
+    bool found = reader_find(storage, key, key_len, hash) != NULL;
+    reader_exit(storage, reader);
+    return found;
 }
 
 size_t fast_storage_size(fast_storage_t *storage) {
-    return storage->hash_count;
+    reader_slot_t *reader = reader_enter(storage);
+    size_t count = __atomic_load_n(&current_view(storage)->index->count, __ATOMIC_RELAXED);
+    reader_exit(storage, reader);
+    return count;
 }
 
 size_t fast_storage_bytes_used(fast_storage_t *storage) {
-    return storage->next_free_offset - HEADER_SIZE;
+    return __atomic_load_n(&storage->next_free_offset, __ATOMIC_ACQUIRE) - HEADER_SIZE;
 }
 
 size_t fast_storage_capacity(fast_storage_t *storage) {
-    return storage->file_size - HEADER_SIZE;
+    reader_slot_t *reader = reader_enter(storage);
+    size_t capacity = current_view(storage)->file_size - HEADER_SIZE;
+    reader_exit(storage, reader);
+    return capacity;
+}
+
+int fast_storage_checkpoint(fast_storage_t *storage) {
+    if (storage->options.read_only) return -1;
+    
+    update_header(storage);
+    if (storage->checkpoint_offset == storage->next_free_offset) return 0;
+    return write_checkpoint(storage);
+}
+
+int fast_storage_compact(fast_storage_t *storage) {
+    if (storage->options.read_only) return -1;
+    if (storage_compact(storage, 0) < 0) return -1;
+    update_header(storage);
+    return 0;
+}
+
+void fast_storage_get_stats(fast_storage_t *storage, fast_storage_stats_t *stats) {
+    uint64_t total = storage->live_bytes + storage->dead_bytes;
+    stats->keys = storage->index->count;
+    stats->live_bytes = storage->live_bytes;
+    stats->dead_bytes = storage->dead_bytes;
+    stats->dead_ratio = total ? (double)storage->dead_bytes / (double)total : 0.0;
+    stats->file_size = storage->file_size;
+    stats->compactions = storage->compactions;
+    stats->grows = storage->grows;
+    stats->replayed = storage->replayed;
+    stats->recovered = storage->recovered;
+    pthread_mutex_lock(&storage->commit_lock);
+    stats->syncs = storage->syncs;
+    stats->committed_bytes = storage->committed_offset - HEADER_SIZE;
+    pthread_mutex_unlock(&storage->commit_lock);
+    stats->reads = total_reads(storage);
+    stats->writes = storage->write_count;
 }
@@ -0,0 +1,150 @@
+/*
+ * Fast Storage Engine - public C API
+ *
+ * mmap-backed append-only key/value log with an in-memory index. The file
+ * grows on demand and is compacted when most of it is dead. The index is
+ * checkpointed to <filename>.idx on destroy, so reopening maps it and
+ * replays only records written after the checkpoint.
+ *
+ * Durability: every record carries a CRC32C and the header a checksummed
+ * commit marker. Opening replays verified records up to and past the marker
+ * and drops everything from the first torn or corrupt record on, so a crashed
+ * process loses at most what was never written. What survives power loss
+ * depends on the handle's durability mode (fast_storage_set_durability).
+ *
+ * Threading: one writer thread, any number of concurrent reader threads.
+ * read, read_many, read_copy, contains, size, capacity and bytes_used are
+ * lock-free and safe alongside the writer; every other call is writer-only.
+ * Values returned by fast_storage_read() point into the mapping (zero-copy).
+ * On the writer thread they stay valid until its next write, remove or
+ * compaction; on a reader thread, until that thread's pin is released.
+ * Unpinned readers should use fast_storage_read_copy().
+ */
+
+#ifndef FASTSTORAGE_H
+#define FASTSTORAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fast_storage fast_storage_t;
+
+/* When written records are forced to disk */
+typedef enum {
+    FAST_STORAGE_NONE = 0,  /* Only by fast_storage_sync(); the default */
+    FAST_STORAGE_ASYNC,     /* Marker moved per write, writeback started every MiB */
+    FAST_STORAGE_GROUP,     /* Background sync commit every interval */
+    FAST_STORAGE_SYNC,      /* Sync commit per write, remove and batch */
+} fast_storage_durability_t;
+
+/* Access pattern hint for the mapping after open (replay is always sequential) */
+typedef enum {
+    FAST_STORAGE_ADVICE_NORMAL = 0,
+    FAST_STORAGE_ADVICE_RANDOM,
+    FAST_STORAGE_ADVICE_SEQUENTIAL,
+    FAST_STORAGE_ADVICE_WILLNEED,
+} fast_storage_advice_t;
+
+/* How the file is mapped; start from fast_storage_default_options() */
+typedef struct {
+    size_t initial_size;            /* New files start this big and grow on demand */
+    size_t populate_ahead;          /* Bytes faulted in ahead of the write position (0: on demand) */
+    fast_storage_advice_t advice;
+    bool populate;                  /* Fault in the whole file at open and on growth */
+    bool lock;                      /* mlock populated pages */
+    bool huge_pages;                /* hugetlbfs pages if the file allows, else transparent ones */
+    bool read_only;                 /* Map read-only: writes fail, nothing is written back */
+} fast_storage_options_t;
+
+typedef struct {
+    size_t keys;
+    uint64_t live_bytes;     /* Records reachable through the index */
+    uint64_t dead_bytes;     /* Overwritten, removed and tombstone records */
+    double dead_ratio;       /* dead / (live + dead); compaction reclaims it */
+    uint64_t file_size;
+    uint64_t compactions;
+    uint64_t grows;
+    uint64_t replayed;       /* Log records replayed at open (tail after the checkpoint) */
+    uint64_t recovered;      /* Of those, records past the commit marker */
+    uint64_t syncs;          /* Sync commits since open */
+    uint64_t committed_bytes; /* Log bytes covered by the commit marker */
+    uint64_t reads;          /* Found keys, summed over reader slots */
+    uint64_t writes;
+} fast_storage_stats_t;
+
+/* Defaults: nothing populated, locked or advised up front; pages are faulted
+ * in populate_ahead (2 MiB) at a time as writes advance */
+void fast_storage_default_options(fast_storage_options_t *options);
+/* Open filename, creating it unless read_only. NULL on failure */
+fast_storage_t *fast_storage_open_ex(const char *filename, const fast_storage_options_t *options);
+/* fast_storage_open_ex() with default options and initial_size = size */
+fast_storage_t *fast_storage_create(const char *filename, size_t size);
+void fast_storage_destroy(fast_storage_t *storage);
+
+/* Returns 0 on success, -1 on failure (file cannot grow, allocation failure,
+ * read-only store). Every call that modifies the store fails when read-only */
+int fast_storage_write(fast_storage_t *storage, const char *key, size_t key_len,
+                       const char *value, size_t value_len);
+
+/* Returns 0 and a pointer into the mapping, or -1 if key is absent */
+int fast_storage_read(fast_storage_t *storage, const char *key, size_t key_len,
+                      char **value_out, size_t *value_len_out);
+
+/* Write count records with one space reservation; later duplicates win.
+ * Returns 0, or -1 (nothing written if the file cannot grow) */
+int fast_storage_write_batch(fast_storage_t *storage, size_t count,
+                             const char *const *keys, const size_t *key_lens,
+                             const char *const *values, const size_t *value_lens);
+
+/* Look up count keys; absent keys get NULL/0. Returns the number found */
+size_t fast_storage_read_many(fast_storage_t *storage, size_t count,
+                              const char *const *keys, const size_t *key_lens,
+                              char **values_out, size_t *value_lens_out);
+
+/* Copy at most buf_len bytes of the value into buf. Returns 0 with the full
+ * value length (which may exceed buf_len), or -1 if key is absent */
+int fast_storage_read_copy(fast_storage_t *storage, const char *key, size_t key_len,
+                           char *buf, size_t buf_len, size_t *value_len_out);
+
+/* Keep everything readable at pin time mapped until the matching unpin
+ * (nestable). A thread pins one store at a time: -1 if it already pins
+ * another. The writer thread never needs to pin */
+int fast_storage_pin(fast_storage_t *storage);
+void fast_storage_unpin(fast_storage_t *storage);
+
+/* Returns 0, or -1 if key is absent */
+int fast_storage_remove(fast_storage_t *storage, const char *key, size_t key_len);
+
+/* Rewrite live records into a fresh file renamed over the original.
+ * Returns 0, or -1 with the store unchanged */
+int fast_storage_compact(fast_storage_t *storage);
+/* Checkpoint the index now (destroy does so too). Returns 0 or -1 */
+int fast_storage_checkpoint(fast_storage_t *storage);
+void fast_storage_get_stats(fast_storage_t *storage, fast_storage_stats_t *stats);
+
+/* Select durability; interval_ms applies to FAST_STORAGE_GROUP (0: 10 ms).
+ * In FAST_STORAGE_SYNC a write that cannot be made durable returns -1
+ * although it is applied. Returns 0 or -1 */
+int fast_storage_set_durability(fast_storage_t *storage, fast_storage_durability_t durability,
+                                unsigned interval_ms);
+/* Make everything written so far durable, whatever the mode. Returns 0 or -1 */
+int fast_storage_sync(fast_storage_t *storage);
+
+/* Commit and start writeback; a sync commit in GROUP and SYNC modes */
+void fast_storage_flush(fast_storage_t *storage);
+bool fast_storage_contains(fast_storage_t *storage, const char *key, size_t key_len);
+
+size_t fast_storage_size(fast_storage_t *storage);        /* Live keys */
+size_t fast_storage_bytes_used(fast_storage_t *storage);  /* Log bytes, live and dead */
+size_t fast_storage_capacity(fast_storage_t *storage);    /* Log bytes available */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FASTSTORAGE_H */
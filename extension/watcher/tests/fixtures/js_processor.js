@@ -0,0 +1,22 @@
+/*
+ * JavaScript processor used by test_processor: same verdicts as
+ * native_processor.c with "drop-odd", written per event (main). A batch
+ * whose first event is in function "slow()" takes 300 ms.
+ */
+
+'use strict';
+
+function main(event) {
+    if (event.function === 'slow()' && event.event_id === 'evt-0') {
+        const until = Date.now() + 300;
+        while (Date.now() < until) {}
+    }
+    const seq = Number(event.event_id.split('-').pop());
+    if (event.deltas.length === 0 || seq % 2 === 1) {
+        return { action: 'drop' };
+    }
+    const changed = event.deltas.reduce((total, run) => total + run.len, 0);
+    return { action: 'annotate', annotations: { changed_bytes: changed, variable: event.variable_name } };
+}
+
+module.exports = { main };
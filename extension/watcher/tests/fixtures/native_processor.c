@@ -0,0 +1,56 @@
+/*
+ * Compiled processor used by test_processor: drops events without deltas,
+ * annotates the rest with their changed byte count and variable name.
+ * Config "drop-odd" also drops events with an odd event_seq.
+ */
+
+#include "watcher_processor_abi.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int drop_odd;
+} fixture_state;
+
+static void* fixture_create(const char* config) {
+    if (strcmp(config, "reject") == 0) {
+        return NULL;
+    }
+    fixture_state* state = calloc(1, sizeof(fixture_state));
+    if (state) {
+        state->drop_odd = strcmp(config, "drop-odd") == 0;
+    }
+    return state;
+}
+
+static void fixture_destroy(void* state) {
+    free(state);
+}
+
+static void fixture_process(void* state, const watcher_event_view* events, size_t count,
+                            uint8_t* actions, const watcher_processor_host* host) {
+    const fixture_state* s = state;
+    for (size_t i = 0; i < count; ++i) {
+        const watcher_event_view* e = &events[i];
+        if (e->delta_count == 0 || (s->drop_odd && (e->event_seq & 1))) {
+            actions[i] = WATCHER_ACTION_DROP;
+            continue;
+        }
+        int64_t changed = 0;
+        for (uint32_t r = 0; r < e->delta_count; ++r) {
+            changed += e->deltas[r].length;
+        }
+        host->annotate_int(host->context, (uint32_t)i, "changed_bytes", changed);
+        host->annotate_string(host->context, (uint32_t)i, "variable", e->variable_name,
+                              strlen(e->variable_name));
+        actions[i] = WATCHER_ACTION_ANNOTATE;
+    }
+}
+
+static const watcher_processor_api fixture_api = {
+    WATCHER_PROCESSOR_ABI_VERSION, 0, fixture_create, fixture_destroy, fixture_process
+};
+
+const watcher_processor_api* watcher_processor_entry(void) {
+    return &fixture_api;
+}
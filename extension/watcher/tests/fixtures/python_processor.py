@@ -0,0 +1,21 @@
+"""
+Python processor used by test_processor: same verdicts as native_processor.c
+with "drop-odd", written against the whole batch (main_batch). A batch
+whose first event is in function "slow()" takes 300 ms.
+"""
+
+import time
+
+
+def main_batch(batch):
+    if batch.count and batch.event(0)['function'] == 'slow()':
+        time.sleep(0.3)
+    for i in range(batch.count):
+        event_seq, _, _, _, _, _, _, _, delta_runs, delta_bytes, _ = batch.record(i)
+        if delta_runs == 0 or event_seq & 1:
+            batch.drop(i)
+            continue
+        batch.annotate(i, {
+            'changed_bytes': delta_bytes,
+            'variable': batch.event(i)['variable_name'],
+        })
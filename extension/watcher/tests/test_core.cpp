@@ -1,9 +1,28 @@
 #include <watcher_core.hpp>
+#include <event_ring.hpp>
+#include <delta_engine.hpp>
+#include <page_index.hpp>
+#include <latency_histogram.hpp>
+#include <event_clock.hpp>
+#include <event_channel.hpp>
+#include <symbolizer.hpp>
+#include <event_recording.hpp>
 #include <cassert>
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <cstring>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <map>
+#include <random>
+#include <sys/mman.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <csignal>
 
 using namespace watcher;
 
@@ -11,18 +30,65 @@ using namespace watcher;
 // Test Utilities
 // ============================================================================
 
+static int g_failures = 0;
+
 void test_print(const std::string& test_name, bool passed) {
+    if (!passed) {
+        ++g_failures;
+    }
     std::cout << "[" << (passed ? "PASS" : "FAIL") << "] " << test_name << std::endl;
 }
 
+/// Run step() every 5 ms until it returns true or timeout_ms passes
+/// @return the last step() result
+bool poll_until(const std::function<bool()>& step, int timeout_ms = 2000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!step()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+/// Hand every event the pipeline delivers to visit() until done() holds
+/// or timeout_ms passes
+/// @return done() at return
+bool poll_events(WatcherCore& core, const std::function<void(const EnrichedEvent&)>& visit,
+                 const std::function<bool()>& done, int timeout_ms = 2000) {
+    std::vector<EnrichedEvent> events;
+    return poll_until([&] {
+        events.clear();
+        core.dequeueEvents(events, 16);
+        for (const auto& event : events) {
+            visit(event);
+        }
+        return done();
+    }, timeout_ms);
+}
+
 // ============================================================================
 // Core Tests
 // ============================================================================
 
 void test_initialization() {
     auto& core = WatcherCore::getInstance();
+
+    // A recording that cannot be opened fails initialization
+    mkdir("./test_output_bad", 0755);
+    FILE* bad = fopen("./test_output_bad/events.wrec", "wb");
+    bool refused = bad && fputs("not a recording", bad) >= 0;
+    if (bad) {
+        fclose(bad);
+    }
+    refused = refused && !core.initialize("./test_output_bad", 1000) &&
+              !core.getErrorMessage().empty() && core.getState() == WatcherCore::UNINITIALIZED;
+    unlink("./test_output_bad/events.wrec");
+    rmdir("./test_output_bad");
+
     bool success = core.initialize("./test_output", 1000);
-    test_print("Initialization", success && core.getState() == WatcherCore::INITIALIZED);
+    test_print("Initialization", refused && success && core.getState() == WatcherCore::INITIALIZED);
 }
 
 void test_register_unregister() {
@@ -87,6 +153,35 @@ void test_snapshot() {
     test_print("Snapshot Operations", read_success && write_success && verify_success);
 }
 
+void test_snapshot_views() {
+    auto& core = WatcherCore::getInstance();
+    
+    if (core.getState() != WatcherCore::INITIALIZED) {
+        core.initialize("./test_output", 1000);
+    }
+    
+    char page[4096];
+    memset(page, 'A', sizeof(page));
+    MutationDepth depth{true, 0};
+    std::string var_id = core.registerPage(page, 4096, "view_test", FLAG_TRACK_THREADS, depth);
+    
+    // Unchanged variable: every reader shares one buffer
+    SnapshotView first = core.snapshotView(var_id);
+    SnapshotView again = core.snapshotView(var_id);
+    bool shared = first && first == again && first->size() == 4096 && (*first)[0] == 'A';
+    
+    // A new baseline yields a new view; the held one keeps its bytes
+    std::vector<uint8_t> baseline(4096, 'B');
+    core.writeSnapshot(var_id, baseline);
+    SnapshotView updated = core.snapshotView(var_id);
+    bool replaced = updated && updated != first && (*updated)[0] == 'B' && (*first)[0] == 'A';
+    
+    core.unregisterPage(var_id);
+    bool unknown = core.snapshotView(var_id) == nullptr;
+    
+    test_print("Snapshot Views", shared && replaced && unknown);
+}
+
 void test_state_transitions() {
     auto& core = WatcherCore::getInstance();
     
@@ -145,6 +240,1390 @@ void test_error_handling() {
     test_print("Error Handling", error_handled);
 }
 
+void test_native_pipeline() {
+    auto& core = WatcherCore::getInstance();
+    
+    // A stopped core can be brought back up for another session
+    if (core.getState() != WatcherCore::INITIALIZED &&
+        !core.initialize("./test_output", 1000)) {
+        test_print("Native Slow-Path Pipeline", false);
+        return;
+    }
+    
+    auto* page = static_cast<volatile uint8_t*>(mmap(nullptr, 4096, PROT_READ | PROT_WRITE,
+                                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    memset(const_cast<uint8_t*>(page), 0, 4096);
+    
+    std::atomic<int> processed(0), batched(0);
+    core.setEventProcessor([&](EnrichedEvent&) {
+        processed.fetch_add(1);
+        return true;
+    });
+    core.setBatchProcessor([&](EnrichedEvent*, size_t count, uint8_t*) {
+        batched.fetch_add(static_cast<int>(count));
+    });
+    
+    MutationDepth depth{true, 0};
+    std::string var_id = core.registerPage(const_cast<uint8_t*>(page), 4096, "pipeline_var",
+                                          FLAG_TRACK_THREADS, depth);
+    bool started = !var_id.empty() && core.start();
+    
+    // Fault on a write-protected page; the handler lets it through
+    page[100] = 42;
+    page[101] = 43;
+    
+    // Collect until the write shows up as a delta (or time out)
+    std::vector<EnrichedEvent> events;
+    bool delta_seen = false;
+    if (started) {
+        poll_events(core, [&](const EnrichedEvent& event) {
+            events.push_back(event);
+            for (const auto& run : event.deltas.runs) {
+                if (run.offset <= 100 && run.offset + run.length > 100 &&
+                    event.deltas.newBytes(run)[100 - run.offset] == 42) {
+                    delta_seen = true;
+                }
+            }
+        }, [&] { return delta_seen; });
+    }
+    
+    bool tagged = !events.empty() && !events[0].variable_ids.empty() &&
+                  events[0].variable_ids[0] == var_id && events[0].variable_name == "pipeline_var";
+    bool snapshot_updated = core.readSnapshot(var_id)[101] == 43;
+    bool ip_captured = !events.empty() && events[0].ip != 0 && events[0].tid != 0;
+    int64_t age_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count() -
+        static_cast<int64_t>(events.empty() ? 0 : events[0].ts_ns);
+    bool wall_timestamp = age_ns >= 0 && age_ns < 10000000000LL;
+    auto stages = core.getPipelineMetrics();
+    bool stages_recorded = stages.fault_to_unprotect.count > 0 && stages.end_to_end.count > 0 &&
+                           stages.ioctls > 0 && core.getMetrics().mean_latency_ms > 0.0;
+    
+    core.setEventProcessor(nullptr);
+    core.setBatchProcessor(nullptr);
+    core.unregisterPage(var_id);
+    core.stop();
+    munmap(const_cast<uint8_t*>(page), 4096);
+    
+    test_print("Native Slow-Path Pipeline", started && delta_seen && tagged &&
+                                            processed.load() > 0 && batched.load() >= processed.load() &&
+                                            snapshot_updated && ip_captured &&
+                                            stages_recorded && wall_timestamp);
+}
+
+void test_async_wp_pipeline() {
+    auto& core = WatcherCore::getInstance();
+    
+    WatcherConfig config;
+    config.output_dir = "./test_output";
+    config.max_queue_size = 1000;
+    config.fault_mode = FaultMode::ASYNC_SCAN;
+    if (!core.initialize(config)) {
+        test_print("Async WP Pipeline", false);
+        return;
+    }
+    if (core.getFaultMode() != FaultMode::ASYNC_SCAN) {
+        test_print("Async WP Pipeline (kernel lacks WP_ASYNC, skipped)", true);
+        return;
+    }
+    
+    // Three adjacent pages, one variable each; scanned as one range
+    const size_t pages = 3;
+    auto* region = static_cast<volatile uint8_t*>(mmap(nullptr, pages * 4096, PROT_READ | PROT_WRITE,
+                                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    memset(const_cast<uint8_t*>(region), 0, pages * 4096);
+    
+    MutationDepth depth{true, 0};
+    std::vector<std::string> ids;
+    for (size_t p = 0; p < pages; ++p) {
+        ids.push_back(core.registerPage(const_cast<uint8_t*>(region) + p * 4096, 4096,
+                                        "async_var", FLAG_TRACK_THREADS, depth));
+    }
+    bool started = core.start();
+    
+    // Writers never block in this mode
+    for (size_t p = 0; p < pages; ++p) {
+        region[p * 4096 + 8] = static_cast<uint8_t>(p + 1);
+    }
+    
+    std::vector<bool> seen(pages, false);
+    size_t seen_count = 0;
+    if (started) {
+        poll_events(core, [&](const EnrichedEvent& event) {
+            for (size_t p = 0; p < pages; ++p) {
+                if (!seen[p] && event.variable_ids.size() == 1 && event.variable_ids[0] == ids[p] &&
+                    event.deltas.size() == 1 && event.deltas.runs[0].offset == 8 &&
+                    event.deltas.newBytes(event.deltas.runs[0])[0] == p + 1) {
+                    seen[p] = true;
+                    ++seen_count;
+                }
+            }
+        }, [&] { return seen_count == pages; });
+    }
+    
+    for (const auto& id : ids) {
+        core.unregisterPage(id);
+    }
+    core.stop();
+    munmap(const_cast<uint8_t*>(region), pages * 4096);
+    
+    test_print("Async WP Pipeline", started && seen_count == pages);
+}
+
+void test_sharded_pipeline() {
+    auto& core = WatcherCore::getInstance();
+    
+    // Two handler shards, both pinned to CPU 0; pages alternate between them
+    WatcherConfig config;
+    config.output_dir = "./test_output";
+    config.max_queue_size = 1000;
+    config.handler_threads = 2;
+    config.handler_cpus = {0};
+    if (!core.initialize(config)) {
+        test_print("Sharded Handler Pipeline", false);
+        return;
+    }
+    
+    const size_t pages = 4;
+    auto* region = static_cast<volatile uint8_t*>(mmap(nullptr, pages * 4096, PROT_READ | PROT_WRITE,
+                                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    memset(const_cast<uint8_t*>(region), 0, pages * 4096);
+    
+    MutationDepth depth{true, 0};
+    std::vector<std::string> ids;
+    for (size_t p = 0; p < pages; ++p) {
+        ids.push_back(core.registerPage(const_cast<uint8_t*>(region) + p * 4096, 4096,
+                                        "sharded_var", FLAG_TRACK_THREADS, depth));
+    }
+    bool started = core.start();
+    
+    // Each writer blocks on whichever shard owns its page
+    std::vector<std::thread> writers;
+    for (size_t t = 0; t < 2; ++t) {
+        writers.emplace_back([&, t]() {
+            for (size_t p = t; p < pages; p += 2) {
+                region[p * 4096 + 16] = static_cast<uint8_t>(p + 1);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    
+    std::vector<bool> seen(pages, false);
+    size_t seen_count = 0;
+    if (started) {
+        poll_events(core, [&](const EnrichedEvent& event) {
+            for (size_t p = 0; p < pages; ++p) {
+                if (!seen[p] && event.variable_ids.size() == 1 && event.variable_ids[0] == ids[p] &&
+                    event.deltas.size() == 1 && event.deltas.runs[0].offset == 16 &&
+                    event.deltas.newBytes(event.deltas.runs[0])[0] == p + 1) {
+                    seen[p] = true;
+                    ++seen_count;
+                }
+            }
+        }, [&] { return seen_count == pages; });
+    }
+    
+    for (const auto& id : ids) {
+        core.unregisterPage(id);
+    }
+    core.stop();
+    munmap(const_cast<uint8_t*>(region), pages * 4096);
+    
+    test_print("Sharded Handler Pipeline", started && seen_count == pages);
+}
+
+void test_register_range() {
+    auto& core = WatcherCore::getInstance();
+    
+    if (!core.initialize("./test_output", 1000)) {
+        test_print("Register Range", false);
+        return;
+    }
+    
+    // 2 MiB THP-eligible buffer registered as one variable
+    const size_t huge = 2 * 1024 * 1024;
+    uint8_t* raw = static_cast<uint8_t*>(mmap(nullptr, 2 * huge, PROT_READ | PROT_WRITE,
+                                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    auto* buf = reinterpret_cast<volatile uint8_t*>(
+        (reinterpret_cast<uintptr_t>(raw) + huge - 1) & ~(uintptr_t)(huge - 1));
+    madvise(const_cast<uint8_t*>(buf), huge, MADV_HUGEPAGE);
+    memset(const_cast<uint8_t*>(buf), 0, huge);
+    
+    MutationDepth depth{true, 0};
+    std::string var_id = core.registerRange(const_cast<uint8_t*>(buf), huge, "range_var",
+                                            FLAG_TRACK_THREADS, depth);
+    bool started = !var_id.empty() && core.start();
+    
+    buf[3 * 4096 + 10] = 7;
+    buf[300 * 4096 + 20] = 9;
+    
+    // Each write is diffed against its own sub-page only
+    bool first_seen = false, second_seen = false;
+    if (started) {
+        poll_events(core, [&](const EnrichedEvent& event) {
+            bool tagged = event.variable_ids.size() == 1 && event.variable_ids[0] == var_id &&
+                          event.pre_snapshot.size() == PAGE_SIZE;
+            for (const auto& run : event.deltas.runs) {
+                first_seen |= tagged && run.offset == 3 * 4096 + 10 && event.deltas.newBytes(run)[0] == 7;
+                second_seen |= tagged && run.offset == 300 * 4096 + 20 && event.deltas.newBytes(run)[0] == 9;
+            }
+        }, [&] { return first_seen && second_seen; });
+    }
+    
+    auto snapshot = core.readSnapshot(var_id);
+    bool snapshot_ok = snapshot.size() == huge && snapshot[3 * 4096 + 10] == 7 &&
+                       snapshot[300 * 4096 + 20] == 9;
+    
+    core.unregisterPage(var_id);
+    core.stop();
+    munmap(raw, 2 * huge);
+    
+    test_print("Register Range", started && first_seen && second_seen && snapshot_ok);
+}
+
+void test_register_ranges() {
+    auto& core = WatcherCore::getInstance();
+    
+    if (core.getState() != WatcherCore::INITIALIZED &&
+        !core.initialize("./test_output", 1000)) {
+        test_print("Bulk Register & Snapshots", false);
+        return;
+    }
+    
+    const size_t count = 64;
+    auto* pages = static_cast<uint8_t*>(mmap(nullptr, count * 4096, PROT_READ | PROT_WRITE,
+                                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    std::vector<RangeRegistration> ranges;
+    for (size_t i = 0; i < count; ++i) {
+        memset(pages + i * 4096, static_cast<int>(i), 4096);
+        ranges.push_back(RangeRegistration{pages + i * 4096, 4096, "bulk_var", FLAG_TRACK_THREADS,
+                                           MutationDepth{true, 0}});
+    }
+    ranges.push_back(RangeRegistration{nullptr, 4096, "null_var", FLAG_TRACK_THREADS,
+                                       MutationDepth{true, 0}});
+    
+    std::vector<std::string> ids;
+    bool registered = core.registerRanges(ranges.data(), ranges.size(), ids) == count &&
+                      ids.size() == count + 1 && ids.back().empty();
+    
+    // Snapshots land in caller buffers; a short buffer only reports the size
+    bool snapshots_ok = registered;
+    uint8_t buffer[4096];
+    for (size_t i = 0; snapshots_ok && i < count; ++i) {
+        snapshots_ok = core.readSnapshotInto(ids[i], buffer, sizeof(buffer)) == 4096 &&
+                       buffer[0] == i && buffer[4095] == i;
+    }
+    uint8_t small[16] = {0};
+    bool short_ok = registered && core.readSnapshotInto(ids[0], small, sizeof(small)) == 4096 &&
+                    small[0] == 0 && core.readSnapshotInto("var-missing", buffer, sizeof(buffer)) == 0;
+    
+    memset(buffer, 0xAB, sizeof(buffer));
+    bool write_ok = registered && core.writeSnapshotFrom(ids[1], buffer, sizeof(buffer)) &&
+                    core.readSnapshot(ids[1])[10] == 0xAB;
+    
+    for (size_t i = 0; registered && i < count; ++i) {
+        core.unregisterPage(ids[i]);
+    }
+    munmap(pages, count * 4096);
+    
+    test_print("Bulk Register & Snapshots", registered && snapshots_ok && short_ok && write_ok);
+}
+
+void test_mutation_depth() {
+    auto& core = WatcherCore::getInstance();
+    
+    if (core.getState() != WatcherCore::INITIALIZED &&
+        !core.initialize("./test_output", 1000)) {
+        test_print("Byte-Range Mutation Depth", false);
+        return;
+    }
+    
+    // Two pages; only the first 16 bytes are tracked, without thread tracking
+    auto* page = static_cast<volatile uint8_t*>(mmap(nullptr, 2 * 4096, PROT_READ | PROT_WRITE,
+                                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    memset(const_cast<uint8_t*>(page), 0, 2 * 4096);
+    std::string var_id = core.registerRange(const_cast<uint8_t*>(page), 2 * 4096, "struct_var", EventFlags(0),
+                                            MutationDepth{false, 16});
+    bool started = !var_id.empty() && core.start();
+    bool snapshot_sized = started && core.readSnapshot(var_id).size() == 16;
+    
+    // Inside the span: a 16-byte diff, no writer attribution
+    page[4] = 5;
+    bool span_ok = false, attribution_skipped = false;
+    if (started) {
+        poll_events(core, [&](const EnrichedEvent& event) {
+            if (event.deltas.size() == 1 && event.deltas.runs[0].offset == 4 && event.pre_snapshot.size() == 16) {
+                span_ok = true;
+                attribution_skipped = event.tid == 0 && event.ip == 0 && event.symbol == "??";
+            }
+        }, [&] { return span_ok; });
+    }
+    
+    // Same page past the span: still a fault, but nothing to diff
+    page[200] = 6;
+    bool outside_ok = false;
+    if (span_ok) {
+        poll_events(core, [&](const EnrichedEvent& event) {
+            outside_ok |= reinterpret_cast<uintptr_t>(event.fault_addr) / 4096 ==
+                              reinterpret_cast<uintptr_t>(page) / 4096 && event.deltas.empty();
+        }, [&] { return outside_ok; });
+    }
+    
+    // The second page was never armed
+    uint64_t received = core.getMetrics().events_received;
+    page[4096 + 8] = 7;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    bool unarmed = core.getMetrics().events_received == received;
+    
+    core.unregisterPage(var_id);
+    core.stop();
+    munmap(const_cast<uint8_t*>(page), 2 * 4096);
+    
+    test_print("Byte-Range Mutation Depth", snapshot_sized && span_ok && attribution_skipped && outside_ok &&
+                                                unarmed);
+}
+
+void test_sampling_policies() {
+    auto& core = WatcherCore::getInstance();
+
+    if (core.getState() != WatcherCore::INITIALIZED &&
+        !core.initialize("./test_output", 1000)) {
+        test_print("Sampling Policies", false);
+        return;
+    }
+
+    auto* sampled = static_cast<volatile uint8_t*>(mmap(nullptr, 4096, PROT_READ | PROT_WRITE,
+                                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    auto* coalesced = static_cast<volatile uint8_t*>(mmap(nullptr, 4096, PROT_READ | PROT_WRITE,
+                                                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    memset(const_cast<uint8_t*>(sampled), 0, 4096);
+    memset(const_cast<uint8_t*>(coalesced), 0, 4096);
+
+    MutationDepth depth{true, 0};
+    std::string sampled_id = core.registerPage(const_cast<uint8_t*>(sampled), 4096, "sampled_var",
+                                               FLAG_TRACK_THREADS, depth);
+    std::string coalesced_id = core.registerPage(const_cast<uint8_t*>(coalesced), 4096, "coalesced_var",
+                                                 FLAG_TRACK_THREADS, depth);
+    SamplingPolicy every4;
+    every4.mode = SamplingPolicy::EVERY_NTH;
+    every4.every_n = 4;
+    SamplingPolicy window;
+    window.mode = SamplingPolicy::COALESCE;
+    window.window_us = 50000;
+    SamplingPolicy invalid;
+    invalid.mode = SamplingPolicy::RATE_LIMIT;
+    bool policies_set = core.setSamplingPolicy(sampled_id, every4) && core.setSamplingPolicy(coalesced_id, window) &&
+                        !core.setSamplingPolicy(coalesced_id, invalid) &&
+                        !core.setSamplingPolicy("var-unknown", every4);
+    bool started = policies_set && core.start();
+    WatcherCore::Metrics before = core.getMetrics();
+
+    // Every 4th of 8 separate writes is an event; the rest are policy drops.
+    // A page is never re-protected under a write still pending, so each
+    // write faults once.
+    for (int i = 1; i <= 8 && started; ++i) {
+        sampled[0] = static_cast<uint8_t>(i);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    // One fault opens a window; the following writes land unobserved
+    for (int i = 0; i < 10 && started; ++i) {
+        coalesced[i] = 1;
+    }
+
+    // Collect for a fixed time: extra events would be the failure
+    size_t sampled_events = 0, coalesced_events = 0;
+    bool combined_delta = false;
+    if (started) {
+        poll_events(core, [&](const EnrichedEvent& event) {
+            if (event.variable_name == "sampled_var") {
+                ++sampled_events;
+            } else if (event.variable_name == "coalesced_var") {
+                ++coalesced_events;
+                combined_delta = event.deltas.size() == 1 && event.deltas.runs[0].offset == 0 &&
+                                 event.deltas.runs[0].length == 10;
+            }
+        }, [] { return false; }, 300);
+    }
+
+    WatcherCore::Metrics metrics = core.getMetrics();
+    bool counted_apart = metrics.policy_drops - before.policy_drops == 6 &&
+                         metrics.events_dropped == before.events_dropped;
+    bool window_closed = core.getPipelineMetrics().coalesced_windows >= 1;
+
+    core.unregisterPage(sampled_id);
+    core.unregisterPage(coalesced_id);
+    core.stop();
+    munmap(const_cast<uint8_t*>(sampled), 4096);
+    munmap(const_cast<uint8_t*>(coalesced), 4096);
+
+    test_print("Sampling Policies", policies_set && started && sampled_events == 2 &&
+                                        coalesced_events == 1 && combined_delta && counted_apart && window_closed);
+}
+
+void test_same_value_store() {
+    auto& core = WatcherCore::getInstance();
+
+    if (core.getState() != WatcherCore::INITIALIZED &&
+        !core.initialize("./test_output", 1000)) {
+        test_print("Same-Value Store Then Write", false);
+        return;
+    }
+
+    auto* page = static_cast<volatile uint8_t*>(mmap(nullptr, 4096, PROT_READ | PROT_WRITE,
+                                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    memset(const_cast<uint8_t*>(page), 0, 4096);
+
+    MutationDepth depth{true, 0};
+    std::string var_id = core.registerPage(const_cast<uint8_t*>(page), 4096, "same_var",
+                                          static_cast<EventFlags>(0), depth);
+    bool started = !var_id.empty() && core.start();
+    WatcherCore::Metrics before = core.getMetrics();
+
+    // A store of the value already there never visibly lands; the real
+    // write to the same address after it must still be its own event
+    page[10] = 0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    page[10] = 7;
+
+    size_t events = 0;
+    bool delta_seen = false;
+    if (started) {
+        poll_events(core, [&](const EnrichedEvent& event) {
+            ++events;
+            for (const auto& run : event.deltas.runs) {
+                if (run.offset <= 10 && run.offset + run.length > 10 &&
+                    event.deltas.newBytes(run)[10 - run.offset] == 7) {
+                    delta_seen = true;
+                }
+            }
+        }, [] { return false; }, 300);
+    }
+    bool counted_once = core.getMetrics().events_received - before.events_received == 2;
+
+    core.unregisterPage(var_id);
+    core.stop();
+    munmap(const_cast<uint8_t*>(page), 4096);
+
+    test_print("Same-Value Store Then Write", started && delta_seen && events == 2 && counted_once);
+}
+
+void test_baseline_chain() {
+    auto& core = WatcherCore::getInstance();
+
+    // Writers never block in ASYNC_SCAN, so they race the slow path's read
+    // of the post-state; SYNC (the fallback) only races the release window
+    WatcherConfig config;
+    config.output_dir = "./test_output";
+    config.max_queue_size = 1000;
+    config.fault_mode = FaultMode::ASYNC_SCAN;
+    if (!core.initialize(config)) {
+        test_print("Baseline Chain Under Concurrent Writes", false);
+        return;
+    }
+
+    auto* page = static_cast<volatile uint8_t*>(mmap(nullptr, 4096, PROT_READ | PROT_WRITE,
+                                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    memset(const_cast<uint8_t*>(page), 0, 4096);
+
+    // Every event's pre-state must be exactly the post-state reported before it
+    std::mutex chain_mutex;
+    std::vector<std::pair<std::vector<uint8_t>, std::vector<uint8_t>>> chain;
+    core.setEventProcessor([&](EnrichedEvent& event) {
+        if (!event.pre_snapshot.empty()) {
+            std::lock_guard<std::mutex> lock(chain_mutex);
+            chain.emplace_back(event.pre_snapshot, event.post_snapshot);
+        }
+        return true;
+    });
+
+    MutationDepth depth{true, 0};
+    std::string var_id = core.registerPage(const_cast<uint8_t*>(page), 4096, "chain_var",
+                                          static_cast<EventFlags>(0), depth);
+    bool started = !var_id.empty() && core.start();
+
+    std::atomic<bool> writing(started);
+    std::thread writer([&]() {
+        // Every other byte: thousands of delta runs per event keep the slow
+        // path inside enrichment for a while. Short sleeps let each wakeup
+        // preempt it even on a single CPU.
+        for (uint32_t n = 1; writing.load(std::memory_order_relaxed);) {
+            for (int burst = 0; burst < 256; ++burst, ++n) {
+                page[(n * 2) % 4096] = static_cast<uint8_t>(n / 2048 + 1);
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(5));
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    writing = false;
+    writer.join();
+    core.stop();
+    core.setEventProcessor(nullptr);
+    core.unregisterPage(var_id);
+    munmap(const_cast<uint8_t*>(page), 4096);
+
+    size_t breaks = 0;
+    for (size_t i = 1; i < chain.size(); ++i) {
+        breaks += chain[i].first != chain[i - 1].second;
+    }
+    test_print("Baseline Chain Under Concurrent Writes", started && chain.size() >= 2 && breaks == 0);
+}
+
+void test_drain_and_stop() {
+    auto& core = WatcherCore::getInstance();
+
+    if (core.getState() != WatcherCore::INITIALIZED &&
+        !core.initialize("./test_output", 1000)) {
+        test_print("Drain-Aware Pause/Stop", false);
+        return;
+    }
+
+    // page is written before the pause, clean is first written while paused,
+    // late is registered while paused
+    auto* page = static_cast<volatile uint8_t*>(mmap(nullptr, 3 * 4096, PROT_READ | PROT_WRITE,
+                                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    memset(const_cast<uint8_t*>(page), 0, 3 * 4096);
+    volatile uint8_t* clean = page + 4096;
+    volatile uint8_t* late = page + 2 * 4096;
+
+    // Paused writes must show up in the delta of the next event on their page
+    std::mutex seen_mutex;
+    std::map<std::string, std::pair<uint8_t, uint8_t>> seen;  // Name -> byte 10 of its first event
+    core.setEventProcessor([&](EnrichedEvent& event) {
+        if (event.pre_snapshot.size() > 10) {
+            std::lock_guard<std::mutex> lock(seen_mutex);
+            seen.emplace(event.variable_name, std::make_pair(event.pre_snapshot[10], event.post_snapshot[10]));
+        }
+        return true;
+    });
+
+    MutationDepth depth{true, 0};
+    std::string var_id = core.registerPage(const_cast<uint8_t*>(page), 4096, "drain_var", static_cast<EventFlags>(0), depth);
+    std::string clean_id = core.registerPage(const_cast<uint8_t*>(clean), 4096, "clean_var", static_cast<EventFlags>(0), depth);
+    bool started = !var_id.empty() && !clean_id.empty() && core.start();
+
+    // pause() returns with everything the writes produced already persisted
+    for (int i = 0; i < 50 && started; ++i) {
+        page[i] = 1;
+    }
+    bool paused = started && core.pause(2000);
+    WatcherCore::Metrics at_pause = core.getMetrics();
+    bool drained_on_pause = at_pause.events_received > 0 && at_pause.events_processed == at_pause.events_received;
+
+    // Protection is lifted while paused: writes neither fault nor queue. A
+    // range registered now is not armed until resume().
+    for (int i = 0; i < 50 && paused; ++i) {
+        page[100 + i] = 2;
+    }
+    clean[10] = 2;
+    std::string late_id = paused ? core.registerPage(const_cast<uint8_t*>(late), 4096, "late_var",
+                                                     static_cast<EventFlags>(0), depth) : "";
+    uint64_t ioctls_paused = core.getPipelineMetrics().ioctls;
+    late[10] = 2;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    bool quiet = !late_id.empty() && core.getMetrics().events_received == at_pause.events_received &&
+                 core.getPipelineMetrics().ioctls == ioctls_paused;
+
+    bool resumed = paused && core.resume();
+    page[200] = 3;
+    clean[20] = 3;
+    late[20] = 3;
+    bool rearmed = resumed && poll_until([&] {
+        std::lock_guard<std::mutex> lock(seen_mutex);
+        return seen.count("clean_var") && seen.count("late_var");
+    });
+    bool paused_in_delta = false;
+    {
+        std::lock_guard<std::mutex> lock(seen_mutex);
+        paused_in_delta = rearmed && seen["clean_var"] == std::make_pair<uint8_t, uint8_t>(0, 2) &&
+                          seen["late_var"] == std::make_pair<uint8_t, uint8_t>(0, 2);
+    }
+
+    // An idle pipeline stops well inside the timeout, with nothing left behind
+    for (int i = 0; i < 50 && resumed; ++i) {
+        page[300 + i] = 4;
+    }
+    auto stop_start = std::chrono::steady_clock::now();
+    bool stopped = core.stop(5000);
+    auto stop_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - stop_start).count();
+    WatcherCore::Metrics at_stop = core.getMetrics();
+    bool drained_on_stop = at_stop.events_processed == at_stop.events_received &&
+                           at_stop.queue_depth == 0;
+
+    core.setEventProcessor(nullptr);
+    core.unregisterPage(var_id);
+    core.unregisterPage(clean_id);
+    core.unregisterPage(late_id);
+    munmap(const_cast<uint8_t*>(page), 3 * 4096);
+
+    test_print("Drain-Aware Pause/Stop", started && paused && drained_on_pause && quiet &&
+                                             resumed && rearmed && paused_in_delta && stopped &&
+                                             stop_ms < 1000 && drained_on_stop);
+}
+
+void test_event_channel_pipeline() {
+    auto& core = WatcherCore::getInstance();
+    
+    if (core.getState() != WatcherCore::INITIALIZED &&
+        !core.initialize("./test_output", 1000)) {
+        test_print("Event Channel Pipeline", false);
+        return;
+    }
+    
+    // Once open, events go to the channel only (run after the other core tests)
+    EventChannel* channel = core.openEventChannel(256);
+    bool opened = channel != nullptr && core.openEventChannel(0) == channel;
+    
+    auto* page = static_cast<volatile uint8_t*>(mmap(nullptr, 4096, PROT_READ | PROT_WRITE,
+                                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    memset(const_cast<uint8_t*>(page), 0, 4096);
+    
+    MutationDepth depth{true, 0};
+    std::string var_id = core.registerPage(const_cast<uint8_t*>(page), 4096, "channel_var",
+                                          FLAG_TRACK_THREADS, depth);
+    uint32_t var_index = core.variableIndex(var_id);
+    bool started = opened && var_index != 0 && core.start();
+    
+    page[8] = 7;
+    
+    bool seen = false;
+    bool record_ok = false;
+    if (started) {
+        poll_until([&] {
+            uint64_t start = 0;
+            size_t n = channel->acquire(&start);
+            const auto* header = static_cast<const EventChannelHeader*>(channel->base());
+            const auto* slots = reinterpret_cast<const BinaryEventRecord*>(
+                static_cast<const uint8_t*>(channel->base()) + header->records_offset);
+            for (size_t i = 0; i < n; ++i) {
+                const BinaryEventRecord& rec = slots[(start + i) & (channel->capacity() - 1)];
+                if (rec.var_index == var_index) {
+                    seen = true;
+                    record_ok = rec.page_base == reinterpret_cast<uintptr_t>(page) &&
+                                rec.var_count == 1 && rec.tid != 0 && rec.ts_ns != 0;
+                }
+            }
+            channel->release(n);
+            return seen;
+        });
+    }
+    
+    std::vector<EnrichedEvent> events;
+    bool bypassed = core.dequeueEvents(events, 16) == 0;
+    
+    core.unregisterPage(var_id);
+    core.stop();
+    munmap(const_cast<uint8_t*>(page), 4096);
+    
+    test_print("Event Channel Pipeline", started && seen && record_ok && bypassed);
+}
+
+// ============================================================================
+// Event Ring Tests
+// ============================================================================
+
+void test_spsc_ring() {
+    SpscRing<FastPathEvent> ring(1000);
+    bool capacity_ok = ring.capacity() == 1024;
+    
+    // Fill to capacity, then one more must be rejected
+    bool fill_ok = true;
+    for (size_t i = 0; i < ring.capacity(); ++i) {
+        FastPathEvent event{};
+        event.event_seq = i;
+        fill_ok = fill_ok && ring.tryPush(event);
+    }
+    FastPathEvent overflow{};
+    bool full_rejected = !ring.tryPush(overflow);
+    
+    // Drain in FIFO order, half single-pop and half batch-pop
+    bool order_ok = true;
+    FastPathEvent event{};
+    for (size_t i = 0; i < 512; ++i) {
+        order_ok = order_ok && ring.tryPop(event) && event.event_seq == i;
+    }
+    std::vector<FastPathEvent> batch(1024);
+    size_t n = ring.popBatch(batch.data(), batch.size());
+    for (size_t i = 0; i < n; ++i) {
+        order_ok = order_ok && batch[i].event_seq == 512 + i;
+    }
+    bool empty_ok = n == 512 && ring.size() == 0 && !ring.tryPop(event);
+    
+    test_print("SPSC Ring", capacity_ok && fill_ok && full_rejected && order_ok && empty_ok);
+}
+
+void test_spsc_ring_threaded() {
+    SpscRing<FastPathEvent> ring(64);
+    const uint64_t total = 200000;
+    
+    std::thread producer([&]() {
+        for (uint64_t i = 0; i < total; ++i) {
+            FastPathEvent event{};
+            event.event_seq = i;
+            while (!ring.tryPush(event)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    
+    bool order_ok = true;
+    uint64_t expected = 0;
+    FastPathEvent batch[32];
+    while (expected < total) {
+        size_t n = ring.popBatch(batch, 32);
+        for (size_t i = 0; i < n; ++i) {
+            order_ok = order_ok && batch[i].event_seq == expected++;
+        }
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    
+    test_print("SPSC Ring (threaded)", order_ok && ring.size() == 0);
+}
+
+void test_mpsc_ring_threaded() {
+    MpscRing<FastPathEvent> ring(256);
+    const uint64_t per_producer = 50000;
+    const int producers = 3;
+    
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (uint64_t i = 0; i < per_producer; ++i) {
+                FastPathEvent event{};
+                event.tid = p;
+                event.event_seq = i;
+                while (!ring.tryPush(event)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    
+    // Per-producer order must be preserved
+    std::vector<uint64_t> next(producers, 0);
+    bool order_ok = true;
+    uint64_t received = 0;
+    FastPathEvent event{};
+    while (received < per_producer * producers) {
+        if (ring.tryPop(event)) {
+            order_ok = order_ok && event.event_seq == next[event.tid]++;
+            ++received;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    
+    test_print("MPSC Ring (threaded)", order_ok && ring.size() == 0);
+}
+
+void test_event_channel() {
+    auto channel = EventChannel::create(100);
+    if (!channel) {
+        test_print("Event Channel", false);
+        return;
+    }
+    auto* header = static_cast<const EventChannelHeader*>(channel->base());
+    bool layout_ok = channel->capacity() == 128 && header->magic == EVENT_CHANNEL_MAGIC &&
+                     header->record_size == 64 && offsetof(EventChannelHeader, head) == 64 &&
+                     offsetof(EventChannelHeader, dropped) == 136 &&
+                     header->records_offset + 128 * 64 <= channel->mappingSize();
+    
+    std::vector<BinaryEventRecord> records(200);
+    for (size_t i = 0; i < records.size(); ++i) {
+        records[i] = BinaryEventRecord{};
+        records[i].event_seq = i;
+    }
+    
+    // Move the cursors near the end so the next batch wraps
+    uint64_t start = 0;
+    bool order_ok = channel->push(records.data(), 100) == 100;
+    order_ok = order_ok && channel->acquire(&start) == 100 && start == 0;
+    channel->release(100);
+    
+    // 50 records: 28 before the end of the ring, 22 from its start
+    order_ok = order_ok && channel->push(records.data() + 100, 50) == 50;
+    const auto* slots = reinterpret_cast<const BinaryEventRecord*>(
+        static_cast<const uint8_t*>(channel->base()) + header->records_offset);
+    uint64_t expected = 100;
+    for (int round = 0; round < 2; ++round) {
+        size_t n = channel->acquire(&start);
+        order_ok = order_ok && n == (round == 0 ? 28u : 22u) && start == expected;
+        for (size_t i = 0; i < n; ++i) {
+            order_ok = order_ok && slots[(start + i) & 127].event_seq == expected++;
+        }
+        channel->release(n);
+    }
+    
+    // A full ring keeps what fits and counts the rest
+    bool drops_ok = channel->push(records.data(), 200) == 128 && channel->dropped() == 72 &&
+                    channel->size() == 128;
+    
+    test_print("Event Channel", layout_ok && order_ok && expected == 150 && drops_ok);
+}
+
+// ============================================================================
+// Page Index Tests
+// ============================================================================
+
+void test_page_index_lookup() {
+    // [0x1000,0x3000) var 1, [0x2000,0x4000) var 2 (overlap), [0x8000,0x9000) var 3
+    std::vector<IndexedRange> ranges = {
+        {0x2000, 0x4000, PAGE_SIZE, 2, nullptr},
+        {0x8000, 0x9000, PAGE_SIZE, 3, nullptr},
+        {0x1000, 0x3000, PAGE_SIZE, 1, nullptr},
+    };
+    PageIndexTable table(ranges);
+    
+    auto vars_at = [&](uint64_t addr) {
+        std::vector<uint32_t> vars;
+        const PageIndexTable::Segment* seg = table.find(addr);
+        for (uint32_t i = 0; seg && i < seg->count; ++i) {
+            vars.push_back(table.member(*seg, i).var_index);
+        }
+        return vars;
+    };
+    
+    bool ok = vars_at(0x0fff).empty() &&
+              vars_at(0x1000) == std::vector<uint32_t>{1} &&
+              vars_at(0x2abc) == std::vector<uint32_t>{1, 2} &&
+              vars_at(0x3000) == std::vector<uint32_t>{2} &&
+              vars_at(0x4000).empty() && vars_at(0x5000).empty() &&
+              vars_at(0x8fff) == std::vector<uint32_t>{3} &&
+              vars_at(0x9000).empty();
+    
+    test_print("Page Index Lookup", ok);
+}
+
+void test_shadow_arena() {
+    auto arena = std::make_shared<ShadowArena>();
+    
+    // Short spans are packed into slots of one sub-page
+    uint8_t* a = arena->allocate(16);
+    uint8_t* b = arena->allocate(16);
+    bool packed = a && b && a != b &&
+                  reinterpret_cast<uintptr_t>(a) / 4096 == reinterpret_cast<uintptr_t>(b) / 4096 &&
+                  arena->bytesInUse() == 2 * ShadowArena::MIN_SLOT;
+    
+    // Longer ones get whole sub-pages; freed blocks are reused
+    uint8_t* pages = arena->allocate(3 * 4096 + 1);
+    bool aligned = pages && reinterpret_cast<uintptr_t>(pages) % 4096 == 0 &&
+                   ShadowArena::blockSize(3 * 4096 + 1) == 4 * 4096;
+    memset(pages, 0xAB, 4 * 4096);
+    arena->release(pages, 3 * 4096 + 1);
+    bool reused = arena->allocate(4 * 4096) == pages;
+    arena->release(pages, 4 * 4096);
+    arena->release(a, 16);
+    arena->release(b, 16);
+    
+    // A 16-byte shadow copies and restores only its span
+    uint8_t live[4096];
+    memset(live, 1, sizeof(live));
+    bool shadow_ok = false;
+    {
+        PageShadow shadow(16, arena);
+        shadow_ok = shadow.valid() && shadow.subPageCount() == 1 && shadow.markDirty(0, live);
+        uint64_t generation = shadow.generation();
+        live[3] = 9;
+        uint8_t out[16];
+        shadow.materialize(live, out);
+        shadow_ok = shadow_ok && out[3] == 1;
+        shadow.refresh(0, live);
+        shadow.materialize(live, out);
+        shadow_ok = shadow_ok && out[3] == 9 && shadow.generation() != generation;
+    }
+    
+    test_print("Shadow Arena", packed && aligned && reused && shadow_ok && arena->bytesInUse() == 0);
+}
+
+void test_page_index_publish() {
+    PageIndex index;
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> bad(0);
+    
+    // Reader sees either table, never a freed one
+    std::thread reader([&]() {
+        while (!done.load()) {
+            PageIndex::ReadGuard guard(index);
+            const PageIndexTable* table = guard.table();
+            if (table && table->ranges().size() != 1) {
+                bad.fetch_add(1);
+            }
+            if (table && !table->find(table->ranges()[0].start)) {
+                bad.fetch_add(1);
+            }
+        }
+    });
+    
+    for (uint64_t i = 0; i < 2000; ++i) {
+        index.publish({{0x1000 * (i + 1), 0x1000 * (i + 2), PAGE_SIZE, static_cast<uint32_t>(i), nullptr}});
+    }
+    done = true;
+    reader.join();
+    
+    PageIndex::ReadGuard guard(index);
+    bool latest = guard.table() && guard.table()->ranges()[0].var_index == 1999;
+    test_print("Page Index Publish", bad.load() == 0 && latest);
+}
+
+// ============================================================================
+// Event Clock Tests
+// ============================================================================
+
+void test_event_clock() {
+    EventClock clock;
+    clock.calibrate();
+    
+    // Calibrated wall time tracks the system clock; raw time never goes back
+    uint64_t first = EventClock::now();
+    int64_t wall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t drift = static_cast<int64_t>(clock.toWall(EventClock::now())) - wall;
+    bool monotonic = EventClock::now() >= first;
+    
+    bool ids = formatEventId(42) == "evt-42" &&
+               formatEventId((uint64_t(2) << EVENT_SEQ_SHARD_SHIFT) | 7) == "evt-2-7";
+    
+    test_print("Event Clock & IDs", drift > -1000000 && drift < 1000000 && monotonic && ids);
+}
+
+// ============================================================================
+// Latency Histogram Tests
+// ============================================================================
+
+void test_latency_histogram() {
+    // Every value lands in a bucket whose upper bound is within ~3%
+    bool buckets_ok = true;
+    for (uint64_t v = 1; v < (uint64_t(1) << 30); v = v * 3 / 2 + 1) {
+        uint64_t upper = LatencyHistogram::bucketUpper(LatencyHistogram::bucketOf(v));
+        buckets_ok = buckets_ok && upper >= v && upper - v <= v / 32 + 1;
+    }
+    
+    // 1..10000 ns split across two recording threads, merged on read
+    LatencyRecorder recorder;
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 2; ++t) {
+        threads.emplace_back([&recorder, t]() {
+            for (uint64_t v = 1 + t; v <= 10000; v += 2) {
+                recorder.record(v);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    LatencySnapshot snap = recorder.snapshot();
+    auto near = [](uint64_t got, uint64_t want) { return got >= want && got - want <= want / 32 + 1; };
+    bool merged = snap.total == 10000 && snap.min == 1 && snap.max == 10000 &&
+                  snap.mean() == 5000.5 && near(snap.percentile(0.5), 5000) &&
+                  near(snap.percentile(0.99), 9900) && snap.percentile(1.0) == 10000;
+    
+    test_print("Latency Histogram", buckets_ok && merged);
+}
+
+// ============================================================================
+// Delta Engine Tests
+// ============================================================================
+
+void test_delta_runs() {
+    std::vector<uint8_t> pre(PAGE_SIZE, 0x11);
+    std::vector<uint8_t> post = pre;
+    DeltaSet deltas;
+    
+    bool identical_ok = computeDeltas(pre.data(), post.data(), PAGE_SIZE, deltas) == 0 &&
+                        deltas.empty();
+    
+    // Single byte change
+    post[100] = 42;
+    computeDeltas(pre.data(), post.data(), PAGE_SIZE, deltas);
+    bool single_ok = deltas.size() == 1 && deltas.runs[0].offset == 100 &&
+                     deltas.runs[0].length == 1 && deltas.oldBytes(deltas.runs[0])[0] == 0x11 &&
+                     deltas.newBytes(deltas.runs[0])[0] == 42;
+    
+    // Changes a short gap apart merge; a long gap splits
+    deltas.clear();
+    post[104] = 43;
+    post[200] = 44;
+    computeDeltas(pre.data(), post.data(), PAGE_SIZE, deltas);
+    bool merge_ok = deltas.size() == 2 && deltas.runs[0].offset == 100 &&
+                    deltas.runs[0].length == 5 && deltas.newBytes(deltas.runs[0])[4] == 43 &&
+                    deltas.runs[1].offset == 200;
+    
+    // Full rewrite is one run, not one delta per byte
+    deltas.clear();
+    std::fill(post.begin(), post.end(), 0x22);
+    computeDeltas(pre.data(), post.data(), PAGE_SIZE, deltas);
+    bool full_ok = deltas.size() == 1 && deltas.runs[0].length == PAGE_SIZE &&
+                   deltas.arena.size() == 2 * PAGE_SIZE;
+    
+    // Unaligned tail and base offset
+    deltas.clear();
+    computeDeltas(pre.data() + 3, post.data() + 3, 70, deltas, 3);
+    bool tail_ok = deltas.size() == 1 && deltas.runs[0].offset == 3 && deltas.runs[0].length == 70;
+    
+    test_print(std::string("Delta Runs (") + deltaKernelName() + ")",
+               identical_ok && single_ok && merge_ok && full_ok && tail_ok);
+}
+
+void test_delta_matches_scalar() {
+    std::mt19937 rng(7);
+    bool match = true;
+    for (int iter = 0; iter < 200 && match; ++iter) {
+        size_t len = PAGE_SIZE - (rng() % 100);
+        std::vector<uint8_t> pre(len), post(len);
+        for (size_t i = 0; i < len; ++i) {
+            pre[i] = static_cast<uint8_t>(rng());
+            post[i] = (rng() % (iter % 10 + 2) == 0) ? static_cast<uint8_t>(rng()) : pre[i];
+        }
+        size_t gap = rng() % 16;
+        DeltaSet fast, ref;
+        computeDeltas(pre.data(), post.data(), len, fast, 0, gap);
+        computeDeltasScalar(pre.data(), post.data(), len, ref, 0, gap);
+        match = fast.arena == ref.arena && fast.size() == ref.size();
+        for (size_t i = 0; match && i < fast.size(); ++i) {
+            match = fast.runs[i].offset == ref.runs[i].offset &&
+                    fast.runs[i].length == ref.runs[i].length &&
+                    fast.runs[i].arena_offset == ref.runs[i].arena_offset;
+        }
+    }
+    test_print("Delta Kernel Matches Scalar", match);
+}
+
+// ============================================================================
+// Symbolizer Tests
+// ============================================================================
+
+static const int PROBE_LINE = __LINE__ + 2;
+__attribute__((noinline))
+int symbolizer_probe(int x) {
+    return x * 3 + 1;
+}
+
+void test_symbolizer() {
+    Symbolizer symbolizer;
+    
+    const Symbolizer::Result* own = symbolizer.resolve(reinterpret_cast<uint64_t>(&symbolizer_probe));
+    bool own_ok = own->known && own->symbol == "symbolizer_probe(int)" &&
+                  symbolizer.resolve(own->ip) == own;  // Second lookup hits the cache
+    // With debug info the entry maps to the definition, else to this binary
+    bool line_ok = own->file.size() > 4 && own->file.compare(own->file.size() - 4, 4, ".cpp") == 0
+                       ? own->line >= PROBE_LINE && own->line <= PROBE_LINE + 2
+                       : own->line == 0 && own->file.find("test_core") != std::string::npos;
+    
+    std::string symbol, file;
+    int line = -1;
+    bool libc_ok = symbolizer.resolve(reinterpret_cast<uint64_t>(&getpid) + 1, symbol, file, line) &&
+                   symbol.find("getpid") != std::string::npos && file.find("libc") != std::string::npos;
+    bool unknown_ok = !symbolizer.resolve(16, symbol, file, line) && symbol == "??" && line == 0;
+    
+    // Objects loaded after the first lookup are picked up on demand (the
+    // first library that is not already linked in is used)
+    bool dlopen_ok = true;
+    size_t modules = symbolizer.moduleCount();
+    const char* candidates[][2] = {{"libz.so.1", "zlibVersion"}, {"liblz4.so.1", "LZ4_versionNumber"}};
+    for (const auto& candidate : candidates) {
+        if (void* loaded = dlopen(candidate[0], RTLD_NOW | RTLD_NOLOAD)) {
+            dlclose(loaded);
+            continue;
+        }
+        if (void* lib = dlopen(candidate[0], RTLD_NOW | RTLD_LOCAL)) {
+            void* fn = dlsym(lib, candidate[1]);
+            dlopen_ok = fn && symbolizer.resolve(reinterpret_cast<uint64_t>(fn), symbol, file, line) &&
+                        symbol == candidate[1] && symbolizer.moduleCount() > modules;
+            dlclose(lib);
+            break;
+        }
+    }
+    
+    test_print("Symbolizer", own_ok && line_ok && libc_ok && unknown_ok && dlopen_ok);
+}
+
+// ============================================================================
+// Recording Format Tests
+// ============================================================================
+
+static EnrichedEvent make_recorded_event(uint64_t i) {
+    EnrichedEvent event{};
+    event.event_seq = (i % 2 ? uint64_t(1) << EVENT_SEQ_SHARD_SHIFT : 0) | i;
+    event.ts_ns = 1700000000000000000ull + i * 1000;
+    event.page_base = reinterpret_cast<void*>(0x7f0000000000ull + (i % 4) * 4096);
+    event.fault_addr = static_cast<uint8_t*>(event.page_base) + 24;
+    event.tid = 4000 + static_cast<pid_t>(i % 3);
+    event.ip = 0x401000 + i;
+    event.symbol = i % 5 ? "update_counter(int)" : "??";
+    event.file = i % 5 ? "/src/app/counter.cpp" : "";
+    event.line = i % 5 ? 40 + static_cast<int>(i % 7) : 0;
+    event.variable_ids = {"var-" + std::to_string(i % 4)};
+    if (i % 3 == 0) {
+        event.variable_ids.push_back("var-shared");  // Overlapping variable
+    }
+    event.variable_index = static_cast<uint32_t>(i % 4 + 1);
+    event.variable_name = "counter_" + std::to_string(i % 4);
+    if (i % 10 == 0) {
+        event.sql_context_id = "sql-" + std::to_string(i);
+    }
+    // Runs in address order, then one that starts below the previous end
+    uint8_t pre[64] = {}, post[64] = {};
+    for (size_t b = 0; b < 4 + i % 5; ++b) {
+        post[8 + b] = static_cast<uint8_t>(i + b + 1);
+    }
+    post[40] = 0xEE;
+    computeDeltas(pre, post, sizeof(pre), event.deltas, 4096);
+    return event;
+}
+
+void test_recording_format() {
+    mkdir("./test_output", 0755);
+    const std::string path = "./test_output/recording_test.wrec";
+    unlink(path.c_str());
+    
+    const size_t total = RECORDING_SEGMENT_EVENTS + 50;  // One full segment, then a partial one
+    std::vector<std::string> expected;
+    std::string json;
+    auto append = [&](RecordingWriter& writer, size_t from, size_t to) {
+        for (size_t i = from; i < to; ++i) {
+            EnrichedEvent event = make_recorded_event(i);
+            json.clear();
+            appendEventJson(event, json);
+            expected.push_back(json);
+            writer.append(event);
+        }
+    };
+    auto read_all = [&](RecordingReader& reader, std::vector<std::string>& out) {
+        out.clear();
+        EnrichedEvent event;
+        while (reader.next(event)) {
+            json.clear();
+            appendEventJson(event, json);
+            out.push_back(json);
+        }
+        return reader.error().empty();
+    };
+    
+    {
+        auto writer = RecordingWriter::open(path);
+        if (!writer) {
+            test_print("Recording Format", false);
+            return;
+        }
+        append(*writer, 0, total);
+        writer->close();
+    }
+    
+    // Round trip through the footer index; every field survives
+    RecordingReader reader;
+    std::vector<std::string> decoded;
+    bool roundtrip_ok = reader.open(path) && reader.hasIndex() && reader.segments().size() == 2 &&
+                        reader.eventCount() == total && read_all(reader, decoded) && decoded == expected;
+    bool index_ok = roundtrip_ok && reader.segments()[0].min_ts_ns == make_recorded_event(0).ts_ns &&
+                    reader.segments()[1].max_ts_ns == make_recorded_event(total - 1).ts_ns;
+    
+    // Far smaller than the JSONL it replaces
+    struct stat st;
+    size_t jsonl_bytes = 0;
+    for (const auto& line : expected) {
+        jsonl_bytes += line.size() + 1;
+    }
+    bool compact_ok = stat(path.c_str(), &st) == 0 && static_cast<size_t>(st.st_size) * 4 < jsonl_bytes;
+    
+    // Reopening appends after the footer, which is rewritten on close
+    {
+        auto writer = RecordingWriter::open(path);
+        append(*writer, total, total + 10);
+    }
+    bool append_ok = reader.open(path) && reader.hasIndex() && reader.segments().size() == 3 &&
+                     read_all(reader, decoded) && decoded == expected;
+    
+    // Without a footer (the writer died) the segments are found by a scan,
+    // and a torn last segment is dropped
+    uint64_t last_segment = reader.segments().back().offset;
+    bool recover_ok = truncate(path.c_str(), static_cast<off_t>(reader.dataEnd())) == 0 &&
+                      reader.open(path) && !reader.hasIndex() && reader.segments().size() == 3 &&
+                      read_all(reader, decoded) && decoded == expected;
+    recover_ok = recover_ok && truncate(path.c_str(), static_cast<off_t>(last_segment + 50)) == 0 &&
+                 reader.open(path) && reader.segments().size() == 2 && reader.eventCount() == total;
+    expected.resize(total);
+    {
+        auto writer = RecordingWriter::open(path);
+        recover_ok = recover_ok && writer && writer->segmentCount() == 2;
+        if (writer) {
+            append(*writer, total + 10, total + 12);
+        }
+    }
+    recover_ok = recover_ok && reader.open(path) && reader.hasIndex() && reader.segments().size() == 3 &&
+                 read_all(reader, decoded) && decoded == expected;
+    
+    // A segment whose write fails stays open, unindexed, and is written whole
+    // by the next attempt. Keyframes (from the snapshots) go in the same
+    // attempt, so neither is left without the other.
+    const std::string retry_path = "./test_output/recording_retry.wrec";
+    unlink(retry_path.c_str());
+    bool retry_ok = false;
+    if (auto writer = RecordingWriter::open(retry_path)) {
+        struct rlimit saved;
+        getrlimit(RLIMIT_FSIZE, &saved);
+        auto old_handler = signal(SIGXFSZ, SIG_IGN);
+        struct rlimit capped = saved;
+        capped.rlim_cur = sizeof(RecordingFileHeader);  // Nothing past the file header
+        setrlimit(RLIMIT_FSIZE, &capped);
+        for (size_t i = 0; i < 10; ++i) {
+            EnrichedEvent event = make_recorded_event(i);
+            event.post_snapshot.assign(64, static_cast<uint8_t>(i));
+            writer->append(event);
+        }
+        bool failed = !writer->sync() && writer->segmentCount() == 0 && writer->eventsWritten() == 0;
+        setrlimit(RLIMIT_FSIZE, &saved);
+        signal(SIGXFSZ, old_handler);
+        retry_ok = failed && writer->sync() && writer->segmentCount() == 2 && writer->eventsWritten() == 10 &&
+                   writer->keyframesWritten() > 0 && writer->close();
+    }
+    retry_ok = retry_ok && reader.open(retry_path) && reader.hasIndex() && reader.segments().size() == 2 &&
+               reader.segments()[0].kind == RecordingSegmentKind::KEYFRAMES && reader.eventCount() == 10;
+    unlink(retry_path.c_str());
+    
+    // Corruption is reported, not decoded
+    bool corrupt_ok = false;
+    if (FILE* f = fopen(path.c_str(), "r+b")) {
+        fseek(f, static_cast<long>(reader.segments()[0].offset + sizeof(RecordingSegmentHeader) + 10), SEEK_SET);
+        fputc(0x5A, f);
+        fclose(f);
+        std::vector<EnrichedEvent> events;
+        corrupt_ok = reader.open(path) && !reader.readSegment(0, events) && events.empty() &&
+                     !reader.error().empty() && reader.readSegment(1, events) && !events.empty();
+    }
+    bool foreign_ok = !reader.open("./test_output/no_such_recording.wrec") && !reader.error().empty();
+    
+    unlink(path.c_str());
+    test_print("Recording Format", roundtrip_ok && index_ok && compact_ok && append_ok && recover_ok &&
+                                   retry_ok && corrupt_ok && foreign_ok);
+}
+
+void test_recording_keyframes() {
+    mkdir("./test_output", 0755);
+    const std::string path = "./test_output/recording_keyframes.wrec";
+    unlink(path.c_str());
+    
+    // Two sub-pages of var-a written with real snapshots, var-b sharing some
+    // of its events, var-c (no snapshots) in between
+    const size_t total = RECORDING_SEGMENT_EVENTS + 900;
+    const uint64_t t0 = 1700000000000000000ull;
+    std::vector<EnrichedEvent> history;
+    std::vector<uint8_t> live(2 * PAGE_SIZE, 0);
+    {
+        auto writer = RecordingWriter::open(path);
+        if (!writer) {
+            test_print("Recording Keyframes", false);
+            return;
+        }
+        for (size_t i = 0; i < total; ++i) {
+            EnrichedEvent event{};
+            event.event_seq = i;
+            event.ts_ns = t0 + i * 1000;
+            event.symbol = "??";
+            if (i % 5 == 4) {
+                event.variable_ids = {"var-c"};
+            } else {
+                uint32_t sub = (i / 7) % 2;
+                uint8_t* page = live.data() + sub * PAGE_SIZE;
+                event.pre_snapshot.assign(page, page + PAGE_SIZE);
+                for (size_t b = 0; b < 3; ++b) {
+                    page[(i * 37 + b * 1021) % PAGE_SIZE] = static_cast<uint8_t>(i + b + 1);
+                }
+                event.post_snapshot.assign(page, page + PAGE_SIZE);
+                event.snapshot_offset = sub * PAGE_SIZE;
+                computeDeltas(event.pre_snapshot.data(), event.post_snapshot.data(), PAGE_SIZE, event.deltas,
+                              sub * PAGE_SIZE);
+                event.variable_ids = {"var-a"};
+                if (i % 3 == 0) {
+                    event.variable_ids.push_back("var-b");
+                }
+            }
+            writer->append(event);
+            history.push_back(std::move(event));
+        }
+        writer->close();
+    }
+    
+    // Brute force: var-a's sub-pages after every event up to ts
+    auto expected_state = [&](uint64_t ts, std::vector<uint8_t>& state) {
+        state.assign(2 * PAGE_SIZE, 0);
+        for (const auto& event : history) {
+            if (event.ts_ns <= ts && !event.post_snapshot.empty()) {
+                memcpy(state.data() + event.snapshot_offset, event.post_snapshot.data(), PAGE_SIZE);
+            }
+        }
+    };
+    auto state_matches = [&](RecordingReader& reader, uint64_t ts) {
+        std::vector<RecordedSubPage> pages;
+        std::vector<uint8_t> state;
+        expected_state(ts, state);
+        if (!reader.variableState("var-a", ts, pages) || pages.size() != 2) {
+            return false;
+        }
+        for (const auto& page : pages) {
+            if (page.data.size() != PAGE_SIZE ||
+                memcmp(page.data.data(), state.data() + page.offset, PAGE_SIZE) != 0) {
+                return false;
+            }
+        }
+        return pages[0].offset == 0 && pages[1].offset == PAGE_SIZE;
+    };
+    const uint64_t probes[] = {t0 - 1, t0, t0 + 3000, t0 + 250 * 1000 + 500, t0 + 2049 * 1000,
+                               t0 + (total / 2) * 1000, t0 + (total - 1) * 1000, t0 + total * 1000};
+    auto states_match = [&](RecordingReader& reader) {
+        for (uint64_t ts : probes) {
+            if (!state_matches(reader, ts)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    
+    // Keyframes go in their own segments ahead of the events they follow
+    RecordingReader reader;
+    size_t keyframe_segments = 0;
+    bool keyframes_ok = reader.open(path) && reader.hasIndex() && reader.eventCount() == total;
+    for (const auto& segment : reader.segments()) {
+        keyframe_segments += segment.kind == RecordingSegmentKind::KEYFRAMES;
+    }
+    const auto& directory = reader.directory();
+    keyframes_ok = keyframes_ok && keyframe_segments == 2 && reader.segments().size() == 4 &&
+                   directory.count("var-a") && directory.at("var-a").keyframes.size() > 4 &&
+                   directory.count("var-c") && directory.at("var-c").keyframes.empty() &&
+                   directory.at("var-c").spans.size() == 2;
+    
+    // Seeks land on the brute-force state, before, between and after keyframes
+    bool state_ok = keyframes_ok && states_match(reader);
+    
+    // Range queries read only the variable's events
+    std::vector<EnrichedEvent> events;
+    size_t expected_events = 0;
+    const uint64_t from = t0 + 100 * 1000, to = t0 + (total - 100) * 1000;
+    for (const auto& event : history) {
+        expected_events += event.ts_ns >= from && event.ts_ns <= to && event.variable_ids.size() == 2;
+    }
+    bool events_ok = reader.variableEvents("var-b", from, to, events) && events.size() == expected_events &&
+                     events.front().ts_ns >= from && events.back().ts_ns <= to &&
+                     reader.variableEvents("var-none", 0, UINT64_MAX, events) && events.empty();
+    
+    // Without a footer the directory is rebuilt from the segments
+    size_t keyframes = keyframes_ok ? directory.at("var-a").keyframes.size() : 0;
+    bool rebuild_ok = truncate(path.c_str(), static_cast<off_t>(reader.dataEnd())) == 0 &&
+                      reader.open(path) && !reader.hasIndex() && reader.directory().count("var-a") &&
+                      reader.directory().at("var-a").keyframes.size() == keyframes && states_match(reader);
+    
+    unlink(path.c_str());
+    test_print("Recording Keyframes", keyframes_ok && state_ok && events_ok && rebuild_ok);
+}
+
 // ============================================================================
 // Main Test Runner
 // ============================================================================
@@ -156,12 +1635,38 @@ int main() {
     test_initialization();
     test_register_unregister();
     test_snapshot();
+    test_snapshot_views();
     test_state_transitions();
     test_metrics();
     test_error_handling();
+    test_native_pipeline();
+    test_async_wp_pipeline();
+    test_sharded_pipeline();
+    test_register_range();
+    test_register_ranges();
+    test_mutation_depth();
+    test_sampling_policies();
+    test_same_value_store();
+    test_baseline_chain();
+    test_drain_and_stop();
+    test_event_channel_pipeline();
+    test_spsc_ring();
+    test_spsc_ring_threaded();
+    test_mpsc_ring_threaded();
+    test_event_channel();
+    test_page_index_lookup();
+    test_page_index_publish();
+    test_shadow_arena();
+    test_delta_runs();
+    test_delta_matches_scalar();
+    test_latency_histogram();
+    test_event_clock();
+    test_symbolizer();
+    test_recording_format();
+    test_recording_keyframes();
     
     std::cout << std::endl;
     std::cout << "=== All tests completed ===" << std::endl;
     
-    return 0;
+    return g_failures == 0 ? 0 : 1;
 }
@@ -0,0 +1,230 @@
+#!/usr/bin/env node
+/**
+ * Event Stream Test - startEventStream / onEvents / stopEventStream
+ * Drives real write faults through the native addon and checks batch
+ * delivery, maxQueuedBatches backpressure and stopping with batches queued.
+ */
+
+const os = require('os');
+const path = require('path');
+const { WatcherCore } = require('../adapters/javascript/index.js');
+
+const PAGE_SIZE = 4096;
+
+// A write landing while the page is still open from the previous fault
+// folds into that event; spacing keeps most writes separate, and counts
+// are checked against the core's eventsReceived rather than the writes
+const WRITE_SPACING_MS = 5;
+
+function sleepSync(ms) {
+    const end = Date.now() + ms;
+    while (Date.now() < end) {}
+}
+
+function sleep(ms) {
+    return new Promise(resolve => setTimeout(resolve, ms));
+}
+
+async function waitFor(predicate, timeoutMs = 3000) {
+    const end = Date.now() + timeoutMs;
+    while (!predicate()) {
+        if (Date.now() > end) {
+            return false;
+        }
+        await sleep(5);
+    }
+    return true;
+}
+
+function eventsSince(watcher, before) {
+    return watcher.getMetrics().eventsReceived - before;
+}
+
+function assert(condition, message) {
+    if (!condition) {
+        throw new Error(message);
+    }
+}
+
+// Only whole pages can be write-protected, and a Buffer is not page
+// aligned: register the first slice of a larger Buffer the kernel accepts
+function registerAlignedPage(watcher, name) {
+    const backing = Buffer.alloc(3 * PAGE_SIZE);
+    for (let offset = 0; offset < PAGE_SIZE; offset += 8) {
+        const page = backing.subarray(offset, offset + PAGE_SIZE);
+        const varID = watcher.core.registerPage(page, PAGE_SIZE, name, 0, 0);
+        if (varID) {
+            return { varID, page, backing };
+        }
+    }
+    throw new Error('Could not register a page-aligned slice');
+}
+
+// Each call blocks the event loop, so no batch is delivered meanwhile
+function writeSpaced(page, count, first = 1) {
+    for (let i = 0; i < count; i++) {
+        page[i] = (first + i) & 0xff;
+        sleepSync(WRITE_SPACING_MS);
+    }
+}
+
+async function test_batch_delivery(watcher, page) {
+    console.log("\n" + "=".repeat(70));
+    console.log("TEST 1: Batch Delivery");
+    console.log("=".repeat(70));
+
+    const batches = [];
+    assert(watcher.onEvents(batch => batches.push(batch), { batchSize: 4, maxLatencyMs: 5 }),
+           'onEvents() did not start the stream');
+
+    let threw = false;
+    try {
+        watcher.onEvents(() => {});
+    } catch (e) {
+        threw = true;
+    }
+    assert(threw, 'A second onEvents() should throw while the stream runs');
+
+    const before = watcher.getMetrics().eventsReceived;
+    const writes = 12;
+    writeSpaced(page, writes);
+    const total = () => batches.reduce((sum, batch) => sum + batch.count, 0);
+    assert(await waitFor(() => total() > 0 && total() === eventsSince(watcher, before)),
+           `Received ${total()} of ${eventsSince(watcher, before)} events`);
+    assert(total() <= writes, `${total()} events for ${writes} writes`);
+    console.log(`✅ ${total()} events in ${batches.length} batches`);
+
+    let lastSeq = -1n;
+    for (const batch of batches) {
+        assert(batch.count >= 1 && batch.count <= 4, `Batch of ${batch.count} exceeds batchSize`);
+        for (let i = 0; i < batch.count; i++) {
+            assert(batch.eventSeq(i) > lastSeq, 'Event sequence numbers are not increasing');
+            lastSeq = batch.eventSeq(i);
+            const offset = batch.faultAddr(i) - batch.pageBase(i);
+            assert(offset >= 0n && offset < BigInt(writes), `Fault at unexpected offset ${offset}`);
+        }
+    }
+
+    const stats = watcher.getEventStreamStats();
+    assert(stats.batches === batches.length, `stats.batches ${stats.batches} != ${batches.length}`);
+    assert(stats.dropped === 0, `${stats.dropped} events dropped`);
+    console.log(`✅ Stats: ${JSON.stringify(stats)}`);
+
+    assert(watcher.offEvents() === true, 'offEvents() should stop a running stream');
+    assert(watcher.offEvents() === false, 'offEvents() should report no running stream');
+    assert(Object.keys(watcher.getEventStreamStats()).length === 0, 'Stats after stop should be empty');
+    console.log(`✅ TEST 1 PASSED`);
+    return true;
+}
+
+async function test_queued_batch_limit(watcher, page) {
+    console.log("\n" + "=".repeat(70));
+    console.log("TEST 2: maxQueuedBatches Deferral");
+    console.log("=".repeat(70));
+
+    let received = 0;
+    watcher.onEvents(batch => { received += batch.count; },
+                     { batchSize: 1, maxLatencyMs: 1, maxQueuedBatches: 2 });
+
+    // The event loop is blocked: two batches queue up, the rest wait in the core
+    const before = watcher.getMetrics().eventsReceived;
+    writeSpaced(page, 8, 101);
+    sleepSync(30);
+    const events = eventsSince(watcher, before);
+    assert(events > 2, `Only ${events} events; need more than maxQueuedBatches`);
+
+    const blocked = watcher.getEventStreamStats();
+    console.log(`  While blocked: ${JSON.stringify(blocked)}`);
+    assert(received === 0, 'A batch was delivered while the event loop was blocked');
+    assert(blocked.queuedBatches === 2, `queuedBatches ${blocked.queuedBatches} != maxQueuedBatches`);
+    assert(blocked.deferred > 0, 'Drainer never deferred a due batch');
+    assert(blocked.pending === events - 2, `pending ${blocked.pending} != ${events - 2}`);
+
+    assert(await waitFor(() => received >= events), `Received ${received} of ${events} events`);
+    const drained = watcher.getEventStreamStats();
+    assert(drained.batches === events, `stats.batches ${drained.batches} != ${events}`);
+    assert(drained.queuedBatches === 0 && drained.pending === 0, 'Stream did not drain');
+    assert(drained.dropped === 0, `${drained.dropped} events dropped`);
+    console.log(`✅ All ${received} deferred events delivered: ${JSON.stringify(drained)}`);
+
+    watcher.offEvents();
+    console.log(`✅ TEST 2 PASSED`);
+    return true;
+}
+
+async function test_stop_with_queued_batches(watcher, page) {
+    console.log("\n" + "=".repeat(70));
+    console.log("TEST 3: Stop With Batches Queued");
+    console.log("=".repeat(70));
+
+    let received = 0;
+    watcher.onEvents(batch => { received += batch.count; },
+                     { batchSize: 1, maxLatencyMs: 1, maxQueuedBatches: 3 });
+
+    const before = watcher.getMetrics().eventsReceived;
+    writeSpaced(page, 6, 201);
+    sleepSync(30);
+    const events = eventsSince(watcher, before);
+    assert(events > 3, `Only ${events} events; need more than maxQueuedBatches`);
+    const queued = watcher.getEventStreamStats().queuedBatches;
+    assert(queued === 3, `queuedBatches ${queued} != 3 before stop`);
+
+    // Batches already handed to the event loop still arrive; nothing after
+    assert(watcher.offEvents() === true, 'offEvents() should stop a running stream');
+    await sleep(50);
+    assert(received === queued, `Received ${received} events after stop, expected ${queued}`);
+    console.log(`✅ Stopped with ${queued} batches queued; all ${received} delivered, no more after`);
+
+    // Events never batched stay in the channel for the next stream
+    let resumed = 0;
+    watcher.onEvents(batch => { resumed += batch.count; }, { batchSize: 1, maxLatencyMs: 1 });
+    assert(await waitFor(() => resumed === events - queued),
+           `Restarted stream delivered ${resumed} of ${events - queued} held events`);
+    watcher.offEvents();
+    console.log(`✅ Restarted stream delivered the ${resumed} events left in the channel`);
+    console.log(`✅ TEST 3 PASSED`);
+    return true;
+}
+
+async function main() {
+    console.log("\n" + "=".repeat(70));
+    console.log("🧪 WATCHER EVENT STREAM TESTS");
+    console.log("=".repeat(70));
+
+    const watcher = WatcherCore.getInstance();
+    watcher.initialize(path.join(os.tmpdir(), `watcher_event_stream_${process.pid}`));
+    const { varID, page } = registerAlignedPage(watcher, 'stream_page');
+
+    const tests = [
+        ["Batch Delivery", test_batch_delivery],
+        ["maxQueuedBatches Deferral", test_queued_batch_limit],
+        ["Stop With Batches Queued", test_stop_with_queued_batches],
+    ];
+
+    const results = [];
+    for (const [name, fn] of tests) {
+        try {
+            results.push([name, await fn(watcher, page)]);
+        } catch (e) {
+            console.log(`❌ ${name} FAILED: ${e.message}`);
+            watcher.offEvents();
+            results.push([name, false]);
+        }
+    }
+
+    watcher.core.unregisterPage(varID);
+    watcher.stop();
+
+    console.log("\n" + "=".repeat(70));
+    console.log("📊 TEST SUMMARY");
+    console.log("=".repeat(70));
+
+    const passed = results.filter(([, ok]) => ok).length;
+    for (const [name, ok] of results) {
+        console.log(`${ok ? "✅ PASSED" : "❌ FAILED"}: ${name}`);
+    }
+    console.log(`\nTotal: ${passed}/${results.length} tests passed`);
+    return passed === results.length ? 0 : 1;
+}
+
+main().then(code => process.exit(code));
@@ -0,0 +1,836 @@
+#define _GNU_SOURCE
+#include "faststorage.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * Test Utilities
+ * ============================================================================ */
+
+static int g_failures = 0;
+
+static void test_print(const char *test_name, bool passed) {
+    if (!passed) {
+        ++g_failures;
+    }
+    printf("[%s] %s\n", passed ? "PASS" : "FAIL", test_name);
+}
+
+#define STORE_SIZE (16 * 1024 * 1024)
+
+/* Fresh store path; the file is removed */
+static void temp_path(char *path, size_t len) {
+    snprintf(path, len, "/tmp/test_faststorage_%d_XXXXXX", (int)getpid());
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        close(fd);
+        unlink(path);
+    }
+}
+
+/* Unlink path and the checkpoint next to it */
+static void remove_store(const char *path) {
+    char sidecar[80];
+    snprintf(sidecar, sizeof(sidecar), "%s.idx", path);
+    unlink(path);
+    unlink(sidecar);
+}
+
+static fast_storage_stats_t stats_of(fast_storage_t *storage) {
+    fast_storage_stats_t stats = {0};
+    if (storage) {
+        fast_storage_get_stats(storage, &stats);
+    }
+    return stats;
+}
+
+/* Key i: short keys inline in the index, every third one long */
+static size_t make_key(char *buf, size_t i) {
+    if (i % 3 == 0) {
+        return (size_t)sprintf(buf, "long-key-to-force-record-compare-%zu", i);
+    }
+    return (size_t)sprintf(buf, "k%zu", i);
+}
+
+static bool read_equals(fast_storage_t *storage, const char *key, size_t key_len,
+                        const char *expected, size_t expected_len) {
+    char *value = NULL;
+    size_t value_len = 0;
+    return fast_storage_read(storage, key, key_len, &value, &value_len) == 0 &&
+           value_len == expected_len && memcmp(value, expected, value_len) == 0;
+}
+
+/* ============================================================================
+ * Storage Tests
+ * ============================================================================ */
+
+static void test_basic_operations(void) {
+    char path[64];
+    temp_path(path, sizeof(path));
+    fast_storage_t *storage = fast_storage_create(path, STORE_SIZE);
+
+    bool ok = storage != NULL;
+    ok = ok && fast_storage_write(storage, "alpha", 5, "one", 3) == 0;
+    ok = ok && fast_storage_write(storage, "beta", 4, "two", 3) == 0;
+    ok = ok && fast_storage_write(storage, "alpha", 5, "uno", 3) == 0;
+    ok = ok && read_equals(storage, "alpha", 5, "uno", 3);
+    ok = ok && read_equals(storage, "beta", 4, "two", 3);
+    ok = ok && fast_storage_size(storage) == 2;
+    ok = ok && fast_storage_remove(storage, "beta", 4) == 0;
+    ok = ok && !fast_storage_contains(storage, "beta", 4);
+    ok = ok && fast_storage_remove(storage, "beta", 4) == -1;
+    ok = ok && fast_storage_contains(storage, "alpha", 5);
+    ok = ok && fast_storage_size(storage) == 1;
+
+    fast_storage_destroy(storage);
+    remove_store(path);
+    test_print("Basic Operations", ok);
+}
+
+static void test_index_growth(void) {
+    char path[64];
+    temp_path(path, sizeof(path));
+    fast_storage_t *storage = fast_storage_create(path, STORE_SIZE);
+
+    /* Enough keys to rehash the index several times */
+    const size_t keys = 50000;
+    char key[64];
+    bool ok = storage != NULL;
+    for (size_t i = 0; ok && i < keys; i++) {
+        size_t len = make_key(key, i);
+        ok = fast_storage_write(storage, key, len, (const char *)&i, sizeof(i)) == 0;
+    }
+    for (size_t i = 0; ok && i < keys; i++) {
+        size_t len = make_key(key, i);
+        ok = read_equals(storage, key, len, (const char *)&i, sizeof(i));
+    }
+    ok = ok && fast_storage_size(storage) == keys;
+    ok = ok && !fast_storage_contains(storage, "missing", 7);
+
+    fast_storage_destroy(storage);
+    remove_store(path);
+    test_print("Index Growth", ok);
+}
+
+static void test_tombstone_churn(void) {
+    char path[64];
+    temp_path(path, sizeof(path));
+    fast_storage_t *storage = fast_storage_create(path, STORE_SIZE);
+
+    /* Insert/remove cycles reuse deleted slots without losing live keys */
+    char key[64];
+    bool ok = storage != NULL && fast_storage_write(storage, "anchor", 6, "a", 1) == 0;
+    for (size_t round = 0; ok && round < 20; round++) {
+        for (size_t i = 0; ok && i < 1000; i++) {
+            size_t len = make_key(key, round * 1000 + i);
+            ok = fast_storage_write(storage, key, len, "v", 1) == 0;
+        }
+        for (size_t i = 0; ok && i < 1000; i++) {
+            size_t len = make_key(key, round * 1000 + i);
+            ok = fast_storage_remove(storage, key, len) == 0;
+        }
+    }
+    ok = ok && fast_storage_size(storage) == 1 && read_equals(storage, "anchor", 6, "a", 1);
+
+    fast_storage_destroy(storage);
+    remove_store(path);
+    test_print("Tombstone Churn", ok);
+}
+
+static void test_reopen(void) {
+    char path[64];
+    temp_path(path, sizeof(path));
+    fast_storage_t *storage = fast_storage_create(path, STORE_SIZE);
+
+    char key[64];
+    bool ok = storage != NULL;
+    for (size_t i = 0; ok && i < 2000; i++) {
+        size_t len = make_key(key, i);
+        ok = fast_storage_write(storage, key, len, (const char *)&i, sizeof(i)) == 0;
+    }
+    ok = ok && fast_storage_write(storage, "k1", 2, "latest", 6) == 0;
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+
+    /* Without a checkpoint the index is recovered from the log; the newest record wins */
+    char sidecar[80];
+    snprintf(sidecar, sizeof(sidecar), "%s.idx", path);
+    unlink(sidecar);
+    storage = fast_storage_create(path, STORE_SIZE);
+    ok = ok && storage != NULL && fast_storage_size(storage) == 2000;
+    ok = ok && stats_of(storage).replayed == 2001;
+    ok = ok && read_equals(storage, "k1", 2, "latest", 6);
+    size_t probe = 1998;
+    size_t len = make_key(key, probe);
+    ok = ok && read_equals(storage, key, len, (const char *)&probe, sizeof(probe));
+
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    remove_store(path);
+    test_print("Reopen Rebuilds Index", ok);
+}
+
+static void test_file_growth(void) {
+    char path[64];
+    temp_path(path, sizeof(path));
+    /* Far smaller than the data written: every write past it grows the file */
+    fast_storage_t *storage = fast_storage_create(path, 64 * 1024);
+
+    char key[64];
+    char value[512];
+    memset(value, 'g', sizeof(value));
+    bool ok = storage != NULL;
+    size_t initial = ok ? fast_storage_capacity(storage) : 0;
+    for (size_t i = 0; ok && i < 4000; i++) {
+        size_t len = make_key(key, i);
+        memcpy(value, &i, sizeof(i));
+        ok = fast_storage_write(storage, key, len, value, sizeof(value)) == 0;
+    }
+    fast_storage_stats_t stats = {0};
+    if (storage) {
+        fast_storage_get_stats(storage, &stats);
+    }
+    ok = ok && stats.grows > 0 && fast_storage_capacity(storage) > initial;
+    ok = ok && stats.keys == 4000 && stats.dead_bytes == 0;
+    for (size_t i = 0; ok && i < 4000; i += 97) {
+        size_t len = make_key(key, i);
+        memcpy(value, &i, sizeof(i));
+        ok = read_equals(storage, key, len, value, sizeof(value));
+    }
+
+    /* A value read from the mapping can be written back across a grow */
+    char *mapped = NULL;
+    size_t mapped_len = 0;
+    ok = ok && fast_storage_read(storage, "k1", 2, &mapped, &mapped_len) == 0;
+    for (size_t i = 0; ok && i < 200; i++) {
+        ok = fast_storage_write(storage, "k1", 2, mapped, mapped_len) == 0 &&
+             fast_storage_read(storage, "k1", 2, &mapped, &mapped_len) == 0;
+    }
+    size_t one = 1;
+    memcpy(value, &one, sizeof(one));
+    ok = ok && read_equals(storage, "k1", 2, value, sizeof(value));
+
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    remove_store(path);
+    test_print("File Growth", ok);
+}
+
+static void test_remove_persists(void) {
+    char path[64];
+    temp_path(path, sizeof(path));
+    fast_storage_t *storage = fast_storage_create(path, STORE_SIZE);
+
+    bool ok = storage != NULL;
+    ok = ok && fast_storage_write(storage, "gone", 4, "x", 1) == 0;
+    ok = ok && fast_storage_write(storage, "kept", 4, "y", 1) == 0;
+    ok = ok && fast_storage_remove(storage, "gone", 4) == 0;
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+
+    /* The tombstone record replays on reopen */
+    storage = fast_storage_create(path, STORE_SIZE);
+    ok = ok && storage != NULL && fast_storage_size(storage) == 1;
+    ok = ok && !fast_storage_contains(storage, "gone", 4) && read_equals(storage, "kept", 4, "y", 1);
+    ok = ok && fast_storage_write(storage, "gone", 4, "z", 1) == 0 && read_equals(storage, "gone", 4, "z", 1);
+
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    remove_store(path);
+    test_print("Remove Persists Across Reopen", ok);
+}
+
+static void test_compaction(void) {
+    char path[64];
+    temp_path(path, sizeof(path));
+    fast_storage_t *storage = fast_storage_create(path, 256 * 1024);
+
+    /* 100 live keys rewritten over and over: nearly all of the log is dead */
+    char key[64];
+    char value[256];
+    memset(value, 'c', sizeof(value));
+    bool ok = storage != NULL;
+    for (size_t round = 0; ok && round < 100; round++) {
+        for (size_t i = 0; ok && i < 100; i++) {
+            size_t len = make_key(key, i);
+            memcpy(value, &round, sizeof(round));
+            ok = fast_storage_write(storage, key, len, value, sizeof(value)) == 0;
+        }
+    }
+    ok = ok && fast_storage_remove(storage, "k1", 2) == 0;
+    fast_storage_stats_t stats = {0};
+    if (storage) {
+        fast_storage_get_stats(storage, &stats);
+    }
+    /* Growth compacted instead of growing the file without bound */
+    ok = ok && stats.compactions > 0 && stats.file_size < 100 * 100 * sizeof(value);
+
+    ok = ok && fast_storage_compact(storage) == 0;
+    if (storage) {
+        fast_storage_get_stats(storage, &stats);
+    }
+    ok = ok && stats.dead_bytes == 0 && stats.dead_ratio == 0.0 && stats.keys == 99;
+    ok = ok && fast_storage_bytes_used(storage) <= stats.live_bytes + 4096;
+
+    size_t last = 99;
+    memcpy(value, &last, sizeof(last));
+    for (size_t i = 0; ok && i < 100; i++) {
+        size_t len = make_key(key, i);
+        ok = i == 1 ? !fast_storage_contains(storage, key, len)
+                    : read_equals(storage, key, len, value, sizeof(value));
+    }
+    ok = ok && fast_storage_write(storage, "after", 5, "compact", 7) == 0;
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+
+    /* The compacted file is what reopens */
+    storage = fast_storage_create(path, 256 * 1024);
+    ok = ok && storage != NULL && fast_storage_size(storage) == 100;
+    ok = ok && !fast_storage_contains(storage, "k1", 2) && read_equals(storage, "after", 5, "compact", 7);
+    ok = ok && read_equals(storage, "k2", 2, value, sizeof(value));
+    ok = ok && access(path, F_OK) == 0;
+
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    remove_store(path);
+    test_print("Compaction", ok);
+}
+
+static void test_batch_operations(void) {
+    char path[64];
+    temp_path(path, sizeof(path));
+    /* Small initial file so the batch reservation has to grow it */
+    fast_storage_t *storage = fast_storage_create(path, 64 * 1024);
+
+    enum { COUNT = 5000 };
+    static char key_store[COUNT][64];
+    static size_t numbers[COUNT];
+    static const char *keys[COUNT];
+    static size_t key_lens[COUNT];
+    static const char *values[COUNT];
+    static size_t value_lens[COUNT];
+    for (size_t i = 0; i < COUNT; i++) {
+        key_lens[i] = make_key(key_store[i], i);
+        keys[i] = key_store[i];
+        numbers[i] = i * 7;
+        values[i] = (const char *)&numbers[i];
+        value_lens[i] = sizeof(numbers[i]);
+    }
+    /* The last record repeats key 0 and must win */
+    keys[COUNT - 1] = key_store[0];
+    key_lens[COUNT - 1] = key_lens[0];
+
+    bool ok = storage != NULL;
+    ok = ok && fast_storage_write_batch(storage, COUNT, keys, key_lens, values, value_lens) == 0;
+    ok = ok && fast_storage_size(storage) == COUNT - 1;
+
+    /* Every key present plus one absent one in the middle */
+    static char *out[COUNT];
+    static size_t out_lens[COUNT];
+    keys[COUNT / 2] = "missing";
+    key_lens[COUNT / 2] = 7;
+    ok = ok && fast_storage_read_many(storage, COUNT, keys, key_lens, out, out_lens) == COUNT - 1;
+    for (size_t i = 0; ok && i < COUNT; i++) {
+        if (i == COUNT / 2) {
+            ok = out[i] == NULL && out_lens[i] == 0;
+        } else {
+            size_t expected = i == 0 ? (COUNT - 1) * 7 : i * 7;
+            ok = out_lens[i] == sizeof(expected) && memcmp(out[i], &expected, sizeof(expected)) == 0;
+        }
+    }
+
+    /* Values read from the mapping written back as a batch across a grow */
+    size_t before = ok ? fast_storage_capacity(storage) : 0;
+    for (size_t round = 0; ok && round < 8; round++) {
+        keys[COUNT / 2] = key_store[COUNT / 2];
+        key_lens[COUNT / 2] = make_key(key_store[COUNT / 2], COUNT / 2);
+        ok = fast_storage_read_many(storage, COUNT - 1, keys, key_lens, out, out_lens) == COUNT - 1;
+        values[COUNT / 2] = "v";
+        value_lens[COUNT / 2] = 1;
+        for (size_t i = 0; ok && i < COUNT - 1; i++) {
+            if (i != COUNT / 2) {
+                values[i] = out[i];
+                value_lens[i] = out_lens[i];
+            }
+        }
+        ok = ok && fast_storage_write_batch(storage, COUNT - 1, keys, key_lens, values, value_lens) == 0;
+    }
+    size_t expected = 10 * 7;
+    ok = ok && fast_storage_capacity(storage) > before;
+    ok = ok && read_equals(storage, key_store[10], key_lens[10], (const char *)&expected, sizeof(expected));
+    ok = ok && read_equals(storage, key_store[COUNT / 2], key_lens[COUNT / 2], "v", 1);
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+
+    /* Batch records replay like single writes */
+    storage = fast_storage_create(path, 64 * 1024);
+    expected = (COUNT - 1) * 7;
+    ok = ok && storage != NULL && fast_storage_size(storage) == COUNT - 1;
+    ok = ok && read_equals(storage, key_store[0], key_lens[0], (const char *)&expected, sizeof(expected));
+
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    remove_store(path);
+    test_print("Batch Write and Multi-Get", ok);
+}
+
+static void test_checkpoint(void) {
+    char path[64];
+    char sidecar[80];
+    temp_path(path, sizeof(path));
+    snprintf(sidecar, sizeof(sidecar), "%s.idx", path);
+    fast_storage_t *storage = fast_storage_create(path, STORE_SIZE);
+
+    char key[64];
+    bool ok = storage != NULL;
+    for (size_t i = 0; ok && i < 20000; i++) {
+        size_t len = make_key(key, i);
+        ok = fast_storage_write(storage, key, len, (const char *)&i, sizeof(i)) == 0;
+    }
+    ok = ok && fast_storage_remove(storage, "k1", 2) == 0;
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    ok = ok && access(sidecar, F_OK) == 0;
+
+    /* Reopen maps the checkpoint: nothing to replay */
+    storage = fast_storage_create(path, STORE_SIZE);
+    fast_storage_stats_t before = stats_of(storage);
+    ok = ok && storage != NULL && before.replayed == 0 && before.keys == 19999;
+    ok = ok && !fast_storage_contains(storage, "k1", 2);
+    for (size_t i = 2; ok && i < 20000; i += 331) {
+        size_t len = make_key(key, i);
+        ok = read_equals(storage, key, len, (const char *)&i, sizeof(i));
+    }
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+
+    /* A writer that dies after flushing leaves a tail past the checkpoint */
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        fast_storage_t *child = fast_storage_create(path, STORE_SIZE);
+        if (!child) _exit(1);
+        for (size_t i = 0; i < 10; i++) {
+            size_t len = make_key(key, 100000 + i);
+            fast_storage_write(child, key, len, "tail", 4);
+        }
+        fast_storage_write(child, "k2", 2, "new", 3);
+        fast_storage_remove(child, "k4", 2);
+        fast_storage_flush(child);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    storage = fast_storage_create(path, STORE_SIZE);
+    fast_storage_stats_t after = stats_of(storage);
+    ok = ok && storage != NULL && after.replayed == 12 && after.keys == 19999 + 10 - 1;
+    ok = ok && after.live_bytes + after.dead_bytes == fast_storage_bytes_used(storage);
+    size_t len = make_key(key, 100009);
+    ok = ok && read_equals(storage, key, len, "tail", 4) && read_equals(storage, "k2", 2, "new", 3);
+    ok = ok && !fast_storage_contains(storage, "k4", 2);
+
+    /* Compaction rewrites the log, so the old checkpoint must not be used */
+    ok = ok && fast_storage_compact(storage) == 0;
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0) {
+        fast_storage_t *child = fast_storage_create(path, STORE_SIZE);
+        _exit(child && stats_of(child).replayed == 19999 + 10 - 1 ? 0 : 1);
+    }
+    waitpid(pid, &status, 0);
+    ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    ok = ok && read_equals(storage, "k2", 2, "new", 3);
+
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    storage = fast_storage_create(path, STORE_SIZE);
+    ok = ok && storage != NULL && stats_of(storage).replayed == 0 && read_equals(storage, "k2", 2, "new", 3);
+
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    remove_store(path);
+    test_print("Index Checkpoint", ok);
+}
+
+/* Fixed-size records, so a test can find record i in the file */
+#define RECORD_BYTES (24 + 5 + sizeof(size_t))
+#define RECORD_AT(i) (64 + (off_t)(i) * (off_t)RECORD_BYTES)
+
+static bool write_numbered(fast_storage_t *storage, size_t from, size_t to) {
+    char key[16];
+    bool ok = true;
+    for (size_t i = from; ok && i < to; i++) {
+        sprintf(key, "r%04zu", i);
+        ok = fast_storage_write(storage, key, 5, (const char *)&i, sizeof(i)) == 0;
+    }
+    return ok;
+}
+
+static bool patch_file(const char *path, off_t offset, uint8_t flip) {
+    FILE *f = fopen(path, "r+b");
+    if (!f) return false;
+    int c = fseeko(f, offset, SEEK_SET) == 0 ? fgetc(f) : EOF;
+    bool ok = c != EOF && fseeko(f, offset, SEEK_SET) == 0 && fputc(c ^ flip, f) != EOF;
+    fclose(f);
+    return ok;
+}
+
+static void test_crash_recovery(void) {
+    char path[64];
+    char sidecar[80];
+    temp_path(path, sizeof(path));
+    snprintf(sidecar, sizeof(sidecar), "%s.idx", path);
+    fast_storage_t *storage = fast_storage_create(path, STORE_SIZE);
+    bool ok = storage != NULL && write_numbered(storage, 0, 100);
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+
+    /* A writer that dies without flushing: its records are past the marker */
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        fast_storage_t *child = fast_storage_create(path, STORE_SIZE);
+        _exit(child && write_numbered(child, 100, 150) ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    storage = fast_storage_create(path, STORE_SIZE);
+    fast_storage_stats_t stats = stats_of(storage);
+    ok = ok && storage != NULL && stats.keys == 150 && stats.replayed == 50 && stats.recovered == 50;
+    size_t probe = 149;
+    ok = ok && read_equals(storage, "r0149", 5, (const char *)&probe, sizeof(probe));
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+
+    /* A corrupt record ends the log: it and everything after it are dropped */
+    unlink(sidecar);
+    ok = ok && patch_file(path, RECORD_AT(120) + 24 + 5, 0x01);
+    storage = fast_storage_create(path, STORE_SIZE);
+    stats = stats_of(storage);
+    ok = ok && storage != NULL && stats.keys == 120 && stats.replayed == 120;
+    ok = ok && !fast_storage_contains(storage, "r0120", 5) && !fast_storage_contains(storage, "r0149", 5);
+    ok = ok && fast_storage_bytes_used(storage) == (size_t)(RECORD_AT(120) - 64);
+
+    /* The log continues from there, and nothing stale comes back */
+    ok = ok && write_numbered(storage, 200, 230);
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    unlink(sidecar);
+    storage = fast_storage_create(path, STORE_SIZE);
+    ok = ok && storage != NULL && fast_storage_size(storage) == 150 && !fast_storage_contains(storage, "r0121", 5);
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+
+    /* A torn commit marker commits nothing, but checksums still recover it all */
+    unlink(sidecar);
+    ok = ok && patch_file(path, 6 * 8, 0x01);
+    storage = fast_storage_create(path, STORE_SIZE);
+    stats = stats_of(storage);
+    ok = ok && storage != NULL && stats.keys == 150 && stats.recovered == 150;
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+
+    /* A damaged checkpoint block fails its checksum and the log is replayed */
+    ok = ok && access(sidecar, F_OK) == 0 && patch_file(sidecar, 4096 + 64, 0x80);
+    storage = fast_storage_create(path, STORE_SIZE);
+    stats = stats_of(storage);
+    probe = 229;
+    ok = ok && storage != NULL && stats.keys == 150 && stats.replayed == 150;
+    ok = ok && read_equals(storage, "r0229", 5, (const char *)&probe, sizeof(probe));
+
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    remove_store(path);
+    test_print("Crash Recovery", ok);
+}
+
+static void test_durability_modes(void) {
+    char path[64];
+    temp_path(path, sizeof(path));
+    fast_storage_t *storage = fast_storage_create(path, STORE_SIZE);
+    bool ok = storage != NULL;
+
+    /* SYNC: one sync commit per write and per batch */
+    ok = ok && fast_storage_set_durability(storage, FAST_STORAGE_SYNC, 0) == 0;
+    ok = ok && write_numbered(storage, 0, 10);
+    const char *keys[2] = {"b0", "b1"};
+    size_t key_lens[2] = {2, 2};
+    const char *values[2] = {"x", "y"};
+    size_t value_lens[2] = {1, 1};
+    ok = ok && fast_storage_write_batch(storage, 2, keys, key_lens, values, value_lens) == 0;
+    fast_storage_stats_t stats = stats_of(storage);
+    ok = ok && stats.syncs == 11 && stats.committed_bytes == fast_storage_bytes_used(storage);
+
+    /* SYNC survives the process dying right after the write returns */
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        fast_storage_t *child = fast_storage_create(path, STORE_SIZE);
+        if (!child || fast_storage_set_durability(child, FAST_STORAGE_SYNC, 0) != 0) _exit(1);
+        _exit(fast_storage_write(child, "last", 4, "word", 4) == 0 &&
+              stats_of(child).committed_bytes == fast_storage_bytes_used(child) ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    storage = fast_storage_create(path, STORE_SIZE);
+    ok = ok && storage != NULL && read_equals(storage, "last", 4, "word", 4) && fast_storage_size(storage) == 13;
+
+    /* GROUP: the committer catches up without the writer syncing */
+    ok = ok && fast_storage_set_durability(storage, FAST_STORAGE_GROUP, 5) == 0;
+    ok = ok && write_numbered(storage, 100, 200);
+    for (int wait = 0; ok && wait < 200; wait++) {
+        stats = stats_of(storage);
+        if (stats.syncs > 0 && stats.committed_bytes == fast_storage_bytes_used(storage)) break;
+        usleep(5000);
+    }
+    ok = ok && stats.syncs > 0 && stats.committed_bytes == fast_storage_bytes_used(storage);
+
+    /* ASYNC and NONE move the marker without syncing */
+    ok = ok && fast_storage_set_durability(storage, FAST_STORAGE_ASYNC, 0) == 0;
+    uint64_t syncs = stats_of(storage).syncs;
+    ok = ok && write_numbered(storage, 200, 210);
+    stats = stats_of(storage);
+    ok = ok && stats.syncs == syncs && stats.committed_bytes == fast_storage_bytes_used(storage);
+    ok = ok && fast_storage_set_durability(storage, FAST_STORAGE_NONE, 0) == 0;
+    ok = ok && write_numbered(storage, 210, 220);
+    ok = ok && stats_of(storage).committed_bytes < fast_storage_bytes_used(storage);
+    ok = ok && fast_storage_sync(storage) == 0 && stats_of(storage).syncs == syncs + 1;
+    ok = ok && fast_storage_set_durability(storage, (fast_storage_durability_t)7, 0) == -1;
+
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    remove_store(path);
+    test_print("Durability Modes", ok);
+}
+
+static void test_open_options(void) {
+    char path[64];
+    temp_path(path, sizeof(path));
+    fast_storage_options_t options;
+    fast_storage_default_options(&options);
+
+    /* Read-only needs an existing store */
+    options.read_only = true;
+    bool ok = fast_storage_open_ex(path, &options) == NULL;
+
+    /* Eager policy: everything populated and locked, still grows */
+    fast_storage_default_options(&options);
+    options.initial_size = 64 * 1024;
+    options.populate = true;
+    options.lock = true;
+    options.huge_pages = true;
+    options.advice = FAST_STORAGE_ADVICE_RANDOM;
+    fast_storage_t *storage = fast_storage_open_ex(path, &options);
+    ok = ok && storage != NULL && write_numbered(storage, 0, 5000);
+    ok = ok && stats_of(storage).grows > 0;
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+
+    /* Lazy policy with no read-ahead window */
+    fast_storage_default_options(&options);
+    options.initial_size = 64 * 1024;
+    options.populate_ahead = 0;
+    options.advice = FAST_STORAGE_ADVICE_SEQUENTIAL;
+    storage = fast_storage_open_ex(path, &options);
+    ok = ok && storage != NULL && fast_storage_size(storage) == 5000 && write_numbered(storage, 5000, 6000);
+    size_t used = fast_storage_bytes_used(storage);
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+
+    /* Read-only: readable, every modification refused, the file untouched */
+    options.read_only = true;
+    storage = fast_storage_open_ex(path, &options);
+    size_t probe = 5999;
+    ok = ok && storage != NULL && fast_storage_size(storage) == 6000;
+    ok = ok && read_equals(storage, "r5999", 5, (const char *)&probe, sizeof(probe));
+    ok = ok && fast_storage_write(storage, "new", 3, "x", 1) == -1;
+    ok = ok && fast_storage_remove(storage, "r0001", 5) == -1;
+    ok = ok && fast_storage_compact(storage) == -1 && fast_storage_sync(storage) == -1;
+    ok = ok && fast_storage_set_durability(storage, FAST_STORAGE_SYNC, 0) == -1;
+    fast_storage_flush(storage);
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    storage = fast_storage_create(path, STORE_SIZE);
+    ok = ok && storage != NULL && fast_storage_bytes_used(storage) == used && !fast_storage_contains(storage, "new", 3);
+
+    fast_storage_default_options(&options);
+    options.advice = (fast_storage_advice_t)42;
+    ok = ok && fast_storage_open_ex(path, &options) == NULL;
+
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    remove_store(path);
+    test_print("Open Options", ok);
+}
+
+/* ============================================================================
+ * Concurrency Tests
+ * ============================================================================ */
+
+#define ANCHORS 512
+
+typedef struct {
+    fast_storage_t *storage;
+    volatile bool stop;
+    volatile bool failed;
+    size_t reads;
+} concurrent_ctx_t;
+
+/* Anchor i always holds anchor_value(i); churn keys hold their own index */
+static size_t anchor_value(size_t i) {
+    return i * 2654435761u;
+}
+
+static void *concurrent_reader(void *arg) {
+    concurrent_ctx_t *ctx = arg;
+    char key[64];
+    size_t round = 0;
+    while (!ctx->stop && !ctx->failed) {
+        size_t i = round++ % ANCHORS;
+        size_t len = (size_t)sprintf(key, "anchor-%zu", i);
+        size_t value = 0;
+        size_t value_len = 0;
+        size_t expected = anchor_value(i);
+        if (fast_storage_read_copy(ctx->storage, key, len, (char *)&value, sizeof(value), &value_len) != 0 ||
+            value_len != sizeof(value) || value != expected) {
+            ctx->failed = true;
+        }
+
+        /* Churn keys come and go; any value seen must be the key's own */
+        len = make_key(key, round % 4096);
+        fast_storage_pin(ctx->storage);
+        char *ptr = NULL;
+        if (fast_storage_read(ctx->storage, key, len, &ptr, &value_len) == 0) {
+            size_t seen;
+            memcpy(&seen, ptr, sizeof(seen));
+            if (value_len != 64 || seen != round % 4096) {
+                ctx->failed = true;
+            }
+        }
+        fast_storage_unpin(ctx->storage);
+        ctx->reads++;
+    }
+    return NULL;
+}
+
+static void test_concurrent_readers(void) {
+    char path[64];
+    temp_path(path, sizeof(path));
+    /* Tiny initial file: the writer grows, rehashes and compacts under the readers */
+    fast_storage_t *storage = fast_storage_create(path, 64 * 1024);
+    concurrent_ctx_t ctx = { storage, false, false, 0 };
+
+    char key[64];
+    char value[64] = {0};
+    bool ok = storage != NULL;
+    for (size_t i = 0; ok && i < ANCHORS; i++) {
+        size_t len = (size_t)sprintf(key, "anchor-%zu", i);
+        size_t v = anchor_value(i);
+        ok = fast_storage_write(storage, key, len, (const char *)&v, sizeof(v)) == 0;
+    }
+
+    enum { READERS = 3 };
+    concurrent_ctx_t readers[READERS];
+    pthread_t threads[READERS];
+    for (int r = 0; ok && r < READERS; r++) {
+        readers[r] = ctx;
+        pthread_create(&threads[r], NULL, concurrent_reader, &readers[r]);
+    }
+
+    /* A value pinned before the log is rewritten stays readable */
+    char *pinned_ptr = NULL;
+    size_t pinned_len = 0;
+    ok = ok && fast_storage_pin(storage) == 0;
+    ok = ok && fast_storage_read(storage, "anchor-7", 8, &pinned_ptr, &pinned_len) == 0;
+
+    for (size_t round = 0; ok && round < 60; round++) {
+        for (size_t i = 0; ok && i < 4096; i++) {
+            size_t len = make_key(key, i);
+            memcpy(value, &i, sizeof(i));
+            ok = fast_storage_write(storage, key, len, value, sizeof(value)) == 0;
+        }
+        for (size_t i = round % 2; ok && i < 4096; i += 2) {
+            size_t len = make_key(key, i);
+            ok = fast_storage_remove(storage, key, len) == 0;
+        }
+    }
+    fast_storage_stats_t stats = stats_of(storage);
+    ok = ok && stats.grows > 0 && stats.compactions > 0;
+
+    size_t expected = anchor_value(7);
+    ok = ok && pinned_len == sizeof(expected) && memcmp(pinned_ptr, &expected, sizeof(expected)) == 0;
+    fast_storage_unpin(storage);
+
+    size_t reads = 0;
+    for (int r = 0; r < READERS; r++) {
+        readers[r].stop = true;
+        pthread_join(threads[r], NULL);
+        ok = ok && !readers[r].failed;
+        reads += readers[r].reads;
+    }
+    ok = ok && reads > 0 && stats_of(storage).reads > 0;
+
+    if (storage) {
+        fast_storage_destroy(storage);
+    }
+    remove_store(path);
+    test_print("Concurrent Readers", ok);
+}
+
+int main(void) {
+    printf("=== Fast Storage Unit Tests ===\n\n");
+
+    test_basic_operations();
+    test_index_growth();
+    test_tombstone_churn();
+    test_reopen();
+    test_file_growth();
+    test_remove_persists();
+    test_compaction();
+    test_batch_operations();
+    test_checkpoint();
+    test_crash_recovery();
+    test_durability_modes();
+    test_open_options();
+    test_concurrent_readers();
+
+    printf("\n=== All tests completed ===\n");
+
+    return g_failures == 0 ? 0 : 1;
+}
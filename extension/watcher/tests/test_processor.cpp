@@ -0,0 +1,292 @@
+#include <processor.hpp>
+#include <processor_batch.hpp>
+#include <delta_engine.hpp>
+#include <chrono>
+#include <iostream>
+#include <cstring>
+
+using namespace watcher;
+using namespace watcher::processor;
+
+// ============================================================================
+// Test Utilities
+// ============================================================================
+
+static int g_failures = 0;
+
+void test_print(const std::string& test_name, bool passed) {
+    if (!passed) {
+        ++g_failures;
+    }
+    std::cout << "[" << (passed ? "PASS" : "FAIL") << "] " << test_name << std::endl;
+}
+
+static std::vector<EnrichedEvent> make_batch(size_t count) {
+    std::vector<EnrichedEvent> events(count);
+    for (size_t i = 0; i < count; ++i) {
+        EnrichedEvent& event = events[i];
+        event.event_seq = i;
+        event.symbol = "update(int)";
+        event.variable_name = "counter_" + std::to_string(i % 3);
+        event.variable_ids = {"var-" + std::to_string(i % 3)};
+        if (i % 4 != 3) {  // Every fourth event has no deltas
+            uint8_t pre[16] = {}, post[16] = {};
+            memset(post + 2, 0xAB, 1 + i % 5);
+            computeDeltas(pre, post, sizeof(pre), event.deltas, 0);
+        }
+    }
+    return events;
+}
+
+/// Counts the events it sees, annotates each with its event_seq
+class CountingProcessor : public CustomProcessor {
+public:
+    void processBatch(Span<const EnrichedEvent> events, Span<ProcessorResponse> responses,
+                      AnnotationArena& annotations) override {
+        calls++;
+        for (size_t i = 0; i < events.size(); ++i) {
+            seen.push_back(events[i].event_seq);
+            annotations.addInt(static_cast<uint32_t>(i), "seq", static_cast<int64_t>(events[i].event_seq));
+            responses[i].action = ProcessorAction::ANNOTATE;
+        }
+    }
+
+    size_t calls = 0;
+    std::vector<uint64_t> seen;
+};
+
+// ============================================================================
+// Processor Tests
+// ============================================================================
+
+void test_annotation_arena() {
+    AnnotationArena arena;
+    arena.addInt(0, "count", -7);
+    arena.addDouble(1, "ratio", 0.25);
+    arena.addString(1, "label", "hot");
+    arena.setEventBase(10);
+    arena.addInt(2, "late", 1);
+
+    const auto& entries = arena.entries();
+    bool typed = entries.size() == 4 && entries[0].type == AnnotationType::INT && entries[0].int_value == -7 &&
+                 arena.key(entries[0]) == "count" && entries[1].double_value == 0.25 &&
+                 arena.key(entries[2]) == "label" && arena.text(entries[2]) == "hot" && entries[3].event == 12;
+    arena.clear();
+    test_print("Annotation Arena", typed && arena.size() == 0 && arena.eventBase() == 0);
+}
+
+void test_processor_chain() {
+    std::vector<EnrichedEvent> events = make_batch(16);
+    std::vector<ProcessorResponse> responses(events.size());
+    AnnotationArena annotations;
+
+    auto counting = std::make_shared<CountingProcessor>();
+    ProcessorChain chain;
+    chain.add(std::make_shared<FilteringProcessor>([](const EnrichedEvent& e) { return !e.deltas.empty(); }));
+    chain.add(counting);
+    chain.processBatch(events, responses, annotations);
+
+    // Dropped events never reach the second stage; annotations keep batch indices
+    bool short_circuit = counting->seen.size() == 12 && counting->calls == 4;
+    for (uint64_t seq : counting->seen) {
+        short_circuit = short_circuit && seq % 4 != 3;
+    }
+    bool actions_ok = true;
+    for (size_t i = 0; i < events.size(); ++i) {
+        actions_ok = actions_ok && responses[i].action ==
+                                       (i % 4 == 3 ? ProcessorAction::DROP : ProcessorAction::ANNOTATE);
+    }
+    bool indices_ok = annotations.size() == 12;
+    for (const auto& a : annotations.entries()) {
+        indices_ok = indices_ok && a.event < events.size() && static_cast<uint64_t>(a.int_value) == a.event;
+    }
+    test_print("Processor Chain", short_circuit && actions_ok && indices_ok && chain.size() == 2);
+}
+
+/// Verdicts of the fixture processors with "drop-odd": events without
+/// deltas or with an odd event_seq are dropped, the rest annotated with
+/// changed_bytes and variable
+static bool check_drop_odd(const std::vector<EnrichedEvent>& events, const std::vector<ProcessorResponse>& responses,
+                           const AnnotationArena& annotations) {
+    bool actions_ok = true;
+    size_t kept = 0;
+    for (size_t i = 0; i < events.size(); ++i) {
+        bool drop = i % 4 == 3 || i % 2 == 1;
+        kept += !drop;
+        actions_ok = actions_ok && responses[i].action == (drop ? ProcessorAction::DROP : ProcessorAction::ANNOTATE);
+    }
+    bool annotations_ok = annotations.size() == 2 * kept;
+    for (const auto& a : annotations.entries()) {
+        const EnrichedEvent& event = events[a.event];
+        if (annotations.key(a) == "changed_bytes") {
+            annotations_ok = annotations_ok && a.type == AnnotationType::INT &&
+                             a.int_value == static_cast<int64_t>(event.deltas.changedBytes());
+        } else {
+            annotations_ok = annotations_ok && annotations.key(a) == "variable" &&
+                             annotations.text(a) == event.variable_name;
+        }
+    }
+    return actions_ok && annotations_ok;
+}
+
+void test_native_processor() {
+    std::string error;
+    auto processor = ProcessorFactory::createNativeProcessor(WATCHER_TEST_NATIVE_PROCESSOR, "drop-odd", &error);
+    if (!processor) {
+        std::cout << "  " << error << std::endl;
+        test_print("Native Processor (dlopen)", false);
+        return;
+    }
+
+    std::vector<EnrichedEvent> events = make_batch(16);
+    std::vector<ProcessorResponse> responses(events.size());
+    AnnotationArena annotations;
+    processor->processBatch(events, responses, annotations);
+    bool verdicts_ok = check_drop_odd(events, responses, annotations);
+
+    // Bad libraries and rejected configurations fail the load with a reason
+    std::string missing, rejected;
+    bool failures_ok =
+        !ProcessorFactory::createNativeProcessor("./no_such_processor.so", "", &missing) && !missing.empty() &&
+        !ProcessorFactory::createNativeProcessor(WATCHER_TEST_NATIVE_PROCESSOR, "reject", &rejected) &&
+        !rejected.empty();
+    test_print("Native Processor (dlopen)", verdicts_ok && failures_ok);
+}
+
+void test_packed_batch() {
+    std::vector<EnrichedEvent> events = make_batch(8);
+    events[5].sql_context_id = "sql-1";
+    ProcessorBatchPacker packer;
+    const std::vector<uint8_t>& buffer = packer.pack(events);
+
+    ProcessorBatchHeader header;
+    memcpy(&header, buffer.data(), sizeof(header));
+    bool header_ok = header.magic == PROCESSOR_BATCH_MAGIC && header.count == 8 && header.size == buffer.size() &&
+                     header.records_offset % 8 == 0 && header.text_offset % 8 == 0;
+
+    const auto* records = reinterpret_cast<const BinaryEventRecord*>(buffer.data() + header.records_offset);
+    const auto* text = reinterpret_cast<const ProcessorEventText*>(buffer.data() + header.text_offset);
+    const char* strings = reinterpret_cast<const char*>(buffer.data() + header.strings_offset);
+    const uint8_t* deltas = buffer.data() + header.deltas_offset;
+    bool events_ok = true;
+    for (size_t i = 0; i < events.size(); ++i) {
+        const EnrichedEvent& event = events[i];
+        events_ok = events_ok && records[i].event_seq == event.event_seq &&
+                    records[i].delta_runs == event.deltas.size() &&
+                    std::string(strings + text[i].variable_name) == event.variable_name &&
+                    std::string(strings + text[i].symbol) == event.symbol &&
+                    std::string(strings + text[i].variable_ids) == event.variable_ids[0] &&
+                    std::string(strings + text[i].sql_context_id) == event.sql_context_id;
+        size_t pos = text[i].deltas;
+        for (const DeltaRun& run : event.deltas.runs) {
+            uint32_t fields[2];
+            memcpy(fields, deltas + pos, sizeof(fields));
+            pos += sizeof(fields);
+            events_ok = events_ok && fields[0] == run.offset && fields[1] == run.length &&
+                        memcmp(deltas + pos, event.deltas.oldBytes(run), run.length) == 0 &&
+                        memcmp(deltas + pos + run.length, event.deltas.newBytes(run), run.length) == 0;
+            pos += 2 * size_t(run.length);
+        }
+    }
+
+    // Repeated strings are stored once
+    bool interned = text[0].symbol == text[1].symbol && text[0].variable_name == text[3].variable_name;
+    test_print("Packed Processor Batch", header_ok && events_ok && interned);
+}
+
+using ScriptFactory = std::unique_ptr<CustomProcessor> (*)(const std::string&, const ScriptProcessorOptions&,
+                                                           std::string*);
+
+/// Load a fixture script; nullptr (and a SKIP) when the runtime is missing
+static std::unique_ptr<CustomProcessor> load_script(const std::string& name, ScriptFactory factory,
+                                                    const char* path, const ScriptProcessorOptions& options) {
+    std::string error;
+    auto processor = factory(path, options, &error);
+    if (!processor) {
+        if (error.rfind("Cannot run", 0) == 0) {
+            std::cout << "[SKIP] " << name << ": " << error << std::endl;
+        } else {
+            std::cout << "  " << error << std::endl;
+            test_print(name, false);
+        }
+    }
+    return processor;
+}
+
+void test_script_processor(const std::string& name, ScriptFactory factory, const char* path) {
+    ScriptProcessorOptions options;
+    options.batch_deadline = std::chrono::seconds(10);  // Generous for loaded CI hosts
+    auto processor = load_script(name, factory, path, options);
+    if (!processor) {
+        return;
+    }
+
+    // Two batches, so the second reuses the host's buffers
+    bool verdicts_ok = true;
+    for (int round = 0; round < 2; ++round) {
+        std::vector<EnrichedEvent> events = make_batch(16);
+        std::vector<ProcessorResponse> responses(events.size());
+        AnnotationArena annotations;
+        processor->processBatch(events, responses, annotations);
+        verdicts_ok = verdicts_ok && check_drop_odd(events, responses, annotations);
+    }
+    auto& script = static_cast<ScriptProcessor&>(*processor);
+    bool counters_ok = script.batches() == 2 && script.deadlineMisses() == 0 && script.failures() == 0;
+    test_print(name, verdicts_ok && counters_ok);
+}
+
+void test_script_deadline(const std::string& name, ScriptFactory factory, const char* path) {
+    // The fixtures take 300 ms on "slow()" batches, against a 30 ms deadline
+    ScriptProcessorOptions options;
+    options.batch_deadline = std::chrono::milliseconds(30);
+    auto processor = load_script(name, factory, path, options);
+    if (!processor) {
+        return;
+    }
+
+    // Both batches pass unprocessed; the second waits out its own deadline
+    // behind the first instead of queueing
+    bool passed = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 2; ++round) {
+        std::vector<EnrichedEvent> events = make_batch(4);
+        for (auto& event : events) {
+            event.symbol = "slow()";
+        }
+        std::vector<ProcessorResponse> responses(events.size());
+        AnnotationArena annotations;
+        processor->processBatch(events, responses, annotations);
+        for (const auto& response : responses) {
+            passed = passed && response.action == ProcessorAction::PASS;
+        }
+        passed = passed && annotations.size() == 0;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    auto& script = static_cast<ScriptProcessor&>(*processor);
+    bool bounded = elapsed < std::chrono::milliseconds(250);
+    test_print(name, passed && bounded && script.deadlineMisses() == 2 && script.batches() == 0);
+}
+
+int main() {
+    std::cout << "=== Watcher Processor Tests ===" << std::endl;
+    std::cout << std::endl;
+
+    test_annotation_arena();
+    test_processor_chain();
+    test_native_processor();
+    test_packed_batch();
+    test_script_processor("Python Processor (embedded)", &ProcessorFactory::createPythonProcessor,
+                          WATCHER_TEST_PYTHON_PROCESSOR);
+    test_script_deadline("Python Processor Deadline", &ProcessorFactory::createPythonProcessor,
+                         WATCHER_TEST_PYTHON_PROCESSOR);
+    test_script_processor("JavaScript Processor (node)", &ProcessorFactory::createJavaScriptProcessor,
+                          WATCHER_TEST_JS_PROCESSOR);
+    test_script_deadline("JavaScript Processor Deadline", &ProcessorFactory::createJavaScriptProcessor,
+                         WATCHER_TEST_JS_PROCESSOR);
+
+    std::cout << std::endl;
+    std::cout << "=== All tests completed ===" << std::endl;
+
+    return g_failures == 0 ? 0 : 1;
+}
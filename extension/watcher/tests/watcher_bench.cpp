@@ -0,0 +1,416 @@
+#include <watcher_core.hpp>
+#include <event_ring.hpp>
+#include <delta_engine.hpp>
+#include <latency_histogram.hpp>
+#include <event_clock.hpp>
+#include <symbolizer.hpp>
+#include <faststorage.h>
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace watcher;
+
+// ============================================================================
+// Bench Utilities
+// ============================================================================
+
+/// Scratch file path under $TMPDIR (or /tmp), unique per process
+static std::string scratch_path(const char* name) {
+    const char* dir = getenv("TMPDIR");
+    return std::string(dir && *dir ? dir : "/tmp") + "/watcher_bench_" + std::to_string(getpid()) + "_" + name;
+}
+
+static void remove_store(const std::string& path) {
+    unlink(path.c_str());
+    unlink((path + ".idx").c_str());
+}
+
+static std::string make_key(size_t i) {
+    char key[32];
+    int len = snprintf(key, sizeof(key), "key-%08zu", i);
+    return std::string(key, static_cast<size_t>(len));
+}
+
+// ============================================================================
+// Event Queue
+// ============================================================================
+
+static void BM_SpscRingPushPop(benchmark::State& state) {
+    SpscRing<FastPathEvent> ring(EVENT_QUEUE_CAPACITY);
+    FastPathEvent event = {};
+    for (auto _ : state) {
+        ring.tryPush(event);
+        ring.tryPop(event);
+        benchmark::DoNotOptimize(event);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpscRingPushPop);
+
+static void BM_MpscRingPushPop(benchmark::State& state) {
+    MpscRing<FastPathEvent> ring(EVENT_QUEUE_CAPACITY);
+    FastPathEvent event = {};
+    for (auto _ : state) {
+        ring.tryPush(event);
+        ring.tryPop(event);
+        benchmark::DoNotOptimize(event);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MpscRingPushPop);
+
+/// Producer on the benchmark thread, consumer draining in batches (as the
+/// slow path does); a full ring spins the producer
+static void BM_SpscRingCrossThread(benchmark::State& state) {
+    SpscRing<FastPathEvent> ring(EVENT_QUEUE_CAPACITY);
+    std::atomic<bool> done(false);
+    std::thread consumer([&] {
+        std::vector<FastPathEvent> batch(SLOW_PATH_BATCH_SIZE);
+        while (!done.load(std::memory_order_relaxed)) {
+            ring.popBatch(batch.data(), batch.size());
+        }
+    });
+    FastPathEvent event = {};
+    for (auto _ : state) {
+        while (!ring.tryPush(event)) {
+        }
+        ++event.event_seq;
+    }
+    done = true;
+    consumer.join();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpscRingCrossThread);
+
+// ============================================================================
+// Delta Kernel
+// ============================================================================
+
+/// One 4 KiB sub-page with range(0) changed runs of 4 bytes, spread evenly
+static void delta_inputs(size_t runs, std::vector<uint8_t>& pre, std::vector<uint8_t>& post) {
+    std::mt19937 rng(42);
+    pre.resize(PAGE_SIZE);
+    for (auto& byte : pre) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    post = pre;
+    for (size_t r = 0; r < runs; ++r) {
+        size_t offset = r * (PAGE_SIZE / runs);
+        for (size_t b = 0; b < 4 && offset + b < PAGE_SIZE; ++b) {
+            post[offset + b] ^= 0xFF;
+        }
+    }
+}
+
+static void BM_ComputeDeltas(benchmark::State& state) {
+    std::vector<uint8_t> pre, post;
+    delta_inputs(static_cast<size_t>(state.range(0)), pre, post);
+    DeltaSet deltas;
+    for (auto _ : state) {
+        deltas.clear();
+        benchmark::DoNotOptimize(computeDeltas(pre.data(), post.data(), PAGE_SIZE, deltas));
+    }
+    state.SetBytesProcessed(state.iterations() * PAGE_SIZE);
+    state.SetLabel(deltaKernelName());
+}
+BENCHMARK(BM_ComputeDeltas)->Arg(0)->Arg(1)->Arg(16)->Arg(256);
+
+static void BM_ComputeDeltasScalar(benchmark::State& state) {
+    std::vector<uint8_t> pre, post;
+    delta_inputs(static_cast<size_t>(state.range(0)), pre, post);
+    DeltaSet deltas;
+    for (auto _ : state) {
+        deltas.clear();
+        benchmark::DoNotOptimize(computeDeltasScalar(pre.data(), post.data(), PAGE_SIZE, deltas));
+    }
+    state.SetBytesProcessed(state.iterations() * PAGE_SIZE);
+}
+BENCHMARK(BM_ComputeDeltasScalar)->Arg(0)->Arg(1)->Arg(16)->Arg(256);
+
+// ============================================================================
+// Symbol Cache
+// ============================================================================
+
+static void bench_probe() {
+    benchmark::ClobberMemory();
+}
+
+/// Cached lookups of one ip (the common case: a hot writer)
+static void BM_SymbolizerCached(benchmark::State& state) {
+    Symbolizer symbolizer;
+    uint64_t ip = reinterpret_cast<uint64_t>(&bench_probe);
+    symbolizer.resolve(ip);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(symbolizer.resolve(ip));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SymbolizerCached);
+
+/// Lookups spread over range(0) distinct ips in this binary's text
+static void BM_SymbolizerSpread(benchmark::State& state) {
+    Symbolizer symbolizer;
+    std::vector<uint64_t> ips(static_cast<size_t>(state.range(0)));
+    uint64_t base = reinterpret_cast<uint64_t>(&bench_probe);
+    for (size_t i = 0; i < ips.size(); ++i) {
+        ips[i] = base + i * 16;
+    }
+    size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(symbolizer.resolve(ips[next]));
+        next = next + 1 == ips.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SymbolizerSpread)->Arg(64)->Arg(4096);
+
+// ============================================================================
+// Fast Storage
+// ============================================================================
+
+static void BM_FastStorageWrite(benchmark::State& state) {
+    std::string path = scratch_path("write.db");
+    remove_store(path);
+    fast_storage_t* storage = fast_storage_create(path.c_str(), 64 << 20);
+    if (!storage) {
+        state.SkipWithError("fast_storage_create failed");
+        return;
+    }
+    std::string value(static_cast<size_t>(state.range(0)), 'v');
+    size_t i = 0;
+    for (auto _ : state) {
+        std::string key = make_key(i++ % 100000);
+        if (fast_storage_write(storage, key.data(), key.size(), value.data(), value.size()) != 0) {
+            state.SkipWithError("fast_storage_write failed");
+            break;
+        }
+    }
+    fast_storage_destroy(storage);
+    remove_store(path);
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+// Fixed iterations: the log only grows, so keep the scratch file bounded
+BENCHMARK(BM_FastStorageWrite)->Arg(64)->Arg(1024)->Iterations(100000);
+
+static void BM_FastStorageRead(benchmark::State& state) {
+    const size_t keys = static_cast<size_t>(state.range(0));
+    std::string path = scratch_path("read.db");
+    remove_store(path);
+    fast_storage_t* storage = fast_storage_create(path.c_str(), 64 << 20);
+    if (!storage) {
+        state.SkipWithError("fast_storage_create failed");
+        return;
+    }
+    std::vector<std::string> names(keys);
+    std::string value(64, 'v');
+    for (size_t i = 0; i < keys; ++i) {
+        names[i] = make_key(i);
+        fast_storage_write(storage, names[i].data(), names[i].size(), value.data(), value.size());
+    }
+    std::mt19937 rng(7);
+    for (auto _ : state) {
+        const std::string& key = names[rng() % keys];
+        char* out = nullptr;
+        size_t len = 0;
+        benchmark::DoNotOptimize(fast_storage_read(storage, key.data(), key.size(), &out, &len));
+        benchmark::DoNotOptimize(out);
+    }
+    fast_storage_destroy(storage);
+    remove_store(path);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FastStorageRead)->Arg(1000)->Arg(100000);
+
+/// Open a store of range(0) records. With range(1) == 0 the checkpoint is
+/// deleted first, so the index is rebuilt by replaying the whole log.
+static void BM_FastStorageRebuildIndex(benchmark::State& state) {
+    const size_t records = static_cast<size_t>(state.range(0));
+    const bool checkpointed = state.range(1) != 0;
+    std::string path = scratch_path("rebuild.db");
+    remove_store(path);
+    fast_storage_t* storage = fast_storage_create(path.c_str(), 64 << 20);
+    if (!storage) {
+        state.SkipWithError("fast_storage_create failed");
+        return;
+    }
+    std::string value(64, 'v');
+    for (size_t i = 0; i < records; ++i) {
+        std::string key = make_key(i);
+        fast_storage_write(storage, key.data(), key.size(), value.data(), value.size());
+    }
+    fast_storage_destroy(storage);  // Writes the checkpoint
+
+    fast_storage_options_t options;
+    fast_storage_default_options(&options);
+    for (auto _ : state) {
+        state.PauseTiming();
+        if (!checkpointed) {
+            unlink((path + ".idx").c_str());
+        }
+        state.ResumeTiming();
+        storage = fast_storage_open_ex(path.c_str(), &options);
+        state.PauseTiming();
+        if (!storage) {
+            state.SkipWithError("fast_storage_open_ex failed");
+            break;
+        }
+        fast_storage_destroy(storage);
+        state.ResumeTiming();
+    }
+    remove_store(path);
+    state.SetItemsProcessed(state.iterations() * records);
+}
+BENCHMARK(BM_FastStorageRebuildIndex)
+    ->ArgsProduct({{10000, 100000}, {0, 1}})
+    ->ArgNames({"records", "checkpointed"})
+    ->Unit(benchmark::kMicrosecond);
+
+// ============================================================================
+// End-to-End Fault Latency
+// ============================================================================
+
+constexpr size_t BENCH_PAGES_PER_WRITER = 8;
+constexpr size_t BENCH_WRITES_PER_WRITER = 4000;
+
+/// range(0) handler shards, range(1) writer threads. Each writer cycles
+/// through its own watched pages, so every write hits a protected page and
+/// blocks until a handler releases it. Reports the writers' fault latency
+/// percentiles and how many events per second the slow path finished.
+/// Runs without an output directory, so persistence is not included.
+static void BM_FaultLatency(benchmark::State& state) {
+    const size_t handlers = static_cast<size_t>(state.range(0));
+    const size_t writers = static_cast<size_t>(state.range(1));
+    auto& core = WatcherCore::getInstance();
+
+    WatcherConfig config;
+    config.output_dir = "";
+    config.max_queue_size = 1 << 16;
+    config.handler_threads = handlers;
+    if (!core.initialize(config)) {
+        state.SkipWithError(("initialize failed: " + core.getErrorMessage()).c_str());
+        return;
+    }
+
+    std::vector<uint8_t*> pages;
+    std::vector<std::string> ids;
+    for (size_t i = 0; i < writers * BENCH_PAGES_PER_WRITER; ++i) {
+        void* mem = mmap(nullptr, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        memset(mem, 0, PAGE_SIZE);
+        pages.push_back(static_cast<uint8_t*>(mem));
+        ids.push_back(core.registerPage(mem, PAGE_SIZE, "bench_var", FLAG_TRACK_THREADS, MutationDepth{true, 0}));
+    }
+    if (!core.start()) {
+        state.SkipWithError(("start failed (userfaultfd unavailable?): " + core.getErrorMessage()).c_str());
+        for (uint8_t* page : pages) {
+            munmap(page, PAGE_SIZE);
+        }
+        return;
+    }
+
+    // Keep the hand-out queue from filling up
+    std::atomic<bool> draining(true);
+    std::thread drainer([&] {
+        std::vector<EnrichedEvent> events;
+        while (draining.load(std::memory_order_relaxed)) {
+            events.clear();
+            if (core.dequeueEvents(events, 1024) == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+    });
+
+    LatencyRecorder fault_latency;
+    uint64_t events = 0;
+    double seconds = 0;
+    for (auto _ : state) {
+        WatcherCore::Metrics before = core.getMetrics();
+        uint64_t start_ns = EventClock::now();
+
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < writers; ++w) {
+            threads.emplace_back([&, w] {
+                uint8_t* const* own = pages.data() + w * BENCH_PAGES_PER_WRITER;
+                for (size_t i = 0; i < BENCH_WRITES_PER_WRITER; ++i) {
+                    volatile uint8_t* page = own[i % BENCH_PAGES_PER_WRITER];
+                    uint64_t t0 = EventClock::now();
+                    page[i % PAGE_SIZE] = static_cast<uint8_t>(i);
+                    fault_latency.record(EventClock::now() - t0);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        // Wait for the slow path to finish what the writers produced
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        WatcherCore::Metrics after = core.getMetrics();
+        while (after.events_processed - before.events_processed <
+                   after.events_received - before.events_received &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            after = core.getMetrics();
+        }
+        events += after.events_processed - before.events_processed;
+        double elapsed = static_cast<double>(EventClock::now() - start_ns) / 1e9;
+        seconds += elapsed;
+        state.SetIterationTime(elapsed);
+    }
+
+    draining = false;
+    drainer.join();
+    for (const std::string& id : ids) {
+        core.unregisterPage(id);
+    }
+    core.stop();
+    for (uint8_t* page : pages) {
+        munmap(page, PAGE_SIZE);
+    }
+
+    LatencySnapshot snap = fault_latency.snapshot();
+    state.counters["p50_ns"] = static_cast<double>(snap.percentile(0.50));
+    state.counters["p99_ns"] = static_cast<double>(snap.percentile(0.99));
+    state.counters["p999_ns"] = static_cast<double>(snap.percentile(0.999));
+    state.counters["events"] = static_cast<double>(events);
+    state.counters["events_per_s"] = seconds > 0 ? static_cast<double>(events) / seconds : 0.0;
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * writers * BENCH_WRITES_PER_WRITER));
+}
+BENCHMARK(BM_FaultLatency)
+    ->ArgsProduct({{1, 2, 3}, {1, 2, 4}})
+    ->ArgNames({"handlers", "writers"})
+    ->Iterations(3)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+// JSON on stdout unless another format was asked for, so runs can be
+// diffed for regressions (--benchmark_out=<file> writes a copy)
+int main(int argc, char** argv) {
+    std::vector<char*> args(argv, argv + argc);
+    bool format_given = false;
+    for (int i = 1; i < argc; ++i) {
+        format_given |= strncmp(argv[i], "--benchmark_format", 18) == 0;
+    }
+    static char json_format[] = "--benchmark_format=json";
+    if (!format_given) {
+        args.push_back(json_format);
+    }
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}